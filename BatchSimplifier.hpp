@@ -0,0 +1,226 @@
+#ifndef ZERO_ONE_SOLVER_BATCH_SIMPLIFIER_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_BATCH_SIMPLIFIER_HPP_INCLUDED
+
+#include <cassert>  // for assert
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for std::uint8_t, std::uint64_t
+#include <iostream> // for std::cerr
+#include <memory>   // for std::unique_ptr, std::make_unique
+#include <vector>   // for std::vector
+
+#include "BitsetSystem.hpp"
+#include "ZeroOneSolver.hpp"
+
+#ifdef ZERO_ONE_SOLVER_CUDA
+#include "GpuSimplify.hpp"
+#endif
+
+namespace ZeroOneSolver {
+
+
+/**
+ * A BatchSimplifier applies simplify() to batches of up to capacity()
+ * independent systems. By default, it simplifies them one by one on the
+ * CPU. If a GPU is requested, the solver was built with CUDA support (see
+ * GpuSimplify.hpp), SYSTEM is a BitsetSystem, and a device is available,
+ * every batch is simplified on the GPU instead, and if that ever fails, on
+ * the CPU from then on. Either way, each system reaches the same fixed
+ * point, but search statistics are only recorded on the CPU. The GPU path
+ * is experimental (see GpuSimplify.hpp).
+ */
+template <typename SYSTEM>
+class BatchSimplifier {
+
+    const typename SYSTEM::shape_type shape;
+    const std::size_t max_size;
+    std::vector<SYSTEM *> systems;
+    std::vector<std::uint8_t> results;
+#ifdef ZERO_ONE_SOLVER_CUDA
+    std::unique_ptr<GpuSimplifier> gpu;
+
+    static constexpr bool GPU_LAYOUT =
+        requires(SYSTEM &system) { system.p_unknown[0]; };
+
+    bool create_gpu() {
+        if constexpr (GPU_LAYOUT) {
+            if ((shape.num_slots() > GPU_MAX_SLOTS) ||
+                (shape.num_equations() > GPU_MAX_EQUATIONS) ||
+                !GpuSimplifier::available()) {
+                return false;
+            }
+            const auto pattern = std::make_unique<GpuPattern>();
+            const auto &system_pattern = shape.pattern();
+            const auto &masks = bitset_pattern(shape);
+            pattern->m = shape.m();
+            pattern->n = shape.n();
+            pattern->num_equations =
+                static_cast<std::uint16_t>(shape.num_equations());
+            for (std::size_t e = 0; e < shape.num_equations(); ++e) {
+                for (std::size_t t = 0; t < shape.num_slots(); ++t) {
+                    pattern->slot_p[e][t] = system_pattern.lhs[e][t].p_index;
+                    pattern->slot_q[e][t] = system_pattern.lhs[e][t].q_index;
+                }
+            }
+            for (var_index_t i = 1; i < shape.m(); ++i) {
+                for (std::size_t e = 0; e < shape.num_equations(); ++e) {
+                    pattern->p_mask[i][e] = masks.p_mask[i][e];
+                }
+                pattern->p_count[i] = system_pattern.p_count[i];
+                for (std::size_t k = 0; k < system_pattern.p_count[i]; ++k) {
+                    pattern->p_equations[i][k] =
+                        system_pattern.p_occurrences[i][k].equation;
+                }
+            }
+            for (var_index_t j = 1; j < shape.n(); ++j) {
+                for (std::size_t e = 0; e < shape.num_equations(); ++e) {
+                    pattern->q_mask[j][e] = masks.q_mask[j][e];
+                }
+                pattern->q_count[j] = system_pattern.q_count[j];
+                for (std::size_t k = 0; k < system_pattern.q_count[j]; ++k) {
+                    pattern->q_equations[j][k] =
+                        system_pattern.q_occurrences[j][k].equation;
+                }
+            }
+            gpu.reset(GpuSimplifier::create(*pattern, max_size));
+            return static_cast<bool>(gpu);
+        } else {
+            return false;
+        }
+    }
+
+    bool run_on_gpu() {
+        if constexpr (GPU_LAYOUT) {
+            GpuBatch &batch = gpu->batch();
+            const std::size_t num_equations = shape.num_equations();
+            const std::size_t stride = batch.capacity;
+            batch.count = systems.size();
+            for (std::size_t k = 0; k < systems.size(); ++k) {
+                const SYSTEM &system = *systems[k];
+                for (std::size_t e = 0; e < num_equations; ++e) {
+                    std::uint64_t *mask = batch.masks + e * stride + k;
+                    const std::size_t field = num_equations * stride;
+                    mask[GPU_LIVE * field] = system.live[e];
+                    mask[GPU_P_FACTOR * field] = system.p_factor[e];
+                    mask[GPU_Q_FACTOR * field] = system.q_factor[e];
+                    mask[GPU_P_UNKNOWN * field] = system.p_unknown[e];
+                    mask[GPU_Q_UNKNOWN * field] = system.q_unknown[e];
+                    batch.rhs[e * stride + k] =
+                        static_cast<std::uint8_t>(system.rhs.get(e));
+                }
+                for (std::size_t i = 0; i + 1 < shape.m(); ++i) {
+                    batch.p[i * stride + k] =
+                        static_cast<std::uint8_t>(system.p.get(i));
+                }
+                for (std::size_t j = 0; j + 1 < shape.n(); ++j) {
+                    batch.q[j * stride + k] =
+                        static_cast<std::uint8_t>(system.q.get(j));
+                }
+            }
+            if (!gpu->simplify()) { return false; }
+            for (std::size_t k = 0; k < systems.size(); ++k) {
+                SYSTEM &system = *systems[k];
+                results[k] = batch.consistent[k];
+                for (std::size_t e = 0; e < num_equations; ++e) {
+                    const std::uint64_t *mask = batch.masks + e * stride + k;
+                    const std::size_t field = num_equations * stride;
+                    system.live[e] = mask[GPU_LIVE * field];
+                    system.p_factor[e] = mask[GPU_P_FACTOR * field];
+                    system.q_factor[e] = mask[GPU_Q_FACTOR * field];
+                    system.p_unknown[e] = mask[GPU_P_UNKNOWN * field];
+                    system.q_unknown[e] = mask[GPU_Q_UNKNOWN * field];
+                    system.rhs.set(
+                        e, static_cast<RHS>(batch.rhs[e * stride + k])
+                    );
+                }
+                for (std::size_t i = 0; i + 1 < shape.m(); ++i) {
+                    system.p.set(i, static_cast<VAR>(batch.p[i * stride + k]));
+                }
+                for (std::size_t j = 0; j + 1 < shape.n(); ++j) {
+                    system.q.set(j, static_cast<VAR>(batch.q[j * stride + k]));
+                }
+            }
+            return true;
+        } else {
+            return false;
+        }
+    }
+#endif
+
+public:
+
+    explicit BatchSimplifier(
+        const typename SYSTEM::shape_type &system_shape,
+        std::size_t capacity,
+        bool use_gpu
+    )
+        : shape(system_shape)
+        , max_size(capacity)
+        , systems()
+        , results()
+#ifdef ZERO_ONE_SOLVER_CUDA
+        , gpu()
+#endif
+    {
+        systems.reserve(capacity);
+        results.reserve(capacity);
+#ifdef ZERO_ONE_SOLVER_CUDA
+        if (use_gpu && !create_gpu()) {
+            std::cerr << "WARNING: No CUDA device can simplify systems of"
+                         " this layout and shape; simplifying on the CPU.\n";
+        }
+#else
+        if (use_gpu) {
+            std::cerr << "WARNING: This solver was built without CUDA"
+                         " support; simplifying on the CPU.\n";
+        }
+#endif
+    }
+
+    bool on_gpu() const noexcept {
+#ifdef ZERO_ONE_SOLVER_CUDA
+        return static_cast<bool>(gpu);
+#else
+        return false;
+#endif
+    }
+
+    std::size_t capacity() const noexcept { return max_size; }
+    std::size_t size() const noexcept { return systems.size(); }
+
+    // Adds system to the batch. It must remain valid until run() returns,
+    // and is then replaced by its simplified form.
+    void push(SYSTEM &system) {
+        assert(systems.size() < max_size);
+        systems.push_back(&system);
+    }
+
+    // Simplifies every system in the batch. Then consistent(k) is the result
+    // of simplify() for the k-th system pushed, until clear() is called.
+    void run() {
+        results.assign(systems.size(), 0);
+#ifdef ZERO_ONE_SOLVER_CUDA
+        if (gpu) {
+            if (run_on_gpu()) { return; }
+            std::cerr << "WARNING: Failed to simplify a batch on the GPU;"
+                         " simplifying on the CPU.\n";
+            gpu.reset();
+        }
+#endif
+        for (std::size_t k = 0; k < systems.size(); ++k) {
+            results[k] = systems[k]->simplify() ? 1 : 0;
+        }
+    }
+
+    bool consistent(std::size_t k) const noexcept { return results[k] != 0; }
+
+    void clear() noexcept {
+        systems.clear();
+        results.clear();
+    }
+
+}; // class BatchSimplifier<SYSTEM>
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_BATCH_SIMPLIFIER_HPP_INCLUDED
@@ -0,0 +1,289 @@
+#!/usr/bin/env python3
+
+import json
+import os
+import subprocess
+from collections.abc import Sequence
+from sys import argv, exit
+from time import perf_counter, strftime
+from typing import Any
+
+from ParallelSolver import compile, compile_runtime
+
+
+LAYOUTS: list[str] = ["System", "BitsetSystem"]
+
+
+BENCHMARK_PAIRS: list[tuple[int, int]] = [
+    (11, 13),
+    (13, 15),
+    (14, 17),
+    (15, 18),
+    (16, 17),
+    (15, 19),
+    (16, 18),
+]
+
+
+# Each workload is (m, n, begin_case, end_case, golden number of leaf systems).
+# The (17, 24) workloads are the cases with the largest search trees in that
+# pair, together with a contiguous range of cases around them.
+BENCHMARK_WORKLOADS: list[tuple[int, int, int, int, int]] = [
+    (11, 13, 0, 1024, 4),
+    (13, 15, 0, 4096, 24),
+    (14, 17, 0, 8192, 16),
+    (15, 18, 0, 16384, 12),
+    (16, 17, 0, 32768, 36),
+    (15, 19, 0, 16384, 66),
+    (16, 18, 0, 32768, 16),
+    (17, 24, 34703, 34704, 0),
+    (17, 24, 8411, 8412, 5),
+    (17, 24, 8667, 8668, 4),
+    (17, 24, 8192, 9728, 64),
+]
+
+
+# The (M, N) pair solved with every number of threads by measure_scaling().
+SCALING_PAIR: tuple[int, int] = (17, 22)
+
+
+def benchmark_path(m: int, n: int, layout: str) -> str:
+    return f"bin/Benchmark-{layout}-{m+n:04}-{m:04}-{n:04}"
+
+
+def runtime_benchmark_path(layout: str) -> str:
+    return f"bin/Benchmark-{layout}-Runtime"
+
+
+def time_solver(
+    path: str, repetitions: int, args: Sequence[str] = ()
+) -> tuple[float, bytes]:
+    """
+    Run the solver executable at the given path the specified number of
+    times and return the minimum wall time observed, together with its output.
+    """
+    best_time = float("inf")
+    output = b""
+    for _ in range(repetitions):
+        start = perf_counter()
+        output = subprocess.run(
+            [path, *args], stdout=subprocess.PIPE, check=True
+        ).stdout
+        best_time = min(best_time, perf_counter() - start)
+    return best_time, output
+
+
+def compare_layouts(repetitions: int):
+    """
+    Time the full search for each benchmark pair under every storage layout,
+    checking that all layouts produce byte-identical output.
+    """
+    print(f"{'(M, N)':>10}", *(f"{layout:>14}" for layout in LAYOUTS), "speedup")
+    for m, n in BENCHMARK_PAIRS:
+        times: list[float] = []
+        outputs: list[bytes] = []
+        for layout in LAYOUTS:
+            path = benchmark_path(m, n, layout)
+            compile(m, n, path, ["-DZERO_ONE_SOLVER_LAYOUT=" + layout])
+            elapsed, output = time_solver(path, repetitions)
+            os.remove(path)
+            times.append(elapsed)
+            outputs.append(output)
+        status = "" if all(out == outputs[0] for out in outputs) else " MISMATCH"
+        print(
+            f"{str((m, n)):>10}",
+            *(f"{t:13.3f}s" for t in times),
+            f"{times[0] / times[-1]:6.2f}x" + status,
+        )
+
+
+def compare_dimensions(repetitions: int):
+    """
+    For every storage layout, time the full search for each benchmark pair
+    with a solver specialized for (M, N) at compile time against the single
+    runtime-dimensioned solver, checking that both produce identical output.
+    A ratio above 1 is the slowdown paid for runtime dimensions.
+    """
+    for layout in LAYOUTS:
+        runtime_path = runtime_benchmark_path(layout)
+        compile_runtime(runtime_path, ["-DZERO_ONE_SOLVER_LAYOUT=" + layout])
+        print(layout)
+        print(f"{'(M, N)':>10}", f"{'static':>14}", f"{'runtime':>14}", "  ratio")
+        for m, n in BENCHMARK_PAIRS:
+            path = benchmark_path(m, n, layout)
+            compile(m, n, path, ["-DZERO_ONE_SOLVER_LAYOUT=" + layout])
+            static_time, static_output = time_solver(path, repetitions)
+            os.remove(path)
+            runtime_time, runtime_output = time_solver(
+                runtime_path, repetitions, ["--m", str(m), "--n", str(n)]
+            )
+            status = "" if static_output == runtime_output else " MISMATCH"
+            print(
+                f"{str((m, n)):>10}",
+                f"{static_time:13.3f}s",
+                f"{runtime_time:13.3f}s",
+                f"{runtime_time / static_time:6.2f}x" + status,
+            )
+        os.remove(runtime_path)
+
+
+def numa_nodes() -> list[str]:
+    """
+    Return the CPU list of each NUMA node of this machine, as reported by
+    Linux, or an empty list if it is unavailable.
+    """
+    root = "/sys/devices/system/node"
+    if not os.path.isdir(root):
+        return []
+    names = [
+        name
+        for name in os.listdir(root)
+        if name.startswith("node") and name[4:].isdigit()
+    ]
+    result: list[str] = []
+    for name in sorted(names, key=lambda name: int(name[4:])):
+        with open(os.path.join(root, name, "cpulist")) as cpulist:
+            result.append(cpulist.read().strip())
+    return result
+
+
+def measure_scaling(repetitions: int):
+    """
+    Time the full search for SCALING_PAIR with the runtime-dimensioned solver,
+    using 1, 2, 4, ... threads up to every CPU of the machine, with workers
+    pinned to NUMA nodes by --numa. Speedup and efficiency are relative to
+    one thread, and the sorted output of every run must match it.
+    """
+    m, n = SCALING_PAIR
+    num_cpus = os.cpu_count() or 1
+    nodes = numa_nodes()
+    print(f"{num_cpus} CPUs on {len(nodes) or 'unknown'} NUMA nodes:", *nodes)
+    thread_counts = [1]
+    while thread_counts[-1] * 2 < num_cpus:
+        thread_counts.append(thread_counts[-1] * 2)
+    if thread_counts[-1] < num_cpus:
+        thread_counts.append(num_cpus)
+    runtime_path = runtime_benchmark_path(LAYOUTS[0])
+    compile_runtime(runtime_path)
+    print(f"{'threads':>7} {'time':>14} {'speedup':>8} {'efficiency':>10}")
+    base_time = 0.0
+    base_output: list[bytes] = []
+    for num_threads in thread_counts:
+        elapsed, output = time_solver(
+            runtime_path,
+            repetitions,
+            [
+                *("--m", str(m), "--n", str(n)),
+                *("--threads", str(num_threads)),
+                *("--trail", "--numa"),
+            ],
+        )
+        # Leaf systems are written in a different order by every run.
+        lines = sorted(output.splitlines())
+        if num_threads == 1:
+            base_time = elapsed
+            base_output = lines
+        speedup = base_time / elapsed
+        print(
+            f"{num_threads:7}",
+            f"{elapsed:13.3f}s",
+            f"{speedup:7.2f}x",
+            f"{speedup / num_threads:9.0%}",
+            "" if lines == base_output else "MISMATCH",
+        )
+    os.remove(runtime_path)
+
+
+def git_revision() -> str:
+    try:
+        return subprocess.run(
+            ["git", "rev-parse", "HEAD"], stdout=subprocess.PIPE, check=True
+        ).stdout.decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return ""
+
+
+def run_suite(repetitions: int, output_path: str) -> bool:
+    """
+    Run every benchmark workload under every storage layout using the
+    solver's --benchmark mode, which times simplify(), find_case_split(),
+    and analyze_case() separately. Of the repetitions of each workload, the
+    one with the smallest total search time is kept. The results are written
+    to output_path as JSON, so that runs of different revisions can be
+    compared, and leaf counts that differ from the golden counts are
+    reported. Returns True if all leaf counts match.
+    """
+    results: list[dict[str, Any]] = []
+    all_match = True
+    print(
+        f"{'layout':>12} {'(M, N)':>10} {'cases':>13}",
+        f"{'nodes/s':>10} {'leaves/s':>9} {'simplify':>9} {'split':>7}",
+        f"{'bytes/system':>12}",
+    )
+    for layout in LAYOUTS:
+        runtime_path = runtime_benchmark_path(layout)
+        compile_runtime(runtime_path, ["-DZERO_ONE_SOLVER_LAYOUT=" + layout])
+        for m, n, begin, end, golden_leaves in BENCHMARK_WORKLOADS:
+            best: dict[str, Any] = {}
+            for _ in range(repetitions):
+                output = subprocess.run(
+                    [
+                        runtime_path,
+                        *("--m", str(m), "--n", str(n)),
+                        *("--cases", f"{begin}:{end}"),
+                        "--benchmark",
+                    ],
+                    stdout=subprocess.PIPE,
+                    check=True,
+                ).stdout
+                result = json.loads(output)
+                if not best or result["analyze_seconds"] < best["analyze_seconds"]:
+                    best = result
+            best["golden_leaves"] = golden_leaves
+            best["leaves_match"] = best["leaves"] == golden_leaves
+            all_match = all_match and best["leaves_match"]
+            results.append(best)
+            print(
+                f"{layout:>12} {str((m, n)):>10} {f'{begin}:{end}':>13}",
+                f"{best['nodes_per_second']:10.0f}",
+                f"{best['leaves_per_second']:9.0f}",
+                f"{best['simplify_ns_per_node']:7.0f}ns",
+                f"{best['split_ns_per_split']:5.0f}ns",
+                f"{best['system_size']:12d}",
+                "" if best["leaves_match"] else "MISMATCH",
+            )
+        os.remove(runtime_path)
+    with open(output_path, "w") as output_file:
+        json.dump(
+            {
+                "revision": git_revision(),
+                "time": strftime("%Y-%m-%dT%H:%M:%S%z"),
+                "repetitions": repetitions,
+                "results": results,
+            },
+            output_file,
+            indent=2,
+        )
+    print("Wrote", output_path + ".")
+    return all_match
+
+
+def main():
+    if not os.path.isdir("bin"):
+        os.mkdir("bin")
+    repetitions = int(argv[1]) if len(argv) > 1 else 3
+    mode = argv[2] if len(argv) > 2 else "all"
+    output_path = argv[3] if len(argv) > 3 else "bin/BenchmarkResults.json"
+    if mode in ("all", "layouts"):
+        compare_layouts(repetitions)
+    if mode in ("all", "dimensions"):
+        compare_dimensions(repetitions)
+    if mode in ("all", "scaling"):
+        measure_scaling(repetitions)
+    if mode in ("all", "suite"):
+        if not run_suite(repetitions, output_path):
+            exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,495 @@
+#ifndef ZERO_ONE_SOLVER_BITSET_SYSTEM_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_BITSET_SYSTEM_HPP_INCLUDED
+
+#include <bit>         // for std::countr_zero, std::popcount
+#include <cassert>     // for assert
+#include <cstddef>     // for std::size_t
+#include <cstdint>     // for std::uint64_t
+#include <type_traits> // for std::remove_cvref_t
+
+#include "ZeroOneSolver.hpp"
+
+namespace ZeroOneSolver {
+
+
+using term_mask_t = std::uint64_t;
+
+
+/**
+ * A BitsetPattern describes the initial system of equations for a given
+ * (M, N) in terms of bitmasks over the M + 1 term slots of each equation,
+ * using the same slot numbering as SystemPattern. In addition to the masks
+ * of live terms and of terms containing a p or q factor, it records, for
+ * every variable, the mask of slots in each equation at which it occurs.
+ */
+template <typename SHAPE>
+struct BitsetPattern {
+
+    term_mask_t live[SHAPE::MAX_EQUATIONS];
+    term_mask_t p_factor[SHAPE::MAX_EQUATIONS];
+    term_mask_t q_factor[SHAPE::MAX_EQUATIONS];
+
+    // p_mask[i][e] is the set of slots in equation e containing p_i,
+    // and similarly for q_mask[j][e]. Index 0 is unused.
+    term_mask_t p_mask[SHAPE::MAX_M][SHAPE::MAX_EQUATIONS];
+    term_mask_t q_mask[SHAPE::MAX_N][SHAPE::MAX_EQUATIONS];
+
+}; // struct BitsetPattern<SHAPE>
+
+
+template <typename SHAPE>
+constexpr BitsetPattern<SHAPE>
+make_bitset_pattern(const SystemPattern<SHAPE> &pattern) noexcept {
+    BitsetPattern<SHAPE> result{};
+    for (std::size_t e = 0; e < SHAPE::MAX_EQUATIONS; ++e) {
+        for (std::size_t t = 0; t < SHAPE::MAX_M + 1; ++t) {
+            const Term term = pattern.lhs[e][t];
+            if (term == TERM_ZERO) { continue; }
+            const term_mask_t bit = static_cast<term_mask_t>(1) << t;
+            result.live[e] |= bit;
+            if (term.p_index) {
+                result.p_factor[e] |= bit;
+                result.p_mask[term.p_index][e] |= bit;
+            }
+            if (term.q_index) {
+                result.q_factor[e] |= bit;
+                result.q_mask[term.q_index][e] |= bit;
+            }
+        }
+    }
+    return result;
+}
+
+
+template <var_index_t M, var_index_t N>
+inline constexpr BitsetPattern<StaticShape<M, N>> BITSET_PATTERN =
+    make_bitset_pattern(SYSTEM_PATTERN<M, N>);
+
+
+// BasicBitsetSystem locates the BitsetPattern of its shape by calling
+// bitset_pattern(shape), which is found by argument-dependent lookup, so
+// that other shapes can supply their own overload (see DynamicShape.hpp).
+template <var_index_t M, var_index_t N>
+constexpr const BitsetPattern<StaticShape<M, N>> &
+bitset_pattern(const StaticShape<M, N> &) noexcept {
+    return BITSET_PATTERN<M, N>;
+}
+
+
+/**
+ * A BitsetSystem represents the same system of equations as System<M, N>,
+ * but stores the left-hand side of each equation as a set of bitmasks over
+ * its term slots instead of an array of Terms. The term in slot t is live
+ * if bit t of live[e] is set, and it retains its p (resp. q) factor if bit t
+ * of p_factor[e] (resp. q_factor[e]) is set. Finally, bit t of p_unknown[e]
+ * (resp. q_unknown[e]) is set if that factor is a variable of state UNKNOWN.
+ *
+ * In this layout, the scans performed by simplify() become bitwise operations
+ * followed by a popcount, and substituting a value for a variable becomes a
+ * masked update of every equation at once, which the compiler vectorizes
+ * into AVX2/AVX-512 instructions when compiled with -O3 -march=native.
+ *
+ * BitsetSystem provides the same interface as System, so the search driver
+ * can select either layout at compile time via ZERO_ONE_SOLVER_LAYOUT.
+ */
+template <typename SHAPE>
+struct BasicBitsetSystem {
+
+
+    using shape_type = SHAPE;
+
+    static constexpr std::size_t MAX_M = SHAPE::MAX_M;
+    static constexpr std::size_t MAX_N = SHAPE::MAX_N;
+    static constexpr std::size_t MAX_EQUATIONS = SHAPE::MAX_EQUATIONS;
+
+    static_assert(MAX_M + 1 <= 64, "BitsetSystem requires M + 1 <= 64");
+
+
+    [[no_unique_address]] SHAPE shape;
+    term_mask_t live[MAX_EQUATIONS];
+    term_mask_t p_factor[MAX_EQUATIONS];
+    term_mask_t q_factor[MAX_EQUATIONS];
+    term_mask_t p_unknown[MAX_EQUATIONS];
+    term_mask_t q_unknown[MAX_EQUATIONS];
+    TwoBitPackedArray<RHS, MAX_EQUATIONS> rhs;
+    TwoBitPackedArray<VAR, MAX_M - 1> p;
+    TwoBitPackedArray<VAR, MAX_N - 1> q;
+
+
+    constexpr explicit BasicBitsetSystem(const SHAPE &system_shape = SHAPE()
+    ) noexcept
+        : shape(system_shape) {
+        const BitsetPattern<SHAPE> &pattern = bitset_pattern(shape);
+        for (std::size_t e = 0; e < MAX_EQUATIONS; ++e) {
+            live[e] = pattern.live[e];
+            p_factor[e] = pattern.p_factor[e];
+            q_factor[e] = pattern.q_factor[e];
+            p_unknown[e] = pattern.p_factor[e];
+            q_unknown[e] = pattern.q_factor[e];
+        }
+        for (std::size_t i = 0; i < MAX_EQUATIONS; ++i) {
+            rhs.set(i, RHS::ZERO_OR_ONE);
+        }
+        for (std::size_t i = 0; i < MAX_M - 1; ++i) { p.set(i, VAR::UNKNOWN); }
+        for (std::size_t i = 0; i < MAX_N - 1; ++i) { q.set(i, VAR::UNKNOWN); }
+    }
+
+
+    constexpr var_index_t m() const noexcept { return shape.m(); }
+    constexpr var_index_t n() const noexcept { return shape.n(); }
+    constexpr std::size_t num_equations() const noexcept {
+        return shape.num_equations();
+    }
+    constexpr std::size_t num_slots() const noexcept {
+        return shape.num_slots();
+    }
+
+    constexpr std::size_t length(std::size_t e) const noexcept {
+        assert(e < num_equations());
+        return shape.pattern().length[e];
+    }
+
+
+    // Clears the bits of mask[e] from target[e] in every equation e. Without a
+    // trail, this is a branch-free loop that the compiler vectorizes; with a
+    // trail, only the words that actually change are recorded.
+    template <typename TRAIL>
+    constexpr void clear_bits(
+        term_mask_t (&target)[MAX_EQUATIONS],
+        const term_mask_t *mask,
+        TRAIL &trail
+    ) noexcept {
+        const std::size_t num_equations = this->num_equations();
+        if constexpr (std::remove_cvref_t<TRAIL>::ENABLED) {
+            for (std::size_t e = 0; e < num_equations; ++e) {
+                if (target[e] & mask[e]) {
+                    trail.save(target[e]);
+                    target[e] &= ~mask[e];
+                }
+            }
+        } else {
+            for (std::size_t e = 0; e < num_equations; ++e) {
+                target[e] &= ~mask[e];
+            }
+        }
+    }
+
+
+    constexpr Term term(std::size_t e, std::size_t t) const noexcept {
+        assert(e < num_equations());
+        assert(t < num_slots());
+        if (!((live[e] >> t) & 1)) { return TERM_ZERO; }
+        const Term term = shape.pattern().lhs[e][t];
+        return {
+            ((p_factor[e] >> t) & 1) ? term.p_index : 0,
+            ((q_factor[e] >> t) & 1) ? term.q_index : 0,
+        };
+    }
+
+
+    template <typename TRAIL = NullTrail>
+    constexpr void
+    set_p_zero(var_index_t p_index, TRAIL &&trail = TRAIL{}) noexcept {
+        assert((1 <= p_index) && (p_index < m()));
+        assert(p.get(p_index - 1) != VAR::ONE);
+        p.set(p_index - 1, VAR::ZERO, trail);
+        const term_mask_t *mask = bitset_pattern(shape).p_mask[p_index];
+        clear_bits(live, mask, trail);
+        clear_bits(p_unknown, mask, trail);
+    }
+
+
+    template <typename TRAIL = NullTrail>
+    constexpr void
+    set_q_zero(var_index_t q_index, TRAIL &&trail = TRAIL{}) noexcept {
+        assert((1 <= q_index) && (q_index < n()));
+        assert(q.get(q_index - 1) != VAR::ONE);
+        q.set(q_index - 1, VAR::ZERO, trail);
+        const term_mask_t *mask = bitset_pattern(shape).q_mask[q_index];
+        clear_bits(live, mask, trail);
+        clear_bits(q_unknown, mask, trail);
+    }
+
+
+    template <typename TRAIL = NullTrail>
+    constexpr void
+    set_p_one(var_index_t p_index, TRAIL &&trail = TRAIL{}) noexcept {
+        assert((1 <= p_index) && (p_index < m()));
+        assert(p.get(p_index - 1) != VAR::ZERO);
+        p.set(p_index - 1, VAR::ONE, trail);
+        const term_mask_t *mask = bitset_pattern(shape).p_mask[p_index];
+        clear_bits(p_factor, mask, trail);
+        clear_bits(p_unknown, mask, trail);
+    }
+
+
+    template <typename TRAIL = NullTrail>
+    constexpr void
+    set_q_one(var_index_t q_index, TRAIL &&trail = TRAIL{}) noexcept {
+        assert((1 <= q_index) && (q_index < n()));
+        assert(q.get(q_index - 1) != VAR::ZERO);
+        q.set(q_index - 1, VAR::ONE, trail);
+        const term_mask_t *mask = bitset_pattern(shape).q_mask[q_index];
+        clear_bits(q_factor, mask, trail);
+        clear_bits(q_unknown, mask, trail);
+    }
+
+
+    template <typename TRAIL = NullTrail>
+    constexpr bool
+    set_p_zero_or_one(var_index_t p_index, TRAIL &&trail = TRAIL{}) noexcept {
+        assert((1 <= p_index) && (p_index < m()));
+        if (p.get(p_index - 1) == VAR::UNKNOWN) {
+            p.set(p_index - 1, VAR::ZERO_OR_ONE, trail);
+            const term_mask_t *mask = bitset_pattern(shape).p_mask[p_index];
+            clear_bits(p_unknown, mask, trail);
+            return true;
+        }
+        return false;
+    }
+
+
+    template <typename TRAIL = NullTrail>
+    constexpr bool
+    set_q_zero_or_one(var_index_t q_index, TRAIL &&trail = TRAIL{}) noexcept {
+        assert((1 <= q_index) && (q_index < n()));
+        if (q.get(q_index - 1) == VAR::UNKNOWN) {
+            q.set(q_index - 1, VAR::ZERO_OR_ONE, trail);
+            const term_mask_t *mask = bitset_pattern(shape).q_mask[q_index];
+            clear_bits(q_unknown, mask, trail);
+            return true;
+        }
+        return false;
+    }
+
+
+    constexpr void set_case(std::uint64_t case_index) noexcept {
+        set_case_base();
+        for (var_index_t i = 1; i <= m() - 1; ++i) {
+            set_case_choice(i, (case_index >> (i - 1)) & 1);
+        }
+    }
+
+
+    // The parts of set_case() that are common to all cases.
+    template <typename TRAIL = NullTrail>
+    constexpr void set_case_base(TRAIL &&trail = TRAIL{}) noexcept {
+        set_q_zero(m(), trail);
+        set_q_zero(n() - m(), trail);
+    }
+
+
+    // The part of set_case() selected by bit i - 1 of the case index. Since
+    // these parts commute, they can be applied and undone in any order.
+    template <typename TRAIL = NullTrail>
+    constexpr void set_case_choice(
+        var_index_t i, bool bit, TRAIL &&trail = TRAIL{}
+    ) noexcept {
+        assert((1 <= i) && (i < m()));
+        if (bit) {
+            set_q_zero(m() - i, trail);
+            set_q_zero(n() - i, trail);
+        } else {
+            set_p_zero(i, trail);
+        }
+    }
+
+
+    constexpr bool has_unknown_variable() const noexcept {
+        for (std::size_t i = 0; i + 1 < m(); ++i) {
+            if (p.get(i) == VAR::UNKNOWN) { return true; }
+        }
+        for (std::size_t i = 0; i + 1 < n(); ++i) {
+            if (q.get(i) == VAR::UNKNOWN) { return true; }
+        }
+        return false;
+    }
+
+
+    // Returns the mask of live slots in equation e
+    // containing a variable of state UNKNOWN.
+    constexpr term_mask_t unknown_terms(std::size_t e) const noexcept {
+        return live[e] & (p_unknown[e] | q_unknown[e]);
+    }
+
+
+    // Returns the mask of live slots in equation e whose
+    // term is the constant 1, i.e., has neither factor left.
+    constexpr term_mask_t one_terms(std::size_t e) const noexcept {
+        return live[e] & ~(p_factor[e] | q_factor[e]);
+    }
+
+
+    template <typename TRAIL = NullTrail>
+    constexpr bool simplify(TRAIL &&trail = TRAIL{}) noexcept {
+
+        record(Stat::SIMPLIFY_CALLS);
+        const SystemPattern<SHAPE> &pattern = shape.pattern();
+        const std::size_t num_equations = this->num_equations();
+
+        // The rules applied here are exactly those of System::simplify(),
+        // and they are applied in the same order, so both layouts reach
+        // the same fixed point. See System::simplify() for commentary.
+        Worklist<SHAPE> worklist(pattern);
+        for (std::size_t e = 0; e < num_equations; ++e) { worklist.push(e); }
+        while (!worklist.empty()) {
+            const std::size_t e = worklist.pop();
+
+            // Phase 1: Simplify the right-hand side of equation e.
+            const term_mask_t ones = one_terms(e);
+            if (std::popcount(ones) > 1) {
+                record(Stat::PHASE_1_CONFLICTS);
+                refute(PROOF_TWO_ONES, e);
+                return false;
+            }
+            if (!live[e]) {
+                if (rhs.get(e) == RHS::ONE) {
+                    record(Stat::PHASE_1_CONFLICTS);
+                    refute(PROOF_ZERO_EQUALS_ONE, e);
+                    return false;
+                }
+                record(Stat::PHASE_1_FIRED, rhs.get(e) != RHS::ZERO);
+                rhs.set(e, RHS::ZERO, trail);
+            }
+            if (ones) {
+                if (rhs.get(e) == RHS::ZERO) {
+                    record(Stat::PHASE_1_CONFLICTS);
+                    refute(PROOF_ONE_EQUALS_ZERO, e);
+                    return false;
+                }
+                record(Stat::PHASE_1_FIRED);
+                trail.save(live[e]);
+                live[e] &= ~ones;
+                rhs.set(e, RHS::ZERO, trail);
+            }
+
+            // Phase 2: Use the right-hand side to directly solve for variables.
+            const RHS rhs_value = rhs.get(e);
+            if (rhs_value == RHS::ZERO) {
+                // Linear terms in p and q are set to zero. Distinct linear
+                // terms in one equation involve distinct variables, so the
+                // masks computed here remain valid during the loop.
+                term_mask_t p_linear = live[e] & p_factor[e] & ~q_factor[e];
+                term_mask_t q_linear = live[e] & q_factor[e] & ~p_factor[e];
+                while (p_linear) {
+                    const int t = std::countr_zero(p_linear);
+                    p_linear &= p_linear - 1;
+                    const var_index_t p_index = pattern.lhs[e][t].p_index;
+                    set_p_zero(p_index, trail);
+                    record(Stat::PHASE_2_FIRED);
+                    record(Stat::PHASE_2_RESTARTS, worklist.push_p(p_index));
+                }
+                while (q_linear) {
+                    const int t = std::countr_zero(q_linear);
+                    q_linear &= q_linear - 1;
+                    const var_index_t q_index = pattern.lhs[e][t].q_index;
+                    set_q_zero(q_index, trail);
+                    record(Stat::PHASE_2_FIRED);
+                    record(Stat::PHASE_2_RESTARTS, worklist.push_q(q_index));
+                }
+            } else if (rhs_value == RHS::ONE) {
+                const term_mask_t bit = live[e];
+                if (bit && !(bit & (bit - 1))) {
+                    const int t = std::countr_zero(bit);
+                    const Term term = pattern.lhs[e][t];
+                    if (p_factor[e] & bit) {
+                        set_p_one(term.p_index, trail);
+                        record(Stat::PHASE_2_FIRED);
+                        record(
+                            Stat::PHASE_2_RESTARTS,
+                            worklist.push_p(term.p_index)
+                        );
+                    }
+                    if (q_factor[e] & bit) {
+                        set_q_one(term.q_index, trail);
+                        record(Stat::PHASE_2_FIRED);
+                        record(
+                            Stat::PHASE_2_RESTARTS,
+                            worklist.push_q(term.q_index)
+                        );
+                    }
+                }
+            }
+        }
+
+        while (true) {
+
+            std::size_t num_changes = 0;
+
+            // Phase 3: Eliminate unknown variables using all-but-one principle.
+            for (std::size_t e = 0; e < num_equations; ++e) {
+                const term_mask_t unknown = unknown_terms(e);
+                if (std::popcount(unknown) == 1) {
+                    const Term term = this->term(e, std::countr_zero(unknown));
+                    if (term.q_index == 0) {
+                        num_changes += set_p_zero_or_one(term.p_index, trail);
+                    } else if (term.p_index == 0) {
+                        num_changes += set_q_zero_or_one(term.q_index, trail);
+                    }
+                }
+            }
+            record(Stat::PHASE_3_FIRED, num_changes);
+            if (!has_unknown_variable()) { return true; }
+            if (num_changes) {
+                record(Stat::PHASE_3_RESTARTS);
+                continue;
+            }
+
+            // Phase 4: Eliminate unknown variables in subsystems of the form:
+            //     a + b == 0 or 1
+            //     a * b == 0 or 1
+            Term lone_quadratic_terms[MAX_EQUATIONS];
+            for (std::size_t e = 0; e < num_equations; ++e) {
+                const term_mask_t unknown = unknown_terms(e);
+                if (std::popcount(unknown) == 1) {
+                    const Term term = this->term(e, std::countr_zero(unknown));
+                    assert(term.p_index);
+                    assert(term.q_index);
+                    lone_quadratic_terms[e] = term;
+                } else {
+                    lone_quadratic_terms[e] = TERM_ONE;
+                }
+            }
+            for (std::size_t e = 0; e < num_equations; ++e) {
+                if (std::popcount(live[e]) != 2) { continue; }
+                const term_mask_t first = live[e] & -live[e];
+                const Term x = this->term(e, std::countr_zero(first));
+                const Term y = this->term(e, std::countr_zero(live[e] ^ first));
+                if ((x.q_index == 0) && (y.p_index == 0)) {
+                    const Term target = {x.p_index, y.q_index};
+                    for (std::size_t t = 0; t < num_equations; ++t) {
+                        if (lone_quadratic_terms[t] == target) {
+                            num_changes += set_p_zero_or_one(x.p_index, trail);
+                            num_changes += set_q_zero_or_one(y.q_index, trail);
+                            break;
+                        }
+                    }
+                } else if ((x.p_index == 0) && (y.q_index == 0)) {
+                    const Term target = {y.p_index, x.q_index};
+                    for (std::size_t t = 0; t < num_equations; ++t) {
+                        if (lone_quadratic_terms[t] == target) {
+                            num_changes += set_p_zero_or_one(y.p_index, trail);
+                            num_changes += set_q_zero_or_one(x.q_index, trail);
+                            break;
+                        }
+                    }
+                }
+            }
+            record(Stat::PHASE_4_FIRED, num_changes);
+            if (!has_unknown_variable()) { return true; }
+            if (!num_changes) { return true; }
+            record(Stat::PHASE_4_RESTARTS);
+        }
+    }
+
+
+}; // struct BasicBitsetSystem<SHAPE>
+
+
+template <var_index_t M, var_index_t N>
+using BitsetSystem = BasicBitsetSystem<StaticShape<M, N>>;
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_BITSET_SYSTEM_HPP_INCLUDED
@@ -0,0 +1,400 @@
+#ifndef ZERO_ONE_SOLVER_CANONIZER_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_CANONIZER_HPP_INCLUDED
+
+#include <algorithm>  // for std::sort, std::lexicographical_compare
+#include <cassert>    // for assert
+#include <compare>    // for operator<=>
+#include <cstddef>    // for std::size_t, std::ptrdiff_t
+#include <cstdint>    // for std::uint8_t, std::uint16_t, std::uint32_t
+#include <filesystem> // for std::filesystem
+#include <fstream>    // for std::ifstream
+#include <atomic>     // for std::atomic
+#include <numeric>    // for std::iota
+#include <ostream>    // for std::ostream
+#include <string>     // for std::string, std::getline
+#include <vector>     // for std::vector
+
+#include "FingerprintSet.hpp"
+#include "ZeroOneSolver.hpp"
+
+namespace ZeroOneSolver {
+
+
+/**
+ * A CanonicalTerm is a term of a leaf system in the representation used by
+ * Canonizer.py, where each variable is a (label, index) pair. A variable is
+ * encoded as (label << 8) | index, with label 0 for p and 1 for q, so that
+ * variables compare in the same order as the corresponding Python tuples.
+ * A linear term has second == 0, which makes it compare like a 1-tuple,
+ * i.e., before every 2-tuple with the same first element.
+ */
+struct CanonicalTerm {
+
+    std::uint16_t first;
+    std::uint16_t second;
+
+    constexpr bool is_quadratic() const noexcept { return second != 0; }
+
+    constexpr auto operator<=>(const CanonicalTerm &) const noexcept = default;
+
+}; // struct CanonicalTerm
+
+
+constexpr std::uint16_t CANONICAL_P = 0x000;
+constexpr std::uint16_t CANONICAL_Q = 0x100;
+
+
+/**
+ * A CanonicalSystem holds the equations of a leaf system and computes the
+ * same weak canonical form as Canonizer.py::canonize(), i.e., the fixed point
+ * of sorting the equations and renaming the variables in order of first
+ * appearance. Its canonical form is identified by the 128-bit fingerprint
+ * of a compact byte encoding, and printed by write_wolfram() exactly as
+ * Canonizer.py::wolfram_string() does.
+ */
+class CanonicalSystem {
+
+    std::vector<CanonicalTerm> terms;
+    // Equation k consists of terms[offsets[k] .. offsets[k + 1] - 1].
+    std::vector<std::uint32_t> offsets;
+
+    std::size_t begin(std::size_t k) const noexcept { return offsets[k]; }
+    std::size_t end(std::size_t k) const noexcept { return offsets[k + 1]; }
+
+    std::size_t num_quadratic(std::size_t k) const noexcept {
+        std::size_t result = 0;
+        for (std::size_t i = begin(k); i < end(k); ++i) {
+            if (terms[i].is_quadratic()) { ++result; }
+        }
+        return result;
+    }
+
+    // Equivalent to Canonizer.py::sorted_system().
+    void sort_system() {
+        for (std::size_t k = 0; k < num_equations(); ++k) {
+            std::sort(
+                terms.begin() + static_cast<std::ptrdiff_t>(begin(k)),
+                terms.begin() + static_cast<std::ptrdiff_t>(end(k)),
+                [](const CanonicalTerm &a, const CanonicalTerm &b) {
+                    if (a.is_quadratic() != b.is_quadratic()) {
+                        return a.is_quadratic();
+                    }
+                    return a < b;
+                }
+            );
+        }
+        std::vector<std::uint32_t> order(num_equations());
+        std::iota(order.begin(), order.end(), 0);
+        std::vector<std::size_t> quadratic_counts(num_equations());
+        for (std::size_t k = 0; k < num_equations(); ++k) {
+            quadratic_counts[k] = num_quadratic(k);
+        }
+        std::sort(
+            order.begin(),
+            order.end(),
+            [&](std::uint32_t a, std::uint32_t b) {
+                const std::size_t a_quadratic = quadratic_counts[a];
+                const std::size_t b_quadratic = quadratic_counts[b];
+                if (a_quadratic != b_quadratic) {
+                    return a_quadratic < b_quadratic;
+                }
+                const std::size_t a_linear = end(a) - begin(a) - a_quadratic;
+                const std::size_t b_linear = end(b) - begin(b) - b_quadratic;
+                if (a_linear != b_linear) { return a_linear < b_linear; }
+                return std::lexicographical_compare(
+                    terms.begin() + static_cast<std::ptrdiff_t>(begin(a)),
+                    terms.begin() + static_cast<std::ptrdiff_t>(end(a)),
+                    terms.begin() + static_cast<std::ptrdiff_t>(begin(b)),
+                    terms.begin() + static_cast<std::ptrdiff_t>(end(b))
+                );
+            }
+        );
+        std::vector<CanonicalTerm> sorted_terms;
+        std::vector<std::uint32_t> sorted_offsets;
+        sorted_terms.reserve(terms.size());
+        sorted_offsets.reserve(offsets.size());
+        sorted_offsets.push_back(0);
+        for (const std::uint32_t k : order) {
+            sorted_terms.insert(
+                sorted_terms.end(),
+                terms.begin() + static_cast<std::ptrdiff_t>(begin(k)),
+                terms.begin() + static_cast<std::ptrdiff_t>(end(k))
+            );
+            sorted_offsets.push_back(
+                static_cast<std::uint32_t>(sorted_terms.size())
+            );
+        }
+        terms = std::move(sorted_terms);
+        offsets = std::move(sorted_offsets);
+    }
+
+    // Equivalent to Canonizer.py::rename_variables().
+    void rename_variables() {
+        std::uint16_t new_variables[0x200] = {};
+        std::uint16_t next_index[2] = {0, 0};
+        const auto rename = [&](std::uint16_t &variable) {
+            if (!new_variables[variable]) {
+                const std::uint16_t label = variable & CANONICAL_Q;
+                const std::uint16_t index = ++next_index[label >> 8];
+                new_variables[variable] = label | index;
+            }
+            variable = new_variables[variable];
+        };
+        for (CanonicalTerm &term : terms) {
+            rename(term.first);
+            if (term.second) { rename(term.second); }
+        }
+    }
+
+public:
+
+    CanonicalSystem()
+        : terms()
+        , offsets{0} {}
+
+    std::size_t num_equations() const noexcept { return offsets.size() - 1; }
+
+    // Calls f(terms, num_terms) for each equation in order.
+    template <typename F>
+    void for_each_equation(F &&f) const {
+        for (std::size_t k = 0; k < num_equations(); ++k) {
+            f(terms.data() + begin(k), end(k) - begin(k));
+        }
+    }
+
+    void add_term(const Term &term) {
+        assert(term != TERM_ZERO);
+        assert(term != TERM_ONE);
+        if (term.p_index && term.q_index) {
+            terms.push_back({
+                static_cast<std::uint16_t>(CANONICAL_P | term.p_index),
+                static_cast<std::uint16_t>(CANONICAL_Q | term.q_index),
+            });
+        } else if (term.p_index) {
+            terms.push_back(
+                {static_cast<std::uint16_t>(CANONICAL_P | term.p_index), 0}
+            );
+        } else {
+            terms.push_back(
+                {static_cast<std::uint16_t>(CANONICAL_Q | term.q_index), 0}
+            );
+        }
+    }
+
+    void add_term(const CanonicalTerm &term) { terms.push_back(term); }
+
+    void end_equation() {
+        offsets.push_back(static_cast<std::uint32_t>(terms.size()));
+    }
+
+    bool operator==(const CanonicalSystem &) const noexcept = default;
+
+    // Equivalent to Canonizer.py::canonize().
+    void canonize() {
+        sort_system();
+        while (true) {
+            CanonicalSystem next = *this;
+            next.rename_variables();
+            next.sort_system();
+            if (next == *this) { return; }
+            *this = std::move(next);
+        }
+    }
+
+    // Appends a byte encoding of this system to out, in which each equation
+    // is a term count followed by the two variables of each term.
+    void encode(std::string &out) const {
+        out.push_back(static_cast<char>(num_equations()));
+        for (std::size_t k = 0; k < num_equations(); ++k) {
+            out.push_back(static_cast<char>(end(k) - begin(k)));
+            for (std::size_t i = begin(k); i < end(k); ++i) {
+                out.push_back(static_cast<char>(terms[i].first & 0xFF));
+                out.push_back(static_cast<char>(terms[i].first >> 8));
+                out.push_back(static_cast<char>(terms[i].second & 0xFF));
+                out.push_back(static_cast<char>(terms[i].second >> 8));
+            }
+        }
+    }
+
+    // Replaces this system by the one encoded by encode() in the given
+    // bytes. Returns false if the encoding is truncated.
+    bool decode(const char *data, std::size_t size) {
+        terms.clear();
+        offsets.assign(1, 0);
+        const auto byte = [&](std::size_t k) {
+            return static_cast<std::uint8_t>(data[k]);
+        };
+        if (size == 0) { return false; }
+        std::size_t pos = 1;
+        for (std::size_t k = 0; k < byte(0); ++k) {
+            if (pos >= size) { return false; }
+            const std::size_t num_terms = byte(pos++);
+            if (size - pos < 4 * num_terms) { return false; }
+            for (std::size_t i = 0; i < num_terms; ++i, pos += 4) {
+                const auto variable = [&](std::size_t k) {
+                    return static_cast<std::uint16_t>(
+                        byte(k) | (byte(k + 1) << 8)
+                    );
+                };
+                terms.push_back({variable(pos), variable(pos + 2)});
+            }
+            end_equation();
+        }
+        return pos == size;
+    }
+
+    Fingerprint fingerprint() const {
+        std::string bytes;
+        encode(bytes);
+        return fingerprint_of(bytes.data(), bytes.size());
+    }
+
+    // Equivalent to Canonizer.py::wolfram_string().
+    void write_wolfram(std::ostream &os) const {
+        const auto write_variable = [&](std::uint16_t variable) {
+            os << ((variable & CANONICAL_Q) ? "q[" : "p[")
+               << (variable & 0xFF) << "]";
+        };
+        for (std::size_t k = 0; k < num_equations(); ++k) {
+            if (k) { os << "\n"; }
+            for (std::size_t i = begin(k); i < end(k); ++i) {
+                if (i != begin(k)) { os << " + "; }
+                write_variable(terms[i].first);
+                if (terms[i].second) {
+                    os << " ";
+                    write_variable(terms[i].second);
+                }
+            }
+        }
+    }
+
+    // Parses a block of lines in the format written by write_wolfram().
+    // Returns false if the block is malformed.
+    bool parse_wolfram(const std::vector<std::string> &lines) {
+        terms.clear();
+        offsets.assign(1, 0);
+        for (const std::string &line : lines) {
+            std::size_t pos = 0;
+            CanonicalTerm term = {0, 0};
+            int num_variables = 0;
+            while (pos < line.size()) {
+                if ((line[pos] == 'p') || (line[pos] == 'q')) {
+                    const std::uint16_t label =
+                        (line[pos] == 'q') ? CANONICAL_Q : CANONICAL_P;
+                    const std::size_t close = line.find(']', pos);
+                    if ((close == std::string::npos) || (num_variables == 2)) {
+                        return false;
+                    }
+                    const int index = std::stoi(line.substr(pos + 2));
+                    if ((index <= 0) || (index > 0xFF)) { return false; }
+                    const std::uint16_t variable =
+                        label | static_cast<std::uint16_t>(index);
+                    if (num_variables++ == 0) {
+                        term.first = variable;
+                    } else {
+                        term.second = variable;
+                    }
+                    pos = close + 1;
+                } else if (line[pos] == '+') {
+                    if (num_variables == 0) { return false; }
+                    add_term(term);
+                    term = {0, 0};
+                    num_variables = 0;
+                    ++pos;
+                } else {
+                    ++pos;
+                }
+            }
+            if (num_variables == 0) { return false; }
+            add_term(term);
+            end_equation();
+        }
+        return true;
+    }
+
+}; // class CanonicalSystem
+
+
+// Collects the equations of a leaf system, i.e., those with right-hand
+// side 1, in the order in which print_leaf_system prints them.
+template <typename SYSTEM>
+CanonicalSystem canonical_system_of(const SYSTEM &system) {
+    CanonicalSystem result;
+    for (std::size_t e = 0; e < system.num_equations(); ++e) {
+        if (system.rhs.get(e) != RHS::ONE) { continue; }
+        for (std::size_t t = 0; t < system.length(e); ++t) {
+            const Term term = system.term(e, t);
+            if (term != TERM_ZERO) { result.add_term(term); }
+        }
+        result.end_equation();
+    }
+    return result;
+}
+
+
+/**
+ * A LeafDeduplicator canonizes leaf systems and remembers the fingerprints
+ * of all canonical forms it has seen, so that each canonical system is only
+ * written once across an entire run. It may be shared by several threads,
+ * which usually do not block each other (see ConcurrentFingerprintSet).
+ *
+ * Two systems are considered equal if their 128-bit fingerprints agree. For
+ * the number of systems encountered in practice, the probability that this
+ * discards a genuinely new system is negligible (below 2^-64).
+ */
+class LeafDeduplicator {
+
+    ConcurrentFingerprintSet fingerprints;
+    std::atomic<std::uint64_t> num_leaves;
+
+public:
+
+    explicit LeafDeduplicator(
+        const std::filesystem::path &spill_dir, std::size_t memory_budget
+    )
+        : fingerprints(spill_dir, memory_budget)
+        , num_leaves(0) {}
+
+    // Returns true if the canonical form of system has not been seen before.
+    bool insert(const CanonicalSystem &system) {
+        num_leaves.fetch_add(1, std::memory_order_relaxed);
+        return fingerprints.insert(system.fingerprint());
+    }
+
+    // Records every system in a file previously written in the format of
+    // Canonizer.py, so that they are not written again. Returns false if the
+    // file cannot be read or contains a malformed block.
+    bool seed_from_file(const std::filesystem::path &path) {
+        std::ifstream file(path);
+        if (!file) { return false; }
+        std::vector<std::string> block;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty()) {
+                block.push_back(line);
+                continue;
+            }
+            if (block.empty()) { continue; }
+            CanonicalSystem system;
+            if (!system.parse_wolfram(block)) { return false; }
+            fingerprints.insert(system.fingerprint());
+            block.clear();
+        }
+        return block.empty();
+    }
+
+    std::uint64_t leaves_seen() const noexcept {
+        return num_leaves.load(std::memory_order_relaxed);
+    }
+    std::size_t unique_systems() const noexcept { return fingerprints.size(); }
+
+    // Returns true if fingerprints could not be spilled to or read from disk,
+    // in which case some unique systems may have been dropped.
+    bool failed() const noexcept { return fingerprints.failed(); }
+
+}; // class LeafDeduplicator
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_CANONIZER_HPP_INCLUDED
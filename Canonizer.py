@@ -2,9 +2,10 @@
 
 import os
 from collections.abc import Iterator
-from sys import stderr
+from sys import argv, exit, stderr
 
-from ParallelSolver import data_file_path, degree_pair_iterator
+from LeafFormat import BinaryTerm, leaf_records
+from ParallelSolver import binary_data_file_path, data_file_path, degree_pair_iterator
 
 
 def line_block_iterator(path: str) -> Iterator[list[str]]:
@@ -30,7 +31,10 @@ def line_block_iterator(path: str) -> Iterator[list[str]]:
 
 def data_files_available(degree: int) -> bool:
     for m, n in degree_pair_iterator(degree):
-        if not os.path.isfile(data_file_path(m, n)):
+        if not (
+            os.path.isfile(binary_data_file_path(m, n))
+            or os.path.isfile(data_file_path(m, n))
+        ):
             return False
     return True
 
@@ -47,6 +51,29 @@ Polynomial = tuple[Term, ...]
 System = tuple[Polynomial, ...]
 
 
+def convert_term(term: BinaryTerm) -> Term:
+    p_index, q_index = term
+    result: list[Variable] = []
+    if p_index:
+        result.append(("p", p_index))
+    if q_index:
+        result.append(("q", q_index))
+    return tuple(result)
+
+
+def binary_system_iterator(path: str) -> Iterator[System]:
+    """
+    Read the leaf systems in a binary leaf file directly into the
+    representation produced by parse_system, without formatting them as text.
+    """
+    for record in leaf_records(path):
+        assert not record.free_variables
+        yield tuple(
+            tuple(convert_term(term) for term in terms)
+            for terms in record.equation_terms()
+        )
+
+
 def parse_variable(var: str) -> Variable:
     return (var[0], int(var[1:]))
 
@@ -93,6 +120,21 @@ def rename_variables(system: System) -> System:
     )
 
 
+def system_iterator(degree: int) -> Iterator[System]:
+    """
+    Return an iterator over all leaf systems of the given degree, reading the
+    binary data file for each (m, n) if it exists and the text file otherwise.
+    """
+    assert data_files_available(degree)
+    for m, n in degree_pair_iterator(degree):
+        binary_path = binary_data_file_path(m, n)
+        if os.path.isfile(binary_path):
+            yield from binary_system_iterator(binary_path)
+        else:
+            for block in line_block_iterator(data_file_path(m, n)):
+                yield parse_system(block)
+
+
 def canonize(system: System) -> System:
     system = sorted_system(system)
     while True:
@@ -118,6 +160,17 @@ def output_data_file_path(degree: int) -> str:
 
 
 def main():
+    # With --store DIR, every canonical system that the result store in DIR
+    # does not know yet is recorded there as unverified (see ResultStore.py).
+    store = None
+    if len(argv) == 3 and argv[1] == "--store":
+        from ResultStore import UNVERIFIED, ResultStore, fingerprint
+
+        store = ResultStore(argv[2])
+    elif len(argv) != 1:
+        print("Usage: Canonizer.py [--store DIR]", file=stderr)
+        exit(1)
+
     max_degree = 0
     while data_files_available(max_degree):
         max_degree += 1
@@ -128,14 +181,20 @@ def main():
     for degree in range(max_degree + 1):
         print(f"Processing data files of degree {degree}.", file=stderr)
         with open(output_data_file_path(degree), "w") as file:
-            for block in equation_block_iterator(degree):
-                system = canonize(parse_system(block))
+            for system in system_iterator(degree):
+                system = canonize(system)
                 if system in canonized_systems:
                     canonized_systems[system] += 1
                 else:
                     canonized_systems[system] = 1
                     file.write(wolfram_string(system))
                     file.write("\n\n")
+                    if store is not None:
+                        system_fingerprint = fingerprint(system)
+                        if store.status(system_fingerprint) is None:
+                            store.set_status(system_fingerprint, UNVERIFIED)
+    if store is not None:
+        store.flush()
 
 
 if __name__ == "__main__":
@@ -0,0 +1,87 @@
+#ifndef ZERO_ONE_SOLVER_CASE_ENUMERATOR_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_CASE_ENUMERATOR_HPP_INCLUDED
+
+#include <bit>     // for std::bit_width
+#include <cassert> // for assert
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <vector>  // for std::vector
+
+#include "Trail.hpp"
+#include "ZeroOneSolver.hpp"
+
+namespace ZeroOneSolver {
+
+
+/**
+ * A CaseEnumerator produces the root system of each case, as built by
+ * set_case(), incrementally from the root system of the previous case.
+ *
+ * The choices selected by the bits of a case index are applied from the
+ * most significant bit down, and a trail mark is taken before each one.
+ * To move to another case, only the choices below its highest bit that
+ * differs from the previous case are undone and reapplied. For consecutive
+ * case indices, this is 2 choices on average, rather than the M - 1 choices
+ * made by set_case(), while still visiting cases in increasing order, which
+ * the output format relies on. Any other order of cases also works, e.g.,
+ * the interleaved order in which the workers of a ParallelAnalyzer claim
+ * them, albeit with less sharing.
+ *
+ * A CaseEnumerator cannot be copied or moved, since its trail refers to
+ * the address of the system it modifies.
+ */
+template <typename SYSTEM>
+class CaseEnumerator {
+
+    SYSTEM system;
+    Trail<SYSTEM> trail;
+    // marks[k] is the position on the trail before the choice for bit
+    // M - 2 - k, i.e., p_{M - 1 - k}, was applied.
+    std::vector<std::size_t> marks;
+    std::uint64_t current_case;
+    bool has_case;
+
+public:
+
+    explicit CaseEnumerator(const typename SYSTEM::shape_type &shape)
+        : system(shape)
+        , trail(system)
+        , marks(static_cast<std::size_t>(shape.m() - 1), 0)
+        , current_case(0)
+        , has_case(false) {
+        system.set_case_base();
+    }
+
+    CaseEnumerator(const CaseEnumerator &) = delete;
+    CaseEnumerator &operator=(const CaseEnumerator &) = delete;
+
+    // Returns a reference to the root system of the given case, which
+    // remains valid until the next call.
+    const SYSTEM &root(std::uint64_t case_index) {
+        const std::size_t num_choices = marks.size();
+        assert(static_cast<std::size_t>(std::bit_width(case_index)) <=
+               num_choices);
+        std::size_t level = 0;
+        if (has_case) {
+            const std::uint64_t diff = case_index ^ current_case;
+            if (diff == 0) { return system; }
+            level = num_choices -
+                    static_cast<std::size_t>(std::bit_width(diff));
+            trail.undo(system, marks[level]);
+        }
+        for (std::size_t k = level; k < num_choices; ++k) {
+            marks[k] = trail.mark();
+            const var_index_t i = static_cast<var_index_t>(num_choices - k);
+            system.set_case_choice(i, (case_index >> (i - 1)) & 1, trail);
+        }
+        current_case = case_index;
+        has_case = true;
+        return system;
+    }
+
+}; // class CaseEnumerator<SYSTEM>
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_CASE_ENUMERATOR_HPP_INCLUDED
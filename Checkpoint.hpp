@@ -0,0 +1,170 @@
+#ifndef ZERO_ONE_SOLVER_CHECKPOINT_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_CHECKPOINT_HPP_INCLUDED
+
+#include <cstddef>     // for std::size_t
+#include <cstdint>     // for std::uint8_t, std::uint32_t, std::uint64_t
+#include <cstring>     // for std::memcmp, std::memcpy
+#include <filesystem>  // for std::filesystem
+#include <fstream>     // for std::ifstream, std::ofstream
+#include <type_traits> // for std::is_trivially_copyable_v
+#include <vector>      // for std::vector
+
+#include "LeafFormat.hpp"
+#include "ResultStore.hpp"
+
+namespace ZeroOneSolver {
+
+
+/**
+ * A checkpoint records the progress of a long-running search over the cases
+ * of a single (M, N) pair, so that it can be resumed after an interruption
+ * without losing or duplicating any leaf systems. It consists of:
+ *
+ *   1. the size of the output file at the time the checkpoint was taken,
+ *      after all leaf systems found so far were written and synced to disk;
+ *   2. the index of the next case that has not been started yet, so that
+ *      cases [begin_case, next_case) have been started and cases
+ *      [next_case, end_case) have not; and
+ *   3. every node of the started cases that has not been explored, i.e.,
+ *      the combined pending DFS stacks of all workers.
+ *
+ * The symmetry mode is recorded because it changes which cases are solved.
+ * Pending nodes are stored as raw bytes, which is only meaningful to a
+ * solver built with the same system layout and capacity bucket (this is
+ * checked using system_size). The shape is not stored, and is reattached
+ * to each node when the checkpoint is read.
+ */
+struct CheckpointHeader {
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint8_t m;
+    std::uint8_t n;
+    std::uint8_t format;
+    std::uint8_t symmetry;
+    std::uint64_t system_size;
+    std::uint64_t output_size;
+    std::uint64_t begin_case;
+    std::uint64_t end_case;
+    std::uint64_t next_case;
+    std::uint64_t num_pending;
+
+}; // struct CheckpointHeader
+
+
+static_assert(sizeof(CheckpointHeader) == 64);
+
+constexpr char CHECKPOINT_MAGIC[8] = {'Z', 'O', 'C', 'K', 'P', 'T', '\r', '\n'};
+constexpr std::uint32_t CHECKPOINT_VERSION = 1;
+
+
+template <typename SYSTEM>
+struct Checkpoint {
+
+    std::uint64_t output_size;
+    std::uint64_t begin_case;
+    std::uint64_t end_case;
+    std::uint64_t next_case;
+    bool break_symmetry;
+    std::vector<SYSTEM> pending;
+
+}; // struct Checkpoint<SYSTEM>
+
+
+// Reads only the header of a checkpoint, which does not require knowing the
+// system layout. Returns false if path does not contain a valid checkpoint.
+inline bool read_checkpoint_header(
+    const std::filesystem::path &path, CheckpointHeader &header
+) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+        return false;
+    }
+    return (std::memcmp(header.magic, CHECKPOINT_MAGIC, 8) == 0) &&
+           (header.version == CHECKPOINT_VERSION);
+}
+
+
+// Atomically replaces the checkpoint at path, by writing and syncing a
+// temporary file before renaming it over the previous checkpoint.
+template <typename SYSTEM>
+bool write_checkpoint(
+    const std::filesystem::path &path,
+    const typename SYSTEM::shape_type &shape,
+    LeafFormat format,
+    const Checkpoint<SYSTEM> &checkpoint
+) {
+    static_assert(std::is_trivially_copyable_v<SYSTEM>);
+    CheckpointHeader header = {};
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = CHECKPOINT_VERSION;
+    header.m = static_cast<std::uint8_t>(shape.m());
+    header.n = static_cast<std::uint8_t>(shape.n());
+    header.format = static_cast<std::uint8_t>(format);
+    header.symmetry = checkpoint.break_symmetry ? 1 : 0;
+    header.system_size = sizeof(SYSTEM);
+    header.output_size = checkpoint.output_size;
+    header.begin_case = checkpoint.begin_case;
+    header.end_case = checkpoint.end_case;
+    header.next_case = checkpoint.next_case;
+    header.num_pending = checkpoint.pending.size();
+    std::filesystem::path temp_path = path;
+    temp_path += ".temp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(
+            reinterpret_cast<const char *>(checkpoint.pending.data()),
+            static_cast<std::streamsize>(
+                checkpoint.pending.size() * sizeof(SYSTEM)
+            )
+        );
+        if (!file.flush()) { return false; }
+    }
+    if (!sync_file(temp_path)) { return false; }
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    return !error;
+}
+
+
+// Reads a checkpoint written by write_checkpoint() for the same shape and
+// format. Returns false if it does not exist or does not match.
+template <typename SYSTEM>
+bool read_checkpoint(
+    const std::filesystem::path &path,
+    const typename SYSTEM::shape_type &shape,
+    LeafFormat format,
+    Checkpoint<SYSTEM> &checkpoint
+) {
+    static_assert(std::is_trivially_copyable_v<SYSTEM>);
+    CheckpointHeader header;
+    if (!read_checkpoint_header(path, header)) { return false; }
+    if ((header.m != shape.m()) || (header.n != shape.n()) ||
+        (header.format != static_cast<std::uint8_t>(format)) ||
+        (header.system_size != sizeof(SYSTEM)) ||
+        (header.begin_case > header.next_case) ||
+        (header.next_case > header.end_case)) {
+        return false;
+    }
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(sizeof(header));
+    checkpoint.output_size = header.output_size;
+    checkpoint.begin_case = header.begin_case;
+    checkpoint.end_case = header.end_case;
+    checkpoint.next_case = header.next_case;
+    checkpoint.break_symmetry = (header.symmetry != 0);
+    checkpoint.pending.assign(header.num_pending, SYSTEM(shape));
+    for (SYSTEM &system : checkpoint.pending) {
+        if (!file.read(reinterpret_cast<char *>(&system), sizeof(SYSTEM))) {
+            return false;
+        }
+        system.shape = shape;
+    }
+    return true;
+}
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_CHECKPOINT_HPP_INCLUDED
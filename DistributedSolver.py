@@ -0,0 +1,388 @@
+#!/usr/bin/env python3
+"""
+Solve a single (m, n) pair on several machines by distributing ranges of
+case indices from a coordinator to any number of workers over TCP.
+
+    DistributedSolver.py coordinator M N [--port PORT] [--binary] [--trail]
+                                         [--symmetry] [--strategy NAME]
+                                         [--case-costs FILE.csv]
+    DistributedSolver.py worker HOST PORT [--threads T]
+
+Each work unit is a range of case indices, solved by a worker with
+`ZeroOneSolver --cases BEGIN:END`. Units start large and shrink as the
+remaining work decreases (guided self-scheduling), so that a slow unit near
+the end cannot hold up the whole run for long. Once every unit has been
+handed out, idle workers are given a second copy of the oldest outstanding
+unit, and whichever copy finishes first is kept. With --case-costs, units
+are sized by predicted cost rather than by number of cases, using the
+per-case node counts written by `ZeroOneSolver --case-stats` for a pair with
+the same M, which has the same cases (see CaseProfile in Scheduler.hpp).
+
+Completed units are stored in a work directory next to the data file, so a
+restarted coordinator only recomputes units that were not yet finished.
+Finally, the units are concatenated in order of case index. Since a range
+of cases produces exactly the corresponding segment of the output for all
+cases, the merged file is independent of which worker solved which unit.
+
+The protocol is unauthenticated and is only meant for use within a cluster.
+Every message is a line of JSON, and a result message is followed by the
+raw bytes of the output of the unit.
+"""
+
+import csv
+import json
+import os
+import socket
+import socketserver
+import subprocess
+import tempfile
+import threading
+from math import ceil
+from sys import argv, exit, stderr
+from time import sleep
+from typing import Any, BinaryIO
+
+from ParallelSolver import (
+    RUNTIME_EXECUTABLE_PATH,
+    binary_data_file_path,
+    compile_runtime,
+    data_file_path,
+)
+
+
+DEFAULT_PORT: int = 47011
+MIN_UNIT_SIZE: int = 16
+# Size of the header at the start of each binary leaf file (see LeafFormat.hpp).
+BINARY_HEADER_SIZE: int = 16
+
+
+def send_message(file: BinaryIO, message: dict[str, Any], data: bytes = b""):
+    file.write(json.dumps(message).encode() + b"\n")
+    file.write(data)
+    file.flush()
+
+
+def receive_message(file: BinaryIO) -> dict[str, Any] | None:
+    line = file.readline()
+    return json.loads(line) if line else None
+
+
+Unit = tuple[int, int]
+
+
+class CaseCosts:
+    """
+    Predicts the cost of ranges of cases from a --case-stats CSV file, in
+    the same way as CaseProfile::prediction() in Scheduler.hpp: node counts
+    are summed over at most MAX_BUCKETS buckets of contiguous cases, and
+    blended with a uniform cost, so that no range is predicted to be free.
+    """
+
+    MAX_BUCKETS: int = 256
+    UNIFORM_FRACTION: float = 0.1
+
+    def __init__(self, path: str, num_cases: int):
+        self.width = max(num_cases // self.MAX_BUCKETS, 1)
+        self.weights = [0.0] * (num_cases // self.width)
+        with open(path, newline="") as file:
+            for row in csv.DictReader(file):
+                case_index = int(row["case_index"])
+                if case_index >= num_cases:
+                    raise ValueError(f"{path} does not belong to this M")
+                self.weights[case_index // self.width] += int(row["nodes"])
+        total = sum(self.weights)
+        if total <= 0:
+            raise ValueError(f"{path} contains no nodes")
+        uniform = 1.0 / len(self.weights)
+        self.weights = [
+            (1.0 - self.UNIFORM_FRACTION) * weight / total
+            + self.UNIFORM_FRACTION * uniform
+            for weight in self.weights
+        ]
+
+    def density(self, case_index: int) -> float:
+        return self.weights[case_index // self.width] / self.width
+
+    def cost(self, begin: int, end: int) -> float:
+        result = 0.0
+        while begin < end:
+            next = min((begin // self.width + 1) * self.width, end)
+            result += self.density(begin) * (next - begin)
+            begin = next
+        return result
+
+    def advance(self, begin: int, end: int, target: float) -> int:
+        """
+        Return the least position in [begin, end] such that the cases in
+        [begin, position) cost at least target, or end if there is none.
+        """
+        while begin < end:
+            next = min((begin // self.width + 1) * self.width, end)
+            bucket_cost = self.density(begin) * (next - begin)
+            if bucket_cost >= target:
+                return min(begin + ceil(target / self.density(begin)), next)
+            target -= bucket_cost
+            begin = next
+        return end
+
+
+class Coordinator:
+    """
+    Tracks which units of the case range [0, 2^(m-1)) are unassigned,
+    outstanding, or complete. All methods are called with self.lock held.
+    """
+
+    def __init__(
+        self,
+        m: int,
+        n: int,
+        flags: list[str],
+        work_dir: str,
+        costs: CaseCosts | None = None,
+    ):
+        self.m = m
+        self.n = n
+        self.flags = flags
+        self.costs = costs
+        self.work_dir = work_dir
+        self.num_cases = 1 << (m - 1)
+        self.lock = threading.Lock()
+        self.finished = threading.Event()
+        self.num_workers = 0
+        self.complete: set[Unit] = set()
+        self.outstanding: dict[Unit, int] = {}
+        os.makedirs(work_dir, exist_ok=True)
+        for name in os.listdir(work_dir):
+            if name.startswith("cases-") and name.endswith(".part"):
+                begin, end = name[6:-5].split("-")
+                self.complete.add((int(begin), int(end)))
+        # Unassigned ranges are the complement of the complete units.
+        self.unassigned: list[Unit] = []
+        position = 0
+        for begin, end in sorted(self.complete):
+            if position < begin:
+                self.unassigned.append((position, begin))
+            position = end
+        if position < self.num_cases:
+            self.unassigned.append((position, self.num_cases))
+
+    def part_path(self, unit: Unit) -> str:
+        return os.path.join(self.work_dir, f"cases-{unit[0]:020}-{unit[1]:020}.part")
+
+    def next_unit(self) -> Unit | None:
+        if self.unassigned:
+            begin, end = self.unassigned[0]
+            num_shares = 4 * max(self.num_workers, 1)
+            if self.costs is None:
+                remaining = sum(e - b for b, e in self.unassigned)
+                unit_end = begin + max(MIN_UNIT_SIZE, remaining // num_shares)
+            else:
+                remaining_cost = sum(self.costs.cost(b, e) for b, e in self.unassigned)
+                unit_end = max(
+                    begin + MIN_UNIT_SIZE,
+                    self.costs.advance(begin, end, remaining_cost / num_shares),
+                )
+            unit = (begin, min(end, unit_end))
+            if unit[1] == end:
+                del self.unassigned[0]
+            else:
+                self.unassigned[0] = (unit[1], end)
+            self.outstanding[unit] = 1
+            return unit
+        # Every unit has been handed out. Duplicate the oldest outstanding
+        # unit that is only being solved by a single worker, if any.
+        for unit in sorted(self.outstanding):
+            if self.outstanding[unit] == 1 and unit not in self.complete:
+                self.outstanding[unit] += 1
+                return unit
+        return None
+
+    def abandon(self, unit: Unit):
+        self.outstanding[unit] -= 1
+        if self.outstanding[unit] == 0:
+            del self.outstanding[unit]
+            if unit not in self.complete:
+                self.unassigned.append(unit)
+                self.unassigned.sort()
+
+    def finish_unit(self, unit: Unit, data: bytes):
+        if unit not in self.complete:
+            path = self.part_path(unit)
+            with open(path + ".temp", "wb") as file:
+                file.write(data)
+            os.rename(path + ".temp", path)
+            self.complete.add(unit)
+            print(f"Finished cases {unit[0]}:{unit[1]}.", file=stderr)
+        self.abandon(unit)
+        if not self.unassigned and self.complete.issuperset(self.outstanding):
+            self.finished.set()
+
+    def merge(self, output_path: str):
+        """
+        Concatenate the complete units in order of case index.
+        """
+        binary = "--binary" in self.flags
+        position = 0
+        for begin, end in sorted(self.complete):
+            assert begin == position
+            position = end
+        assert position == self.num_cases
+        temp_path = output_path + ".temp"
+        with open(temp_path, "wb") as output:
+            for k, unit in enumerate(sorted(self.complete)):
+                with open(self.part_path(unit), "rb") as part:
+                    if binary and k > 0:
+                        part.seek(BINARY_HEADER_SIZE)
+                    output.write(part.read())
+        os.rename(temp_path, output_path)
+        for unit in self.complete:
+            os.remove(self.part_path(unit))
+        os.rmdir(self.work_dir)
+
+
+class CoordinatorHandler(socketserver.StreamRequestHandler):
+
+    def handle(self):
+        coordinator: Coordinator = self.server.coordinator  # type: ignore
+        unit: Unit | None = None
+        with coordinator.lock:
+            coordinator.num_workers += 1
+        try:
+            while True:
+                request = receive_message(self.rfile)
+                if request is None:
+                    return
+                if request["type"] == "result" and unit is not None:
+                    data = self.rfile.read(request["size"])
+                    if len(data) != request["size"]:
+                        return
+                    with coordinator.lock:
+                        coordinator.finish_unit(unit, data)
+                    unit = None
+                with coordinator.lock:
+                    if coordinator.finished.is_set():
+                        send_message(self.wfile, {"type": "done"})
+                        return
+                    unit = coordinator.next_unit()
+                if unit is None:
+                    send_message(self.wfile, {"type": "wait"})
+                else:
+                    send_message(
+                        self.wfile,
+                        {
+                            "type": "unit",
+                            "m": coordinator.m,
+                            "n": coordinator.n,
+                            "begin": unit[0],
+                            "end": unit[1],
+                            "flags": coordinator.flags,
+                        },
+                    )
+        finally:
+            with coordinator.lock:
+                coordinator.num_workers -= 1
+                if unit is not None:
+                    coordinator.abandon(unit)
+
+
+class CoordinatorServer(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+
+def run_coordinator(
+    m: int, n: int, port: int, flags: list[str], costs: CaseCosts | None
+):
+    output_path = (
+        binary_data_file_path(m, n) if "--binary" in flags else data_file_path(m, n)
+    )
+    if os.path.isfile(output_path):
+        print(output_path, "already computed.", file=stderr)
+        return
+    coordinator = Coordinator(m, n, flags, output_path + ".parts", costs)
+    if not coordinator.unassigned:
+        coordinator.finished.set()
+    with CoordinatorServer(("", port), CoordinatorHandler) as server:
+        server.coordinator = coordinator  # type: ignore
+        thread = threading.Thread(target=server.serve_forever, daemon=True)
+        thread.start()
+        print(f"Coordinating {output_path} on port {port}.", file=stderr)
+        coordinator.finished.wait()
+        # Give connected workers a chance to receive their "done" message.
+        sleep(1.0)
+        server.shutdown()
+    coordinator.merge(output_path)
+    print("Finished computing", output_path + ".", file=stderr)
+
+
+def run_worker(host: str, port: int, num_threads: int):
+    if not os.path.isfile(RUNTIME_EXECUTABLE_PATH):
+        os.makedirs(os.path.dirname(RUNTIME_EXECUTABLE_PATH), exist_ok=True)
+        compile_runtime(RUNTIME_EXECUTABLE_PATH)
+    with socket.create_connection((host, port)) as sock:
+        file = sock.makefile("rwb")
+        send_message(file, {"type": "request"})
+        while True:
+            message = receive_message(file)
+            if message is None or message["type"] == "done":
+                return
+            if message["type"] == "wait":
+                sleep(1.0)
+                send_message(file, {"type": "request"})
+                continue
+            begin, end = message["begin"], message["end"]
+            print(f"Solving cases {begin}:{end}.", file=stderr)
+            with tempfile.TemporaryDirectory() as temp_dir:
+                output_path = os.path.join(temp_dir, "output")
+                subprocess.run(
+                    [
+                        RUNTIME_EXECUTABLE_PATH,
+                        *("--m", str(message["m"]), "--n", str(message["n"])),
+                        *("--cases", f"{begin}:{end}"),
+                        *("--threads", str(num_threads)),
+                        *message["flags"],
+                        *("--output", output_path),
+                    ],
+                    check=True,
+                )
+                with open(output_path, "rb") as output:
+                    data = output.read()
+            send_message(file, {"type": "result", "size": len(data)}, data)
+
+
+def main():
+    if len(argv) >= 4 and argv[1] == "coordinator":
+        m, n = int(argv[2]), int(argv[3])
+        port = DEFAULT_PORT
+        flags: list[str] = []
+        costs: CaseCosts | None = None
+        args = argv[4:]
+        while args:
+            if args[0] == "--port" and len(args) > 1:
+                port = int(args[1])
+                args = args[2:]
+            elif args[0] == "--case-costs" and len(args) > 1:
+                costs = CaseCosts(args[1], 1 << (m - 1))
+                args = args[2:]
+            elif args[0] == "--strategy" and len(args) > 1:
+                flags.extend(args[:2])
+                args = args[2:]
+            elif args[0] in ("--binary", "--trail", "--symmetry"):
+                flags.append(args[0])
+                args = args[1:]
+            else:
+                break
+        if not args:
+            return run_coordinator(m, n, port, flags, costs)
+    elif len(argv) >= 4 and argv[1] == "worker":
+        num_threads = 1
+        if len(argv) == 6 and argv[4] == "--threads":
+            num_threads = int(argv[5])
+        if len(argv) in (4, 6):
+            return run_worker(argv[2], int(argv[3]), num_threads)
+    print(__doc__, file=stderr)
+    exit(1)
+
+
+if __name__ == "__main__":
+    main()
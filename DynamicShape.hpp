@@ -0,0 +1,122 @@
+#ifndef ZERO_ONE_SOLVER_DYNAMIC_SHAPE_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_DYNAMIC_SHAPE_HPP_INCLUDED
+
+#include <cassert> // for assert
+#include <cstddef> // for std::size_t
+#include <map>     // for std::map
+#include <memory>  // for std::unique_ptr, std::make_unique
+#include <mutex>   // for std::mutex, std::lock_guard
+#include <utility> // for std::pair
+
+#include "BitsetSystem.hpp"
+#include "ZeroOneSolver.hpp"
+
+namespace ZeroOneSolver {
+
+
+template <std::size_t MAX_DEGREE>
+struct DynamicPatterns;
+
+
+/**
+ * A DynamicShape selects the dimensions (M, N) of a system at runtime, for
+ * any 0 < M < N with M + N <= MAX_DEGREE. Systems of this shape are sized
+ * for the largest dimensions in their capacity bucket, but all loops only
+ * visit the equations and term slots that are actually in use, so a single
+ * binary compiled for a few buckets can solve every (M, N) pair.
+ *
+ * The patterns for each (M, N) are built on first use and shared by all
+ * systems of that shape, which only store a pointer to them.
+ */
+template <std::size_t MAX_DEGREE>
+class DynamicShape {
+
+    static_assert(MAX_DEGREE >= 3);
+
+    const DynamicPatterns<MAX_DEGREE> *patterns;
+    var_index_t m_value;
+    var_index_t n_value;
+
+public:
+
+    static constexpr std::size_t MAX_M = (MAX_DEGREE - 1) / 2;
+    static constexpr std::size_t MAX_N = MAX_DEGREE - 1;
+    static constexpr std::size_t MAX_EQUATIONS = MAX_DEGREE - 1;
+
+    static constexpr bool fits(int m, int n) noexcept {
+        return (0 < m) && (m < n) &&
+               (static_cast<std::size_t>(m + n) <= MAX_DEGREE);
+    }
+
+    DynamicShape(int m, int n);
+
+    constexpr var_index_t m() const noexcept { return m_value; }
+    constexpr var_index_t n() const noexcept { return n_value; }
+    constexpr std::size_t num_equations() const noexcept {
+        return static_cast<std::size_t>(m_value + n_value - 1);
+    }
+    constexpr std::size_t num_slots() const noexcept {
+        return static_cast<std::size_t>(m_value + 1);
+    }
+
+    const SystemPattern<DynamicShape> &pattern() const noexcept;
+    const BitsetPattern<DynamicShape> &bitset_pattern() const noexcept;
+
+}; // class DynamicShape<MAX_DEGREE>
+
+
+template <std::size_t MAX_DEGREE>
+struct DynamicPatterns {
+
+    SystemPattern<DynamicShape<MAX_DEGREE>> system;
+    BitsetPattern<DynamicShape<MAX_DEGREE>> bitset;
+
+    DynamicPatterns(int m, int n)
+        : system(make_system_pattern<DynamicShape<MAX_DEGREE>>(m, n))
+        , bitset(make_bitset_pattern(system)) {}
+
+}; // struct DynamicPatterns<MAX_DEGREE>
+
+
+template <std::size_t MAX_DEGREE>
+DynamicShape<MAX_DEGREE>::DynamicShape(int m, int n)
+    : patterns(nullptr)
+    , m_value(static_cast<var_index_t>(m))
+    , n_value(static_cast<var_index_t>(n)) {
+    assert(fits(m, n));
+    static std::mutex mutex;
+    static std::map<
+        std::pair<int, int>,
+        std::unique_ptr<const DynamicPatterns<MAX_DEGREE>>>
+        cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &entry = cache[{m, n}];
+    if (!entry) { entry = std::make_unique<DynamicPatterns<MAX_DEGREE>>(m, n); }
+    patterns = entry.get();
+}
+
+
+template <std::size_t MAX_DEGREE>
+const SystemPattern<DynamicShape<MAX_DEGREE>> &
+DynamicShape<MAX_DEGREE>::pattern() const noexcept {
+    return patterns->system;
+}
+
+
+template <std::size_t MAX_DEGREE>
+const BitsetPattern<DynamicShape<MAX_DEGREE>> &
+DynamicShape<MAX_DEGREE>::bitset_pattern() const noexcept {
+    return patterns->bitset;
+}
+
+
+template <std::size_t MAX_DEGREE>
+const BitsetPattern<DynamicShape<MAX_DEGREE>> &
+bitset_pattern(const DynamicShape<MAX_DEGREE> &shape) noexcept {
+    return shape.bitset_pattern();
+}
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_DYNAMIC_SHAPE_HPP_INCLUDED
@@ -0,0 +1,463 @@
+#ifndef ZERO_ONE_SOLVER_FINGERPRINT_SET_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_FINGERPRINT_SET_HPP_INCLUDED
+
+#include <algorithm>     // for std::sort, std::upper_bound, std::max_element
+#include <atomic>        // for std::atomic, std::atomic_ref
+#include <bit>           // for std::bit_floor
+#include <compare>       // for operator<=>
+#include <cstddef>       // for std::size_t
+#include <cstdint>       // for std::uint8_t, std::uint64_t
+#include <cstdio>        // for std::FILE, std::fopen, std::fread, std::fseek
+#include <cstdlib>       // for std::calloc, std::free
+#include <cstring>       // for std::memcpy
+#include <filesystem>    // for std::filesystem
+#include <memory>        // for std::unique_ptr
+#include <mutex>         // for std::mutex, std::lock_guard
+#include <new>           // for std::bad_alloc
+#include <string>        // for std::string, std::to_string
+#include <system_error>  // for std::error_code
+#include <unordered_set> // for std::unordered_set
+#include <vector>        // for std::vector
+
+namespace ZeroOneSolver {
+
+
+struct Fingerprint {
+
+    std::uint64_t low;
+    std::uint64_t high;
+
+    constexpr auto operator<=>(const Fingerprint &) const noexcept = default;
+
+}; // struct Fingerprint
+
+
+struct FingerprintHash {
+    std::size_t operator()(const Fingerprint &fingerprint) const noexcept {
+        return static_cast<std::size_t>(fingerprint.low);
+    }
+}; // struct FingerprintHash
+
+
+namespace Murmur3 {
+
+constexpr std::uint64_t rotl(std::uint64_t x, int r) noexcept {
+    return (x << r) | (x >> (64 - r));
+}
+
+constexpr std::uint64_t fmix(std::uint64_t k) noexcept {
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCDULL;
+    k ^= k >> 33;
+    k *= 0xC4CEB9FE1A85EC53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+} // namespace Murmur3
+
+
+// Computes the 128-bit MurmurHash3 (x64 variant) of the given bytes.
+inline Fingerprint
+fingerprint_of(const void *data, std::size_t size, std::uint64_t seed = 0) {
+    using Murmur3::fmix;
+    using Murmur3::rotl;
+    constexpr std::uint64_t C1 = 0x87C37B91114253D5ULL;
+    constexpr std::uint64_t C2 = 0x4CF5AD432745937FULL;
+    const std::uint8_t *bytes = static_cast<const std::uint8_t *>(data);
+    const std::size_t num_blocks = size / 16;
+    std::uint64_t h1 = seed;
+    std::uint64_t h2 = seed;
+    for (std::size_t i = 0; i < num_blocks; ++i) {
+        std::uint64_t k1;
+        std::uint64_t k2;
+        std::memcpy(&k1, bytes + 16 * i, 8);
+        std::memcpy(&k2, bytes + 16 * i + 8, 8);
+        k1 *= C1;
+        k1 = rotl(k1, 31);
+        k1 *= C2;
+        h1 ^= k1;
+        h1 = rotl(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52DCE729;
+        k2 *= C2;
+        k2 = rotl(k2, 33);
+        k2 *= C1;
+        h2 ^= k2;
+        h2 = rotl(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495AB5;
+    }
+    const std::uint8_t *tail = bytes + 16 * num_blocks;
+    const std::size_t tail_size = size & 15;
+    std::uint64_t k1 = 0;
+    std::uint64_t k2 = 0;
+    for (std::size_t i = tail_size; i > 0; --i) {
+        if (i > 8) {
+            k2 ^= static_cast<std::uint64_t>(tail[i - 1]) << (8 * (i - 9));
+        } else {
+            k1 ^= static_cast<std::uint64_t>(tail[i - 1]) << (8 * (i - 1));
+        }
+    }
+    if (tail_size > 8) {
+        k2 *= C2;
+        k2 = rotl(k2, 33);
+        k2 *= C1;
+        h2 ^= k2;
+    }
+    if (tail_size > 0) {
+        k1 *= C1;
+        k1 = rotl(k1, 31);
+        k1 *= C2;
+        h1 ^= k1;
+    }
+    h1 ^= static_cast<std::uint64_t>(size);
+    h2 ^= static_cast<std::uint64_t>(size);
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix(h1);
+    h2 = fmix(h2);
+    h1 += h2;
+    h2 += h1;
+    return {h1, h2};
+}
+
+
+/**
+ * A FingerprintSet records which 128-bit fingerprints have been seen, using
+ * at most a fixed amount of memory for its in-memory hash tables. The set is
+ * divided into shards by fingerprint. When the in-memory entries exceed the
+ * budget, the largest shard is sorted and written to a run file in the spill
+ * directory, where later lookups find it by binary search.
+ *
+ * Each run keeps a Bloom filter (about 10 bits per entry, i.e., a 1% false
+ * positive rate) and a sparse index of every BLOCK_SIZE-th entry in memory.
+ * Hence, a lookup of a new fingerprint reads from disk only on a false
+ * positive, and otherwise reads a single block per run.
+ *
+ * If a run file cannot be written or read, failed() is true from then on.
+ * A shard that could not be spilled keeps its entries in memory, and a
+ * fingerprint whose run could not be read is reported as present, so that
+ * the answers of insert() can no longer be trusted and must be discarded.
+ */
+class FingerprintSet {
+
+    static constexpr std::size_t BLOCK_SIZE = 512;
+    static constexpr std::size_t BLOOM_BITS_PER_ENTRY = 10;
+    static constexpr int BLOOM_NUM_HASHES = 7;
+    // Approximate memory used by one entry of a std::unordered_set,
+    // including its node, bucket pointer, and allocator overhead.
+    static constexpr std::size_t ENTRY_COST = 48;
+
+    struct Run {
+        std::filesystem::path path;
+        std::FILE *file;
+        std::size_t count;
+        std::vector<Fingerprint> index;
+        std::vector<std::uint64_t> bloom;
+    }; // struct Run
+
+    struct Shard {
+        std::unordered_set<Fingerprint, FingerprintHash> entries;
+        std::vector<Run> runs;
+    }; // struct Shard
+
+    std::filesystem::path spill_dir;
+    std::size_t max_memory_entries;
+    std::vector<Shard> shards;
+    std::size_t memory_entries;
+    std::size_t spilled_entries;
+    std::size_t num_runs;
+    bool io_failed;
+
+    static std::uint64_t bloom_bit(
+        const Fingerprint &fingerprint, int k, std::size_t num_bits
+    ) noexcept {
+        const std::uint64_t h = fingerprint.low +
+                                static_cast<std::uint64_t>(k) *
+                                    (fingerprint.high | 1);
+        return h % num_bits;
+    }
+
+    bool run_contains(const Run &run, const Fingerprint &fingerprint) noexcept {
+        const std::size_t num_bits = run.bloom.size() * 64;
+        for (int k = 0; k < BLOOM_NUM_HASHES; ++k) {
+            const std::uint64_t bit = bloom_bit(fingerprint, k, num_bits);
+            if (!((run.bloom[bit >> 6] >> (bit & 63)) & 1)) { return false; }
+        }
+        const auto upper =
+            std::upper_bound(run.index.begin(), run.index.end(), fingerprint);
+        if (upper == run.index.begin()) { return false; }
+        const std::size_t block =
+            static_cast<std::size_t>(upper - run.index.begin()) - 1;
+        const std::size_t start = block * BLOCK_SIZE;
+        const std::size_t count = std::min(BLOCK_SIZE, run.count - start);
+        Fingerprint buffer[BLOCK_SIZE];
+        const long offset = static_cast<long>(start * sizeof(Fingerprint));
+        if ((std::fseek(run.file, offset, SEEK_SET) != 0) ||
+            (std::fread(buffer, sizeof(Fingerprint), count, run.file) !=
+             count)) {
+            io_failed = true;
+            return true;
+        }
+        return std::binary_search(buffer, buffer + count, fingerprint);
+    }
+
+    void spill() {
+        Shard &shard = *std::max_element(
+            shards.begin(),
+            shards.end(),
+            [](const Shard &a, const Shard &b) {
+                return a.entries.size() < b.entries.size();
+            }
+        );
+        std::vector<Fingerprint> sorted(
+            shard.entries.begin(), shard.entries.end()
+        );
+        std::sort(sorted.begin(), sorted.end());
+        Run run;
+        run.path = spill_dir / ("run-" + std::to_string(num_runs) + ".bin");
+        run.count = sorted.size();
+        std::error_code error;
+        std::filesystem::create_directories(spill_dir, error);
+        run.file = error ? nullptr
+                         : std::fopen(run.path.string().c_str(), "w+b");
+        if (!run.file) {
+            io_failed = true;
+            return;
+        }
+        if ((std::fwrite(
+                 sorted.data(), sizeof(Fingerprint), sorted.size(), run.file
+             ) != sorted.size()) ||
+            (std::fflush(run.file) != 0)) {
+            std::fclose(run.file);
+            std::filesystem::remove(run.path, error);
+            io_failed = true;
+            return;
+        }
+        ++num_runs;
+        for (std::size_t i = 0; i < sorted.size(); i += BLOCK_SIZE) {
+            run.index.push_back(sorted[i]);
+        }
+        const std::size_t num_bits = std::max<std::size_t>(
+            64, sorted.size() * BLOOM_BITS_PER_ENTRY
+        );
+        run.bloom.assign((num_bits + 63) / 64, 0);
+        for (const Fingerprint &fingerprint : sorted) {
+            for (int k = 0; k < BLOOM_NUM_HASHES; ++k) {
+                const std::uint64_t bit =
+                    bloom_bit(fingerprint, k, run.bloom.size() * 64);
+                run.bloom[bit >> 6] |= static_cast<std::uint64_t>(1)
+                                       << (bit & 63);
+            }
+        }
+        memory_entries -= sorted.size();
+        spilled_entries += sorted.size();
+        shard.entries = std::unordered_set<Fingerprint, FingerprintHash>();
+        shard.runs.push_back(std::move(run));
+    }
+
+public:
+
+    explicit FingerprintSet(
+        const std::filesystem::path &spill_directory,
+        std::size_t memory_budget,
+        std::size_t num_shards = 64
+    )
+        : spill_dir(spill_directory)
+        , max_memory_entries(std::max<std::size_t>(
+              memory_budget / ENTRY_COST, num_shards
+          ))
+        , shards(num_shards)
+        , memory_entries(0)
+        , spilled_entries(0)
+        , num_runs(0)
+        , io_failed(false) {}
+
+    FingerprintSet(const FingerprintSet &) = delete;
+    FingerprintSet &operator=(const FingerprintSet &) = delete;
+
+    ~FingerprintSet() {
+        for (Shard &shard : shards) {
+            for (Run &run : shard.runs) {
+                std::fclose(run.file);
+                std::error_code error;
+                std::filesystem::remove(run.path, error);
+            }
+        }
+    }
+
+    // Inserts fingerprint into the set, returning true
+    // if and only if it was not already present.
+    bool insert(const Fingerprint &fingerprint) {
+        Shard &shard = shards[fingerprint.high % shards.size()];
+        if (shard.entries.contains(fingerprint)) { return false; }
+        for (const Run &run : shard.runs) {
+            if (run_contains(run, fingerprint)) { return false; }
+        }
+        shard.entries.insert(fingerprint);
+        if ((++memory_entries > max_memory_entries) && !io_failed) {
+            spill();
+        }
+        return true;
+    }
+
+    std::size_t size() const noexcept {
+        return memory_entries + spilled_entries;
+    }
+
+    std::size_t spilled() const noexcept { return spilled_entries; }
+
+    bool failed() const noexcept { return io_failed; }
+
+}; // class FingerprintSet
+
+
+/**
+ * A ConcurrentFingerprintSet is a FingerprintSet that many threads may
+ * insert into at once. Fingerprints are first inserted into a fixed-size
+ * open-addressing table of 16-byte slots with linear probing, which threads
+ * update with atomic compare-and-swap instead of taking a lock. Once the
+ * table is LOAD_NUMERATOR / LOAD_DENOMINATOR full, or a probe sequence
+ * exceeds MAX_PROBES slots, new fingerprints overflow into a FingerprintSet,
+ * protected by a mutex, which spills to disk when it exhausts its own share
+ * of the memory budget.
+ *
+ * A slot is claimed by changing its high word from EMPTY to BUSY, after
+ * which its low word and then its high word are stored. Threads that find
+ * a BUSY slot wait for these two stores. Slots are never emptied, so every
+ * probe for a given fingerprint visits the same slots in the same states,
+ * except that EMPTY slots may be claimed. Once the table is full, the first
+ * EMPTY slot reached by a probe is changed to CLOSED, which ends every later
+ * probe through it, so that two threads that insert the same fingerprint
+ * either meet in the table or both overflow. Fingerprints whose high word
+ * equals EMPTY, BUSY, or CLOSED always overflow.
+ *
+ * The table is allocated with std::calloc, so that on most systems, its
+ * pages are only committed when first written.
+ */
+class ConcurrentFingerprintSet {
+
+    static constexpr std::uint64_t EMPTY = 0;
+    static constexpr std::uint64_t BUSY = UINT64_MAX;
+    static constexpr std::uint64_t CLOSED = UINT64_MAX - 1;
+    static constexpr std::size_t LOAD_NUMERATOR = 3;
+    static constexpr std::size_t LOAD_DENOMINATOR = 4;
+    static constexpr std::size_t MAX_PROBES = 64;
+    static constexpr std::size_t MIN_SLOTS = 1 << 10;
+
+    // Slot k occupies words[2 * k] (high) and words[2 * k + 1] (low).
+    const std::size_t mask;
+    const std::size_t max_size;
+    std::unique_ptr<std::uint64_t[], decltype(&std::free)> words;
+    std::atomic<std::size_t> table_size;
+    std::mutex overflow_mutex;
+    FingerprintSet overflow;
+
+    static std::size_t
+    num_slots(std::size_t memory_budget, std::size_t table_fraction) {
+        const std::size_t table_bytes =
+            memory_budget / LOAD_DENOMINATOR * table_fraction;
+        return std::bit_floor(
+            std::max(table_bytes / sizeof(Fingerprint), MIN_SLOTS)
+        );
+    }
+
+    std::atomic_ref<std::uint64_t> word(std::size_t index) const noexcept {
+        return std::atomic_ref<std::uint64_t>(words[index]);
+    }
+
+    enum class Probe { FOUND, INSERTED, OVERFLOW };
+
+    Probe probe(const Fingerprint &fingerprint) noexcept {
+        std::size_t slot = static_cast<std::size_t>(fingerprint.low) & mask;
+        for (std::size_t k = 0; k < MAX_PROBES; ++k) {
+            std::atomic_ref<std::uint64_t> high = word(2 * slot);
+            std::uint64_t current = high.load(std::memory_order_acquire);
+            while (current == EMPTY) {
+                const bool full =
+                    table_size.load(std::memory_order_relaxed) >= max_size;
+                if (high.compare_exchange_weak(
+                        current,
+                        full ? CLOSED : BUSY,
+                        std::memory_order_acquire
+                    )) {
+                    if (full) { return Probe::OVERFLOW; }
+                    table_size.fetch_add(1, std::memory_order_relaxed);
+                    word(2 * slot + 1)
+                        .store(fingerprint.low, std::memory_order_relaxed);
+                    high.store(fingerprint.high, std::memory_order_release);
+                    return Probe::INSERTED;
+                }
+            }
+            while (current == BUSY) {
+                current = high.load(std::memory_order_acquire);
+            }
+            if (current == CLOSED) { return Probe::OVERFLOW; }
+            if ((current == fingerprint.high) &&
+                (word(2 * slot + 1).load(std::memory_order_relaxed) ==
+                 fingerprint.low)) {
+                return Probe::FOUND;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return Probe::OVERFLOW;
+    }
+
+public:
+
+    // Three quarters of memory_budget are used for the table, and the rest
+    // for the in-memory entries of the overflow set.
+    explicit ConcurrentFingerprintSet(
+        const std::filesystem::path &spill_directory,
+        std::size_t memory_budget
+    )
+        : mask(num_slots(memory_budget, 3) - 1)
+        , max_size((mask + 1) / LOAD_DENOMINATOR * LOAD_NUMERATOR)
+        , words(
+              static_cast<std::uint64_t *>(
+                  std::calloc(2 * (mask + 1), sizeof(std::uint64_t))
+              ),
+              &std::free
+          )
+        , table_size(0)
+        , overflow_mutex()
+        , overflow(spill_directory, memory_budget / LOAD_DENOMINATOR) {
+        static_assert(std::atomic_ref<std::uint64_t>::is_always_lock_free);
+        if (!words) { throw std::bad_alloc(); }
+    }
+
+    ConcurrentFingerprintSet(const ConcurrentFingerprintSet &) = delete;
+    ConcurrentFingerprintSet &
+    operator=(const ConcurrentFingerprintSet &) = delete;
+
+    // Inserts fingerprint into the set, returning true
+    // if and only if it was not already present.
+    bool insert(const Fingerprint &fingerprint) {
+        if ((fingerprint.high != EMPTY) && (fingerprint.high != BUSY) &&
+            (fingerprint.high != CLOSED)) {
+            const Probe result = probe(fingerprint);
+            if (result != Probe::OVERFLOW) {
+                return (result == Probe::INSERTED);
+            }
+        }
+        std::lock_guard<std::mutex> lock(overflow_mutex);
+        return overflow.insert(fingerprint);
+    }
+
+    // Not synchronized with concurrent calls to insert().
+    std::size_t size() const noexcept {
+        return table_size.load(std::memory_order_relaxed) + overflow.size();
+    }
+
+    std::size_t spilled() const noexcept { return overflow.spilled(); }
+
+    // Not synchronized with concurrent calls to insert().
+    bool failed() const noexcept { return overflow.failed(); }
+
+}; // class ConcurrentFingerprintSet
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_FINGERPRINT_SET_HPP_INCLUDED
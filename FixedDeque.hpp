@@ -0,0 +1,123 @@
+#ifndef ZERO_ONE_SOLVER_FIXED_DEQUE_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_FIXED_DEQUE_HPP_INCLUDED
+
+#include <algorithm> // for std::min
+#include <cassert>   // for assert
+#include <cstddef>   // for std::size_t, std::ptrdiff_t
+#include <vector>    // for std::vector
+
+namespace ZeroOneSolver {
+
+
+// Every child of a case split has strictly fewer variables that are not
+// fixed plus equations with right-hand side ZERO_OR_ONE than its parent,
+// since neither kind of value is ever unfixed. Hence, the depth of the
+// search tree below an initial system is at most (M - 1) + (N - 1) +
+// (M + N - 1), and a depth-first search of it, which keeps at most
+// MAX_CHILDREN - 1 untried siblings of each node on the current path
+// besides the node itself, never holds more than max_pending_nodes().
+constexpr std::size_t MAX_CHILDREN = 3;
+
+constexpr std::size_t max_search_depth(std::size_t m, std::size_t n) noexcept {
+    return 2 * (m + n) - 3;
+}
+
+constexpr std::size_t
+max_pending_nodes(std::size_t m, std::size_t n) noexcept {
+    return (MAX_CHILDREN - 1) * max_search_depth(m, n) + 1;
+}
+
+
+/**
+ * A FixedDeque is a double-ended queue of trivially copyable search nodes
+ * in a ring buffer of fixed capacity. All of its slots are constructed and
+ * touched once, when it is created, so that pushing and popping nodes in
+ * the search loop never allocates or faults in a page. It is used as the
+ * depth-first search stack, which is reused across cases, and inside each
+ * WorkStealingDeque, whose capacity is computed by max_pending_nodes().
+ */
+template <typename T>
+class FixedDeque {
+
+    std::vector<T> slots;
+    std::size_t head;
+    std::size_t count;
+
+    std::size_t slot(std::size_t index) const noexcept {
+        const std::size_t result = head + index;
+        return (result < slots.size()) ? result : result - slots.size();
+    }
+
+public:
+
+    FixedDeque() noexcept
+        : slots()
+        , head(0)
+        , count(0) {}
+
+    explicit FixedDeque(std::size_t capacity, const T &prototype)
+        : slots(capacity, prototype)
+        , head(0)
+        , count(0) {}
+
+    std::size_t capacity() const noexcept { return slots.size(); }
+    std::size_t size() const noexcept { return count; }
+    bool empty() const noexcept { return count == 0; }
+
+    T &front() noexcept {
+        assert(count > 0);
+        return slots[head];
+    }
+
+    T &back() noexcept {
+        assert(count > 0);
+        return slots[slot(count - 1)];
+    }
+
+    void push_back(const T &value) noexcept {
+        assert(count < slots.size());
+        slots[slot(count++)] = value;
+    }
+
+    void pop_back() noexcept {
+        assert(count > 0);
+        --count;
+    }
+
+    void pop_front() noexcept {
+        assert(count > 0);
+        head = slot(1);
+        --count;
+    }
+
+    void clear() noexcept {
+        head = 0;
+        count = 0;
+    }
+
+    template <typename ITERATOR>
+    void assign(ITERATOR first, ITERATOR last) noexcept {
+        clear();
+        for (; first != last; ++first) { push_back(*first); }
+    }
+
+    // Appends every node, from front to back, to the end of out.
+    void append_to(std::vector<T> &out) const {
+        const std::size_t first_part = std::min(count, slots.size() - head);
+        const auto begin = slots.begin() + static_cast<std::ptrdiff_t>(head);
+        out.insert(
+            out.end(), begin, begin + static_cast<std::ptrdiff_t>(first_part)
+        );
+        out.insert(
+            out.end(),
+            slots.begin(),
+            slots.begin() + static_cast<std::ptrdiff_t>(count - first_part)
+        );
+    }
+
+}; // class FixedDeque<T>
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_FIXED_DEQUE_HPP_INCLUDED
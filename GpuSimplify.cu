@@ -0,0 +1,411 @@
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint8_t, std::uint16_t, std::uint64_t
+#include <new>     // for std::nothrow
+#include <vector>  // for std::vector
+
+#include <cuda_runtime.h>
+
+#include "GpuSimplify.hpp"
+
+namespace ZeroOneSolver {
+
+
+// These are the underlying values of RHS and VAR in ZeroOneSolver.hpp.
+constexpr std::uint8_t GPU_RHS_ZERO_OR_ONE = 0x00;
+constexpr std::uint8_t GPU_RHS_ZERO = 0x01;
+constexpr std::uint8_t GPU_RHS_ONE = 0x02;
+constexpr std::uint8_t GPU_VAR_UNKNOWN = 0x00;
+constexpr std::uint8_t GPU_VAR_ZERO_OR_ONE = 0x01;
+constexpr std::uint8_t GPU_VAR_ZERO = 0x02;
+constexpr std::uint8_t GPU_VAR_ONE = 0x03;
+
+constexpr unsigned GPU_BLOCK_SIZE = 128;
+
+
+struct GpuSimplifier::Buffers {
+
+    GpuBatch host;
+    std::vector<std::uint64_t> host_masks;
+    std::vector<std::uint8_t> host_bytes;
+    GpuPattern *pattern;
+    std::uint64_t *masks;
+    std::uint8_t *bytes;
+
+}; // struct GpuSimplifier::Buffers
+
+
+/**
+ * A GpuNode accesses the fields of system k of a batch on the device. All
+ * rules below are transcribed from BitsetSystem::simplify(), with the same
+ * worklist order, so the two must be changed together.
+ */
+struct GpuNode {
+
+    const GpuPattern &pattern;
+    std::uint64_t *masks;
+    std::uint8_t *rhs;
+    std::uint8_t *p;
+    std::uint8_t *q;
+    std::size_t stride;
+
+    __device__ std::uint64_t &mask(std::size_t field, std::size_t e) {
+        return masks[(field * pattern.num_equations + e) * stride];
+    }
+
+    __device__ std::uint8_t &rhs_of(std::size_t e) { return rhs[e * stride]; }
+    __device__ std::uint8_t &p_of(std::size_t i) { return p[(i - 1) * stride]; }
+    __device__ std::uint8_t &q_of(std::size_t j) { return q[(j - 1) * stride]; }
+
+    __device__ void clear(std::size_t field, const std::uint64_t *bits) {
+        for (std::size_t e = 0; e < pattern.num_equations; ++e) {
+            mask(field, e) &= ~bits[e];
+        }
+    }
+
+    __device__ void set_p_zero(std::size_t i) {
+        p_of(i) = GPU_VAR_ZERO;
+        clear(GPU_LIVE, pattern.p_mask[i]);
+        clear(GPU_P_UNKNOWN, pattern.p_mask[i]);
+    }
+
+    __device__ void set_q_zero(std::size_t j) {
+        q_of(j) = GPU_VAR_ZERO;
+        clear(GPU_LIVE, pattern.q_mask[j]);
+        clear(GPU_Q_UNKNOWN, pattern.q_mask[j]);
+    }
+
+    __device__ void set_p_one(std::size_t i) {
+        p_of(i) = GPU_VAR_ONE;
+        clear(GPU_P_FACTOR, pattern.p_mask[i]);
+        clear(GPU_P_UNKNOWN, pattern.p_mask[i]);
+    }
+
+    __device__ void set_q_one(std::size_t j) {
+        q_of(j) = GPU_VAR_ONE;
+        clear(GPU_Q_FACTOR, pattern.q_mask[j]);
+        clear(GPU_Q_UNKNOWN, pattern.q_mask[j]);
+    }
+
+    __device__ unsigned set_p_zero_or_one(std::size_t i) {
+        if (p_of(i) != GPU_VAR_UNKNOWN) { return 0; }
+        p_of(i) = GPU_VAR_ZERO_OR_ONE;
+        clear(GPU_P_UNKNOWN, pattern.p_mask[i]);
+        return 1;
+    }
+
+    __device__ unsigned set_q_zero_or_one(std::size_t j) {
+        if (q_of(j) != GPU_VAR_UNKNOWN) { return 0; }
+        q_of(j) = GPU_VAR_ZERO_OR_ONE;
+        clear(GPU_Q_UNKNOWN, pattern.q_mask[j]);
+        return 1;
+    }
+
+    __device__ bool has_unknown_variable() {
+        for (std::size_t i = 1; i < pattern.m; ++i) {
+            if (p_of(i) == GPU_VAR_UNKNOWN) { return true; }
+        }
+        for (std::size_t j = 1; j < pattern.n; ++j) {
+            if (q_of(j) == GPU_VAR_UNKNOWN) { return true; }
+        }
+        return false;
+    }
+
+    __device__ std::uint64_t unknown_terms(std::size_t e) {
+        return mask(GPU_LIVE, e) &
+               (mask(GPU_P_UNKNOWN, e) | mask(GPU_Q_UNKNOWN, e));
+    }
+
+    // The indices of the factors that the term in slot t of equation e
+    // retains, packed as p_index << 8 | q_index.
+    __device__ unsigned term(std::size_t e, int t) {
+        const unsigned p_index =
+            ((mask(GPU_P_FACTOR, e) >> t) & 1) ? pattern.slot_p[e][t] : 0;
+        const unsigned q_index =
+            ((mask(GPU_Q_FACTOR, e) >> t) & 1) ? pattern.slot_q[e][t] : 0;
+        return (p_index << 8) | q_index;
+    }
+
+    __device__ bool simplify() {
+        const std::size_t num_equations = pattern.num_equations;
+        std::uint16_t items[GPU_MAX_EQUATIONS];
+        bool queued[GPU_MAX_EQUATIONS];
+        std::size_t head = 0;
+        std::size_t size = 0;
+        const auto push = [&](std::size_t e) {
+            if (queued[e]) { return; }
+            queued[e] = true;
+            items[(head + size) % num_equations] =
+                static_cast<std::uint16_t>(e);
+            ++size;
+        };
+        const auto push_p = [&](std::size_t p_index) {
+            for (std::size_t k = 0; k < pattern.p_count[p_index]; ++k) {
+                push(pattern.p_equations[p_index][k]);
+            }
+        };
+        const auto push_q = [&](std::size_t q_index) {
+            for (std::size_t k = 0; k < pattern.q_count[q_index]; ++k) {
+                push(pattern.q_equations[q_index][k]);
+            }
+        };
+        for (std::size_t e = 0; e < num_equations; ++e) {
+            queued[e] = false;
+            push(e);
+        }
+        while (size > 0) {
+            const std::size_t e = items[head];
+            head = (head + 1) % num_equations;
+            --size;
+            queued[e] = false;
+
+            // Phase 1.
+            std::uint64_t &live = mask(GPU_LIVE, e);
+            const std::uint64_t ones =
+                live & ~(mask(GPU_P_FACTOR, e) | mask(GPU_Q_FACTOR, e));
+            if (__popcll(ones) > 1) { return false; }
+            if (!live) {
+                if (rhs_of(e) == GPU_RHS_ONE) { return false; }
+                rhs_of(e) = GPU_RHS_ZERO;
+            }
+            if (ones) {
+                if (rhs_of(e) == GPU_RHS_ZERO) { return false; }
+                live &= ~ones;
+                rhs_of(e) = GPU_RHS_ZERO;
+            }
+
+            // Phase 2.
+            const std::uint8_t rhs_value = rhs_of(e);
+            if (rhs_value == GPU_RHS_ZERO) {
+                std::uint64_t p_linear =
+                    live & mask(GPU_P_FACTOR, e) & ~mask(GPU_Q_FACTOR, e);
+                std::uint64_t q_linear =
+                    live & mask(GPU_Q_FACTOR, e) & ~mask(GPU_P_FACTOR, e);
+                while (p_linear) {
+                    const int t = __ffsll(p_linear) - 1;
+                    p_linear &= p_linear - 1;
+                    const std::size_t p_index = pattern.slot_p[e][t];
+                    set_p_zero(p_index);
+                    push_p(p_index);
+                }
+                while (q_linear) {
+                    const int t = __ffsll(q_linear) - 1;
+                    q_linear &= q_linear - 1;
+                    const std::size_t q_index = pattern.slot_q[e][t];
+                    set_q_zero(q_index);
+                    push_q(q_index);
+                }
+            } else if (rhs_value == GPU_RHS_ONE) {
+                const std::uint64_t bit = live;
+                if (bit && !(bit & (bit - 1))) {
+                    const int t = __ffsll(bit) - 1;
+                    if (mask(GPU_P_FACTOR, e) & bit) {
+                        const std::size_t p_index = pattern.slot_p[e][t];
+                        set_p_one(p_index);
+                        push_p(p_index);
+                    }
+                    if (mask(GPU_Q_FACTOR, e) & bit) {
+                        const std::size_t q_index = pattern.slot_q[e][t];
+                        set_q_one(q_index);
+                        push_q(q_index);
+                    }
+                }
+            }
+        }
+
+        while (true) {
+
+            unsigned num_changes = 0;
+
+            // Phase 3.
+            for (std::size_t e = 0; e < num_equations; ++e) {
+                const std::uint64_t unknown = unknown_terms(e);
+                if (__popcll(unknown) == 1) {
+                    const unsigned t = term(e, __ffsll(unknown) - 1);
+                    if ((t & 0xFF) == 0) {
+                        num_changes += set_p_zero_or_one(t >> 8);
+                    } else if ((t >> 8) == 0) {
+                        num_changes += set_q_zero_or_one(t & 0xFF);
+                    }
+                }
+            }
+            if (!has_unknown_variable()) { return true; }
+            if (num_changes) { continue; }
+
+            // Phase 4. A lone quadratic term always has both factors, so
+            // no lone term is represented by 0, i.e., by TERM_ONE.
+            unsigned lone_quadratic_terms[GPU_MAX_EQUATIONS];
+            for (std::size_t e = 0; e < num_equations; ++e) {
+                const std::uint64_t unknown = unknown_terms(e);
+                lone_quadratic_terms[e] =
+                    (__popcll(unknown) == 1) ? term(e, __ffsll(unknown) - 1)
+                                             : 0;
+            }
+            for (std::size_t e = 0; e < num_equations; ++e) {
+                const std::uint64_t live = mask(GPU_LIVE, e);
+                if (__popcll(live) != 2) { continue; }
+                const std::uint64_t first = live & (~live + 1);
+                const unsigned x = term(e, __ffsll(first) - 1);
+                const unsigned y = term(e, __ffsll(live ^ first) - 1);
+                unsigned target = 0;
+                if (((x & 0xFF) == 0) && ((y >> 8) == 0)) {
+                    target = (x & 0xFF00) | (y & 0xFF);
+                } else if (((x >> 8) == 0) && ((y & 0xFF) == 0)) {
+                    target = (y & 0xFF00) | (x & 0xFF);
+                } else {
+                    continue;
+                }
+                for (std::size_t t = 0; t < num_equations; ++t) {
+                    if (lone_quadratic_terms[t] == target) {
+                        num_changes += set_p_zero_or_one(target >> 8);
+                        num_changes += set_q_zero_or_one(target & 0xFF);
+                        break;
+                    }
+                }
+            }
+            if (!has_unknown_variable()) { return true; }
+            if (!num_changes) { return true; }
+        }
+    }
+
+}; // struct GpuNode
+
+
+__global__ void simplify_kernel(
+    const GpuPattern *pattern,
+    std::uint64_t *masks,
+    std::uint8_t *rhs,
+    std::uint8_t *p,
+    std::uint8_t *q,
+    std::uint8_t *consistent,
+    std::size_t capacity,
+    std::size_t count
+) {
+    const std::size_t k =
+        static_cast<std::size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (k >= count) { return; }
+    GpuNode node = {*pattern, masks + k, rhs + k, p + k, q + k, capacity};
+    consistent[k] = node.simplify() ? 1 : 0;
+}
+
+
+bool GpuSimplifier::available() noexcept {
+    int num_devices = 0;
+    return (cudaGetDeviceCount(&num_devices) == cudaSuccess) &&
+           (num_devices > 0);
+}
+
+
+GpuSimplifier *GpuSimplifier::create(
+    const GpuPattern &pattern, std::size_t capacity
+) noexcept {
+    Buffers *buffers = new (std::nothrow) Buffers();
+    if (!buffers) { return nullptr; }
+    const std::size_t num_masks =
+        GPU_NUM_MASKS * pattern.num_equations * capacity;
+    // rhs, p, q, and consistent, in that order.
+    const std::size_t num_bytes =
+        (pattern.num_equations + pattern.m + pattern.n + 1) * capacity;
+    try {
+        buffers->host_masks.resize(num_masks);
+        buffers->host_bytes.resize(num_bytes);
+    } catch (...) {
+        delete buffers;
+        return nullptr;
+    }
+    std::uint8_t *bytes = buffers->host_bytes.data();
+    buffers->host = {
+        capacity,
+        0,
+        buffers->host_masks.data(),
+        bytes,
+        bytes + pattern.num_equations * capacity,
+        bytes + (pattern.num_equations + pattern.m) * capacity,
+        bytes + (pattern.num_equations + pattern.m + pattern.n) * capacity,
+    };
+    buffers->pattern = nullptr;
+    buffers->masks = nullptr;
+    buffers->bytes = nullptr;
+    if ((cudaMalloc(&buffers->pattern, sizeof(GpuPattern)) != cudaSuccess) ||
+        (cudaMalloc(&buffers->masks, num_masks * sizeof(std::uint64_t)) !=
+         cudaSuccess) ||
+        (cudaMalloc(&buffers->bytes, num_bytes) != cudaSuccess) ||
+        (cudaMemcpy(
+             buffers->pattern,
+             &pattern,
+             sizeof(GpuPattern),
+             cudaMemcpyHostToDevice
+         ) != cudaSuccess)) {
+        GpuSimplifier cleanup(buffers);
+        return nullptr;
+    }
+    return new (std::nothrow) GpuSimplifier(buffers);
+}
+
+
+GpuSimplifier::~GpuSimplifier() {
+    cudaFree(buffers->pattern);
+    cudaFree(buffers->masks);
+    cudaFree(buffers->bytes);
+    delete buffers;
+}
+
+
+GpuBatch &GpuSimplifier::batch() noexcept { return buffers->host; }
+
+
+bool GpuSimplifier::simplify() noexcept {
+    GpuBatch &host = buffers->host;
+    if (host.count == 0) { return true; }
+    // The whole batch is copied in two transfers, rather than one transfer
+    // per field for the first count systems, since it is interleaved.
+    const std::size_t mask_bytes =
+        buffers->host_masks.size() * sizeof(std::uint64_t);
+    const std::size_t num_bytes = buffers->host_bytes.size();
+    if ((cudaMemcpy(
+             buffers->masks,
+             host.masks,
+             mask_bytes,
+             cudaMemcpyHostToDevice
+         ) != cudaSuccess) ||
+        (cudaMemcpy(
+             buffers->bytes,
+             buffers->host_bytes.data(),
+             num_bytes,
+             cudaMemcpyHostToDevice
+         ) != cudaSuccess)) {
+        return false;
+    }
+    const std::size_t offset_p = static_cast<std::size_t>(host.p - host.rhs);
+    const std::size_t offset_q = static_cast<std::size_t>(host.q - host.rhs);
+    const std::size_t offset_consistent =
+        static_cast<std::size_t>(host.consistent - host.rhs);
+    const unsigned num_blocks = static_cast<unsigned>(
+        (host.count + GPU_BLOCK_SIZE - 1) / GPU_BLOCK_SIZE
+    );
+    simplify_kernel<<<num_blocks, GPU_BLOCK_SIZE>>>(
+        buffers->pattern,
+        buffers->masks,
+        buffers->bytes,
+        buffers->bytes + offset_p,
+        buffers->bytes + offset_q,
+        buffers->bytes + offset_consistent,
+        host.capacity,
+        host.count
+    );
+    return (cudaGetLastError() == cudaSuccess) &&
+           (cudaMemcpy(
+                host.masks,
+                buffers->masks,
+                mask_bytes,
+                cudaMemcpyDeviceToHost
+            ) == cudaSuccess) &&
+           (cudaMemcpy(
+                buffers->host_bytes.data(),
+                buffers->bytes,
+                num_bytes,
+                cudaMemcpyDeviceToHost
+            ) == cudaSuccess);
+}
+
+
+} // namespace ZeroOneSolver
@@ -0,0 +1,129 @@
+#ifndef ZERO_ONE_SOLVER_GPU_SIMPLIFY_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_GPU_SIMPLIFY_HPP_INCLUDED
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint8_t, std::uint16_t, std::uint64_t
+
+namespace ZeroOneSolver {
+
+
+// The largest systems that GpuSimplifier can simplify, i.e., M + 1 <= 64
+// term slots and M + N - 1 <= 127 equations, as for BitsetSystem.
+constexpr std::size_t GPU_MAX_SLOTS = 64;
+constexpr std::size_t GPU_MAX_EQUATIONS = 127;
+constexpr std::size_t GPU_MAX_VARIABLES = GPU_MAX_EQUATIONS + 1;
+
+
+/**
+ * A GpuPattern is the BitsetPattern of one (M, N) pair in a form that does
+ * not depend on the capacities of its shape, so that it can be copied to
+ * the device once and shared by every batch. Index 0 of p_mask, q_mask,
+ * p_equations, and q_equations is unused, as in SystemPattern.
+ */
+struct GpuPattern {
+
+    std::uint16_t m;
+    std::uint16_t n;
+    std::uint16_t num_equations;
+    // The indices of the p and q factors of the term in each slot.
+    std::uint8_t slot_p[GPU_MAX_EQUATIONS][GPU_MAX_SLOTS];
+    std::uint8_t slot_q[GPU_MAX_EQUATIONS][GPU_MAX_SLOTS];
+    std::uint64_t p_mask[GPU_MAX_VARIABLES][GPU_MAX_EQUATIONS];
+    std::uint64_t q_mask[GPU_MAX_VARIABLES][GPU_MAX_EQUATIONS];
+    // The equations containing each variable, in pattern order.
+    std::uint16_t p_count[GPU_MAX_VARIABLES];
+    std::uint16_t p_equations[GPU_MAX_VARIABLES][GPU_MAX_VARIABLES];
+    std::uint16_t q_count[GPU_MAX_VARIABLES];
+    std::uint16_t q_equations[GPU_MAX_VARIABLES][GPU_MAX_VARIABLES];
+
+}; // struct GpuPattern
+
+
+// The fields of a system stored by GpuBatch, in this order.
+enum GpuMask : std::size_t {
+    GPU_LIVE = 0,
+    GPU_P_FACTOR = 1,
+    GPU_Q_FACTOR = 2,
+    GPU_P_UNKNOWN = 3,
+    GPU_Q_UNKNOWN = 4,
+    GPU_NUM_MASKS = 5,
+}; // enum GpuMask
+
+
+/**
+ * A GpuBatch holds up to capacity systems in host memory, in the layout of
+ * BitsetSystem, but with the systems interleaved, so that consecutive GPU
+ * threads, which simplify consecutive systems, access consecutive words:
+ *
+ *     masks[(field * num_equations + e) * capacity + k]
+ *     rhs[e * capacity + k], p[i * capacity + k], q[j * capacity + k]
+ *
+ * are the bitmask field of equation e, the right-hand side of equation e,
+ * and the states of p_{i+1} and q_{j+1} of system k, where RHS and VAR
+ * values are stored as their underlying integers. After simplify(),
+ * consistent[k] is nonzero if system k was not refuted.
+ */
+struct GpuBatch {
+
+    std::size_t capacity;
+    std::size_t count;
+    std::uint64_t *masks;
+    std::uint8_t *rhs;
+    std::uint8_t *p;
+    std::uint8_t *q;
+    std::uint8_t *consistent;
+
+}; // struct GpuBatch
+
+
+/**
+ * A GpuSimplifier runs simplify() on batches of systems of a single (M, N)
+ * pair on a CUDA device, one system per thread, applying the same rules in
+ * the same order as BitsetSystem::simplify(), so that every system reaches
+ * the same fixed point as on the CPU. It is only available when the solver
+ * is built with -DZERO_ONE_SOLVER_CUDA and linked with GpuSimplify.cu:
+ *
+ *     nvcc -std=c++17 -O3 -c GpuSimplify.cu -o GpuSimplify.o
+ *     g++ -std=c++20 -O3 -march=native -pthread -DZERO_ONE_SOLVER_CUDA
+ *         ZeroOneSolver.cpp GpuSimplify.o -lcudart -o ZeroOneSolver
+ *
+ * This is experimental: no automated build compiles GpuSimplify.cu, so any
+ * change to it or to BitsetSystem::simplify() must be checked by building
+ * it as above and comparing the leaf systems of a run with --gpu against
+ * those of a run without it.
+ */
+class GpuSimplifier {
+
+    struct Buffers;
+    Buffers *buffers;
+
+    explicit GpuSimplifier(Buffers *device_buffers) noexcept
+        : buffers(device_buffers) {}
+
+public:
+
+    // Returns true if a CUDA device can be used.
+    static bool available() noexcept;
+
+    // Returns nullptr if the device memory could not be allocated.
+    static GpuSimplifier *
+    create(const GpuPattern &pattern, std::size_t capacity) noexcept;
+
+    GpuSimplifier(const GpuSimplifier &) = delete;
+    GpuSimplifier &operator=(const GpuSimplifier &) = delete;
+
+    ~GpuSimplifier();
+
+    // The host batch whose systems are simplified in place by simplify().
+    GpuBatch &batch() noexcept;
+
+    // Returns false if the kernel could not be run, in which case the
+    // contents of batch() are unspecified.
+    bool simplify() noexcept;
+
+}; // class GpuSimplifier
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_GPU_SIMPLIFY_HPP_INCLUDED
@@ -0,0 +1,243 @@
+#ifndef ZERO_ONE_SOLVER_INTERVAL_PREFILTER_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_INTERVAL_PREFILTER_HPP_INCLUDED
+
+#include <algorithm> // for std::copy_n, std::max, std::min
+#include <array>     // for std::array
+#include <cmath>     // for std::nextafter
+#include <cstddef>   // for std::size_t
+#include <cstdint>   // for std::uint16_t, std::uint64_t
+#include <limits>    // for std::numeric_limits
+#include <vector>    // for std::vector
+
+#include "Canonizer.hpp"
+
+namespace ZeroOneSolver {
+
+
+/**
+ * An IntervalPrefilter tries to prove that a leaf system has no real
+ * solution in which every variable lies in [0, 1], so that only the
+ * remaining systems need to be passed to CylindricalSolver.wls. Every
+ * equation of a leaf system states that a sum of variables and products of
+ * two variables equals 1, and all quantities involved are non-negative,
+ * which makes interval constraint propagation particularly effective.
+ *
+ * The prefilter performs a depth-first branch-and-bound search over boxes
+ * in [0, 1]^n. In each box, it repeatedly narrows the range of every term
+ * to the values compatible with its equation, and the range of every
+ * variable to the values compatible with its terms. A box is discarded as
+ * soon as some range becomes empty; otherwise, its widest variable is
+ * bisected. All bounds are rounded outward, so a refutation is a proof.
+ *
+ * A system is left undecided if the search exceeds its box limit or reaches
+ * a box narrower than MIN_WIDTH that it cannot discard, which usually means
+ * the box contains a genuine solution. Undecided systems are not claimed to
+ * be feasible; they must be decided exactly, e.g., by CylindricalSolver.wls.
+ */
+class IntervalPrefilter {
+
+    struct DenseTerm {
+        std::uint16_t x;
+        std::uint16_t y; // NO_VARIABLE for a linear term
+    }; // struct DenseTerm
+
+    static constexpr std::uint16_t NO_VARIABLE = 0xFFFF;
+    static constexpr double MIN_WIDTH = 0x1.0p-30;
+    // Propagation stops once no bound moves by more than MIN_PROGRESS.
+    static constexpr double MIN_PROGRESS = 0x1.0p-20;
+    static constexpr int MAX_ROUNDS = 64;
+
+    std::size_t max_boxes;
+    std::uint64_t num_boxes;
+
+    std::array<std::uint16_t, 0x200> dense_index;
+    std::vector<std::uint16_t> used_variables;
+    std::vector<DenseTerm> terms;
+    // Equation k consists of terms[offsets[k] .. offsets[k + 1] - 1].
+    std::vector<std::size_t> offsets;
+    std::vector<double> term_lo;
+    std::vector<double> term_hi;
+    // Stack of pending boxes, each stored as lo[0 .. n - 1], hi[0 .. n - 1].
+    std::vector<double> stack;
+
+    static double down(double x) noexcept {
+        return std::nextafter(x, -std::numeric_limits<double>::infinity());
+    }
+
+    static double up(double x) noexcept {
+        return std::nextafter(x, std::numeric_limits<double>::infinity());
+    }
+
+    std::uint16_t dense_variable(std::uint16_t variable) {
+        if (dense_index[variable] == NO_VARIABLE) {
+            dense_index[variable] =
+                static_cast<std::uint16_t>(used_variables.size());
+            used_variables.push_back(variable);
+        }
+        return dense_index[variable];
+    }
+
+    void load(const CanonicalSystem &system) {
+        for (std::uint16_t variable : used_variables) {
+            dense_index[variable] = NO_VARIABLE;
+        }
+        used_variables.clear();
+        terms.clear();
+        offsets.assign(1, 0);
+        system.for_each_equation(
+            [&](const CanonicalTerm *equation, std::size_t num_terms) {
+                for (std::size_t k = 0; k < num_terms; ++k) {
+                    const std::uint16_t x = dense_variable(equation[k].first);
+                    const std::uint16_t y =
+                        equation[k].is_quadratic()
+                            ? dense_variable(equation[k].second)
+                            : NO_VARIABLE;
+                    terms.push_back({x, y});
+                }
+                offsets.push_back(terms.size());
+            }
+        );
+        term_lo.resize(terms.size());
+        term_hi.resize(terms.size());
+    }
+
+    // Tightens [lo[v], hi[v]] to [new_lo, new_hi]. Returns false if the
+    // range becomes empty.
+    static bool narrow(
+        double *lo, double *hi, std::size_t v,
+        double new_lo, double new_hi, bool &progress
+    ) noexcept {
+        if (new_lo > lo[v]) {
+            if (new_lo - lo[v] > MIN_PROGRESS) { progress = true; }
+            lo[v] = new_lo;
+        }
+        if (new_hi < hi[v]) {
+            if (hi[v] - new_hi > MIN_PROGRESS) { progress = true; }
+            hi[v] = new_hi;
+        }
+        return lo[v] <= hi[v];
+    }
+
+    // Narrows the box [lo, hi] to a fixed point of the propagation rules.
+    // Returns false if the box provably contains no solution.
+    bool propagate(double *lo, double *hi) {
+        for (int round = 0; round < MAX_ROUNDS; ++round) {
+            bool progress = false;
+            for (std::size_t e = 0; e + 1 < offsets.size(); ++e) {
+                double sum_lo = 0.0;
+                double sum_hi = 0.0;
+                for (std::size_t k = offsets[e]; k < offsets[e + 1]; ++k) {
+                    const DenseTerm term = terms[k];
+                    if (term.y == NO_VARIABLE) {
+                        term_lo[k] = lo[term.x];
+                        term_hi[k] = hi[term.x];
+                    } else {
+                        term_lo[k] = down(lo[term.x] * lo[term.y]);
+                        term_hi[k] = up(hi[term.x] * hi[term.y]);
+                    }
+                    sum_lo = down(sum_lo + term_lo[k]);
+                    sum_hi = up(sum_hi + term_hi[k]);
+                }
+                if ((sum_lo > 1.0) || (sum_hi < 1.0)) { return false; }
+                for (std::size_t k = offsets[e]; k < offsets[e + 1]; ++k) {
+                    // The other terms of this equation sum to a value in
+                    // [sum_lo - term_lo[k], sum_hi - term_hi[k]].
+                    const double rest_lo = down(sum_lo - term_lo[k]);
+                    const double rest_hi = up(sum_hi - term_hi[k]);
+                    const double t_lo = std::max(down(1.0 - rest_hi), 0.0);
+                    const double t_hi = up(1.0 - rest_lo);
+                    const DenseTerm term = terms[k];
+                    if (term.y == NO_VARIABLE) {
+                        if (!narrow(lo, hi, term.x, t_lo, t_hi, progress)) {
+                            return false;
+                        }
+                        continue;
+                    }
+                    // Since x * y lies in [t_lo, t_hi] and x, y >= 0,
+                    // x lies in [t_lo / hi[y], t_hi / lo[y]].
+                    const auto project = [&](std::uint16_t x, std::uint16_t y) {
+                        const double x_lo =
+                            (hi[y] > 0.0)  ? down(t_lo / hi[y])
+                            : (t_lo > 0.0) ? 2.0
+                                           : 0.0;
+                        const double x_hi =
+                            (lo[y] > 0.0) ? up(t_hi / lo[y]) : 1.0;
+                        return narrow(lo, hi, x, x_lo, x_hi, progress);
+                    };
+                    if (!project(term.x, term.y) || !project(term.y, term.x)) {
+                        return false;
+                    }
+                }
+            }
+            if (!progress) { break; }
+        }
+        return true;
+    }
+
+public:
+
+    explicit IntervalPrefilter(std::size_t max_boxes)
+        : max_boxes(max_boxes)
+        , num_boxes(0)
+        , dense_index()
+        , used_variables()
+        , terms()
+        , offsets()
+        , term_lo()
+        , term_hi()
+        , stack() {
+        dense_index.fill(NO_VARIABLE);
+    }
+
+    // Total number of boxes examined by all calls to refute().
+    std::uint64_t boxes_examined() const noexcept { return num_boxes; }
+
+    // Returns true if the given leaf system provably has no solution with
+    // all variables in [0, 1], and false if it remains undecided.
+    bool refute(const CanonicalSystem &system) {
+        load(system);
+        const std::size_t n = used_variables.size();
+        if (n == 0) { return false; }
+        stack.assign(n, 0.0);
+        stack.resize(2 * n, 1.0);
+        std::size_t boxes = 0;
+        while (!stack.empty()) {
+            if (boxes++ == max_boxes) {
+                num_boxes += boxes;
+                return false;
+            }
+            double *lo = stack.data() + stack.size() - 2 * n;
+            double *hi = lo + n;
+            if (!propagate(lo, hi)) {
+                stack.resize(stack.size() - 2 * n);
+                continue;
+            }
+            std::size_t widest = 0;
+            for (std::size_t v = 1; v < n; ++v) {
+                if (hi[v] - lo[v] > hi[widest] - lo[widest]) { widest = v; }
+            }
+            if (hi[widest] - lo[widest] < MIN_WIDTH) {
+                num_boxes += boxes;
+                return false;
+            }
+            // Split the box in place into its lower half, and push its
+            // upper half to be examined first.
+            const double mid = 0.5 * (lo[widest] + hi[widest]);
+            const std::size_t offset = stack.size() - 2 * n;
+            stack.resize(offset + 4 * n);
+            std::copy_n(
+                stack.begin() + offset, 2 * n, stack.begin() + offset + 2 * n
+            );
+            stack[offset + n + widest] = mid;
+            stack[offset + 2 * n + widest] = mid;
+        }
+        num_boxes += boxes;
+        return true;
+    }
+
+}; // class IntervalPrefilter
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_INTERVAL_PREFILTER_HPP_INCLUDED
@@ -0,0 +1,548 @@
+#ifndef ZERO_ONE_SOLVER_LEAF_FORMAT_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_LEAF_FORMAT_HPP_INCLUDED
+
+#include <bitset>      // for std::bitset
+#include <cassert>     // for assert
+#include <cstddef>     // for std::size_t
+#include <cstdint>     // for std::uint8_t, std::uint16_t, std::uint32_t
+#include <cstring>     // for std::memcmp, std::memcpy
+#include <fstream>     // for std::ifstream
+#include <iterator>    // for std::istreambuf_iterator
+#include <mutex>       // for std::mutex, std::lock_guard
+#include <ostream>     // for std::ostream
+#include <sstream>     // for std::ostringstream
+#include <string>      // for std::string
+#include <type_traits> // for std::is_trivially_copyable_v
+#include <vector>      // for std::vector
+
+#ifndef _WIN32
+#include <fcntl.h>    // for open, O_RDONLY
+#include <sys/mman.h> // for mmap, munmap
+#include <sys/stat.h> // for fstat
+#include <unistd.h>   // for close
+#endif
+
+#include "Canonizer.hpp"
+#include "OutputPipeline.hpp"
+#include "ProofTrace.hpp"
+#include "ResultStore.hpp"
+#include "ZeroOneSolver.hpp"
+
+namespace ZeroOneSolver {
+
+
+/**
+ * Leaf systems are written either as text, in the format parsed by
+ * Canonizer.py, or as a compact binary stream. Alternatively, they can be
+ * canonized and deduplicated in the solver and written in the format of the
+ * WeaklyCanonizedEquations files produced by Canonizer.py. A binary leaf
+ * file consists of a LeafFileHeader followed by one record per leaf system:
+ *
+ *     uint8 num_equations
+ *     uint8 num_free_variables
+ *     num_equations times:
+ *         uint8 num_terms
+ *         num_terms times: uint8 p_index, uint8 q_index
+ *     num_free_variables times: uint8 p_index, uint8 q_index
+ *
+ * The equations are those with right-hand side 1, in order of increasing
+ * degree, and their terms appear in slot order. A factor with index 0 is
+ * absent, so (i, 0) is p_i, (0, j) is q_j, and (i, j) is p_i * q_j. Free
+ * variables are those that no longer occur in any equation but whose value
+ * is still unknown, encoded in the same way. Since every field is a single
+ * byte, records need no alignment and can be read in place from a mapping.
+ */
+enum class LeafFormat : std::uint8_t {
+    TEXT,
+    BINARY,
+    CANONICAL,
+}; // enum class LeafFormat
+
+
+struct LeafFileHeader {
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint8_t m;
+    std::uint8_t n;
+    std::uint16_t reserved;
+
+}; // struct LeafFileHeader
+
+
+static_assert(sizeof(LeafFileHeader) == 16);
+static_assert(sizeof(Term) == 2 && alignof(Term) == 1);
+static_assert(std::is_trivially_copyable_v<Term>);
+
+constexpr char LEAF_FILE_MAGIC[8] = {'Z', 'O', 'L', 'E', 'A', 'F', '\r', '\n'};
+constexpr std::uint32_t LEAF_FILE_VERSION = 1;
+
+
+inline void write_leaf_file_header(std::ostream &os, int m, int n) {
+    LeafFileHeader header = {};
+    std::memcpy(header.magic, LEAF_FILE_MAGIC, sizeof(LEAF_FILE_MAGIC));
+    header.version = LEAF_FILE_VERSION;
+    header.m = static_cast<std::uint8_t>(m);
+    header.n = static_cast<std::uint8_t>(n);
+    os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+
+template <typename SYSTEM>
+void print_leaf_system(std::ostream &os, const SYSTEM &system) {
+    const std::size_t M = system.m();
+    const std::size_t N = system.n();
+    std::bitset<SYSTEM::MAX_M> p_used;
+    std::bitset<SYSTEM::MAX_N> q_used;
+    for (std::size_t e = 0; e < system.num_equations(); ++e) {
+        if (system.rhs.get(e) == RHS::ZERO) {
+            for (std::size_t t = 0; t < system.length(e); ++t) {
+                assert(system.term(e, t) == TERM_ZERO);
+            }
+        } else {
+            assert(system.rhs.get(e) == RHS::ONE);
+            bool first = true;
+            for (std::size_t t = 0; t < system.length(e); ++t) {
+                const Term term = system.term(e, t);
+                if (term == TERM_ZERO) { continue; }
+                if (term.p_index) { p_used.set(term.p_index - 1); }
+                if (term.q_index) { q_used.set(term.q_index - 1); }
+                if (first) {
+                    first = false;
+                } else {
+                    os << " + ";
+                }
+                os << term;
+            }
+            os << "\n";
+        }
+    }
+    for (std::size_t i = 0; i < M - 1; ++i) {
+        const VAR value = system.p.get(i);
+        if ((value == VAR::ZERO) || (value == VAR::ONE)) {
+            assert(!p_used.test(i));
+        } else {
+            assert(value == VAR::UNKNOWN);
+            if (!p_used[i]) { os << "0 <= p" << (i + 1) << " <= 1\n"; }
+        }
+    }
+    for (std::size_t i = 0; i < N - 1; ++i) {
+        const VAR value = system.q.get(i);
+        if ((value == VAR::ZERO) || (value == VAR::ONE)) {
+            assert(!q_used.test(i));
+        } else {
+            assert(value == VAR::UNKNOWN);
+            if (!q_used[i]) { os << "0 <= q" << (i + 1) << " <= 1\n"; }
+        }
+    }
+    os << "\n";
+}
+
+
+// Appends the binary record of a leaf system to out,
+// containing exactly the information printed by print_leaf_system.
+template <typename SYSTEM>
+void encode_leaf_record(std::string &out, const SYSTEM &system) {
+    std::bitset<SYSTEM::MAX_M> p_used;
+    std::bitset<SYSTEM::MAX_N> q_used;
+    const std::size_t start = out.size();
+    out.push_back(0);
+    out.push_back(0);
+    std::size_t num_equations = 0;
+    for (std::size_t e = 0; e < system.num_equations(); ++e) {
+        if (system.rhs.get(e) == RHS::ZERO) { continue; }
+        assert(system.rhs.get(e) == RHS::ONE);
+        const std::size_t count_index = out.size();
+        out.push_back(0);
+        std::size_t num_terms = 0;
+        for (std::size_t t = 0; t < system.length(e); ++t) {
+            const Term term = system.term(e, t);
+            if (term == TERM_ZERO) { continue; }
+            if (term.p_index) { p_used.set(term.p_index - 1); }
+            if (term.q_index) { q_used.set(term.q_index - 1); }
+            out.push_back(static_cast<char>(term.p_index));
+            out.push_back(static_cast<char>(term.q_index));
+            ++num_terms;
+        }
+        out[count_index] = static_cast<char>(num_terms);
+        ++num_equations;
+    }
+    std::size_t num_free_variables = 0;
+    for (std::size_t i = 0; i + 1 < system.m(); ++i) {
+        if ((system.p.get(i) == VAR::UNKNOWN) && !p_used[i]) {
+            out.push_back(static_cast<char>(i + 1));
+            out.push_back(0);
+            ++num_free_variables;
+        }
+    }
+    for (std::size_t i = 0; i + 1 < system.n(); ++i) {
+        if ((system.q.get(i) == VAR::UNKNOWN) && !q_used[i]) {
+            out.push_back(0);
+            out.push_back(static_cast<char>(i + 1));
+            ++num_free_variables;
+        }
+    }
+    assert(num_equations <= 0xFF);
+    assert(num_free_variables <= 0xFF);
+    out[start] = static_cast<char>(num_equations);
+    out[start + 1] = static_cast<char>(num_free_variables);
+}
+
+
+/**
+ * A LeafWriter accumulates leaf systems in a private buffer in the chosen
+ * format and writes them to the underlying stream in blocks of at least
+ * the given size. If a mutex is supplied, it is held during each block
+ * write, so that several writers may share one stream without
+ * interleaving the records of different leaf systems. Alternatively, blocks
+ * can be handed to an OutputChannel, whose writer thread writes them to the
+ * stream. In CANONICAL format, only the first leaf system with a given
+ * canonical form is written, as determined by the supplied LeafDeduplicator.
+ * A LeafWriter with buffer size 0 writes every leaf system to its stream as
+ * soon as it arrives and flushes the stream. If a CaseRecorder is attached,
+ * it receives the canonical fingerprint of every leaf system written. If a
+ * ProofRecorder is attached, its cases begin and end with those of this
+ * writer.
+ */
+class LeafWriter {
+
+    std::ostream *stream;
+    OutputChannel *channel;
+    std::mutex *mutex;
+    LeafDeduplicator *deduplicator;
+    CaseRecorder *recorder;
+    ProofRecorder *proof;
+    const LeafFormat format;
+    const std::size_t capacity;
+    std::string binary_buffer;
+    std::ostringstream text_buffer;
+
+public:
+
+    explicit LeafWriter(
+        std::ostream &output_stream,
+        LeafFormat leaf_format,
+        std::size_t buffer_size = 1 << 20,
+        std::mutex *output_mutex = nullptr,
+        LeafDeduplicator *leaf_deduplicator = nullptr
+    )
+        : stream(&output_stream)
+        , channel(nullptr)
+        , mutex(output_mutex)
+        , deduplicator(leaf_deduplicator)
+        , recorder(nullptr)
+        , proof(nullptr)
+        , format(leaf_format)
+        , capacity(buffer_size)
+        , binary_buffer()
+        , text_buffer() {
+        assert((format != LeafFormat::CANONICAL) || deduplicator);
+        if (format == LeafFormat::BINARY) {
+            binary_buffer.reserve(capacity + (1 << 12));
+        }
+    }
+
+    explicit LeafWriter(
+        OutputChannel &output_channel,
+        LeafFormat leaf_format,
+        std::size_t buffer_size = 1 << 20,
+        LeafDeduplicator *leaf_deduplicator = nullptr
+    )
+        : stream(nullptr)
+        , channel(&output_channel)
+        , mutex(nullptr)
+        , deduplicator(leaf_deduplicator)
+        , recorder(nullptr)
+        , proof(nullptr)
+        , format(leaf_format)
+        , capacity(buffer_size)
+        , binary_buffer()
+        , text_buffer() {
+        assert((format != LeafFormat::CANONICAL) || deduplicator);
+        if (format == LeafFormat::BINARY) {
+            binary_buffer.reserve(capacity + (1 << 12));
+        }
+    }
+
+    LeafWriter(const LeafWriter &) = delete;
+    LeafWriter &operator=(const LeafWriter &) = delete;
+
+    ~LeafWriter() { flush(); }
+
+    void record_cases(CaseRecorder *case_recorder) noexcept {
+        recorder = case_recorder;
+    }
+
+    void record_proof(ProofRecorder *proof_recorder) noexcept {
+        proof = proof_recorder;
+    }
+
+    template <typename SYSTEM>
+    void write(const SYSTEM &system) {
+        if (recorder && (format != LeafFormat::CANONICAL)) {
+            CanonicalSystem canonical = canonical_system_of(system);
+            canonical.canonize();
+            recorder->leaf(canonical.fingerprint());
+        }
+        std::size_t buffered;
+        if (format == LeafFormat::BINARY) {
+            encode_leaf_record(binary_buffer, system);
+            buffered = binary_buffer.size();
+        } else if (format == LeafFormat::CANONICAL) {
+            CanonicalSystem canonical = canonical_system_of(system);
+            canonical.canonize();
+            if (recorder) { recorder->leaf(canonical.fingerprint()); }
+            if (deduplicator->insert(canonical)) {
+                canonical.write_wolfram(text_buffer);
+                text_buffer << "\n\n";
+            }
+            buffered = static_cast<std::size_t>(text_buffer.tellp());
+        } else {
+            print_leaf_system(text_buffer, system);
+            buffered = static_cast<std::size_t>(text_buffer.tellp());
+        }
+        if (buffered && (buffered >= capacity)) { flush(); }
+    }
+
+    void flush() {
+        if (channel) {
+            if (format == LeafFormat::BINARY) {
+                channel->write(binary_buffer);
+                binary_buffer.clear();
+            } else {
+                channel->write(text_buffer.view());
+                text_buffer.str(std::string());
+            }
+            return;
+        }
+        std::unique_lock<std::mutex> lock;
+        if (mutex) { lock = std::unique_lock<std::mutex>(*mutex); }
+        if (format == LeafFormat::BINARY) {
+            stream->write(
+                binary_buffer.data(),
+                static_cast<std::streamsize>(binary_buffer.size())
+            );
+            binary_buffer.clear();
+        } else {
+            *stream << text_buffer.view();
+            text_buffer.str(std::string());
+        }
+        if (capacity == 0) { stream->flush(); }
+    }
+
+    // If this writer uses a channel, the leaf systems written between
+    // begin_case(case_index) and end_case() are output as part of that case
+    // by an ordered pipeline (see OutputPipeline.hpp), and if it has a
+    // CaseRecorder, they are recorded as the leaf systems of that case.
+    void begin_case(std::uint64_t case_index) {
+        if (channel && channel->is_ordered()) {
+            flush();
+            channel->begin_case(case_index);
+        }
+        if (recorder) { recorder->begin_case(case_index); }
+        if (proof) { proof->begin_case(case_index); }
+    }
+
+    void end_case() {
+        if (channel && channel->is_ordered()) {
+            flush();
+            channel->end_case();
+        }
+        if (recorder) { recorder->end_case(); }
+        if (proof) { proof->end_case(); }
+    }
+
+}; // class LeafWriter
+
+
+/**
+ * A LeafRecord is a view of a single record inside a binary leaf file. Its
+ * terms are read in place, so a record is only valid while the LeafReader
+ * that produced it remains open.
+ */
+class LeafRecord {
+
+    const std::uint8_t *data;
+    const std::uint8_t *free_variables_data;
+    std::size_t record_size;
+
+    friend class LeafReader;
+
+public:
+
+    constexpr LeafRecord() noexcept
+        : data(nullptr)
+        , free_variables_data(nullptr)
+        , record_size(0) {}
+
+    std::size_t num_equations() const noexcept { return data[0]; }
+
+    std::size_t num_free_variables() const noexcept { return data[1]; }
+
+    // Size of this record in bytes.
+    std::size_t size() const noexcept { return record_size; }
+
+    // Calls f(terms, num_terms) for each equation in order,
+    // where terms points into the underlying buffer.
+    template <typename F>
+    void for_each_equation(F &&f) const {
+        const std::uint8_t *cursor = data + 2;
+        for (std::size_t k = 0; k < num_equations(); ++k) {
+            const std::size_t num_terms = *cursor++;
+            f(reinterpret_cast<const Term *>(cursor), num_terms);
+            cursor += 2 * num_terms;
+        }
+    }
+
+    const Term *free_variables() const noexcept {
+        return reinterpret_cast<const Term *>(free_variables_data);
+    }
+
+}; // class LeafRecord
+
+
+// Collects the equations of a leaf record, as canonical_system_of does for
+// the leaf system from which it was written.
+inline CanonicalSystem canonical_system_of(const LeafRecord &record) {
+    CanonicalSystem result;
+    record.for_each_equation([&](const Term *terms, std::size_t num_terms) {
+        for (std::size_t k = 0; k < num_terms; ++k) {
+            result.add_term(terms[k]);
+        }
+        result.end_equation();
+    });
+    return result;
+}
+
+
+inline void print_leaf_record(std::ostream &os, const LeafRecord &record) {
+    record.for_each_equation([&](const Term *terms, std::size_t num_terms) {
+        for (std::size_t k = 0; k < num_terms; ++k) {
+            if (k) { os << " + "; }
+            os << terms[k];
+        }
+        os << "\n";
+    });
+    const Term *free_variables = record.free_variables();
+    for (std::size_t k = 0; k < record.num_free_variables(); ++k) {
+        os << "0 <= " << free_variables[k] << " <= 1\n";
+    }
+    os << "\n";
+}
+
+
+/**
+ * A LeafReader maps a binary leaf file into memory and iterates over its
+ * records without copying them. On platforms without mmap, the file is
+ * read into a private buffer instead.
+ */
+class LeafReader {
+
+    const std::uint8_t *begin;
+    const std::uint8_t *end;
+    const std::uint8_t *cursor;
+    std::size_t mapped_size;
+    std::vector<std::uint8_t> fallback;
+    LeafFileHeader header;
+    bool valid;
+
+    bool bad_record() noexcept {
+        valid = false;
+        cursor = end;
+        return false;
+    }
+
+public:
+
+    explicit LeafReader(const std::string &path)
+        : begin(nullptr)
+        , end(nullptr)
+        , cursor(nullptr)
+        , mapped_size(0)
+        , fallback()
+        , header()
+        , valid(false) {
+#ifndef _WIN32
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { return; }
+        struct stat status;
+        if ((::fstat(fd, &status) == 0) && (status.st_size > 0)) {
+            const std::size_t size = static_cast<std::size_t>(status.st_size);
+            void *address =
+                ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                begin = static_cast<const std::uint8_t *>(address);
+                mapped_size = size;
+            }
+        }
+        ::close(fd);
+#else
+        std::ifstream file(path, std::ios::binary);
+        fallback.assign(
+            std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>()
+        );
+        begin = fallback.data();
+#endif
+        end = begin + (mapped_size ? mapped_size : fallback.size());
+        if (static_cast<std::size_t>(end - begin) < sizeof(LeafFileHeader)) {
+            return;
+        }
+        std::memcpy(&header, begin, sizeof(LeafFileHeader));
+        valid = (std::memcmp(header.magic, LEAF_FILE_MAGIC, 8) == 0) &&
+                (header.version == LEAF_FILE_VERSION);
+        cursor = begin + sizeof(LeafFileHeader);
+    }
+
+    LeafReader(const LeafReader &) = delete;
+    LeafReader &operator=(const LeafReader &) = delete;
+
+    ~LeafReader() {
+#ifndef _WIN32
+        if (mapped_size) {
+            ::munmap(const_cast<std::uint8_t *>(begin), mapped_size);
+        }
+#endif
+    }
+
+    // Returns false if the file could not be opened, has an invalid header,
+    // or contains a truncated record. Reaching the end of a well-formed file
+    // leaves the reader valid.
+    bool is_valid() const noexcept { return valid; }
+
+    int m() const noexcept { return header.m; }
+    int n() const noexcept { return header.n; }
+
+    // Advances to the next record, returning false at the end of the file.
+    bool next(LeafRecord &record) noexcept {
+        if (!valid || (cursor == end)) { return false; }
+        const std::uint8_t *p = cursor;
+        if (end - p < 2) { return bad_record(); }
+        const std::size_t num_equations = p[0];
+        const std::size_t num_free_variables = p[1];
+        p += 2;
+        for (std::size_t k = 0; k < num_equations; ++k) {
+            if (p == end) { return bad_record(); }
+            const std::size_t num_terms = *p++;
+            if (static_cast<std::size_t>(end - p) < 2 * num_terms) {
+                return bad_record();
+            }
+            p += 2 * num_terms;
+        }
+        if (static_cast<std::size_t>(end - p) < 2 * num_free_variables) {
+            return bad_record();
+        }
+        record.data = cursor;
+        record.free_variables_data = p;
+        p += 2 * num_free_variables;
+        record.record_size = static_cast<std::size_t>(p - cursor);
+        cursor = p;
+        return true;
+    }
+
+}; // class LeafReader
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_LEAF_FORMAT_HPP_INCLUDED
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+
+import mmap
+import struct
+from collections.abc import Iterator
+from sys import argv, stdout
+from typing import TextIO
+
+
+# See LeafFormat.hpp for a description of the binary leaf file format.
+HEADER = struct.Struct("<8sIBBH")
+MAGIC = b"ZOLEAF\r\n"
+VERSION = 1
+
+
+BinaryTerm = tuple[int, int]
+
+
+class LeafRecord:
+    """
+    A single leaf system read from a binary leaf file. Each equation is a
+    memoryview of its packed (p_index, q_index) byte pairs, so reading a
+    record does not copy the underlying file contents.
+    """
+
+    def __init__(self, equations: list[memoryview], free_variables: memoryview):
+        self.equations = equations
+        self.free_variables = free_variables
+
+    def equation_terms(self) -> Iterator[list[BinaryTerm]]:
+        for equation in self.equations:
+            yield list(struct.iter_unpack("BB", equation))
+
+    def free_variable_terms(self) -> list[BinaryTerm]:
+        return list(struct.iter_unpack("BB", self.free_variables))
+
+
+def leaf_records(path: str) -> Iterator[LeafRecord]:
+    """
+    Memory-map a binary leaf file and return an iterator over its records.
+
+    The mapping is not closed explicitly, since the records refer to it;
+    it is released once the iterator and all records are discarded.
+    """
+    with open(path, "rb") as file:
+        if file.seek(0, 2) < HEADER.size:
+            raise ValueError(f"{path} is not a binary leaf file")
+        view = memoryview(mmap.mmap(file.fileno(), 0, access=mmap.ACCESS_READ))
+    magic, version, _, _, _ = HEADER.unpack_from(view, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError(f"{path} is not a binary leaf file")
+    pos = HEADER.size
+    while pos < len(view):
+        num_equations = view[pos]
+        num_free_variables = view[pos + 1]
+        pos += 2
+        equations: list[memoryview] = []
+        for _ in range(num_equations):
+            num_terms = view[pos]
+            equations.append(view[pos + 1 : pos + 1 + 2 * num_terms])
+            pos += 1 + 2 * num_terms
+        free_variables = view[pos : pos + 2 * num_free_variables]
+        pos += 2 * num_free_variables
+        if pos > len(view):
+            raise ValueError(f"{path} contains a truncated record")
+        yield LeafRecord(equations, free_variables)
+
+
+def term_string(term: BinaryTerm) -> str:
+    p_index, q_index = term
+    if p_index and q_index:
+        return f"p{p_index}*q{q_index}"
+    elif p_index:
+        return f"p{p_index}"
+    elif q_index:
+        return f"q{q_index}"
+    else:
+        return "1"
+
+
+def export_text(path: str, file: TextIO):
+    """
+    Write the leaf systems in a binary leaf file in the text format
+    printed by print_leaf_system (see LeafFormat.hpp).
+    """
+    for record in leaf_records(path):
+        for terms in record.equation_terms():
+            file.write(" + ".join(term_string(term) for term in terms))
+            file.write("\n")
+        for term in record.free_variable_terms():
+            file.write(f"0 <= {term_string(term)} <= 1\n")
+        file.write("\n")
+
+
+def main():
+    for path in argv[1:]:
+        export_text(path, stdout)
+
+
+if __name__ == "__main__":
+    main()
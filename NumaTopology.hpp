@@ -0,0 +1,188 @@
+#ifndef ZERO_ONE_SOLVER_NUMA_TOPOLOGY_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_NUMA_TOPOLOGY_HPP_INCLUDED
+
+#include <algorithm>    // for std::max, std::sort
+#include <cstddef>      // for std::size_t
+#include <filesystem>   // for std::filesystem
+#include <fstream>      // for std::ifstream
+#include <string>       // for std::string
+#include <system_error> // for std::error_code
+#include <thread>       // for std::thread::hardware_concurrency
+#include <utility>      // for std::pair, std::move
+#include <vector>       // for std::vector
+
+#ifdef __linux__
+#include <pthread.h> // for pthread_self, pthread_setaffinity_np
+#include <sched.h>   // for cpu_set_t, CPU_SET, CPU_ISSET, sched_getaffinity
+#endif
+
+namespace ZeroOneSolver {
+
+
+// Parses a Linux CPU list, such as "0-3,8-11", appending the CPUs it names
+// to cpus. Returns false if the list is malformed.
+inline bool
+parse_cpu_list(const std::string &list, std::vector<unsigned> &cpus) {
+    std::size_t pos = 0;
+    const auto parse_number = [&](unsigned &value) {
+        const std::size_t start = pos;
+        value = 0;
+        while ((pos < list.size()) && (list[pos] >= '0') &&
+               (list[pos] <= '9')) {
+            value = 10 * value + static_cast<unsigned>(list[pos++] - '0');
+        }
+        return pos > start;
+    };
+    while ((pos < list.size()) && (list[pos] != '\n')) {
+        unsigned first = 0;
+        if (!parse_number(first)) { return false; }
+        unsigned last = first;
+        if ((pos < list.size()) && (list[pos] == '-')) {
+            ++pos;
+            if (!parse_number(last) || (last < first)) { return false; }
+        }
+        for (unsigned cpu = first; cpu <= last; ++cpu) { cpus.push_back(cpu); }
+        if ((pos < list.size()) && (list[pos] == ',')) { ++pos; }
+    }
+    return true;
+}
+
+
+/**
+ * A NumaTopology is the set of CPUs on which this process may run, grouped
+ * by NUMA node. On Linux, it is read from /sys/devices/system/node, and
+ * restricted to the affinity mask of the process, so that CPUs excluded by
+ * taskset or a cgroup are never used. Elsewhere, or if that information is
+ * unavailable, it consists of a single node with hardware_concurrency()
+ * CPUs, on which threads are not pinned.
+ */
+class NumaTopology {
+
+    std::vector<std::vector<unsigned>> nodes;
+    bool detected;
+
+    NumaTopology()
+        : nodes()
+        , detected(false) {}
+
+public:
+
+    static NumaTopology single_node() {
+        NumaTopology result;
+        const unsigned num_cpus =
+            std::max(std::thread::hardware_concurrency(), 1U);
+        result.nodes.emplace_back();
+        for (unsigned cpu = 0; cpu < num_cpus; ++cpu) {
+            result.nodes[0].push_back(cpu);
+        }
+        return result;
+    }
+
+    static NumaTopology detect() {
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            return single_node();
+        }
+        std::vector<std::pair<unsigned, std::vector<unsigned>>> found;
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(
+                 "/sys/devices/system/node", error
+             )) {
+            const std::string name = entry.path().filename().string();
+            if ((name.size() <= 4) || !name.starts_with("node") ||
+                (name.find_first_not_of("0123456789", 4) !=
+                 std::string::npos)) {
+                continue;
+            }
+            std::ifstream file(entry.path() / "cpulist");
+            std::string list;
+            std::vector<unsigned> cpus;
+            if (!std::getline(file, list) || !parse_cpu_list(list, cpus)) {
+                return single_node();
+            }
+            std::vector<unsigned> usable;
+            for (const unsigned cpu : cpus) {
+                if ((cpu < CPU_SETSIZE) && CPU_ISSET(cpu, &allowed)) {
+                    usable.push_back(cpu);
+                }
+            }
+            if (!usable.empty()) {
+                unsigned index = 0;
+                for (std::size_t k = 4; k < name.size(); ++k) {
+                    index = 10 * index + static_cast<unsigned>(name[k] - '0');
+                }
+                found.emplace_back(index, std::move(usable));
+            }
+        }
+        if (found.empty()) { return single_node(); }
+        std::sort(found.begin(), found.end());
+        NumaTopology result;
+        for (auto &node : found) {
+            result.nodes.push_back(std::move(node.second));
+        }
+        result.detected = true;
+        return result;
+#else
+        return single_node();
+#endif
+    }
+
+    std::size_t num_nodes() const noexcept { return nodes.size(); }
+
+    const std::vector<unsigned> &cpus(std::size_t node) const noexcept {
+        return nodes[node];
+    }
+
+    std::size_t num_cpus() const noexcept {
+        std::size_t result = 0;
+        for (const std::vector<unsigned> &node : nodes) {
+            result += node.size();
+        }
+        return result;
+    }
+
+    // Assigns num_workers workers to nodes in proportion to their numbers
+    // of CPUs, so that the workers of each node have consecutive indices,
+    // and returns the node of each worker.
+    std::vector<std::size_t> assign(unsigned num_workers) const {
+        std::vector<std::size_t> result(num_workers);
+        const std::size_t total = num_cpus();
+        std::size_t cumulative = 0;
+        unsigned begin = 0;
+        for (std::size_t node = 0; node < nodes.size(); ++node) {
+            cumulative += nodes[node].size();
+            const unsigned end =
+                static_cast<unsigned>(num_workers * cumulative / total);
+            for (unsigned worker = begin; worker < end; ++worker) {
+                result[worker] = node;
+            }
+            begin = end;
+        }
+        return result;
+    }
+
+    // Restricts the calling thread to the CPUs of the given node. Returns
+    // false if the thread could not be pinned, in which case it may run on
+    // any CPU, as before.
+    bool pin(std::size_t node) const {
+#ifdef __linux__
+        if (!detected) { return false; }
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        for (const unsigned cpu : nodes[node]) { CPU_SET(cpu, &mask); }
+        return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) ==
+               0;
+#else
+        (void)node;
+        return false;
+#endif
+    }
+
+}; // class NumaTopology
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_NUMA_TOPOLOGY_HPP_INCLUDED
@@ -0,0 +1,450 @@
+#ifndef ZERO_ONE_SOLVER_OUTPUT_PIPELINE_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_OUTPUT_PIPELINE_HPP_INCLUDED
+
+#include <atomic>      // for std::atomic
+#include <cassert>     // for assert
+#include <cstddef>     // for std::size_t
+#include <cstdint>     // for std::uint64_t
+#include <deque>       // for std::deque
+#include <functional>  // for std::function
+#include <map>         // for std::map
+#include <ostream>     // for std::ostream
+#include <string>      // for std::string
+#include <string_view> // for std::string_view
+#include <thread>      // for std::thread
+#include <utility>     // for std::move
+
+// Output can only be compressed if the solver is compiled with
+// -DZERO_ONE_SOLVER_ZSTD=true and linked with -lzstd.
+#ifndef ZERO_ONE_SOLVER_ZSTD
+#define ZERO_ONE_SOLVER_ZSTD false
+#endif
+
+#if ZERO_ONE_SOLVER_ZSTD
+#include <zstd.h>
+#endif
+
+namespace ZeroOneSolver {
+
+
+constexpr bool ZSTD_ENABLED = ZERO_ONE_SOLVER_ZSTD;
+
+// The range of zstd compression levels, i.e., ZSTD_minCLevel() and
+// ZSTD_maxCLevel(), where 0 disables compression.
+constexpr int ZSTD_MIN_LEVEL = -(1 << 17);
+constexpr int ZSTD_MAX_LEVEL = 22;
+
+
+// A lock-free queue of fixed capacity between one producer thread,
+// which only calls push(), and one consumer thread, which only calls pop().
+template <typename T, std::size_t CAPACITY>
+class SpscRing {
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0);
+
+    T slots[CAPACITY];
+    alignas(64) std::atomic<std::size_t> head = 0;
+    alignas(64) std::atomic<std::size_t> tail = 0;
+
+public:
+
+    bool push(const T &value) noexcept {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY) {
+            return false;
+        }
+        slots[t & (CAPACITY - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &value) noexcept {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) { return false; }
+        value = slots[h & (CAPACITY - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+}; // class SpscRing<T, CAPACITY>
+
+
+struct OutputBlock {
+
+    std::uint64_t case_index;
+    bool end_of_case;
+    std::string data;
+
+}; // struct OutputBlock
+
+
+class OutputPipeline;
+
+
+/**
+ * An OutputChannel carries the output of a single producer thread to the
+ * writer thread of an OutputPipeline. It owns a fixed set of blocks, which
+ * circulate between a queue of filled blocks and a queue of free blocks, so
+ * that a producer never allocates once every block has grown to the size
+ * of its largest write, and a producer that gets NUM_BLOCKS writes ahead of
+ * the writer thread waits for it to catch up.
+ */
+class OutputChannel {
+
+    static constexpr std::size_t NUM_BLOCKS = 4;
+
+    OutputPipeline &pipeline;
+    OutputBlock blocks[NUM_BLOCKS];
+    SpscRing<OutputBlock *, NUM_BLOCKS> free_blocks;
+    SpscRing<OutputBlock *, NUM_BLOCKS> full_blocks;
+    // Incremented by the writer thread whenever it returns a free block.
+    std::atomic<std::uint64_t> num_returned;
+    std::uint64_t current_case;
+    bool case_open;
+
+    friend class OutputPipeline;
+
+    OutputBlock &acquire_block() noexcept {
+        OutputBlock *block;
+        while (true) {
+            const std::uint64_t seen =
+                num_returned.load(std::memory_order_acquire);
+            if (free_blocks.pop(block)) { return *block; }
+            num_returned.wait(seen, std::memory_order_acquire);
+        }
+    }
+
+    void submit(OutputBlock &block) noexcept;
+
+    void release(OutputBlock &block) noexcept {
+        const bool pushed = free_blocks.push(&block);
+        assert(pushed);
+        (void)pushed;
+        num_returned.fetch_add(1, std::memory_order_release);
+        num_returned.notify_one();
+    }
+
+public:
+
+    explicit OutputChannel(OutputPipeline &output_pipeline) noexcept
+        : pipeline(output_pipeline)
+        , blocks()
+        , free_blocks()
+        , full_blocks()
+        , num_returned(0)
+        , current_case(0)
+        , case_open(false) {
+        for (OutputBlock &block : blocks) { free_blocks.push(&block); }
+    }
+
+    OutputChannel(const OutputChannel &) = delete;
+    OutputChannel &operator=(const OutputChannel &) = delete;
+
+    // Writes data as part of the current case.
+    void write(std::string_view data) {
+        if (data.empty()) { return; }
+        OutputBlock &block = acquire_block();
+        block.case_index = current_case;
+        block.end_of_case = false;
+        block.data.assign(data);
+        submit(block);
+    }
+
+    // In an ordered pipeline, every write between begin_case(case_index)
+    // and the following end_case() is output as part of that case.
+    void begin_case(std::uint64_t case_index) noexcept {
+        current_case = case_index;
+        case_open = true;
+    }
+
+    void end_case() noexcept;
+
+    bool is_ordered() const noexcept;
+
+}; // class OutputChannel
+
+
+/**
+ * An OutputPipeline decouples the search from the output stream. Producers
+ * write blocks of leaf systems to their own OutputChannel, and a dedicated
+ * writer thread drains every channel and writes the blocks to the stream,
+ * optionally compressing them with zstd.
+ *
+ * If it is ordered, the output of each case is written in order of case
+ * index, so that the output does not depend on which thread solved which
+ * case. This requires that each case is solved by a single producer. The
+ * output of the earliest unfinished case is written as it arrives, while
+ * the output of later cases is held until every earlier case has finished.
+ * Producers call wait_for_case() before starting a case, which bounds the
+ * number of cases held to the given window.
+ */
+class OutputPipeline {
+
+    struct HeldCase {
+        std::string data;
+        bool complete;
+    }; // struct HeldCase
+
+    std::ostream &stream;
+    const bool ordered;
+    const std::uint64_t window;
+    const std::function<bool(std::uint64_t)> is_skipped;
+    std::deque<OutputChannel> channels;
+    // Incremented by producers whenever they submit a block,
+    // and by other threads to wake the writer thread.
+    std::atomic<std::uint64_t> num_submitted;
+    std::atomic<std::uint64_t> drains_requested;
+    std::atomic<std::uint64_t> drains_completed;
+    std::atomic<bool> stopping;
+    // Only accessed by the writer thread, except that next_case is read
+    // by wait_for_case().
+    std::atomic<std::uint64_t> next_case;
+    std::map<std::uint64_t, HeldCase> held_cases;
+#if ZERO_ONE_SOLVER_ZSTD
+    ZSTD_CCtx *context;
+    std::string compressed;
+#endif
+    const int compression_level;
+    std::thread writer;
+
+    friend class OutputChannel;
+
+    void wake() noexcept {
+        num_submitted.fetch_add(1, std::memory_order_release);
+        num_submitted.notify_one();
+    }
+
+#if ZERO_ONE_SOLVER_ZSTD
+    void compress(std::string_view data, ZSTD_EndDirective mode) {
+        ZSTD_inBuffer input = {data.data(), data.size(), 0};
+        while (true) {
+            ZSTD_outBuffer output = {compressed.data(), compressed.size(), 0};
+            const std::size_t remaining =
+                ZSTD_compressStream2(context, &output, &input, mode);
+            if (ZSTD_isError(remaining)) {
+                stream.setstate(std::ios::failbit);
+                return;
+            }
+            stream.write(
+                compressed.data(), static_cast<std::streamsize>(output.pos)
+            );
+            if ((mode == ZSTD_e_continue) ? (input.pos == input.size)
+                                          : (remaining == 0)) {
+                return;
+            }
+        }
+    }
+#endif
+
+    void emit(std::string_view data) {
+#if ZERO_ONE_SOLVER_ZSTD
+        if (compression_level) { return compress(data, ZSTD_e_continue); }
+#endif
+        stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    // Ends the current zstd frame, so that the output written so far can
+    // be decompressed on its own, and flushes the stream.
+    void end_frame() {
+#if ZERO_ONE_SOLVER_ZSTD
+        if (compression_level) { compress({}, ZSTD_e_end); }
+#endif
+        stream.flush();
+    }
+
+    void skip_finished_cases() {
+        std::uint64_t c = next_case.load(std::memory_order_relaxed);
+        while (true) {
+            if (is_skipped && is_skipped(c)) {
+                ++c;
+                continue;
+            }
+            const auto found = held_cases.find(c);
+            if (found == held_cases.end()) { break; }
+            emit(found->second.data);
+            const bool complete = found->second.complete;
+            held_cases.erase(found);
+            if (!complete) { break; }
+            ++c;
+        }
+        next_case.store(c, std::memory_order_release);
+        next_case.notify_all();
+    }
+
+    void consume(const OutputBlock &block) {
+        if (!ordered) { return emit(block.data); }
+        const std::uint64_t current = next_case.load(std::memory_order_relaxed);
+        assert(block.case_index >= current);
+        if (block.case_index == current) {
+            emit(block.data);
+            if (block.end_of_case) {
+                next_case.store(current + 1, std::memory_order_relaxed);
+                skip_finished_cases();
+            }
+        } else {
+            HeldCase &held = held_cases[block.case_index];
+            held.data += block.data;
+            held.complete = block.end_of_case;
+        }
+    }
+
+    void run() {
+        while (true) {
+            const std::uint64_t seen =
+                num_submitted.load(std::memory_order_acquire);
+            bool found = false;
+            for (OutputChannel &channel : channels) {
+                OutputBlock *block;
+                while (channel.full_blocks.pop(block)) {
+                    consume(*block);
+                    channel.release(*block);
+                    found = true;
+                }
+            }
+            if (found) { continue; }
+            const std::uint64_t requested =
+                drains_requested.load(std::memory_order_acquire);
+            if (drains_completed.load(std::memory_order_relaxed) < requested) {
+                end_frame();
+                drains_completed.store(requested, std::memory_order_release);
+                drains_completed.notify_all();
+                continue;
+            }
+            if (stopping.load(std::memory_order_acquire)) { break; }
+            num_submitted.wait(seen, std::memory_order_acquire);
+        }
+        assert(held_cases.empty());
+        end_frame();
+    }
+
+public:
+
+    // The preamble is written before any output of the producers. Cases for
+    // which skip_case returns true are never started, and are treated as
+    // finished without output by an ordered pipeline, which begins with
+    // first_case. A zstd_level of 0 disables compression.
+    explicit OutputPipeline(
+        std::ostream &output_stream,
+        std::string_view preamble,
+        std::size_t num_channels,
+        bool ordered_output = false,
+        std::uint64_t first_case = 0,
+        std::uint64_t reorder_window = 1,
+        std::function<bool(std::uint64_t)> skip_case = {},
+        int zstd_level = 0
+    )
+        : stream(output_stream)
+        , ordered(ordered_output)
+        , window(reorder_window)
+        , is_skipped(std::move(skip_case))
+        , channels()
+        , num_submitted(0)
+        , drains_requested(0)
+        , drains_completed(0)
+        , stopping(false)
+        , next_case(first_case)
+        , held_cases()
+#if ZERO_ONE_SOLVER_ZSTD
+        , context(nullptr)
+        , compressed()
+#endif
+        , compression_level(zstd_level)
+        , writer() {
+        assert(ZSTD_ENABLED || (compression_level == 0));
+        assert(window > 0);
+        for (std::size_t i = 0; i < num_channels; ++i) {
+            channels.emplace_back(*this);
+        }
+#if ZERO_ONE_SOLVER_ZSTD
+        if (compression_level) {
+            context = ZSTD_createCCtx();
+            ZSTD_CCtx_setParameter(
+                context, ZSTD_c_compressionLevel, compression_level
+            );
+            compressed.resize(ZSTD_CStreamOutSize());
+        }
+#endif
+        emit(preamble);
+        if (ordered) { skip_finished_cases(); }
+        writer = std::thread(&OutputPipeline::run, this);
+    }
+
+    OutputPipeline(const OutputPipeline &) = delete;
+    OutputPipeline &operator=(const OutputPipeline &) = delete;
+
+    ~OutputPipeline() {
+        close();
+#if ZERO_ONE_SOLVER_ZSTD
+        ZSTD_freeCCtx(context);
+#endif
+    }
+
+    OutputChannel &channel(std::size_t index) noexcept {
+        return channels[index];
+    }
+
+    // Blocks until every block submitted before this call has been written
+    // and the stream has been flushed, ending the current zstd frame.
+    void drain() {
+        const std::uint64_t request =
+            drains_requested.fetch_add(1, std::memory_order_acq_rel) + 1;
+        wake();
+        while (true) {
+            const std::uint64_t completed =
+                drains_completed.load(std::memory_order_acquire);
+            if (completed >= request) { return; }
+            drains_completed.wait(completed, std::memory_order_acquire);
+        }
+    }
+
+    // Blocks while case_index is at least window cases ahead of
+    // the earliest case of an ordered pipeline that has not finished.
+    void wait_for_case(std::uint64_t case_index) const noexcept {
+        if (!ordered) { return; }
+        while (true) {
+            const std::uint64_t current =
+                next_case.load(std::memory_order_acquire);
+            if (case_index < current + window) { return; }
+            next_case.wait(current, std::memory_order_acquire);
+        }
+    }
+
+    // Writes everything submitted so far and stops the writer thread. Every
+    // producer must have finished writing before this is called.
+    void close() {
+        if (!writer.joinable()) { return; }
+        stopping.store(true, std::memory_order_release);
+        wake();
+        writer.join();
+    }
+
+}; // class OutputPipeline
+
+
+inline void OutputChannel::submit(OutputBlock &block) noexcept {
+    const bool pushed = full_blocks.push(&block);
+    assert(pushed);
+    (void)pushed;
+    pipeline.wake();
+}
+
+
+inline bool OutputChannel::is_ordered() const noexcept {
+    return pipeline.ordered;
+}
+
+
+inline void OutputChannel::end_case() noexcept {
+    if (!pipeline.ordered || !case_open) { return; }
+    case_open = false;
+    OutputBlock &block = acquire_block();
+    block.case_index = current_case;
+    block.end_of_case = true;
+    block.data.clear();
+    submit(block);
+}
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_OUTPUT_PIPELINE_HPP_INCLUDED
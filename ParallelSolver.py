@@ -2,9 +2,8 @@
 
 import os
 import subprocess
-from collections.abc import Iterator
+from collections.abc import Iterator, Sequence
 from itertools import count
-from time import sleep
 from sys import argv
 
 
@@ -39,15 +38,18 @@ def get_num_cores() -> int:
     return 4 if result is None else result
 
 
-def executable_path(m: int, n: int) -> str:
-    return f"bin/ZeroOneSolver-{m+n:04}-{m:04}-{n:04}"
+RUNTIME_EXECUTABLE_PATH: str = "bin/ZeroOneSolver"
 
 
 def data_file_path(m: int, n: int) -> str:
     return f"data/ZeroOneEquations-{m+n:04}-{m:04}-{n:04}.txt"
 
 
-def compile(m: int, n: int, output_path: str):
+def binary_data_file_path(m: int, n: int) -> str:
+    return f"data/ZeroOneEquations-{m+n:04}-{m:04}-{n:04}.bin"
+
+
+def compile_flags(output_path: str, flags: Sequence[str]):
     if os.path.isfile(output_path):
         os.remove(output_path)
     subprocess.run(
@@ -56,9 +58,9 @@ def compile(m: int, n: int, output_path: str):
             "-std=c++20",
             "-O3",
             "-march=native",
-            "-DZERO_ONE_SOLVER_M=" + str(m),
-            "-DZERO_ONE_SOLVER_N=" + str(n),
+            "-pthread",
             "-DZERO_ONE_SOLVER_VERBOSE=false",
+            *flags,
             "ZeroOneSolver.cpp",
             "-o",
             output_path,
@@ -67,61 +69,52 @@ def compile(m: int, n: int, output_path: str):
     )
 
 
-def wait_for_process_to_finish(
-    processes: list[tuple[subprocess.Popen[bytes], str, str, str]]
-):
-    while True:
-        for k in range(len(processes)):
-            proc, exe, src, dst = processes[k]
-            return_code = proc.poll()
-            if return_code is not None:
-                if return_code == 0:
-                    print("Finished computing", dst + ".")
-                else:
-                    print("ERROR: Process", dst, "returned non-zero exit code.")
-                if os.path.isfile(exe):
-                    os.remove(exe)
-                if os.path.isfile(exe + ".exe"):
-                    os.remove(exe + ".exe")
-                if proc.stdout is not None:
-                    proc.stdout.close()
-                os.rename(src, dst)
-                del processes[k]
-                return None
-        sleep(0.001)
+def compile(m: int, n: int, output_path: str, extra_flags: Sequence[str] = ()):
+    """
+    Compile a solver specialized for the given (m, n) at compile time.
+    """
+    compile_flags(
+        output_path,
+        ["-DZERO_ONE_SOLVER_M=" + str(m), "-DZERO_ONE_SOLVER_N=" + str(n), *extra_flags],
+    )
+
+
+def compile_runtime(output_path: str, extra_flags: Sequence[str] = ()):
+    """
+    Compile a single solver that takes (m, n) from its command line.
+    """
+    compile_flags(output_path, extra_flags)
 
 
 def main():
     if not os.path.isdir("bin"):
         os.mkdir("bin")
-    if not os.path.isdir("data"):
-        os.mkdir("data")
-
-    num_processes = int(argv[1]) if len(argv) > 1 else get_num_cores() - 1
-    print("Running", num_processes, "parallel processes.")
-
-    processes: list[tuple[subprocess.Popen[bytes], str, str, str]] = []
-    for m, n in max_degree_pair_iterator(int(argv[2]) if len(argv) > 2 else None):
-        data_path = data_file_path(m, n)
-        if os.path.isfile(data_path):
-            print(data_path, "already computed.")
-        else:
-            while len(processes) >= num_processes:
-                wait_for_process_to_finish(processes)
-            exe_path = executable_path(m, n)
-            compile(m, n, exe_path)
-            temp_path = data_path + ".temp"
-            print("Computing", data_path + ".")
-            processes.append(
-                (
-                    subprocess.Popen([exe_path], stdout=open(temp_path, "w")),
-                    exe_path,
-                    temp_path,
-                    data_path,
-                )
-            )
-    while processes:
-        wait_for_process_to_finish(processes)
+
+    num_threads = int(argv[1]) if len(argv) > 1 else get_num_cores() - 1
+    print("Running", num_threads, "solver threads.")
+
+    # A single runtime-dimensioned solver serves every (m, n) pair,
+    # instead of compiling a specialized executable for each one.
+    exe_path = RUNTIME_EXECUTABLE_PATH
+    compile_runtime(exe_path)
+
+    # The solver schedules every pair up to the given degree in one process,
+    # sharing its threads between them and starting the most expensive pairs
+    # first. It skips pairs that are already computed and resumes the parts
+    # of interrupted pairs. Without a maximum degree, one degree is added at
+    # a time, forever.
+    max_degrees = [int(argv[2])] if len(argv) > 2 else count(1)
+    for max_degree in max_degrees:
+        subprocess.run(
+            [
+                exe_path,
+                *("--max-degree", str(max_degree)),
+                "--schedule",
+                *("--threads", str(num_threads)),
+                *("--data-dir", "data"),
+            ],
+            check=True,
+        )
 
 
 if __name__ == "__main__":
@@ -0,0 +1,29 @@
+#ifndef ZERO_ONE_SOLVER_PARSE_NUMBER_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_PARSE_NUMBER_HPP_INCLUDED
+
+#include <charconv>     // for std::from_chars
+#include <string_view>  // for std::string_view
+#include <system_error> // for std::errc
+
+namespace ZeroOneSolver {
+
+
+// Parses all of text as a number in [min, max]. Returns false, leaving value
+// unchanged, if text is not such a number or has trailing characters.
+template <typename T>
+bool parse_number(std::string_view text, T &value, T min, T max) {
+    const char *const end = text.data() + text.size();
+    T result{};
+    const auto [ptr, error] = std::from_chars(text.data(), end, result);
+    if ((error != std::errc()) || (ptr != end) ||
+        !((result >= min) && (result <= max))) {
+        return false;
+    }
+    value = result;
+    return true;
+}
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_PARSE_NUMBER_HPP_INCLUDED
@@ -0,0 +1,217 @@
+#ifndef ZERO_ONE_SOLVER_PRECHECK_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_PRECHECK_HPP_INCLUDED
+
+#include <algorithm> // for std::min, std::max
+#include <cstddef>   // for std::size_t
+#include <cstdint>   // for std::uint8_t
+#include <string>    // for std::string
+
+#include "Stats.hpp"
+#include "ZeroOneSolver.hpp"
+
+namespace ZeroOneSolver {
+
+
+/**
+ * Prechecks are fast necessary conditions for the consistency of a system,
+ * which the search evaluates before calling simplify() on each node, so
+ * that nodes refuted by a precheck skip the full simplification. Each
+ * precheck is a bit of a PrecheckMask, and they are evaluated in order.
+ *
+ * LOCAL looks for the conflicts that Phase 1 of simplify() would detect
+ * without any propagation: an equation whose left-hand side contains two
+ * copies of 1, contains 1 but must vanish, or is empty but must equal 1.
+ * It refutes no node that simplify() would accept, so it never changes the
+ * leaf systems that are found.
+ *
+ * EVALUATION uses the identities P(1) Q(1) = R(1) and P(-1) Q(-1) = R(-1).
+ * Every variable that has not been fixed lies in [0, 1], and every
+ * coefficient of R that has not been fixed is 0 or 1, so both sides of each
+ * identity lie in intervals determined by the fixed variables, and the node
+ * is inconsistent if these intervals are disjoint. A coefficient of R with
+ * a term p_i q_j whose factors are both 1 is 1, even though Phase 1 of
+ * simplify() sets the right-hand side of its equation to 0 when it
+ * subtracts that term from both sides. This is a valid proof of
+ * inconsistency, but simplify() need not find one, so EVALUATION may also
+ * remove leaf systems that would otherwise have been written, each of which
+ * has no real solution.
+ */
+enum PrecheckMask : std::uint8_t {
+    PRECHECK_NONE = 0,
+    PRECHECK_LOCAL = 1,
+    PRECHECK_EVALUATION = 2,
+    PRECHECK_ALL = PRECHECK_LOCAL | PRECHECK_EVALUATION,
+}; // enum PrecheckMask
+
+
+constexpr const char *PRECHECK_NAMES[] = {
+    "none",
+    "local",
+    "evaluation",
+    "all",
+};
+
+
+inline bool parse_precheck_mask(const std::string &name, PrecheckMask &mask) {
+    for (std::size_t k = 0; k < std::size(PRECHECK_NAMES); ++k) {
+        if (name == PRECHECK_NAMES[k]) {
+            mask = static_cast<PrecheckMask>(k);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+template <typename SYSTEM>
+constexpr bool passes_local_precheck(const SYSTEM &system) noexcept {
+    for (std::size_t e = 0; e < system.num_equations(); ++e) {
+        const RHS rhs_value = system.rhs.get(e);
+        bool found_nonzero = false;
+        bool found_one = false;
+        for (std::size_t t = 0; t < system.length(e); ++t) {
+            const Term term = system.term(e, t);
+            if (term == TERM_ZERO) { continue; }
+            if (term == TERM_ONE) {
+                if (found_one) {
+                    refute(PROOF_TWO_ONES, e);
+                    return false;
+                }
+                if (rhs_value == RHS::ZERO) {
+                    refute(PROOF_ONE_EQUALS_ZERO, e);
+                    return false;
+                }
+                found_one = true;
+            }
+            found_nonzero = true;
+        }
+        if (!found_nonzero && (rhs_value == RHS::ONE)) {
+            refute(PROOF_ZERO_EQUALS_ONE, e);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * An EvaluationBounds holds integer intervals containing P(x), Q(x), and
+ * R(x) at x = 1 and x = -1. The leading and constant coefficients of P and
+ * Q are 1, as are those of R = P Q, which are not part of the system.
+ */
+struct EvaluationBounds {
+
+    struct Interval {
+        int lo;
+        int hi;
+
+        constexpr void add(VAR value, int sign) noexcept {
+            if (value == VAR::ONE) {
+                lo += sign;
+                hi += sign;
+            } else if (value != VAR::ZERO) {
+                (sign > 0) ? ++hi : --lo;
+            }
+        }
+
+        constexpr void add(RHS value, int sign) noexcept {
+            if (value == RHS::ONE) {
+                lo += sign;
+                hi += sign;
+            } else if (value == RHS::ZERO_OR_ONE) {
+                (sign > 0) ? ++hi : --lo;
+            }
+        }
+
+        constexpr Interval operator*(const Interval &other) const noexcept {
+            const int a = lo * other.lo;
+            const int b = lo * other.hi;
+            const int c = hi * other.lo;
+            const int d = hi * other.hi;
+            return {
+                std::min(std::min(a, b), std::min(c, d)),
+                std::max(std::max(a, b), std::max(c, d)),
+            };
+        }
+
+        constexpr bool intersects(const Interval &other) const noexcept {
+            return (lo <= other.hi) && (other.lo <= hi);
+        }
+    }; // struct Interval
+
+    template <typename SYSTEM>
+    static constexpr bool consistent(const SYSTEM &system) noexcept {
+        const int M = system.m();
+        const int N = system.n();
+        const int p_end = ((M % 2) == 0) ? 1 : -1;
+        const int q_end = ((N % 2) == 0) ? 1 : -1;
+        Interval p_plus = {2, 2};
+        Interval p_minus = {1 + p_end, 1 + p_end};
+        for (int i = 1; i < M; ++i) {
+            const VAR value = system.p.get(static_cast<std::size_t>(i - 1));
+            p_plus.add(value, 1);
+            p_minus.add(value, (i % 2) ? -1 : 1);
+        }
+        Interval q_plus = {2, 2};
+        Interval q_minus = {1 + q_end, 1 + q_end};
+        for (int j = 1; j < N; ++j) {
+            const VAR value = system.q.get(static_cast<std::size_t>(j - 1));
+            q_plus.add(value, 1);
+            q_minus.add(value, (j % 2) ? -1 : 1);
+        }
+        bool has_one_term[SYSTEM::shape_type::MAX_EQUATIONS + 2] = {};
+        for (int i = 0; i <= M; ++i) {
+            if ((0 < i) && (i < M) &&
+                (system.p.get(static_cast<std::size_t>(i - 1)) != VAR::ONE)) {
+                continue;
+            }
+            for (int j = 0; j <= N; ++j) {
+                if ((0 < j) && (j < N) &&
+                    (system.q.get(static_cast<std::size_t>(j - 1)) !=
+                     VAR::ONE)) {
+                    continue;
+                }
+                has_one_term[i + j] = true;
+            }
+        }
+        Interval r_plus = {2, 2};
+        Interval r_minus = {1 + p_end * q_end, 1 + p_end * q_end};
+        for (int d = 1; d < M + N; ++d) {
+            const RHS value =
+                has_one_term[d]
+                    ? RHS::ONE
+                    : system.rhs.get(static_cast<std::size_t>(d - 1));
+            r_plus.add(value, 1);
+            r_minus.add(value, (d % 2) ? -1 : 1);
+        }
+        return (p_plus * q_plus).intersects(r_plus) &&
+               (p_minus * q_minus).intersects(r_minus);
+    }
+
+}; // struct EvaluationBounds
+
+
+// Returns false if one of the prechecks selected by mask proves that the
+// given system is inconsistent.
+template <typename SYSTEM>
+constexpr bool
+passes_prechecks(const SYSTEM &system, PrecheckMask mask) noexcept {
+    if (mask == PRECHECK_NONE) { return true; }
+    record(Stat::PRECHECK_CALLS);
+    if ((mask & PRECHECK_LOCAL) && !passes_local_precheck(system)) {
+        record(Stat::PRECHECK_LOCAL_REFUTED);
+        return false;
+    }
+    if ((mask & PRECHECK_EVALUATION) &&
+        !EvaluationBounds::consistent(system)) {
+        record(Stat::PRECHECK_EVALUATION_REFUTED);
+        refute(PROOF_EVALUATION);
+        return false;
+    }
+    return true;
+}
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_PRECHECK_HPP_INCLUDED
@@ -0,0 +1,804 @@
+// ProofChecker replays the proof traces written by ZeroOneSolver --proof
+// (see ProofTrace.hpp) and checks, independently of the solver, that the
+// case analysis they record is exhaustive. Compile with:
+//
+//     g++ -std=c++20 -O3 -march=native -pthread -o bin/ProofChecker
+//         ProofChecker.cpp
+//
+// Usage: ProofChecker TRACE [--threads N] [--leaves FILE.bin]
+//
+// The checker shares no code with the search, only the formats of the trace
+// and of binary leaf files. It builds the equations of each case from their
+// definition, the coefficient of x^d in PQ being the sum of p_i q_{d - i}
+// with p_0 = p_M = q_0 = q_N = 1, and follows the search tree recorded in
+// the trace, applying its own propagation to every node:
+//
+// 1. Every variable lies in [0, 1], since p_i q_0 and p_0 q_j are terms of
+//    coefficients of PQ, which are 0 or 1. Hence an equation whose
+//    left-hand side contains two terms equal to 1, or the term 1 and a
+//    right-hand side of 0, or no nonzero terms and a right-hand side of 1,
+//    is refuted. A sum of nonnegative terms that is 0 forces every linear
+//    term to 0, and a lone nonzero term that is 1 forces its variables to 1.
+// 2. A variable that is the only undetermined term of an equation, or whose
+//    sum with another variable and product with it are both equations with
+//    no other undetermined terms, is 0 or 1 in every solution.
+//
+// Each node of the trace must be refuted by (1), or by bounding P(x), Q(x),
+// and PQ(x) at x = 1 and x = -1 if the trace says so; be solved, with every
+// variable 0 or 1; be a leaf, whose equations are compared with the leaf
+// file given by --leaves, if any; or be split into cases that the checker
+// proves exhaustive: a variable known to be 0 or 1 is 0 or 1, a product in
+// an equation summing to 0 has a zero factor, a product that alone sums to
+// 0 or 1 has a zero factor or is 1 * 1, and an equation summing to 0 or 1 is
+// 0 or 1. With symmetry breaking, mirrored splits of systems that are their
+// own mirror image may omit the mirror image of a child, and only the cases
+// that are not greater than their mirror image must be present. The checker
+// trusts that the 2^(M - 1) cases of the solver cover every solution.
+
+#include <algorithm>    // for std::min, std::max, std::sort
+#include <atomic>       // for std::atomic
+#include <charconv>     // for std::from_chars
+#include <cstddef>      // for std::size_t
+#include <cstdint>      // for std::uint8_t, std::uint64_t
+#include <cstdlib>      // for EXIT_SUCCESS, EXIT_FAILURE
+#include <fstream>      // for std::ifstream
+#include <iostream>     // for std::cerr
+#include <iterator>     // for std::istreambuf_iterator
+#include <mutex>        // for std::mutex, std::lock_guard
+#include <string>       // for std::string
+#include <system_error> // for std::errc
+#include <thread>       // for std::thread
+#include <utility>      // for std::pair
+#include <vector>       // for std::vector
+
+#include "LeafFormat.hpp"
+#include "ProofTrace.hpp"
+
+using ZeroOneSolver::LeafReader;
+using ZeroOneSolver::LeafRecord;
+using ZeroOneSolver::read_varint;
+
+
+namespace {
+
+
+constexpr int MAX_DIMENSION = 128;
+
+
+enum class Value : std::uint8_t { FREE, BINARY, ZERO, ONE };
+
+
+enum class Sum : std::uint8_t { EITHER, ZERO, ONE };
+
+
+struct State {
+    Value p[MAX_DIMENSION + 1];
+    Value q[MAX_DIMENSION + 1];
+    // rhs[d - 1] is the value of the coefficient of x^d in PQ.
+    Sum rhs[2 * MAX_DIMENSION];
+}; // struct State
+
+
+// The state of the term p_i q_j in a given State. A factor is live if it is
+// not known to be 1, and a term is live if it is not known to be 0 or 1.
+struct TermState {
+    bool zero;
+    bool p_live;
+    bool q_live;
+
+    constexpr bool one() const noexcept { return !zero && !p_live && !q_live; }
+    constexpr bool live() const noexcept { return !zero && (p_live || q_live); }
+    constexpr bool linear() const noexcept {
+        return live() && !(p_live && q_live);
+    }
+}; // struct TermState
+
+
+struct CaseResult {
+    bool valid = false;
+    std::string error;
+    std::uint64_t num_nodes = 0;
+    std::uint64_t num_leaves = 0;
+    // The encoded leaf systems of the case, if requested (see encode_leaf).
+    std::string leaves;
+}; // struct CaseResult
+
+
+class Checker {
+
+    const int m;
+    const int n;
+    const int num_equations;
+    const bool symmetry;
+    const bool keep_leaves;
+
+    const std::uint8_t *cursor;
+    const std::uint8_t *end;
+    CaseResult *result;
+    std::vector<std::pair<int, int>> lone_products;
+
+    int first_term(int e) const noexcept { return std::max(0, e + 1 - n); }
+    int last_term(int e) const noexcept { return std::min(e + 1, m); }
+
+    static TermState term_state(const State &s, int i, int j) noexcept {
+        const Value p = s.p[i];
+        const Value q = s.q[j];
+        return {
+            (p == Value::ZERO) || (q == Value::ZERO),
+            p != Value::ONE,
+            q != Value::ONE,
+        };
+    }
+
+    static bool is_free(const State &s, int i, int j) noexcept {
+        const TermState t = term_state(s, i, j);
+        return t.live() && ((t.p_live && (s.p[i] == Value::FREE)) ||
+                            (t.q_live && (s.q[j] == Value::FREE)));
+    }
+
+    // Sets a variable to 0 or 1, returning false if it is already
+    // known to have the other value.
+    static bool assign(Value &x, Value value, bool &changed) noexcept {
+        if (x == value) { return true; }
+        if ((x == Value::ZERO) || (x == Value::ONE)) { return false; }
+        x = value;
+        changed = true;
+        return true;
+    }
+
+    // Returns the right-hand side of equation e after subtracting its term
+    // equal to 1, if any, from both sides.
+    Sum residual(const State &s, int e) const noexcept {
+        for (int i = first_term(e); i <= last_term(e); ++i) {
+            if (term_state(s, i, e + 1 - i).one()) { return Sum::ZERO; }
+        }
+        return s.rhs[e];
+    }
+
+    // Applies rule (1) until it makes no further changes, and
+    // returns false if it refutes the system.
+    bool propagate(State &s) const noexcept {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int e = 0; e < num_equations; ++e) {
+                const int d = e + 1;
+                int num_ones = 0;
+                int num_live = 0;
+                for (int i = first_term(e); i <= last_term(e); ++i) {
+                    const TermState t = term_state(s, i, d - i);
+                    num_ones += t.one();
+                    num_live += t.live();
+                }
+                if (num_ones > 1) { return false; }
+                if (num_ones == 1) {
+                    if (s.rhs[e] == Sum::ZERO) { return false; }
+                    if (s.rhs[e] == Sum::EITHER) {
+                        s.rhs[e] = Sum::ONE;
+                        changed = true;
+                    }
+                }
+                const Sum rest = num_ones ? Sum::ZERO : s.rhs[e];
+                if (num_live == 0) {
+                    if (rest == Sum::ONE) { return false; }
+                    if (rest == Sum::EITHER) {
+                        s.rhs[e] = Sum::ZERO;
+                        changed = true;
+                    }
+                    continue;
+                }
+                if ((rest == Sum::EITHER) ||
+                    ((rest == Sum::ONE) && (num_live > 1))) {
+                    continue;
+                }
+                for (int i = first_term(e); i <= last_term(e); ++i) {
+                    const int j = d - i;
+                    const TermState t = term_state(s, i, j);
+                    if (!t.live()) { continue; }
+                    const Value value =
+                        (rest == Sum::ZERO) ? Value::ZERO : Value::ONE;
+                    if ((rest == Sum::ZERO) && !t.linear()) { continue; }
+                    if (t.p_live && !assign(s.p[i], value, changed)) {
+                        return false;
+                    }
+                    if (t.q_live && !assign(s.q[j], value, changed)) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    static void mark_binary(Value &x, bool &changed) noexcept {
+        if (x == Value::FREE) {
+            x = Value::BINARY;
+            changed = true;
+        }
+    }
+
+    // Applies rule (2) until it makes no further changes.
+    void mark_binary(State &s) {
+        while (true) {
+            bool changed = false;
+            lone_products.clear();
+            for (int e = 0; e < num_equations; ++e) {
+                int num_free = 0;
+                int lone = 0;
+                for (int i = first_term(e); i <= last_term(e); ++i) {
+                    if (is_free(s, i, e + 1 - i)) {
+                        ++num_free;
+                        lone = i;
+                    }
+                }
+                if (num_free != 1) { continue; }
+                const int j = e + 1 - lone;
+                const TermState t = term_state(s, lone, j);
+                if (!t.linear()) {
+                    lone_products.emplace_back(lone, j);
+                } else if (t.p_live) {
+                    mark_binary(s.p[lone], changed);
+                } else {
+                    mark_binary(s.q[j], changed);
+                }
+            }
+            if (changed) { continue; }
+            for (int e = 0; e < num_equations; ++e) {
+                int num_live = 0;
+                int a = -1;
+                int b = -1;
+                for (int i = first_term(e); i <= last_term(e); ++i) {
+                    const int j = e + 1 - i;
+                    const TermState t = term_state(s, i, j);
+                    if (!t.live()) { continue; }
+                    ++num_live;
+                    if (t.linear() && t.p_live) { a = i; }
+                    if (t.linear() && t.q_live) { b = j; }
+                }
+                if ((num_live != 2) || (a < 0) || (b < 0)) { continue; }
+                if (std::find(
+                        lone_products.begin(),
+                        lone_products.end(),
+                        std::pair<int, int>(a, b)
+                    ) != lone_products.end()) {
+                    mark_binary(s.p[a], changed);
+                    mark_binary(s.q[b], changed);
+                }
+            }
+            if (!changed) { return; }
+        }
+    }
+
+    // Returns false if P(x) Q(x) and PQ(x) are incompatible at x = 1 or -1.
+    bool evaluation_consistent(const State &s) const noexcept {
+        for (const int x : {1, -1}) {
+            int p_lo = 0, p_hi = 0, q_lo = 0, q_hi = 0, r_lo = 0, r_hi = 0;
+            auto add = [](int &lo, int &hi, int sign, bool zero, bool one) {
+                if (one) {
+                    lo += sign;
+                    hi += sign;
+                } else if (!zero) {
+                    (sign > 0) ? ++hi : --lo;
+                }
+            };
+            for (int i = 0; i <= m; ++i) {
+                const int sign = ((i % 2) && (x < 0)) ? -1 : 1;
+                add(p_lo, p_hi, sign, s.p[i] == Value::ZERO,
+                    s.p[i] == Value::ONE);
+            }
+            for (int j = 0; j <= n; ++j) {
+                const int sign = ((j % 2) && (x < 0)) ? -1 : 1;
+                add(q_lo, q_hi, sign, s.q[j] == Value::ZERO,
+                    s.q[j] == Value::ONE);
+            }
+            for (int d = 0; d <= m + n; ++d) {
+                const int sign = ((d % 2) && (x < 0)) ? -1 : 1;
+                const Sum value =
+                    ((d == 0) || (d == m + n)) ? Sum::ONE : s.rhs[d - 1];
+                add(r_lo, r_hi, sign, value == Sum::ZERO, value == Sum::ONE);
+            }
+            const int corners[4] = {
+                p_lo * q_lo, p_lo * q_hi, p_hi * q_lo, p_hi * q_hi
+            };
+            const int pq_lo = *std::min_element(corners, corners + 4);
+            const int pq_hi = *std::max_element(corners, corners + 4);
+            if ((pq_hi < r_lo) || (r_hi < pq_lo)) { return false; }
+        }
+        return true;
+    }
+
+    bool is_self_mirror(const State &s) const noexcept {
+        for (int i = 1; 2 * i < m; ++i) {
+            if (s.p[i] != s.p[m - i]) { return false; }
+        }
+        for (int j = 1; 2 * j < n; ++j) {
+            if (s.q[j] != s.q[n - j]) { return false; }
+        }
+        for (int e = 0; 2 * e + 1 < num_equations; ++e) {
+            if (residual(s, e) != residual(s, num_equations - 1 - e)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Appends the leaf system in the layout of a binary leaf record, except
+    // that the terms of each equation are sorted.
+    void encode_leaf(const State &s) const {
+        std::string &out = result->leaves;
+        const std::size_t start = out.size();
+        out.append(2, '\0');
+        std::vector<bool> used(static_cast<std::size_t>(m + n + 2), false);
+        std::vector<std::pair<int, int>> terms;
+        int count = 0;
+        for (int e = 0; e < num_equations; ++e) {
+            if (residual(s, e) == Sum::ZERO) { continue; }
+            terms.clear();
+            for (int i = first_term(e); i <= last_term(e); ++i) {
+                const int j = e + 1 - i;
+                const TermState t = term_state(s, i, j);
+                if (!t.live()) { continue; }
+                terms.emplace_back(t.p_live ? i : 0, t.q_live ? j : 0);
+                if (t.p_live) { used[static_cast<std::size_t>(i)] = true; }
+                if (t.q_live) { used[static_cast<std::size_t>(m + j)] = true; }
+            }
+            std::sort(terms.begin(), terms.end());
+            out.push_back(static_cast<char>(terms.size()));
+            for (const auto &[i, j] : terms) {
+                out.push_back(static_cast<char>(i));
+                out.push_back(static_cast<char>(j));
+            }
+            ++count;
+        }
+        int num_free = 0;
+        for (int i = 1; i < m; ++i) {
+            if ((s.p[i] == Value::FREE) && !used[static_cast<std::size_t>(i)]) {
+                out.push_back(static_cast<char>(i));
+                out.push_back(0);
+                ++num_free;
+            }
+        }
+        for (int j = 1; j < n; ++j) {
+            if ((s.q[j] == Value::FREE) &&
+                !used[static_cast<std::size_t>(m + j)]) {
+                out.push_back(0);
+                out.push_back(static_cast<char>(j));
+                ++num_free;
+            }
+        }
+        out[start] = static_cast<char>(count);
+        out[start + 1] = static_cast<char>(num_free);
+    }
+
+    bool fail(const std::string &message) {
+        result->error = message;
+        return false;
+    }
+
+    bool read_operand(int &value, int lo, int hi) {
+        if (cursor == end) { return fail("truncated node"); }
+        value = *cursor++;
+        if ((value < lo) || (value > hi)) {
+            return fail("operand " + std::to_string(value) + " out of range");
+        }
+        return true;
+    }
+
+    // Checks the node at the cursor and all of its descendants, given the
+    // system to which the split that produced it was applied.
+    bool check_node(State s) {
+        if (cursor == end) { return fail("missing node"); }
+        ++result->num_nodes;
+        const std::uint8_t tag = *cursor++;
+        const bool consistent = propagate(s);
+        using namespace ZeroOneSolver;
+        if ((tag == PROOF_TWO_ONES) || (tag == PROOF_ZERO_EQUALS_ONE) ||
+            (tag == PROOF_ONE_EQUALS_ZERO)) {
+            int e;
+            if (!read_operand(e, 0, num_equations - 1)) { return false; }
+            return !consistent || fail("node is not refuted");
+        }
+        if (tag == PROOF_EVALUATION) {
+            return !consistent || !evaluation_consistent(s) ||
+                   fail("node is not refuted by evaluation");
+        }
+        if (!consistent) { return fail("node is inconsistent"); }
+        mark_binary(s);
+        bool has_free = false;
+        for (int i = 1; i < m; ++i) { has_free |= (s.p[i] == Value::FREE); }
+        for (int j = 1; j < n; ++j) { has_free |= (s.q[j] == Value::FREE); }
+        if (tag == PROOF_SOLVED) {
+            return !has_free || fail("solved node has undetermined variables");
+        }
+        if (tag == PROOF_LEAF) {
+            ++result->num_leaves;
+            if (keep_leaves) { encode_leaf(s); }
+            return true;
+        }
+        int a = 0;
+        int b = 0;
+        int e = 0;
+        State children[3] = {s, s, s};
+        int num_children = 2;
+        switch (tag) {
+            case PROOF_P_VARIABLE:
+            case PROOF_P_MIRRORED: {
+                if (!read_operand(a, 1, m - 1)) { return false; }
+                if (s.p[a] != Value::BINARY) {
+                    return fail("split variable is not known to be 0 or 1");
+                }
+                if (tag == PROOF_P_MIRRORED) {
+                    if (!symmetry || (2 * a == m) || !is_self_mirror(s)) {
+                        return fail("invalid mirrored split");
+                    }
+                    children[0].p[a] = children[0].p[m - a] = Value::ONE;
+                    children[1].p[a] = Value::ONE;
+                    children[1].p[m - a] = Value::ZERO;
+                    children[2].p[a] = children[2].p[m - a] = Value::ZERO;
+                    num_children = 3;
+                } else {
+                    children[0].p[a] = Value::ONE;
+                    children[1].p[a] = Value::ZERO;
+                }
+                break;
+            }
+            case PROOF_Q_VARIABLE:
+            case PROOF_Q_MIRRORED: {
+                if (!read_operand(b, 1, n - 1)) { return false; }
+                if (s.q[b] != Value::BINARY) {
+                    return fail("split variable is not known to be 0 or 1");
+                }
+                if (tag == PROOF_Q_MIRRORED) {
+                    if (!symmetry || (2 * b == n) || !is_self_mirror(s)) {
+                        return fail("invalid mirrored split");
+                    }
+                    children[0].q[b] = children[0].q[n - b] = Value::ONE;
+                    children[1].q[b] = Value::ONE;
+                    children[1].q[n - b] = Value::ZERO;
+                    children[2].q[b] = children[2].q[n - b] = Value::ZERO;
+                    num_children = 3;
+                } else {
+                    children[0].q[b] = Value::ONE;
+                    children[1].q[b] = Value::ZERO;
+                }
+                break;
+            }
+            case PROOF_PRODUCT_ZERO:
+            case PROOF_PRODUCT_ZERO_OR_ONE: {
+                if (!read_operand(a, 1, m - 1) || !read_operand(b, 1, n - 1) ||
+                    !read_operand(e, 0, num_equations - 1)) {
+                    return false;
+                }
+                const TermState t = term_state(s, a, b);
+                if ((a + b != e + 1) || !t.live() || t.linear()) {
+                    return fail("split product is not in the equation");
+                }
+                if (tag == PROOF_PRODUCT_ZERO) {
+                    if (residual(s, e) != Sum::ZERO) {
+                        return fail("split product does not sum to 0");
+                    }
+                    children[0].q[b] = Value::ZERO;
+                    children[1].p[a] = Value::ZERO;
+                } else {
+                    int num_live = 0;
+                    for (int i = first_term(e); i <= last_term(e); ++i) {
+                        num_live += term_state(s, i, e + 1 - i).live();
+                    }
+                    if ((residual(s, e) != Sum::EITHER) || (num_live != 1)) {
+                        return fail("split product is not alone");
+                    }
+                    children[0].p[a] = children[0].q[b] = Value::ONE;
+                    children[1].q[b] = Value::ZERO;
+                    children[2].p[a] = Value::ZERO;
+                    num_children = 3;
+                }
+                break;
+            }
+            case PROOF_EQUATION: {
+                if (!read_operand(e, 0, num_equations - 1)) { return false; }
+                if (residual(s, e) != Sum::EITHER) {
+                    return fail("split equation is already determined");
+                }
+                children[0].rhs[e] = Sum::ONE;
+                children[1].rhs[e] = Sum::ZERO;
+                break;
+            }
+            default: return fail("unknown tag " + std::to_string(tag));
+        }
+        for (int child = num_children - 1; child >= 0; --child) {
+            if (!check_node(children[child])) { return false; }
+        }
+        return true;
+    }
+
+public:
+
+    explicit Checker(int m, int n, bool symmetry, bool keep_leaves)
+        : m(m)
+        , n(n)
+        , num_equations(m + n - 1)
+        , symmetry(symmetry)
+        , keep_leaves(keep_leaves)
+        , cursor(nullptr)
+        , end(nullptr)
+        , result(nullptr)
+        , lone_products() {}
+
+    // Bit i - 1 of case_index selects whether p_i == 0 (if clear)
+    // or q_{M - i} == q_{N - i} == 0 (if set), for 1 <= i <= M - 1.
+    State root(std::uint64_t case_index) const noexcept {
+        State s;
+        for (int i = 0; i <= m; ++i) { s.p[i] = Value::FREE; }
+        for (int j = 0; j <= n; ++j) { s.q[j] = Value::FREE; }
+        for (int e = 0; e < num_equations; ++e) { s.rhs[e] = Sum::EITHER; }
+        s.p[0] = s.p[m] = s.q[0] = s.q[n] = Value::ONE;
+        s.q[m] = s.q[n - m] = Value::ZERO;
+        for (int i = 1; i < m; ++i) {
+            if ((case_index >> (i - 1)) & 1) {
+                s.q[m - i] = s.q[n - i] = Value::ZERO;
+            } else {
+                s.p[i] = Value::ZERO;
+            }
+        }
+        return s;
+    }
+
+    void check_case(
+        std::uint64_t case_index,
+        const std::uint8_t *nodes,
+        std::size_t size,
+        CaseResult &case_result
+    ) {
+        cursor = nodes;
+        end = nodes + size;
+        result = &case_result;
+        if (check_node(root(case_index))) {
+            result->valid = (cursor == end) || fail("trailing nodes");
+        }
+    }
+
+}; // class Checker
+
+
+constexpr std::uint64_t mirror_case(int m, std::uint64_t case_index) noexcept {
+    std::uint64_t result = 0;
+    for (int k = 0; k < m - 1; ++k) {
+        if ((case_index >> k) & 1) {
+            result |= static_cast<std::uint64_t>(1) << (m - 2 - k);
+        }
+    }
+    return result;
+}
+
+
+struct CaseRecord {
+    std::uint64_t case_index;
+    const std::uint8_t *nodes;
+    std::size_t size;
+}; // struct CaseRecord
+
+
+// Encodes a leaf record as Checker::encode_leaf() encodes a leaf system.
+std::string encode_record(const LeafRecord &record) {
+    std::string result;
+    result.push_back(static_cast<char>(record.num_equations()));
+    result.push_back(static_cast<char>(record.num_free_variables()));
+    std::vector<std::pair<int, int>> terms;
+    record.for_each_equation([&](const auto *data, std::size_t num_terms) {
+        terms.clear();
+        for (std::size_t k = 0; k < num_terms; ++k) {
+            terms.emplace_back(data[k].p_index, data[k].q_index);
+        }
+        std::sort(terms.begin(), terms.end());
+        result.push_back(static_cast<char>(num_terms));
+        for (const auto &[i, j] : terms) {
+            result.push_back(static_cast<char>(i));
+            result.push_back(static_cast<char>(j));
+        }
+    });
+    for (std::size_t k = 0; k < record.num_free_variables(); ++k) {
+        result.push_back(static_cast<char>(record.free_variables()[k].p_index));
+        result.push_back(static_cast<char>(record.free_variables()[k].q_index));
+    }
+    return result;
+}
+
+
+int usage(const char *program) {
+    std::cerr << "Usage: " << program
+              << " TRACE [--threads N] [--leaves FILE.bin]\n";
+    return EXIT_FAILURE;
+}
+
+
+} // namespace
+
+
+int main(int argc, char **argv) {
+    if (argc < 2) { return usage(argv[0]); }
+    const std::string trace_path = argv[1];
+    const unsigned num_cpus = std::max(std::thread::hardware_concurrency(), 1U);
+    unsigned num_threads = num_cpus;
+    std::string leaves_path;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "--threads") && (i + 1 < argc)) {
+            // Rejects garbage, 0, and counts far beyond the number of CPUs.
+            const std::string value = argv[++i];
+            const char *const end = value.data() + value.size();
+            unsigned count = 0;
+            const auto [ptr, error] =
+                std::from_chars(value.data(), end, count);
+            if ((error != std::errc()) || (ptr != end) || (count == 0) ||
+                (count > 4 * num_cpus)) {
+                return usage(argv[0]);
+            }
+            num_threads = count;
+        } else if ((arg == "--leaves") && (i + 1 < argc)) {
+            leaves_path = argv[++i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    std::ifstream file(trace_path, std::ios::binary);
+    const std::vector<std::uint8_t> trace(
+        (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()
+    );
+    const std::uint8_t *const header = trace.data();
+    std::uint32_t version = 0;
+    std::uint64_t begin_case = 0;
+    std::uint64_t end_case = 0;
+    if (trace.size() >= ZeroOneSolver::PROOF_HEADER_SIZE) {
+        for (int k = 0; k < 4; ++k) {
+            version |= static_cast<std::uint32_t>(header[8 + k]) << (8 * k);
+        }
+        for (int k = 0; k < 8; ++k) {
+            begin_case |= static_cast<std::uint64_t>(header[16 + k]) << (8 * k);
+            end_case |= static_cast<std::uint64_t>(header[24 + k]) << (8 * k);
+        }
+    }
+    if ((trace.size() < ZeroOneSolver::PROOF_HEADER_SIZE) ||
+        !std::equal(
+            ZeroOneSolver::PROOF_MAGIC,
+            ZeroOneSolver::PROOF_MAGIC + 8,
+            reinterpret_cast<const char *>(header)
+        ) ||
+        (version != ZeroOneSolver::PROOF_VERSION)) {
+        std::cerr << "ERROR: " << trace_path << " is not a proof trace.\n";
+        return EXIT_FAILURE;
+    }
+    const int m = header[12];
+    const int n = header[13];
+    const bool symmetry = header[14];
+    if ((m < 1) || (n <= m) || (n > MAX_DIMENSION) ||
+        (end_case < begin_case) ||
+        (end_case > (static_cast<std::uint64_t>(1) << (m - 1)))) {
+        std::cerr << "ERROR: " << trace_path
+                  << " has an unsupported header.\n";
+        return EXIT_FAILURE;
+    }
+
+    // Index the records, then check that every case appears exactly once.
+    std::vector<CaseRecord> records;
+    const std::uint8_t *cursor = header + ZeroOneSolver::PROOF_HEADER_SIZE;
+    const std::uint8_t *const trace_end = trace.data() + trace.size();
+    while (cursor < trace_end) {
+        std::uint64_t case_index;
+        std::uint64_t size;
+        if (!read_varint(cursor, trace_end, case_index) ||
+            !read_varint(cursor, trace_end, size) ||
+            (size > static_cast<std::uint64_t>(trace_end - cursor))) {
+            std::cerr << "ERROR: " << trace_path << " is truncated.\n";
+            return EXIT_FAILURE;
+        }
+        records.push_back({case_index, cursor, static_cast<std::size_t>(size)});
+        cursor += size;
+    }
+    std::sort(records.begin(), records.end(), [](const auto &x, const auto &y) {
+        return x.case_index < y.case_index;
+    });
+    std::uint64_t num_missing = 0;
+    std::uint64_t next = begin_case;
+    bool well_formed = true;
+    auto skip_to = [&](std::uint64_t stop) {
+        for (; next < stop; ++next) {
+            if (!symmetry || (next <= mirror_case(m, next))) { ++num_missing; }
+        }
+    };
+    for (const CaseRecord &record : records) {
+        if ((record.case_index < next) || (record.case_index >= end_case) ||
+            (symmetry &&
+             (record.case_index > mirror_case(m, record.case_index)))) {
+            std::cerr << "ERROR: Unexpected record for case "
+                      << record.case_index << ".\n";
+            well_formed = false;
+            continue;
+        }
+        skip_to(record.case_index);
+        next = record.case_index + 1;
+    }
+    skip_to(end_case);
+    if (num_missing) {
+        std::cerr << "ERROR: " << num_missing << " cases are missing.\n";
+        well_formed = false;
+    }
+
+    // Check the cases in parallel, each thread claiming one at a time.
+    const bool keep_leaves = !leaves_path.empty();
+    std::vector<CaseResult> results(records.size());
+    std::atomic<std::size_t> next_record = 0;
+    std::vector<std::thread> workers;
+    for (unsigned k = 0; k < num_threads; ++k) {
+        workers.emplace_back([&]() {
+            Checker checker(m, n, symmetry, keep_leaves);
+            std::size_t index;
+            while ((index = next_record++) < records.size()) {
+                const CaseRecord &record = records[index];
+                checker.check_case(
+                    record.case_index, record.nodes, record.size, results[index]
+                );
+            }
+        });
+    }
+    for (std::thread &worker : workers) { worker.join(); }
+
+    std::uint64_t num_nodes = 0;
+    std::uint64_t num_leaves = 0;
+    std::uint64_t num_invalid = 0;
+    for (std::size_t k = 0; k < records.size(); ++k) {
+        num_nodes += results[k].num_nodes;
+        num_leaves += results[k].num_leaves;
+        if (!results[k].valid) {
+            if (num_invalid < 10) {
+                std::cerr << "ERROR: Case " << records[k].case_index << ": "
+                          << results[k].error << " at node "
+                          << results[k].num_nodes << ".\n";
+            }
+            ++num_invalid;
+        }
+    }
+    if (num_invalid) {
+        std::cerr << "ERROR: " << num_invalid << " cases are invalid.\n";
+        well_formed = false;
+    }
+
+    // The leaf file holds the leaf systems of the cases in increasing order.
+    if (keep_leaves && well_formed) {
+        LeafReader reader(leaves_path);
+        LeafRecord record;
+        std::uint64_t num_read = 0;
+        bool matched = reader.is_valid() && (reader.m() == m) &&
+                       (reader.n() == n);
+        for (std::size_t k = 0; matched && (k < records.size()); ++k) {
+            const std::string &leaves = results[k].leaves;
+            std::size_t pos = 0;
+            while (matched && (pos < leaves.size())) {
+                if (!reader.next(record)) {
+                    matched = false;
+                    break;
+                }
+                ++num_read;
+                const std::string encoded = encode_record(record);
+                matched = (leaves.compare(pos, encoded.size(), encoded) == 0);
+                pos += encoded.size();
+            }
+        }
+        if (matched && reader.next(record)) { matched = false; }
+        matched = matched && reader.is_valid();
+        if (!matched) {
+            std::cerr << "ERROR: " << leaves_path
+                      << " does not match the leaf systems of the trace"
+                         " (first mismatch at leaf system "
+                      << num_read << ").\n";
+            well_formed = false;
+        }
+    }
+
+    std::cerr << "Checked " << records.size() << " cases of (M, N) = (" << m
+              << ", " << n << ") with " << num_nodes << " nodes and "
+              << num_leaves << " leaf systems.\n";
+    if (!well_formed) { return EXIT_FAILURE; }
+    std::cerr << "The proof trace is valid.\n";
+    return EXIT_SUCCESS;
+}
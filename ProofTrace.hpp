@@ -0,0 +1,271 @@
+#ifndef ZERO_ONE_SOLVER_PROOF_TRACE_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_PROOF_TRACE_HPP_INCLUDED
+
+#include <cstddef>     // for std::size_t
+#include <cstdint>     // for std::uint8_t, std::uint32_t, std::uint64_t
+#include <cstring>     // for std::memcpy
+#include <filesystem>  // for std::filesystem
+#include <fstream>     // for std::ofstream
+#include <mutex>       // for std::mutex, std::lock_guard
+#include <string>      // for std::string
+#include <type_traits> // for std::is_constant_evaluated
+
+namespace ZeroOneSolver {
+
+
+/**
+ * A proof trace records the search tree of every case of an (M, N) pair, so
+ * that ProofChecker.cpp can replay it and confirm, independently of the
+ * solver, that the leaf systems it wrote cover every solution in which some
+ * coefficient of P or Q is not 0 or 1. It consists of a 32-byte header
+ * (PROOF_MAGIC, then the version as a little-endian uint32, M, N, whether
+ * symmetry was broken, a reserved byte, and the range [begin_case, end_case)
+ * of cases solved as two little-endian uint64s), followed by one record per
+ * case, in any order:
+ *
+ *     varint case_index
+ *     varint size of the nodes, in bytes
+ *     the nodes of the case in the order visited by the search
+ *
+ * Varints are unsigned LEB128. The search is depth-first, so the nodes are
+ * in preorder, and the children of each case split are visited in reverse
+ * order, i.e., from child num_children() - 1 down to child 0 (see CaseSplit
+ * in ZeroOneSolver.cpp). Each node is a ProofTag byte followed by the
+ * operands listed next to it, one byte each. A split records the case
+ * distinction made, a leaf is a system written to the output, a solved
+ * node has every variable in {0, 1}, and every other tag names the rule
+ * that refuted the node: a conflict found by Phase 1 of simplify() (or by
+ * PRECHECK_LOCAL, without any propagation) in the given equation, or the
+ * evaluation bounds of PRECHECK_EVALUATION (see Precheck.hpp).
+ */
+enum ProofTag : std::uint8_t {
+    // These are the values of the corresponding SplitKind.
+    PROOF_P_VARIABLE = 0,          // p_index
+    PROOF_Q_VARIABLE = 1,          // q_index
+    PROOF_PRODUCT_ZERO = 2,        // p_index, q_index, equation
+    PROOF_PRODUCT_ZERO_OR_ONE = 3, // p_index, q_index, equation
+    PROOF_EQUATION = 4,            // equation
+    PROOF_P_MIRRORED = 5,          // p_index
+    PROOF_Q_MIRRORED = 6,          // q_index
+    PROOF_LEAF = 0x10,
+    PROOF_SOLVED = 0x11,
+    PROOF_TWO_ONES = 0x20,        // equation: ... + 1 + ... + 1 + ...
+    PROOF_ZERO_EQUALS_ONE = 0x21, // equation: 0 == 1
+    PROOF_ONE_EQUALS_ZERO = 0x22, // equation: ... + 1 + ... == 0
+    PROOF_EVALUATION = 0x23,
+}; // enum ProofTag
+
+
+constexpr char PROOF_MAGIC[8] = {'Z', 'O', 'P', 'R', 'O', 'O', 'F', '\n'};
+constexpr std::uint32_t PROOF_VERSION = 1;
+constexpr std::size_t PROOF_HEADER_SIZE = 32;
+
+
+inline void append_varint(std::string &out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+
+// Decodes a varint starting at cursor, which is advanced past it. Returns
+// false if the varint is malformed or does not end before end.
+inline bool read_varint(
+    const std::uint8_t *&cursor, const std::uint8_t *end, std::uint64_t &value
+) noexcept {
+    value = 0;
+    for (int shift = 0; (shift < 64) && (cursor < end); shift += 7) {
+        const std::uint8_t byte = *cursor++;
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) { return true; }
+    }
+    return false;
+}
+
+
+// The rule by which simplify() or a precheck most recently refuted a system
+// on this thread. Setting it costs one store on the path that returns false,
+// so it is always recorded, whether or not a trace is being written.
+struct Refutation {
+    ProofTag tag;
+    std::uint8_t equation;
+}; // struct Refutation
+
+
+inline thread_local Refutation LAST_REFUTATION = {PROOF_EVALUATION, 0};
+
+
+constexpr void refute(ProofTag tag, std::size_t equation = 0) noexcept {
+    if (!std::is_constant_evaluated()) {
+        LAST_REFUTATION = {tag, static_cast<std::uint8_t>(equation)};
+    }
+}
+
+
+/**
+ * A ProofTrace is a proof trace file being written, to which several
+ * threads may add the records of the cases they finish.
+ */
+class ProofTrace {
+
+    std::ofstream file;
+    std::mutex mutex;
+
+public:
+
+    explicit ProofTrace(
+        const std::filesystem::path &path,
+        int m,
+        int n,
+        bool break_symmetry,
+        std::uint64_t begin_case,
+        std::uint64_t end_case
+    )
+        : file(path, std::ios::binary | std::ios::trunc)
+        , mutex() {
+        char header[PROOF_HEADER_SIZE] = {};
+        std::memcpy(header, PROOF_MAGIC, sizeof(PROOF_MAGIC));
+        for (int k = 0; k < 4; ++k) {
+            header[8 + k] = static_cast<char>(PROOF_VERSION >> (8 * k));
+        }
+        header[12] = static_cast<char>(m);
+        header[13] = static_cast<char>(n);
+        header[14] = break_symmetry ? 1 : 0;
+        for (int k = 0; k < 8; ++k) {
+            header[16 + k] = static_cast<char>(begin_case >> (8 * k));
+            header[24 + k] = static_cast<char>(end_case >> (8 * k));
+        }
+        file.write(header, sizeof(header));
+    }
+
+    ProofTrace(const ProofTrace &) = delete;
+    ProofTrace &operator=(const ProofTrace &) = delete;
+
+    void add_case(std::uint64_t case_index, const std::string &nodes) {
+        std::string prefix;
+        append_varint(prefix, case_index);
+        append_varint(prefix, nodes.size());
+        std::lock_guard<std::mutex> lock(mutex);
+        file << prefix << nodes;
+    }
+
+    // Returns false if any record could not be written.
+    bool close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        file.close();
+        return !file.fail();
+    }
+
+}; // class ProofTrace
+
+
+/**
+ * A ProofRecorder collects the nodes visited by the search on one thread
+ * during a case, and adds them to a ProofTrace once the case ends. While it
+ * exists, it is the recorder of the thread that constructed it, to which
+ * the trace_*() functions below append, as record() does for THREAD_STATS.
+ * Like a CaseRecorder, it requires that cases are not shared by work
+ * stealing, and a case that is never ended leaves no record.
+ */
+class ProofRecorder;
+
+inline thread_local ProofRecorder *THREAD_PROOF = nullptr;
+
+
+class ProofRecorder {
+
+    static constexpr std::uint64_t NO_CASE = UINT64_MAX;
+
+    ProofTrace &trace;
+    ProofRecorder *const previous;
+    std::uint64_t case_index;
+    std::string nodes;
+
+public:
+
+    explicit ProofRecorder(ProofTrace &proof_trace)
+        : trace(proof_trace)
+        , previous(THREAD_PROOF)
+        , case_index(NO_CASE)
+        , nodes() {
+        THREAD_PROOF = this;
+    }
+
+    ProofRecorder(const ProofRecorder &) = delete;
+    ProofRecorder &operator=(const ProofRecorder &) = delete;
+
+    ~ProofRecorder() { THREAD_PROOF = previous; }
+
+    void begin_case(std::uint64_t index) {
+        end_case();
+        case_index = index;
+    }
+
+    void end_case() {
+        if (case_index == NO_CASE) { return; }
+        trace.add_case(case_index, nodes);
+        nodes.clear();
+        case_index = NO_CASE;
+    }
+
+    void node(std::uint8_t tag) { nodes.push_back(static_cast<char>(tag)); }
+
+    void operand(std::size_t value) {
+        nodes.push_back(static_cast<char>(value));
+    }
+
+}; // class ProofRecorder
+
+
+constexpr void trace_split(
+    std::uint8_t tag,
+    std::size_t p_index,
+    std::size_t q_index,
+    std::size_t equation
+) {
+    if (std::is_constant_evaluated()) { return; }
+    ProofRecorder *const proof = THREAD_PROOF;
+    if (!proof) { return; }
+    proof->node(tag);
+    switch (tag) {
+        case PROOF_P_VARIABLE:
+        case PROOF_P_MIRRORED: proof->operand(p_index); break;
+        case PROOF_Q_VARIABLE:
+        case PROOF_Q_MIRRORED: proof->operand(q_index); break;
+        case PROOF_PRODUCT_ZERO:
+        case PROOF_PRODUCT_ZERO_OR_ONE:
+            proof->operand(p_index);
+            proof->operand(q_index);
+            proof->operand(equation);
+            break;
+        case PROOF_EQUATION: proof->operand(equation); break;
+    }
+}
+
+
+inline void trace_leaf() {
+    if (THREAD_PROOF) { THREAD_PROOF->node(PROOF_LEAF); }
+}
+
+
+inline void trace_solved() {
+    if (THREAD_PROOF) { THREAD_PROOF->node(PROOF_SOLVED); }
+}
+
+
+// Records the refutation of the current node by LAST_REFUTATION.
+inline void trace_refuted() {
+    ProofRecorder *const proof = THREAD_PROOF;
+    if (!proof) { return; }
+    proof->node(LAST_REFUTATION.tag);
+    if (LAST_REFUTATION.tag != PROOF_EVALUATION) {
+        proof->operand(LAST_REFUTATION.equation);
+    }
+}
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_PROOF_TRACE_HPP_INCLUDED
@@ -0,0 +1,341 @@
+#ifndef ZERO_ONE_SOLVER_RESULT_STORE_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_RESULT_STORE_HPP_INCLUDED
+
+#include <algorithm>    // for std::max, std::stable_sort
+#include <cstddef>      // for std::size_t
+#include <cstdint>      // for std::uint8_t, std::uint32_t, std::uint64_t
+#include <cstring>      // for std::memcmp, std::memcpy
+#include <filesystem>   // for std::filesystem
+#include <fstream>      // for std::ofstream
+#include <iomanip>      // for std::setw, std::setfill
+#include <mutex>        // for std::mutex, std::lock_guard
+#include <sstream>      // for std::ostringstream
+#include <string>       // for std::string
+#include <system_error> // for std::error_code
+#include <vector>       // for std::vector
+
+#ifndef _WIN32
+#include <fcntl.h>  // for open, O_RDONLY
+#include <unistd.h> // for close, fsync, getpid
+#endif
+
+#include "FingerprintSet.hpp"
+
+namespace ZeroOneSolver {
+
+
+// Forces the contents of the file at path to stable storage. The data to be
+// synced must already have been flushed from any user-space buffers.
+inline bool sync_file(const std::filesystem::path &path) {
+#ifndef _WIN32
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+    const bool result = (::fsync(fd) == 0);
+    ::close(fd);
+    return result;
+#else
+    (void)path;
+    return true;
+#endif
+}
+
+
+/**
+ * A result store is a directory of immutable sorted runs, shared by the
+ * solver, Canonizer.py, and StreamingVerifier.py, which records which leaf
+ * systems each case of each (M, N) pair produced and whether each leaf
+ * system has been verified. The solver only appends to it; reading,
+ * querying, and compacting it are done by ResultStore.py.
+ *
+ * Every run is a file named run-SSSSSSSS-GGGG.dat, consisting of a 16-byte
+ * header (STORE_MAGIC, then the version as a little-endian uint32, then 4
+ * reserved bytes) followed by 32-byte records sorted by key. Each record is
+ * a 28-byte key, compared bytewise, followed by a little-endian uint32
+ * value. The first byte of the key selects the kind of record, and all
+ * multibyte fields of a key are big-endian, so that keys sort by their
+ * fields. Fingerprints are canonical fingerprints (see Canonizer.hpp),
+ * stored as their high word followed by their low word.
+ *
+ *   'C' M N case_index           a completed case; value = number of leaves
+ *   'H' fingerprint M N case_index   case_index produced this leaf system
+ *   'L' M N case_index fingerprint   the same fact, indexed by case
+ *   'V' fingerprint              verification status (see ResultStore.py)
+ *
+ * A record with the same key as a record in an earlier run supersedes it.
+ * Runs are ordered by (S, G): each new run takes S one greater than every
+ * existing run and G = 0, and a compaction of all runs up to S writes them
+ * as a single run with the same S and a greater G. New runs are created
+ * with a hard link, which fails if the name is taken, so several processes
+ * may append to the same store concurrently.
+ */
+constexpr char STORE_MAGIC[8] = {'Z', 'O', 'S', 'T', 'O', 'R', 'E', '\n'};
+constexpr std::uint32_t STORE_VERSION = 1;
+constexpr std::size_t STORE_KEY_SIZE = 28;
+
+
+struct StoreRecord {
+
+    std::uint8_t key[STORE_KEY_SIZE];
+    std::uint8_t value[4];
+
+    static StoreRecord make(char kind, std::uint32_t value) noexcept {
+        StoreRecord result = {};
+        result.key[0] = static_cast<std::uint8_t>(kind);
+        for (int k = 0; k < 4; ++k) {
+            result.value[k] = static_cast<std::uint8_t>(value >> (8 * k));
+        }
+        return result;
+    }
+
+    void put(std::size_t &pos, std::uint64_t field, int size) noexcept {
+        for (int k = size - 1; k >= 0; --k) {
+            key[pos++] = static_cast<std::uint8_t>(field >> (8 * k));
+        }
+    }
+
+    void put(std::size_t &pos, const Fingerprint &fingerprint) noexcept {
+        put(pos, fingerprint.high, 8);
+        put(pos, fingerprint.low, 8);
+    }
+
+    static StoreRecord completed_case(
+        int m, int n, std::uint64_t case_index, std::uint32_t num_leaves
+    ) noexcept {
+        StoreRecord result = make('C', num_leaves);
+        std::size_t pos = 1;
+        result.put(pos, static_cast<std::uint64_t>(m), 1);
+        result.put(pos, static_cast<std::uint64_t>(n), 1);
+        result.put(pos, case_index, 8);
+        return result;
+    }
+
+    static StoreRecord leaf_by_fingerprint(
+        const Fingerprint &fingerprint, int m, int n, std::uint64_t case_index
+    ) noexcept {
+        StoreRecord result = make('H', 0);
+        std::size_t pos = 1;
+        result.put(pos, fingerprint);
+        result.put(pos, static_cast<std::uint64_t>(m), 1);
+        result.put(pos, static_cast<std::uint64_t>(n), 1);
+        result.put(pos, case_index, 8);
+        return result;
+    }
+
+    static StoreRecord leaf_by_case(
+        int m, int n, std::uint64_t case_index, const Fingerprint &fingerprint
+    ) noexcept {
+        StoreRecord result = make('L', 0);
+        std::size_t pos = 1;
+        result.put(pos, static_cast<std::uint64_t>(m), 1);
+        result.put(pos, static_cast<std::uint64_t>(n), 1);
+        result.put(pos, case_index, 8);
+        result.put(pos, fingerprint);
+        return result;
+    }
+
+    bool operator<(const StoreRecord &other) const noexcept {
+        return std::memcmp(key, other.key, STORE_KEY_SIZE) < 0;
+    }
+
+    bool same_key(const StoreRecord &other) const noexcept {
+        return std::memcmp(key, other.key, STORE_KEY_SIZE) == 0;
+    }
+
+}; // struct StoreRecord
+
+
+static_assert(sizeof(StoreRecord) == 32);
+
+
+/**
+ * A ResultStore collects records in memory and appends them to a store
+ * directory as a new run whenever max_pending records have accumulated, and
+ * when flush() is called. It may be shared by several threads.
+ */
+class ResultStore {
+
+    const std::filesystem::path dir;
+    const std::size_t max_pending;
+    std::mutex mutex;
+    std::vector<StoreRecord> pending;
+    std::size_t num_runs_written;
+
+    static std::filesystem::path
+    run_path(const std::filesystem::path &dir, std::uint64_t sequence) {
+        std::ostringstream name;
+        name << "run-" << std::setw(8) << std::setfill('0') << sequence
+             << "-0000.dat";
+        return dir / name.str();
+    }
+
+    // Returns one more than the largest S of any run in dir.
+    std::uint64_t next_sequence() const {
+        std::uint64_t result = 1;
+        std::error_code error;
+        for (const auto &entry :
+             std::filesystem::directory_iterator(dir, error)) {
+            const std::string name = entry.path().filename().string();
+            if ((name.size() != 21) || !name.starts_with("run-") ||
+                !name.ends_with(".dat")) {
+                continue;
+            }
+            std::uint64_t sequence = 0;
+            for (std::size_t k = 4; k < 12; ++k) {
+                if ((name[k] < '0') || (name[k] > '9')) { break; }
+                sequence = 10 * sequence +
+                           static_cast<std::uint64_t>(name[k] - '0');
+            }
+            result = std::max(result, sequence + 1);
+        }
+        return result;
+    }
+
+    bool write_run() {
+        if (pending.empty()) { return true; }
+        // Sort the records, and keep only the last one added for each key.
+        std::stable_sort(pending.begin(), pending.end());
+        std::size_t size = 0;
+        for (std::size_t k = 0; k < pending.size(); ++k) {
+            const bool superseded = (k + 1 < pending.size()) &&
+                                    pending[k].same_key(pending[k + 1]);
+            if (!superseded) { pending[size++] = pending[k]; }
+        }
+        pending.resize(size);
+#ifndef _WIN32
+        const long pid = static_cast<long>(::getpid());
+#else
+        const long pid = 0;
+#endif
+        const std::filesystem::path temp_path =
+            dir / ("run-" + std::to_string(pid) + "-" +
+                   std::to_string(num_runs_written) + ".temp");
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            char header[16] = {};
+            std::memcpy(header, STORE_MAGIC, sizeof(STORE_MAGIC));
+            for (int k = 0; k < 4; ++k) {
+                header[8 + k] = static_cast<char>(STORE_VERSION >> (8 * k));
+            }
+            file.write(header, sizeof(header));
+            file.write(
+                reinterpret_cast<const char *>(pending.data()),
+                static_cast<std::streamsize>(
+                    pending.size() * sizeof(StoreRecord)
+                )
+            );
+            if (!file.flush()) { return false; }
+        }
+        if (!sync_file(temp_path)) { return false; }
+        std::error_code error;
+        for (std::uint64_t sequence = next_sequence();; ++sequence) {
+            std::filesystem::create_hard_link(
+                temp_path, run_path(dir, sequence), error
+            );
+            if (error != std::errc::file_exists) { break; }
+        }
+        std::filesystem::remove(temp_path);
+        if (error) { return false; }
+        pending.clear();
+        ++num_runs_written;
+        return true;
+    }
+
+public:
+
+    explicit ResultStore(
+        const std::filesystem::path &store_dir,
+        std::size_t max_pending_records = 1 << 20
+    )
+        : dir(store_dir)
+        , max_pending(max_pending_records)
+        , mutex()
+        , pending()
+        , num_runs_written(0) {
+        std::error_code error;
+        std::filesystem::create_directories(dir, error);
+    }
+
+    ResultStore(const ResultStore &) = delete;
+    ResultStore &operator=(const ResultStore &) = delete;
+
+    ~ResultStore() { flush(); }
+
+    // Returns false if a run could not be written, in which case its
+    // records are kept and written by a later call.
+    bool add(const StoreRecord *records, std::size_t count) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.insert(pending.end(), records, records + count);
+        return (pending.size() < max_pending) || write_run();
+    }
+
+    bool flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return write_run();
+    }
+
+}; // class ResultStore
+
+
+/**
+ * A CaseRecorder collects the canonical fingerprints of the leaf systems
+ * written by one LeafWriter during a case, and adds them to a ResultStore
+ * together with a completion record once the case ends. A case that is
+ * never ended, e.g., because the solver is interrupted, leaves no records.
+ * This requires every leaf system of a case to pass through the same
+ * writer, i.e., that cases are not shared by work stealing.
+ */
+class CaseRecorder {
+
+    static constexpr std::uint64_t NO_CASE = UINT64_MAX;
+
+    ResultStore &store;
+    const int m;
+    const int n;
+    std::uint64_t case_index;
+    std::vector<Fingerprint> leaves;
+    std::vector<StoreRecord> records;
+
+public:
+
+    explicit CaseRecorder(ResultStore &result_store, int m, int n)
+        : store(result_store)
+        , m(m)
+        , n(n)
+        , case_index(NO_CASE)
+        , leaves()
+        , records() {}
+
+    void begin_case(std::uint64_t index) {
+        end_case();
+        case_index = index;
+    }
+
+    void leaf(const Fingerprint &fingerprint) {
+        if (case_index != NO_CASE) { leaves.push_back(fingerprint); }
+    }
+
+    void end_case() {
+        if (case_index == NO_CASE) { return; }
+        records.clear();
+        for (const Fingerprint &fingerprint : leaves) {
+            records.push_back(
+                StoreRecord::leaf_by_fingerprint(fingerprint, m, n, case_index)
+            );
+            records.push_back(
+                StoreRecord::leaf_by_case(m, n, case_index, fingerprint)
+            );
+        }
+        records.push_back(StoreRecord::completed_case(
+            m, n, case_index, static_cast<std::uint32_t>(leaves.size())
+        ));
+        store.add(records.data(), records.size());
+        leaves.clear();
+        case_index = NO_CASE;
+    }
+
+}; // class CaseRecorder
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_RESULT_STORE_HPP_INCLUDED
@@ -0,0 +1,399 @@
+#!/usr/bin/env python3
+"""
+Read, query, and compact a result store written by the solver (with
+`ZeroOneSolver ... --store DIR`), Canonizer.py, and StreamingVerifier.py.
+
+    ResultStore.py DIR summary
+    ResultStore.py DIR cases FINGERPRINT
+    ResultStore.py DIR leaves M N CASE
+    ResultStore.py DIR unverified
+    ResultStore.py DIR diff OTHER_DIR
+    ResultStore.py DIR compact
+
+`cases` lists the cases that produced a leaf system, `leaves` lists the
+leaf systems of a case, `unverified` lists every known leaf system that has
+not been verified yet, and `diff` lists the cases that were completed in
+both stores but produced different leaf systems, e.g., after a change to
+the search heuristics. Fingerprints are printed as 32 hexadecimal digits.
+
+See ResultStore.hpp for a description of the on-disk format. A store is a
+directory of immutable sorted runs, so lookups are binary searches in each
+run, and writers only ever add new runs. `compact` merges all runs into one.
+"""
+
+import heapq
+import mmap
+import os
+import struct
+from collections.abc import Iterator
+from sys import argv, exit, stderr
+
+from Canonizer import System, parse_variable
+
+
+MAGIC = b"ZOSTORE\n"
+VERSION = 1
+HEADER = struct.Struct("<8sII")
+RECORD_SIZE = 32
+KEY_SIZE = 28
+
+# Verification status of a leaf system, stored in its 'V' record.
+UNVERIFIED = 0
+REFUTED_BY_PREFILTER = 1
+REFUTED_BY_CAS = 2
+POSSIBLE_SOLUTION = 3
+STATUS_NAMES = ["unverified", "refuted by prefilter", "refuted by CAS", "possible"]
+
+MASK64 = (1 << 64) - 1
+
+
+def rotl(x: int, r: int) -> int:
+    return ((x << r) | (x >> (64 - r))) & MASK64
+
+
+def fmix(k: int) -> int:
+    k ^= k >> 33
+    k = (k * 0xFF51AFD7ED558CCD) & MASK64
+    k ^= k >> 33
+    k = (k * 0xC4CEB9FE1A85EC53) & MASK64
+    k ^= k >> 33
+    return k
+
+
+def murmur3(data: bytes) -> int:
+    """
+    Compute the 128-bit MurmurHash3 (x64 variant, seed 0) of data, as
+    fingerprint_of() in FingerprintSet.hpp does, and return it as an
+    integer whose high 64 bits are the high word of the fingerprint.
+    """
+    c1 = 0x87C37B91114253D5
+    c2 = 0x4CF5AD432745937F
+    h1 = h2 = 0
+    num_blocks = len(data) // 16
+    for k1, k2 in struct.iter_unpack("<QQ", data[: 16 * num_blocks]):
+        k1 = rotl((k1 * c1) & MASK64, 31)
+        h1 ^= (k1 * c2) & MASK64
+        h1 = (rotl(h1, 27) + h2) & MASK64
+        h1 = (h1 * 5 + 0x52DCE729) & MASK64
+        k2 = rotl((k2 * c2) & MASK64, 33)
+        h2 ^= (k2 * c1) & MASK64
+        h2 = (rotl(h2, 31) + h1) & MASK64
+        h2 = (h2 * 5 + 0x38495AB5) & MASK64
+    tail = data[16 * num_blocks :]
+    k1 = int.from_bytes(tail[:8], "little")
+    k2 = int.from_bytes(tail[8:], "little")
+    if len(tail) > 8:
+        h2 ^= (rotl((k2 * c2) & MASK64, 33) * c1) & MASK64
+    if len(tail) > 0:
+        h1 ^= (rotl((k1 * c1) & MASK64, 31) * c2) & MASK64
+    h1 ^= len(data)
+    h2 ^= len(data)
+    h1 = (h1 + h2) & MASK64
+    h2 = (h2 + h1) & MASK64
+    h1 = fmix(h1)
+    h2 = fmix(h2)
+    h1 = (h1 + h2) & MASK64
+    h2 = (h2 + h1) & MASK64
+    return (h2 << 64) | h1
+
+
+def encode_variable(label: str, index: int) -> int:
+    return ((1 if label == "q" else 0) << 8) | index
+
+
+def fingerprint(system: System) -> int:
+    """
+    Return the fingerprint of a system in canonical form (see canonize() in
+    Canonizer.py), computed from the same byte encoding as
+    CanonicalSystem::encode() in Canonizer.hpp.
+    """
+    data = bytearray([len(system)])
+    for polynomial in system:
+        data.append(len(polynomial))
+        for term in polynomial:
+            first = encode_variable(*term[0])
+            second = encode_variable(*term[1]) if len(term) > 1 else 0
+            data += struct.pack("<HH", first, second)
+    return murmur3(bytes(data))
+
+
+def parse_wolfram(block: str) -> System:
+    """
+    Parse a system printed by wolfram_string() in Canonizer.py.
+    """
+    return tuple(
+        tuple(
+            tuple(
+                parse_variable(variable.replace("[", "").replace("]", ""))
+                for variable in term.split()
+            )
+            for term in line.split("+")
+        )
+        for line in block.splitlines()
+    )
+
+
+def fingerprint_key(kind: bytes, fingerprint: int) -> bytes:
+    return kind + fingerprint.to_bytes(16, "big")
+
+
+def case_key(kind: bytes, m: int, n: int, case_index: int) -> bytes:
+    return kind + bytes([m, n]) + case_index.to_bytes(8, "big")
+
+
+class Run:
+
+    def __init__(self, path: str):
+        self.path = path
+        with open(path, "rb") as file:
+            size = file.seek(0, 2)
+            if size < HEADER.size or (size - HEADER.size) % RECORD_SIZE:
+                raise ValueError(f"{path} is not a result store run")
+            self.view = memoryview(
+                mmap.mmap(file.fileno(), 0, access=mmap.ACCESS_READ)
+            )
+        magic, version, _ = HEADER.unpack_from(self.view, 0)
+        if magic != MAGIC or version != VERSION:
+            raise ValueError(f"{path} is not a result store run")
+        self.size = (size - HEADER.size) // RECORD_SIZE
+
+    def key(self, k: int) -> bytes:
+        pos = HEADER.size + RECORD_SIZE * k
+        return bytes(self.view[pos : pos + KEY_SIZE])
+
+    def value(self, k: int) -> int:
+        pos = HEADER.size + RECORD_SIZE * k + KEY_SIZE
+        return int.from_bytes(self.view[pos : pos + 4], "little")
+
+    def lower_bound(self, key: bytes) -> int:
+        lo, hi = 0, self.size
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if self.key(mid) < key:
+                lo = mid + 1
+            else:
+                hi = mid
+        return lo
+
+    def scan(self, prefix: bytes) -> Iterator[tuple[bytes, int]]:
+        k = self.lower_bound(prefix)
+        while k < self.size and (key := self.key(k)).startswith(prefix):
+            yield key, self.value(k)
+            k += 1
+
+
+def run_order(name: str) -> tuple[int, int] | None:
+    if len(name) == 21 and name.startswith("run-") and name.endswith(".dat"):
+        sequence, generation = name[4:12], name[13:17]
+        if sequence.isdigit() and generation.isdigit():
+            return int(sequence), int(generation)
+    return None
+
+
+class ResultStore:
+
+    def __init__(self, path: str):
+        self.path = path
+        self.pending: dict[bytes, int] = {}
+        os.makedirs(path, exist_ok=True)
+        self.reload()
+
+    def reload(self):
+        """
+        Open every run currently in the store, ordered from oldest to newest.
+        """
+        runs: list[tuple[tuple[int, int], str]] = []
+        for name in os.listdir(self.path):
+            order = run_order(name)
+            if order is not None:
+                runs.append((order, name))
+        runs.sort()
+        self.orders = [order for order, _ in runs]
+        self.runs: list[Run] = []
+        for _, name in runs:
+            try:
+                self.runs.append(Run(os.path.join(self.path, name)))
+            except FileNotFoundError:
+                # Removed by a concurrent compaction, whose result we have.
+                self.orders.remove(run_order(name))  # type: ignore
+
+    def get(self, key: bytes) -> int | None:
+        if key in self.pending:
+            return self.pending[key]
+        for run in reversed(self.runs):
+            k = run.lower_bound(key)
+            if k < run.size and run.key(k) == key:
+                return run.value(k)
+        return None
+
+    def scan(self, prefix: bytes) -> Iterator[tuple[bytes, int]]:
+        """
+        Return an iterator over all (key, value) pairs whose key starts with
+        prefix, in order of key, where a later record supersedes an earlier
+        one with the same key. Records added since the last flush are not
+        included.
+        """
+        streams = [
+            ((key, -rank, value) for key, value in run.scan(prefix))
+            for rank, run in enumerate(self.runs)
+        ]
+        previous: bytes | None = None
+        for key, _, value in heapq.merge(*streams):
+            if key != previous:
+                yield key, value
+                previous = key
+
+    def add(self, key: bytes, value: int):
+        assert len(key) <= KEY_SIZE
+        self.pending[key.ljust(KEY_SIZE, b"\0")] = value
+
+    def write_run(self, records: Iterator[tuple[bytes, int]], order: tuple[int, int]):
+        temp_path = os.path.join(self.path, f"run-{os.getpid()}-{order[0]}.temp")
+        with open(temp_path, "wb") as file:
+            file.write(HEADER.pack(MAGIC, VERSION, 0))
+            for key, value in records:
+                file.write(key + value.to_bytes(4, "little"))
+            file.flush()
+            os.fsync(file.fileno())
+        sequence, generation = order
+        while True:
+            path = os.path.join(self.path, f"run-{sequence:08}-{generation:04}.dat")
+            try:
+                os.link(temp_path, path)
+                break
+            except FileExistsError:
+                if generation:
+                    raise
+                sequence += 1
+        os.remove(temp_path)
+
+    def flush(self):
+        """
+        Append the records added since the last flush as a new run.
+        """
+        if self.pending:
+            self.reload()
+            sequence = self.orders[-1][0] + 1 if self.orders else 1
+            self.write_run(iter(sorted(self.pending.items())), (sequence, 0))
+            self.pending.clear()
+            self.reload()
+
+    def compact(self):
+        """
+        Merge all runs into a single run that supersedes them, and remove them.
+        Runs created concurrently are newer than the merged run, and are kept.
+        """
+        self.reload()
+        if len(self.runs) < 2:
+            return
+        sequence = self.orders[-1][0]
+        generation = max(g for s, g in self.orders if s == sequence) + 1
+        self.write_run(self.scan(b""), (sequence, generation))
+        for run in self.runs:
+            os.remove(run.path)
+        self.reload()
+
+    def completed_cases(self, m: int, n: int) -> dict[int, int]:
+        """
+        Return a dict mapping each completed case of (m, n) to its number
+        of leaf systems. A degree pair is complete if all 2^(m-1) cases
+        (or all representative cases, in symmetry mode) are present.
+        """
+        return {
+            int.from_bytes(key[3:11], "big"): value
+            for key, value in self.scan(b"C" + bytes([m, n]))
+        }
+
+    def cases_of_leaf(self, fingerprint: int) -> list[tuple[int, int, int]]:
+        return [
+            (key[17], key[18], int.from_bytes(key[19:27], "big"))
+            for key, _ in self.scan(fingerprint_key(b"H", fingerprint))
+        ]
+
+    def leaves_of_case(self, m: int, n: int, case_index: int) -> list[int]:
+        return [
+            int.from_bytes(key[11:27], "big")
+            for key, _ in self.scan(case_key(b"L", m, n, case_index))
+        ]
+
+    def status(self, fingerprint: int) -> int | None:
+        return self.get(fingerprint_key(b"V", fingerprint).ljust(KEY_SIZE, b"\0"))
+
+    def set_status(self, fingerprint: int, status: int):
+        self.add(fingerprint_key(b"V", fingerprint), status)
+
+    def unverified_leaves(self) -> Iterator[int]:
+        """
+        Return an iterator over the fingerprints of all leaf systems that were
+        produced by a case or recorded by Canonizer.py but are not verified.
+        """
+        statuses = {
+            int.from_bytes(key[1:17], "big"): value for key, value in self.scan(b"V")
+        }
+        previous: int | None = None
+        for key, _ in self.scan(b"H"):
+            fingerprint = int.from_bytes(key[1:17], "big")
+            if fingerprint != previous and statuses.get(fingerprint) is None:
+                yield fingerprint
+            previous = fingerprint
+        for fingerprint, status in statuses.items():
+            if status == UNVERIFIED:
+                yield fingerprint
+
+
+def changed_cases(old: ResultStore, new: ResultStore) -> Iterator[tuple[int, int, int]]:
+    """
+    Return an iterator over the cases completed in both stores whose leaf
+    systems differ between them.
+    """
+    old_cases = {key[1:11] for key, _ in old.scan(b"C")}
+    for key, _ in new.scan(b"C"):
+        if key[1:11] in old_cases:
+            m, n, case_index = key[1], key[2], int.from_bytes(key[3:11], "big")
+            if set(old.leaves_of_case(m, n, case_index)) != set(
+                new.leaves_of_case(m, n, case_index)
+            ):
+                yield m, n, case_index
+
+
+def main():
+    if len(argv) < 3:
+        print(__doc__, file=stderr)
+        exit(1)
+    store = ResultStore(argv[1])
+    command, args = argv[2], argv[3:]
+    if command == "summary" and not args:
+        counts: dict[tuple[int, int], int] = {}
+        for key, _ in store.scan(b"C"):
+            counts[(key[1], key[2])] = counts.get((key[1], key[2]), 0) + 1
+        for (m, n), count in sorted(counts.items()):
+            print(f"({m}, {n}): {count} of {1 << (m - 1)} cases completed")
+        # Leaf systems without a 'V' record have not been verified either.
+        statuses = [0] * len(STATUS_NAMES)
+        for _, value in store.scan(b"V"):
+            if value != UNVERIFIED:
+                statuses[value] += 1
+        statuses[UNVERIFIED] = sum(1 for _ in store.unverified_leaves())
+        for name, count in zip(STATUS_NAMES, statuses):
+            print(f"{count} leaf systems {name}")
+    elif command == "cases" and len(args) == 1:
+        for m, n, case_index in store.cases_of_leaf(int(args[0], 16)):
+            print(m, n, case_index)
+    elif command == "leaves" and len(args) == 3:
+        for fingerprint in store.leaves_of_case(*map(int, args)):
+            print(f"{fingerprint:032x}")
+    elif command == "unverified" and not args:
+        for fingerprint in store.unverified_leaves():
+            print(f"{fingerprint:032x}")
+    elif command == "diff" and len(args) == 1:
+        for m, n, case_index in changed_cases(ResultStore(args[0]), store):
+            print(m, n, case_index)
+    elif command == "compact" and not args:
+        store.compact()
+    else:
+        print(__doc__, file=stderr)
+        exit(1)
+
+
+if __name__ == "__main__":
+    main()
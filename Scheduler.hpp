@@ -0,0 +1,798 @@
+#ifndef ZERO_ONE_SOLVER_SCHEDULER_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_SCHEDULER_HPP_INCLUDED
+
+#include <algorithm>          // for std::max, std::sort, std::stable_sort
+#include <atomic>             // for std::atomic
+#include <chrono>             // for std::chrono
+#include <cmath>              // for std::ceil, std::exp2, std::log2
+#include <condition_variable> // for std::condition_variable
+#include <cstddef>            // for std::size_t
+#include <cstdint>            // for std::uint64_t
+#include <cstdlib>            // for std::abs
+#include <filesystem>         // for std::filesystem
+#include <fstream>            // for std::ifstream, std::ofstream
+#include <functional>         // for std::function
+#include <iomanip>            // for std::setw, std::setfill, std::setprecision
+#include <iostream>           // for std::cerr
+#include <map>                // for std::map
+#include <mutex>              // for std::mutex, std::lock_guard
+#include <ostream>            // for std::ostream
+#include <sstream>            // for std::ostringstream
+#include <string>             // for std::string
+#include <string_view>        // for std::string_view
+#include <thread>             // for std::thread
+#include <utility>            // for std::pair, std::move
+#include <vector>             // for std::vector
+
+#include "Checkpoint.hpp"
+#include "ParseNumber.hpp"
+
+namespace ZeroOneSolver {
+
+
+/**
+ * A CaseProfile describes how the cost of an (M, N) pair is distributed over
+ * its 2^(M-1) cases, as the cost of each of at most MAX_BUCKETS buckets of
+ * contiguous cases of equal width, within which cost is assumed to be
+ * uniform. An empty profile assigns the same cost to every case.
+ *
+ * Measured profiles come from the time taken by each unit of a PairScheduler,
+ * or from the per-case node counts written by --case-stats. Since pairs with
+ * the same M have the same cases, the profile of one is used to predict the
+ * cost of the cases of the other. Such predictions are blended with a
+ * uniform profile, so that no range of cases is predicted to be free.
+ */
+class CaseProfile {
+
+    static constexpr double UNIFORM_FRACTION = 0.1;
+
+    std::uint64_t num_cases;
+    std::uint64_t width;
+    std::vector<double> weights;
+
+    // Returns the cost of the cases in [begin, end), all of which must lie
+    // in bucket k.
+    double partial(std::size_t k, std::uint64_t begin, std::uint64_t end)
+        const noexcept {
+        return weights[k] * static_cast<double>(end - begin) /
+               static_cast<double>(width);
+    }
+
+public:
+
+    static constexpr std::size_t MAX_BUCKETS = 256;
+
+    CaseProfile() noexcept
+        : num_cases(0)
+        , width(1)
+        , weights() {}
+
+    // Constructs a profile of the given number of cases, which must be a
+    // power of two, in which every case has zero cost.
+    explicit CaseProfile(std::uint64_t case_count)
+        : num_cases(case_count)
+        , width(std::max<std::uint64_t>(case_count / MAX_BUCKETS, 1))
+        , weights(static_cast<std::size_t>(case_count / width), 0.0) {}
+
+    bool empty() const noexcept { return weights.empty(); }
+
+    std::uint64_t cases() const noexcept { return num_cases; }
+
+    const std::vector<double> &buckets() const noexcept { return weights; }
+
+    // Replaces the bucket costs of this profile. Returns false if their
+    // number does not match.
+    bool assign(const std::vector<double> &bucket_costs) {
+        if (bucket_costs.size() != weights.size()) { return false; }
+        weights = bucket_costs;
+        return true;
+    }
+
+    // Spreads the given cost uniformly over the cases in [begin, end).
+    void add(std::uint64_t begin, std::uint64_t end, double cost) {
+        if (empty() || (begin >= end)) { return; }
+        const double density = cost / static_cast<double>(end - begin);
+        for (std::uint64_t pos = begin; pos < end;) {
+            const std::size_t k = static_cast<std::size_t>(pos / width);
+            const std::uint64_t next = std::min(width * (k + 1), end);
+            weights[k] += density * static_cast<double>(next - pos);
+            pos = next;
+        }
+    }
+
+    double total() const noexcept {
+        double result = 0.0;
+        for (const double weight : weights) { result += weight; }
+        return result;
+    }
+
+    // Returns the cost of the cases in [begin, end), or their number if
+    // this profile is empty.
+    double cost(std::uint64_t begin, std::uint64_t end) const noexcept {
+        if (empty()) { return static_cast<double>(end - begin); }
+        double result = 0.0;
+        for (std::uint64_t pos = begin; pos < end;) {
+            const std::size_t k = static_cast<std::size_t>(pos / width);
+            const std::uint64_t next = std::min(width * (k + 1), end);
+            result += partial(k, pos, next);
+            pos = next;
+        }
+        return result;
+    }
+
+    // Returns the fraction of the total cost spent on the cases in
+    // [begin, end).
+    double fraction(std::uint64_t begin, std::uint64_t end) const noexcept {
+        const double sum = empty() ? 0.0 : total();
+        if (sum <= 0.0) {
+            return static_cast<double>(end - begin) /
+                   static_cast<double>(std::max<std::uint64_t>(num_cases, 1));
+        }
+        return cost(begin, end) / sum;
+    }
+
+    // Returns the least position in [begin, end] such that the cases in
+    // [begin, position) cost at least target, or end if there is none.
+    std::uint64_t
+    advance(std::uint64_t begin, std::uint64_t end, double target)
+        const noexcept {
+        if (empty()) {
+            const double count = std::ceil(std::max(target, 0.0));
+            return (count >= static_cast<double>(end - begin))
+                       ? end
+                       : begin + static_cast<std::uint64_t>(count);
+        }
+        for (std::uint64_t pos = begin; pos < end;) {
+            const std::size_t k = static_cast<std::size_t>(pos / width);
+            const std::uint64_t next = std::min(width * (k + 1), end);
+            const double bucket_cost = partial(k, pos, next);
+            if (bucket_cost >= target) {
+                const double density = weights[k] / static_cast<double>(width);
+                const std::uint64_t count =
+                    (density > 0.0) ? static_cast<std::uint64_t>(
+                                          std::ceil(target / density)
+                                      )
+                                    : 0;
+                return std::min(pos + count, next);
+            }
+            target -= bucket_cost;
+            pos = next;
+        }
+        return end;
+    }
+
+    // Divides [begin, end) into count contiguous ranges of nearly equal
+    // cost, and returns their count + 1 boundaries. Every range is nonempty
+    // if count <= end - begin.
+    std::vector<std::uint64_t>
+    split(std::uint64_t begin, std::uint64_t end, std::uint64_t count) const {
+        std::vector<std::uint64_t> result;
+        result.reserve(static_cast<std::size_t>(count + 1));
+        result.push_back(begin);
+        const double share = cost(begin, end) / static_cast<double>(count);
+        std::uint64_t pos = begin;
+        for (std::uint64_t i = 1; i < count; ++i) {
+            // Leave at least one case for each of the remaining ranges.
+            const std::uint64_t lo = std::min(pos + 1, end);
+            const std::uint64_t hi = (end - begin >= count)
+                                         ? end - (count - i)
+                                         : end;
+            pos = std::clamp(advance(pos, end, share), lo, std::max(lo, hi));
+            result.push_back(pos);
+        }
+        result.push_back(end);
+        return result;
+    }
+
+    // Returns a copy of this profile, normalized to a total cost of 1 and
+    // blended with a uniform profile.
+    CaseProfile prediction() const {
+        CaseProfile result = *this;
+        const double sum = total();
+        if (sum <= 0.0) { return CaseProfile(); }
+        const double uniform = 1.0 / static_cast<double>(weights.size());
+        for (double &weight : result.weights) {
+            weight = (1.0 - UNIFORM_FRACTION) * (weight / sum) +
+                     UNIFORM_FRACTION * uniform;
+        }
+        return result;
+    }
+
+    // Reads the node counts of a CSV file written by --case-stats for a
+    // pair with the given number of cases. Returns false if the file cannot
+    // be read or does not belong to such a pair.
+    bool read_case_stats(
+        const std::filesystem::path &path, std::uint64_t case_count
+    ) {
+        *this = CaseProfile(case_count);
+        std::ifstream file(path);
+        std::string line;
+        if (!std::getline(file, line) || !line.starts_with("case_index,")) {
+            return false;
+        }
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            std::uint64_t case_index;
+            std::uint64_t nodes;
+            char comma;
+            if (!(fields >> case_index >> comma >> nodes) || (comma != ',') ||
+                (case_index >= case_count)) {
+                return false;
+            }
+            add(case_index, case_index + 1, static_cast<double>(nodes));
+        }
+        return file.eof();
+    }
+
+}; // class CaseProfile
+
+
+/**
+ * A CostHistory records how many thread-seconds each (M, N) pair took to
+ * solve in previous runs, and predicts the cost of pairs that have not been
+ * solved yet. The cost of a pair grows by a factor of about 2 with each
+ * increment of M and about sqrt(2) with each increment of N, so an unsolved
+ * pair is predicted to cost prior_cost(M, N), scaled by the geometric mean
+ * ratio of measured to prior cost over the pairs solved so far. Pairs that
+ * took less than MIN_FIT_SECONDS are not used, since they are dominated by
+ * timer noise and startup costs. It also records the measured CaseProfile
+ * of each pair, from which the profile of a pair with the same M and the
+ * nearest N is predicted.
+ *
+ * The history is stored as one line "M N SECONDS" per pair, followed by the
+ * bucket costs of its profile, if any.
+ */
+class CostHistory {
+
+    static constexpr double MIN_FIT_SECONDS = 0.05;
+    static constexpr double MIN_COST = 1.0e-6;
+
+    std::map<std::pair<int, int>, double> seconds;
+    std::map<std::pair<int, int>, CaseProfile> profiles;
+
+    static double prior_cost(int m, int n) noexcept {
+        return std::exp2(m + 0.5 * n - 25.0);
+    }
+
+public:
+
+    // Returns false if path exists but could not be parsed.
+    bool load(const std::filesystem::path &path) {
+        if (!std::filesystem::exists(path)) { return true; }
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            int m;
+            int n;
+            double value;
+            if (!(fields >> m >> n >> value) || (m < 1) || (m > 64)) {
+                return false;
+            }
+            seconds[{m, n}] = value;
+            std::vector<double> bucket_costs;
+            while (fields >> value) { bucket_costs.push_back(value); }
+            if (!fields.eof()) { return false; }
+            if (!bucket_costs.empty()) {
+                CaseProfile profile(static_cast<std::uint64_t>(1) << (m - 1));
+                if (!profile.assign(bucket_costs)) { return false; }
+                profiles[{m, n}] = std::move(profile);
+            }
+        }
+        return file.eof();
+    }
+
+    bool save(const std::filesystem::path &path) const {
+        std::filesystem::path temp_path = path;
+        temp_path += ".temp";
+        {
+            std::ofstream file(temp_path, std::ios::trunc);
+            file << std::setprecision(6);
+            for (const auto &[pair, value] : seconds) {
+                file << pair.first << " " << pair.second << " " << value;
+                const auto found = profiles.find(pair);
+                if (found != profiles.end()) {
+                    for (const double weight : found->second.buckets()) {
+                        file << " " << weight;
+                    }
+                }
+                file << "\n";
+            }
+            if (!file) { return false; }
+        }
+        std::error_code error;
+        std::filesystem::rename(temp_path, path, error);
+        return !error;
+    }
+
+    void record(int m, int n, double value) { seconds[{m, n}] = value; }
+
+    void record_profile(int m, int n, const CaseProfile &profile) {
+        profiles[{m, n}] = profile;
+    }
+
+    // Returns the predicted profile of (M, N), which is empty if no pair
+    // with the same M has a recorded profile.
+    CaseProfile predict_profile(int m, int n) const {
+        const CaseProfile *nearest = nullptr;
+        int distance = 0;
+        for (const auto &[pair, profile] : profiles) {
+            if (pair.first != m) { continue; }
+            // Prefer smaller N on ties, since those are usually measured.
+            const int d = 2 * std::abs(pair.second - n) +
+                          ((pair.second > n) ? 1 : 0);
+            if (!nearest || (d < distance)) {
+                nearest = &profile;
+                distance = d;
+            }
+        }
+        return nearest ? nearest->prediction() : CaseProfile();
+    }
+
+    double estimate(int m, int n) const {
+        const auto found = seconds.find({m, n});
+        if (found != seconds.end()) {
+            return std::max(found->second, MIN_COST);
+        }
+        double log_ratio = 0.0;
+        std::size_t count = 0;
+        for (const auto &[pair, value] : seconds) {
+            if (value >= MIN_FIT_SECONDS) {
+                log_ratio += std::log2(
+                    value / prior_cost(pair.first, pair.second)
+                );
+                ++count;
+            }
+        }
+        const double scale =
+            count ? std::exp2(log_ratio / static_cast<double>(count)) : 1.0;
+        return std::max(scale * prior_cost(m, n), MIN_COST);
+    }
+
+}; // class CostHistory
+
+
+// Formats a duration in seconds as, e.g., "1h02m03s".
+inline std::string format_duration(double seconds) {
+    const std::uint64_t total =
+        static_cast<std::uint64_t>(std::max(seconds, 0.0) + 0.5);
+    std::ostringstream result;
+    result << std::setfill('0');
+    if (total >= 3600) {
+        result << (total / 3600) << "h" << std::setw(2) << (total / 60 % 60)
+               << "m" << std::setw(2);
+    } else if (total >= 60) {
+        result << (total / 60) << "m" << std::setw(2);
+    }
+    result << (total % 60) << "s";
+    return result.str();
+}
+
+
+/**
+ * A PairScheduler solves many (M, N) pairs in one process, sharing a single
+ * pool of threads between all of them. Each pair is divided into units,
+ * which are contiguous ranges of case indices, and every thread repeatedly
+ * takes the next unit and solves it with solve_unit(). Since the output of
+ * a range of cases is exactly the corresponding segment of the output for
+ * all cases, the output of each unit is written to its own part file, and
+ * the parts of a pair are concatenated in order of case index once all of
+ * them are complete. The first header_size bytes of every part but the
+ * first are skipped, so that a binary leaf file has only one header.
+ *
+ * Pairs are scheduled in decreasing order of cost, as predicted by a
+ * CostHistory, and are divided into units of roughly equal predicted cost,
+ * using the predicted CaseProfile of each pair to place unit boundaries.
+ * Units are then started in decreasing order of predicted cost. Hence, the
+ * most expensive work is started first and shared between all threads,
+ * instead of being left as a long tail at the end of the run. The time
+ * taken by each unit is recorded as the measured profile of its pair.
+ * Progress, and the estimated time remaining, are reported periodically.
+ *
+ * Part files are stored in a directory next to the output file of their
+ * pair, in the same layout as DistributedSolver.py. Existing parts from an
+ * interrupted run are kept, and only the remaining cases are solved.
+ */
+class PairScheduler {
+
+public:
+
+    using SolveUnit = std::function<bool(
+        int m, int n, std::uint64_t begin, std::uint64_t end, std::ostream &
+    )>;
+
+private:
+
+    using clock = std::chrono::steady_clock;
+
+    // Every thread is given on the order of this many units in total.
+    static constexpr double UNITS_PER_THREAD = 8.0;
+
+    struct Pair {
+        int m;
+        int n;
+        std::filesystem::path path;
+        std::filesystem::path parts_dir;
+        double cost;
+        CaseProfile predicted;
+        CaseProfile measured;
+        // Ranges of cases that are not yet solved when the run starts.
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> gaps;
+        std::size_t num_units;
+        std::size_t remaining_units;
+        std::uint64_t solved_cases;
+        double seconds;
+    }; // struct Pair
+
+    struct Unit {
+        std::size_t pair_index;
+        std::uint64_t begin;
+        std::uint64_t end;
+        double cost;
+    }; // struct Unit
+
+    const std::filesystem::path history_path;
+    const std::size_t header_size;
+    const SolveUnit solve_unit;
+    CostHistory history;
+    std::vector<Pair> pairs;
+    std::vector<Unit> units;
+    std::atomic<std::size_t> next_unit;
+
+    // The members below are guarded by mutex.
+    std::mutex mutex;
+    std::condition_variable progress_changed;
+    double total_cost;
+    double completed_cost;
+    std::size_t num_finished_pairs;
+    unsigned num_running_threads;
+    bool failed;
+
+    static std::uint64_t num_cases(int m) noexcept {
+        return static_cast<std::uint64_t>(1) << (m - 1);
+    }
+
+    static std::filesystem::path part_path(
+        const std::filesystem::path &parts_dir,
+        std::uint64_t begin,
+        std::uint64_t end
+    ) {
+        std::ostringstream name;
+        name << std::setfill('0') << "cases-" << std::setw(20) << begin << "-"
+             << std::setw(20) << end << ".part";
+        return parts_dir / name.str();
+    }
+
+    // Returns the ranges of cases of the complete parts in parts_dir,
+    // ignoring files whose names are not those of parts.
+    static std::vector<std::pair<std::uint64_t, std::uint64_t>>
+    complete_parts(const std::filesystem::path &parts_dir) {
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> result;
+        if (!std::filesystem::is_directory(parts_dir)) { return result; }
+        for (const auto &entry :
+             std::filesystem::directory_iterator(parts_dir)) {
+            const std::string name = entry.path().filename().string();
+            const std::string_view view = name;
+            std::uint64_t begin = 0;
+            std::uint64_t end = 0;
+            if ((name.size() == 52) && name.starts_with("cases-") &&
+                name.ends_with(".part") && (name[26] == '-') &&
+                parse_number(view.substr(6, 20), begin, std::uint64_t(0),
+                             UINT64_MAX - 1) &&
+                parse_number(view.substr(27, 20), end, begin + 1,
+                             UINT64_MAX)) {
+                result.emplace_back(begin, end);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    // Concatenates the parts of a pair into its output file, and removes
+    // them. Must be called after every unit of the pair is complete.
+    bool merge(const Pair &pair) const {
+        std::filesystem::path temp_path = pair.path;
+        temp_path += ".temp";
+        {
+            std::ofstream output(temp_path, std::ios::binary | std::ios::trunc);
+            std::uint64_t position = 0;
+            for (const auto &[begin, end] : complete_parts(pair.parts_dir)) {
+                if (begin != position) { return false; }
+                const std::filesystem::path path =
+                    part_path(pair.parts_dir, begin, end);
+                const std::size_t skip = (position == 0) ? 0 : header_size;
+                if (std::filesystem::file_size(path) > skip) {
+                    std::ifstream part(path, std::ios::binary);
+                    part.seekg(static_cast<std::streamoff>(skip));
+                    output << part.rdbuf();
+                }
+                position = end;
+            }
+            if ((position != num_cases(pair.m)) || !output) { return false; }
+        }
+        sync_file(temp_path);
+        std::error_code error;
+        std::filesystem::rename(temp_path, pair.path, error);
+        if (error) { return false; }
+        std::filesystem::remove_all(pair.parts_dir, error);
+        return true;
+    }
+
+    // Divides the unsolved cases of every pair into units of roughly equal
+    // predicted cost, and orders them by decreasing cost of their pairs.
+    void make_units(unsigned num_threads) {
+        total_cost = 0.0;
+        for (const Pair &pair : pairs) {
+            for (const auto &[begin, end] : pair.gaps) {
+                total_cost += pair.cost * pair.predicted.fraction(begin, end);
+            }
+        }
+        const double unit_cost =
+            total_cost / (UNITS_PER_THREAD * static_cast<double>(num_threads));
+        std::vector<std::size_t> order(pairs.size());
+        for (std::size_t k = 0; k < order.size(); ++k) { order[k] = k; }
+        std::stable_sort(
+            order.begin(),
+            order.end(),
+            [&](std::size_t a, std::size_t b) {
+                return pairs[a].cost > pairs[b].cost;
+            }
+        );
+        units.clear();
+        for (const std::size_t k : order) {
+            Pair &pair = pairs[k];
+            for (const auto &[begin, end] : pair.gaps) {
+                const std::uint64_t count = std::clamp<std::uint64_t>(
+                    static_cast<std::uint64_t>(std::ceil(
+                        pair.cost * pair.predicted.fraction(begin, end) /
+                        unit_cost
+                    )),
+                    1,
+                    end - begin
+                );
+                const std::vector<std::uint64_t> bounds =
+                    pair.predicted.split(begin, end, count);
+                for (std::uint64_t i = 0; i < count; ++i) {
+                    units.push_back(
+                        {k,
+                         bounds[i],
+                         bounds[i + 1],
+                         pair.cost *
+                             pair.predicted.fraction(bounds[i], bounds[i + 1])}
+                    );
+                }
+                pair.num_units += count;
+                pair.remaining_units += count;
+            }
+        }
+        // Units of equal predicted cost are started in the order above.
+        std::stable_sort(
+            units.begin(),
+            units.end(),
+            [](const Unit &a, const Unit &b) { return a.cost > b.cost; }
+        );
+    }
+
+    // Must be called with mutex held.
+    void finish_pair(Pair &pair, bool merged) {
+        if (!merged) {
+            std::cerr << "ERROR: Failed to merge the parts of "
+                      << pair.path.string() << ".\n";
+            failed = true;
+            return;
+        }
+        ++num_finished_pairs;
+        if (pair.solved_cases) {
+            history.record(
+                pair.m,
+                pair.n,
+                pair.seconds * static_cast<double>(num_cases(pair.m)) /
+                    static_cast<double>(pair.solved_cases)
+            );
+            // A profile measured on part of the cases would be misleading,
+            // and one measured by a single unit says nothing.
+            if ((pair.solved_cases == num_cases(pair.m)) &&
+                (pair.num_units > 1)) {
+                history.record_profile(pair.m, pair.n, pair.measured);
+            }
+            if (!history.save(history_path)) {
+                std::cerr << "WARNING: Failed to write "
+                          << history_path.string() << ".\n";
+            }
+        }
+        std::cerr << "Finished computing " << pair.path.string() << ".\n";
+    }
+
+    void work() {
+        while (true) {
+            const std::size_t index = next_unit.fetch_add(1);
+            if (index >= units.size()) { break; }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (failed) { break; }
+            }
+            const Unit &unit = units[index];
+            Pair &pair = pairs[unit.pair_index];
+            const std::filesystem::path path =
+                part_path(pair.parts_dir, unit.begin, unit.end);
+            std::filesystem::path temp_path = path;
+            temp_path += ".temp";
+            const clock::time_point start = clock::now();
+            std::error_code error;
+            std::filesystem::create_directories(pair.parts_dir, error);
+            bool solved;
+            {
+                std::ofstream file(
+                    temp_path, std::ios::binary | std::ios::trunc
+                );
+                solved = file && solve_unit(
+                                     pair.m, pair.n, unit.begin, unit.end, file
+                                 );
+                file.close();
+                solved = solved && file;
+            }
+            if (solved) {
+                sync_file(temp_path);
+                std::filesystem::rename(temp_path, path, error);
+                solved = !error;
+            }
+            const double seconds =
+                std::chrono::duration<double>(clock::now() - start).count();
+            bool last = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                completed_cost += unit.cost;
+                pair.seconds += seconds;
+                pair.solved_cases += unit.end - unit.begin;
+                pair.measured.add(unit.begin, unit.end, seconds);
+                if (!solved) {
+                    std::cerr << "ERROR: Failed to solve cases " << unit.begin
+                              << ":" << unit.end << " of "
+                              << pair.path.string() << ".\n";
+                    failed = true;
+                } else {
+                    last = (--pair.remaining_units == 0);
+                }
+            }
+            if (last) {
+                const bool merged = merge(pair);
+                std::lock_guard<std::mutex> lock(mutex);
+                finish_pair(pair, merged);
+            }
+            progress_changed.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        --num_running_threads;
+        progress_changed.notify_all();
+    }
+
+    // Must be called with mutex held.
+    void print_progress(double elapsed) const {
+        const double fraction =
+            (total_cost > 0.0) ? std::min(completed_cost / total_cost, 1.0)
+                               : 1.0;
+        std::ostringstream percent;
+        percent << std::fixed << std::setprecision(1) << (100.0 * fraction);
+        std::cerr << "Progress: " << percent.view()
+                  << "% of estimated work, " << num_finished_pairs << " of "
+                  << pairs.size() << " pairs finished, "
+                  << format_duration(elapsed) << " elapsed";
+        if (fraction > 0.0) {
+            std::cerr << ", ETA "
+                      << format_duration(elapsed * (1.0 - fraction) / fraction);
+        }
+        std::cerr << ".\n";
+    }
+
+public:
+
+    explicit PairScheduler(
+        const std::filesystem::path &cost_history_path,
+        std::size_t skipped_header_size,
+        SolveUnit solve
+    )
+        : history_path(cost_history_path)
+        , header_size(skipped_header_size)
+        , solve_unit(std::move(solve))
+        , history()
+        , pairs()
+        , units()
+        , next_unit(0)
+        , mutex()
+        , progress_changed()
+        , total_cost(0.0)
+        , completed_cost(0.0)
+        , num_finished_pairs(0)
+        , num_running_threads(0)
+        , failed(false) {
+        if (!history.load(history_path)) {
+            std::cerr << "WARNING: Ignoring malformed cost history "
+                      << history_path.string() << ".\n";
+            history = CostHistory();
+        }
+    }
+
+    PairScheduler(const PairScheduler &) = delete;
+    PairScheduler &operator=(const PairScheduler &) = delete;
+
+    // Schedules the pair (M, N) to be written to path.
+    void add_pair(int m, int n, const std::filesystem::path &path) {
+        Pair pair = {
+            m,
+            n,
+            path,
+            path,
+            history.estimate(m, n),
+            history.predict_profile(m, n),
+            CaseProfile(num_cases(m)),
+            {},
+            0,
+            0,
+            0,
+            0.0,
+        };
+        pair.parts_dir += ".parts";
+        std::uint64_t position = 0;
+        for (const auto &[begin, end] : complete_parts(pair.parts_dir)) {
+            if (position < begin) { pair.gaps.emplace_back(position, begin); }
+            position = std::max(position, end);
+        }
+        if (position < num_cases(m)) {
+            pair.gaps.emplace_back(position, num_cases(m));
+        }
+        pairs.push_back(std::move(pair));
+    }
+
+    // Solves every scheduled pair with num_threads threads, reporting
+    // progress every progress_interval > 0 seconds. Returns false if any unit
+    // could not be solved or any pair could not be merged.
+    bool run(unsigned num_threads, double progress_interval) {
+        num_threads = std::max(num_threads, 1U);
+        make_units(num_threads);
+        const clock::time_point start = clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            // Pairs that were completely solved, but not merged, by an
+            // interrupted run only need to be merged.
+            for (Pair &pair : pairs) {
+                if (pair.remaining_units == 0) {
+                    finish_pair(pair, merge(pair));
+                }
+            }
+            num_running_threads = num_threads;
+        }
+        std::vector<std::thread> threads;
+        for (unsigned k = 0; k < num_threads; ++k) {
+            threads.emplace_back(&PairScheduler::work, this);
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            const clock::duration interval =
+                std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<double>(progress_interval)
+                );
+            clock::time_point next_report = start + interval;
+            while (num_running_threads > 0) {
+                progress_changed.wait_until(lock, next_report);
+                if (clock::now() >= next_report) {
+                    print_progress(
+                        std::chrono::duration<double>(clock::now() - start)
+                            .count()
+                    );
+                    next_report += interval;
+                }
+            }
+            print_progress(
+                std::chrono::duration<double>(clock::now() - start).count()
+            );
+        }
+        for (std::thread &thread : threads) { thread.join(); }
+        return !failed;
+    }
+
+}; // class PairScheduler
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_SCHEDULER_HPP_INCLUDED
@@ -0,0 +1,232 @@
+#ifndef ZERO_ONE_SOLVER_STATS_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_STATS_HPP_INCLUDED
+
+#include <algorithm>   // for std::partial_sort, std::min
+#include <bit>         // for std::bit_width
+#include <cstddef>     // for std::size_t, std::ptrdiff_t
+#include <cstdint>     // for std::uint8_t, std::uint64_t
+#include <filesystem>  // for std::filesystem
+#include <fstream>     // for std::ofstream
+#include <functional>  // for std::greater
+#include <type_traits> // for std::is_constant_evaluated
+#include <utility>     // for std::pair
+#include <vector>      // for std::vector
+
+// Search statistics are collected only if the solver is compiled with
+// -DZERO_ONE_SOLVER_STATS=true. Otherwise, every call to record() compiles
+// to nothing, so the instrumentation may be left in the hot loops.
+#ifndef ZERO_ONE_SOLVER_STATS
+#define ZERO_ONE_SOLVER_STATS false
+#endif
+
+namespace ZeroOneSolver {
+
+
+constexpr bool STATS_ENABLED = ZERO_ONE_SOLVER_STATS;
+
+
+// For each phase of simplify(), FIRED counts the changes made by that
+// phase, and RESTARTS counts the additional work caused by those changes:
+// equations re-enqueued by Phase 2, and extra rounds of Phases 3 and 4.
+// Phase 1 only affects the equation it examines, so it causes no restarts,
+// but it detects every inconsistent system (counted by PHASE_1_CONFLICTS).
+// The SPLIT_* counters follow the order of SplitKind in ZeroOneSolver.cpp,
+// and SPLIT_CHILDREN counts the children of all case splits of every kind.
+// CACHED_NODES counts the nodes whose subtrees were found in the
+// transposition cache (see TranspositionCache.hpp) instead of searched.
+// PRECHECK_CALLS counts the nodes examined by the prechecks of Precheck.hpp,
+// and the PRECHECK_*_REFUTED counters the nodes that each one refuted.
+enum class Stat : std::uint8_t {
+    SIMPLIFY_CALLS,
+    PHASE_1_CONFLICTS,
+    PHASE_1_FIRED,
+    PHASE_2_FIRED,
+    PHASE_2_RESTARTS,
+    PHASE_3_FIRED,
+    PHASE_3_RESTARTS,
+    PHASE_4_FIRED,
+    PHASE_4_RESTARTS,
+    SPLIT_P_VARIABLE,
+    SPLIT_Q_VARIABLE,
+    SPLIT_PRODUCT_ZERO,
+    SPLIT_PRODUCT_ZERO_OR_ONE,
+    SPLIT_EQUATION,
+    SPLIT_P_MIRRORED,
+    SPLIT_Q_MIRRORED,
+    SPLIT_CHILDREN,
+    NODES,
+    LEAF_NODES,
+    SOLVED_NODES,
+    INCONSISTENT_NODES,
+    CACHED_NODES,
+    PRECHECK_CALLS,
+    PRECHECK_LOCAL_REFUTED,
+    PRECHECK_EVALUATION_REFUTED,
+    COUNT,
+}; // enum class Stat
+
+
+constexpr std::size_t NUM_STATS = static_cast<std::size_t>(Stat::COUNT);
+
+constexpr const char *STAT_NAMES[NUM_STATS] = {
+    "simplify_calls",
+    "phase_1_conflicts",
+    "phase_1_fired",
+    "phase_2_fired",
+    "phase_2_restarts",
+    "phase_3_fired",
+    "phase_3_restarts",
+    "phase_4_fired",
+    "phase_4_restarts",
+    "split_p_variable",
+    "split_q_variable",
+    "split_product_zero",
+    "split_product_zero_or_one",
+    "split_equation",
+    "split_p_mirrored",
+    "split_q_mirrored",
+    "split_children",
+    "nodes",
+    "leaf_nodes",
+    "solved_nodes",
+    "inconsistent_nodes",
+    "cached_nodes",
+    "precheck_calls",
+    "precheck_local_refuted",
+    "precheck_evaluation_refuted",
+};
+
+
+struct StatCounters {
+
+    std::uint64_t values[NUM_STATS];
+
+    constexpr std::uint64_t operator[](Stat stat) const noexcept {
+        return values[static_cast<std::size_t>(stat)];
+    }
+
+    constexpr void add(const StatCounters &other) noexcept {
+        for (std::size_t i = 0; i < NUM_STATS; ++i) {
+            values[i] += other.values[i];
+        }
+    }
+
+}; // struct StatCounters
+
+
+// Each thread counts into its own block, which is only read by other
+// threads while this thread is stopped or after it has finished.
+inline thread_local StatCounters THREAD_STATS = {};
+
+
+constexpr void record(Stat stat, std::uint64_t amount = 1) noexcept {
+    if constexpr (STATS_ENABLED) {
+        if (!std::is_constant_evaluated()) {
+            THREAD_STATS.values[static_cast<std::size_t>(stat)] += amount;
+        }
+    }
+}
+
+
+struct CaseStats {
+
+    std::uint64_t nodes;
+    std::uint64_t leaves;
+    double seconds;
+
+    constexpr void add(const CaseStats &other) noexcept {
+        nodes += other.nodes;
+        leaves += other.leaves;
+        seconds += other.seconds;
+    }
+
+}; // struct CaseStats
+
+
+/**
+ * A StatsSummary aggregates the counters of every worker together with the
+ * nodes, leaf systems, and wall time spent on each case in a contiguous
+ * range that starts at begin_case. When several workers share a case by
+ * work stealing, the nodes explored by a thief are attributed to stolen
+ * instead of the case they came from, as are the nodes restored from a
+ * checkpoint. With one thread, every node is attributed to its own case.
+ */
+struct StatsSummary {
+
+    StatCounters counters = {};
+    double seconds = 0.0;
+    std::uint64_t begin_case = 0;
+    // Indexed by case_index - begin_case. Cases with no nodes have not
+    // been started and are omitted from the output.
+    std::vector<CaseStats> cases;
+    CaseStats stolen = {};
+
+    // Writes the counters, a histogram of per-case wall times in
+    // power-of-two buckets of microseconds, and the slowest cases.
+    bool write_json(const std::filesystem::path &path, int m, int n) const {
+        constexpr std::size_t NUM_HOT_CASES = 20;
+        std::ofstream file(path);
+        file << "{\n  \"m\": " << m << ",\n  \"n\": " << n
+             << ",\n  \"seconds\": " << seconds << ",\n  \"counters\": {";
+        for (std::size_t i = 0; i < NUM_STATS; ++i) {
+            file << (i ? ",\n    \"" : "\n    \"") << STAT_NAMES[i]
+                 << "\": " << counters.values[i];
+        }
+        std::vector<std::uint64_t> histogram;
+        std::vector<std::pair<double, std::size_t>> hot_cases;
+        for (std::size_t k = 0; k < cases.size(); ++k) {
+            if (cases[k].nodes == 0) { continue; }
+            const std::size_t bucket = static_cast<std::size_t>(std::bit_width(
+                static_cast<std::uint64_t>(cases[k].seconds * 1.0e6)
+            ));
+            if (histogram.size() <= bucket) { histogram.resize(bucket + 1); }
+            ++histogram[bucket];
+            hot_cases.emplace_back(cases[k].seconds, k);
+        }
+        file << "\n  },\n  \"case_time_histogram_us\": [";
+        for (std::size_t k = 0; k < histogram.size(); ++k) {
+            const std::uint64_t low = (k == 0) ? 0 : (1ULL << (k - 1));
+            file << (k ? ",\n    " : "\n    ") << "{\"min\": " << low
+                 << ", \"max\": " << (1ULL << k)
+                 << ", \"cases\": " << histogram[k] << "}";
+        }
+        const std::size_t num_hot = std::min(hot_cases.size(), NUM_HOT_CASES);
+        std::partial_sort(
+            hot_cases.begin(),
+            hot_cases.begin() + static_cast<std::ptrdiff_t>(num_hot),
+            hot_cases.end(),
+            std::greater<>()
+        );
+        file << "\n  ],\n  \"hot_cases\": [";
+        for (std::size_t k = 0; k < num_hot; ++k) {
+            const CaseStats &stats = cases[hot_cases[k].second];
+            file << (k ? ",\n    " : "\n    ")
+                 << "{\"case_index\": " << (begin_case + hot_cases[k].second)
+                 << ", \"nodes\": " << stats.nodes
+                 << ", \"leaves\": " << stats.leaves
+                 << ", \"seconds\": " << stats.seconds << "}";
+        }
+        file << "\n  ],\n  \"stolen\": {\"nodes\": " << stolen.nodes
+             << ", \"leaves\": " << stolen.leaves
+             << ", \"seconds\": " << stolen.seconds << "}\n}\n";
+        return static_cast<bool>(file);
+    }
+
+    // Writes one row for every case that has been started.
+    bool write_csv(const std::filesystem::path &path) const {
+        std::ofstream file(path);
+        file << "case_index,nodes,leaves,seconds\n";
+        for (std::size_t k = 0; k < cases.size(); ++k) {
+            if (cases[k].nodes == 0) { continue; }
+            file << (begin_case + k) << "," << cases[k].nodes << ","
+                 << cases[k].leaves << "," << cases[k].seconds << "\n";
+        }
+        return static_cast<bool>(file);
+    }
+
+}; // struct StatsSummary
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_STATS_HPP_INCLUDED
@@ -0,0 +1,693 @@
+#ifndef ZERO_ONE_SOLVER_STREAMING_CANONIZER_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_STREAMING_CANONIZER_HPP_INCLUDED
+
+#include <algorithm>  // for std::sort, std::clamp, std::max
+#include <atomic>     // for std::atomic
+#include <bit>        // for std::bit_ceil, std::bit_floor, std::countr_zero
+#include <cstddef>    // for std::size_t
+#include <cstdint>    // for std::uint16_t, std::uint32_t, std::uint64_t
+#include <cstring>    // for std::memcpy
+#include <deque>      // for std::deque
+#include <filesystem> // for std::filesystem
+#include <fstream>    // for std::ifstream, std::ofstream
+#include <iomanip>    // for std::setw, std::setfill
+#include <iterator>   // for std::istreambuf_iterator
+#include <mutex>      // for std::mutex, std::lock_guard
+#include <queue>      // for std::priority_queue
+#include <sstream>    // for std::ostringstream
+#include <string>     // for std::string, std::getline
+#include <thread>     // for std::thread
+#include <utility>    // for std::move
+#include <vector>     // for std::vector
+
+#include "Canonizer.hpp"
+#include "FingerprintSet.hpp"
+#include "LeafFormat.hpp"
+#include "ZeroOneSolver.hpp"
+
+namespace ZeroOneSolver {
+
+
+// Parses a block of lines in the text format written by print_leaf_system.
+// Lines that declare free variables are ignored, as by canonical_system_of.
+// Returns false if the block is malformed.
+inline bool
+parse_leaf_block(const std::vector<std::string> &lines, CanonicalSystem &out) {
+    out = CanonicalSystem();
+    for (const std::string &line : lines) {
+        if (line.starts_with("0 <= ")) { continue; }
+        Term term;
+        bool has_variable = false;
+        std::size_t pos = 0;
+        while (pos < line.size()) {
+            const char c = line[pos];
+            if ((c == 'p') || (c == 'q')) {
+                std::size_t index = 0;
+                std::size_t end = pos + 1;
+                while ((end < line.size()) && (line[end] >= '0') &&
+                       (line[end] <= '9')) {
+                    index = 10 * index +
+                            static_cast<std::size_t>(line[end] - '0');
+                    ++end;
+                }
+                if ((end == pos + 1) || (index == 0) || (index > 0xFE)) {
+                    return false;
+                }
+                if (c == 'p') {
+                    term.p_index = static_cast<var_index_t>(index);
+                } else {
+                    term.q_index = static_cast<var_index_t>(index);
+                }
+                has_variable = true;
+                pos = end;
+            } else if (c == '+') {
+                if (!has_variable) { return false; }
+                out.add_term(term);
+                term = Term();
+                has_variable = false;
+                ++pos;
+            } else if ((c == ' ') || (c == '*')) {
+                ++pos;
+            } else {
+                return false;
+            }
+        }
+        if (!has_variable) { return false; }
+        out.add_term(term);
+        out.end_equation();
+    }
+    return true;
+}
+
+
+/**
+ * A StreamingCanonizer computes the weakly canonized equations of existing
+ * data files, one degree at a time, with the same output as Canonizer.py:
+ * the canonical form of every leaf system, in order of first appearance,
+ * omitting those that appeared in any earlier degree. It also writes the
+ * multiplicity of each canonical system among the leaf systems of its
+ * degree. Unlike Canonizer.py, its memory use is bounded by memory_budget,
+ * regardless of the number of systems, and it uses several threads.
+ *
+ * Each degree is processed in three passes over files in work_dir:
+ *
+ *   1. Scatter: the input files are divided between the threads, which
+ *      canonize their leaf systems and append them, tagged with their
+ *      position in the input, to bucket files chosen by a prefix of their
+ *      fingerprint. The number of buckets is chosen from the input size,
+ *      so that each bucket fits in its thread's share of the budget.
+ *   2. Deduplicate: the threads load one bucket at a time and group its
+ *      systems by fingerprint. The groups are compared with the sorted
+ *      file of all fingerprints from earlier degrees, of which each bucket
+ *      only reads its own contiguous range, since both are ordered by
+ *      fingerprint prefix. The new groups are written in order of first
+ *      appearance to a run file for the bucket.
+ *   3. Merge: the run files are merged by position in the input and
+ *      written as text, and the fingerprints of the new systems are merged
+ *      into the file of fingerprints seen so far.
+ *
+ * The file of fingerprints is named after the last degree it includes, so
+ * canonization resumes after the last completed degree.
+ */
+class StreamingCanonizer {
+
+public:
+
+    struct Input {
+        std::filesystem::path path;
+        bool binary;
+    }; // struct Input
+
+private:
+
+    // Smallest buffer used to append to a bucket file.
+    static constexpr std::size_t MIN_CHUNK_SIZE = 1 << 12;
+    // Approximate bytes of memory used to deduplicate each byte of a bucket
+    // file, including the sorted index of its records.
+    static constexpr std::size_t MEMORY_PER_BUCKET_BYTE = 2;
+    // Approximate size of a bucket record per byte of input, which is
+    // larger for binary files, since they store terms more compactly.
+    static constexpr std::size_t BINARY_EXPANSION = 3;
+    static constexpr std::size_t TEXT_EXPANSION = 1;
+    // Maximum number of run files merged at once.
+    static constexpr std::size_t MAX_FAN_IN = 256;
+    // A system is tagged with (input index << INPUT_SHIFT) | its position.
+    static constexpr int INPUT_SHIFT = 40;
+
+    // Bucket records consist of a Fingerprint, a 64-bit tag, the 32-bit
+    // length of the encoding of a canonical system, and that encoding. Run
+    // records consist of a tag, a 64-bit multiplicity, the length, and the
+    // encoding, in increasing order of tag.
+    struct Group {
+        Fingerprint fingerprint;
+        std::uint64_t tag;
+        std::uint64_t count;
+        std::size_t offset;
+        std::uint32_t size;
+    }; // struct Group
+
+    struct RunRecord {
+        std::uint64_t tag;
+        std::uint64_t count;
+        std::string encoding;
+    }; // struct RunRecord
+
+    struct Bucket {
+        std::mutex mutex;
+        std::filesystem::path path;
+    }; // struct Bucket
+
+    const std::filesystem::path work_dir;
+    const std::size_t memory_budget;
+    const unsigned num_threads;
+    int degree_seen;
+    std::uint64_t num_leaves;
+    std::uint64_t num_new;
+
+    static constexpr bool
+    prefix_order(const Fingerprint &a, const Fingerprint &b) noexcept {
+        return (a.high != b.high) ? (a.high < b.high) : (a.low < b.low);
+    }
+
+    static std::size_t
+    bucket_of(const Fingerprint &fingerprint, int bucket_bits) noexcept {
+        return bucket_bits ? static_cast<std::size_t>(
+                                 fingerprint.high >> (64 - bucket_bits)
+                             )
+                           : 0;
+    }
+
+    std::filesystem::path numbered(const char *prefix, std::size_t k) const {
+        std::ostringstream name;
+        name << prefix << std::setfill('0') << std::setw(6) << k << ".bin";
+        return work_dir / name.str();
+    }
+
+    std::filesystem::path seen_path(int degree) const {
+        std::ostringstream name;
+        name << "seen-" << std::setfill('0') << std::setw(4) << degree
+             << ".bin";
+        return work_dir / name.str();
+    }
+
+    template <typename T>
+    static void put(std::string &out, const T &value) {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    static void write_all(std::ostream &out, const std::string &data) {
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    template <typename T>
+    static bool get(std::istream &in, T &value) {
+        return static_cast<bool>(
+            in.read(reinterpret_cast<char *>(&value), sizeof(T))
+        );
+    }
+
+    static bool read_run_record(std::istream &in, RunRecord &record) {
+        std::uint32_t size;
+        if (!(get(in, record.tag) && get(in, record.count) && get(in, size))) {
+            return false;
+        }
+        record.encoding.resize(size);
+        return static_cast<bool>(in.read(record.encoding.data(), size));
+    }
+
+    static void write_run_record(std::string &out, const RunRecord &record) {
+        put(out, record.tag);
+        put(out, record.count);
+        put(out, static_cast<std::uint32_t>(record.encoding.size()));
+        out += record.encoding;
+    }
+
+    int bucket_bits_for(const std::vector<Input> &inputs) const {
+        std::uintmax_t estimate = 0;
+        for (const Input &input : inputs) {
+            std::error_code error;
+            const std::uintmax_t size =
+                std::filesystem::file_size(input.path, error);
+            if (!error) {
+                estimate +=
+                    size * (input.binary ? BINARY_EXPANSION : TEXT_EXPANSION);
+            }
+        }
+        const std::uintmax_t per_bucket = std::max<std::uintmax_t>(
+            memory_budget / (2 * num_threads * MEMORY_PER_BUCKET_BYTE), 1
+        );
+        const std::uintmax_t max_buckets = std::bit_floor(std::max<std::size_t>(
+            memory_budget / (4 * num_threads * MIN_CHUNK_SIZE), 1
+        ));
+        const std::uintmax_t num_buckets = std::clamp<std::uintmax_t>(
+            std::bit_ceil((estimate + per_bucket - 1) / per_bucket),
+            1,
+            max_buckets
+        );
+        return std::countr_zero(num_buckets);
+    }
+
+    // Pass 1. Returns false if an input file is missing or malformed.
+    bool scatter(
+        const std::vector<Input> &inputs,
+        std::deque<Bucket> &buckets,
+        int bucket_bits
+    ) {
+        const std::size_t chunk_size = std::max(
+            MIN_CHUNK_SIZE, memory_budget / (4 * buckets.size() * num_threads)
+        );
+        std::atomic<std::size_t> next_input = 0;
+        std::atomic<bool> failed = false;
+        const auto work = [&]() {
+            std::vector<std::string> buffers(buckets.size());
+            const auto flush = [&](std::size_t b) {
+                std::lock_guard<std::mutex> lock(buckets[b].mutex);
+                std::ofstream file(
+                    buckets[b].path, std::ios::binary | std::ios::app
+                );
+                write_all(file, buffers[b]);
+                if (!file) { failed = true; }
+                buffers[b].clear();
+            };
+            std::string encoding;
+            while (!failed) {
+                const std::size_t index = next_input.fetch_add(1);
+                if (index >= inputs.size()) { break; }
+                std::uint64_t tag = static_cast<std::uint64_t>(index)
+                                    << INPUT_SHIFT;
+                const auto emit = [&](CanonicalSystem &system) {
+                    system.canonize();
+                    encoding.clear();
+                    system.encode(encoding);
+                    const Fingerprint fingerprint =
+                        fingerprint_of(encoding.data(), encoding.size());
+                    const std::size_t b = bucket_of(fingerprint, bucket_bits);
+                    const std::uint32_t size =
+                        static_cast<std::uint32_t>(encoding.size());
+                    put(buffers[b], fingerprint);
+                    put(buffers[b], tag++);
+                    put(buffers[b], size);
+                    buffers[b] += encoding;
+                    if (buffers[b].size() >= chunk_size) { flush(b); }
+                };
+                const Input &input = inputs[index];
+                CanonicalSystem system;
+                if (input.binary) {
+                    LeafReader reader(input.path.string());
+                    LeafRecord record;
+                    while (reader.next(record)) {
+                        system = canonical_system_of(record);
+                        emit(system);
+                    }
+                    if (!reader.is_valid()) { failed = true; }
+                } else {
+                    std::ifstream file(input.path);
+                    if (!file) { failed = true; }
+                    std::vector<std::string> block;
+                    std::string line;
+                    while (std::getline(file, line)) {
+                        if (!line.empty()) {
+                            block.push_back(line);
+                            continue;
+                        }
+                        if (!parse_leaf_block(block, system)) {
+                            failed = true;
+                            break;
+                        }
+                        emit(system);
+                        block.clear();
+                    }
+                    if (!block.empty()) { failed = true; }
+                }
+            }
+            for (std::size_t b = 0; b < buckets.size(); ++b) {
+                if (!buffers[b].empty()) { flush(b); }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (unsigned k = 0; k < num_threads; ++k) {
+            threads.emplace_back(work);
+        }
+        for (std::thread &thread : threads) { thread.join(); }
+        return !failed;
+    }
+
+    // Pass 2 for a single bucket. Writes the fingerprints of earlier degrees
+    // and of the new groups in this bucket to seen_out, and the new groups,
+    // in order of first appearance, to run_out.
+    bool deduplicate(
+        std::size_t b,
+        const std::filesystem::path &bucket_path,
+        int bucket_bits,
+        const std::filesystem::path &seen_in,
+        const std::filesystem::path &seen_out,
+        const std::filesystem::path &run_out,
+        std::uint64_t &leaves,
+        std::uint64_t &new_groups
+    ) const {
+        std::string data;
+        if (std::filesystem::exists(bucket_path)) {
+            std::ifstream file(bucket_path, std::ios::binary);
+            data.assign(
+                std::istreambuf_iterator<char>(file),
+                std::istreambuf_iterator<char>()
+            );
+        }
+        std::vector<Group> records;
+        for (std::size_t pos = 0; pos < data.size();) {
+            constexpr std::size_t HEADER_SIZE =
+                sizeof(Fingerprint) + sizeof(std::uint64_t) +
+                sizeof(std::uint32_t);
+            if (data.size() - pos < HEADER_SIZE) { return false; }
+            Group record = {};
+            std::memcpy(&record.fingerprint, data.data() + pos, 16);
+            std::memcpy(&record.tag, data.data() + pos + 16, 8);
+            std::memcpy(&record.size, data.data() + pos + 24, 4);
+            record.offset = pos + HEADER_SIZE;
+            record.count = 1;
+            if (data.size() - record.offset < record.size) { return false; }
+            records.push_back(record);
+            pos = record.offset + record.size;
+        }
+        leaves = records.size();
+        std::sort(
+            records.begin(),
+            records.end(),
+            [](const Group &a, const Group &b) {
+                if (a.fingerprint != b.fingerprint) {
+                    return prefix_order(a.fingerprint, b.fingerprint);
+                }
+                return a.tag < b.tag;
+            }
+        );
+        std::vector<Group> groups;
+        for (const Group &record : records) {
+            if (!groups.empty() &&
+                (groups.back().fingerprint == record.fingerprint)) {
+                ++groups.back().count;
+            } else {
+                groups.push_back(record);
+            }
+        }
+        records = std::vector<Group>();
+
+        // Merge the sorted groups with this bucket's range of seen_in.
+        std::ifstream seen(seen_in, std::ios::binary);
+        std::uint64_t num_seen = 0;
+        if (seen) {
+            seen.seekg(0, std::ios::end);
+            num_seen = static_cast<std::uint64_t>(seen.tellg()) /
+                       sizeof(Fingerprint);
+        }
+        const auto seen_at = [&](std::uint64_t k) {
+            Fingerprint result = {};
+            seen.seekg(static_cast<std::streamoff>(k * sizeof(Fingerprint)));
+            get(seen, result);
+            return result;
+        };
+        std::uint64_t lo = 0;
+        std::uint64_t hi = num_seen;
+        while (lo < hi) {
+            const std::uint64_t mid = lo + (hi - lo) / 2;
+            if (bucket_of(seen_at(mid), bucket_bits) < b) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (num_seen) {
+            seen.clear();
+            seen.seekg(static_cast<std::streamoff>(lo * sizeof(Fingerprint)));
+        }
+        std::string merged;
+        std::vector<bool> is_new(groups.size(), true);
+        std::size_t g = 0;
+        Fingerprint old = {};
+        bool has_old = (lo < num_seen) && get(seen, old) &&
+                       (bucket_of(old, bucket_bits) == b);
+        while (has_old || (g < groups.size())) {
+            if (has_old && ((g == groups.size()) ||
+                            !prefix_order(groups[g].fingerprint, old))) {
+                if ((g < groups.size()) && (old == groups[g].fingerprint)) {
+                    is_new[g++] = false;
+                }
+                put(merged, old);
+                has_old = get(seen, old) && (bucket_of(old, bucket_bits) == b);
+            } else {
+                put(merged, groups[g++].fingerprint);
+            }
+        }
+        {
+            std::ofstream file(seen_out, std::ios::binary | std::ios::trunc);
+            write_all(file, merged);
+            if (!file) { return false; }
+        }
+        merged = std::string();
+
+        std::vector<std::size_t> order;
+        for (std::size_t k = 0; k < groups.size(); ++k) {
+            if (is_new[k]) { order.push_back(k); }
+        }
+        new_groups = order.size();
+        std::sort(
+            order.begin(),
+            order.end(),
+            [&](std::size_t a, std::size_t c) {
+                return groups[a].tag < groups[c].tag;
+            }
+        );
+        std::ofstream file(run_out, std::ios::binary | std::ios::trunc);
+        std::string buffer;
+        for (const std::size_t k : order) {
+            put(buffer, groups[k].tag);
+            put(buffer, groups[k].count);
+            put(buffer, groups[k].size);
+            buffer.append(data, groups[k].offset, groups[k].size);
+            if (buffer.size() >= MIN_CHUNK_SIZE) {
+                write_all(file, buffer);
+                buffer.clear();
+            }
+        }
+        write_all(file, buffer);
+        return static_cast<bool>(file);
+    }
+
+    // Merges run files in order of tag, calling visit(record) for each.
+    template <typename VISIT>
+    static bool
+    merge_runs(const std::vector<std::filesystem::path> &paths, VISIT &&visit) {
+        std::vector<std::ifstream> files;
+        std::vector<RunRecord> heads(paths.size());
+        const auto later = [&](std::size_t a, std::size_t b) {
+            return heads[a].tag > heads[b].tag;
+        };
+        using Queue = std::priority_queue<
+            std::size_t,
+            std::vector<std::size_t>,
+            decltype(later)>;
+        Queue queue(later);
+        for (std::size_t k = 0; k < paths.size(); ++k) {
+            files.emplace_back(paths[k], std::ios::binary);
+            if (!files[k]) { return false; }
+            if (read_run_record(files[k], heads[k])) { queue.push(k); }
+        }
+        while (!queue.empty()) {
+            const std::size_t k = queue.top();
+            queue.pop();
+            if (!visit(heads[k])) { return false; }
+            if (read_run_record(files[k], heads[k])) { queue.push(k); }
+        }
+        for (std::ifstream &file : files) {
+            if (!file.eof()) { return false; }
+        }
+        return true;
+    }
+
+    // Pass 3. Merges at most MAX_FAN_IN run files at a time until they can
+    // all be merged into the output.
+    bool write_output(
+        std::vector<std::filesystem::path> runs,
+        const std::filesystem::path &output_path,
+        const std::filesystem::path &counts_path
+    ) const {
+        std::size_t next_run = 0;
+        while (runs.size() > MAX_FAN_IN) {
+            std::vector<std::filesystem::path> merged_runs;
+            for (std::size_t k = 0; k < runs.size(); k += MAX_FAN_IN) {
+                const std::vector<std::filesystem::path> group(
+                    runs.begin() + static_cast<std::ptrdiff_t>(k),
+                    runs.begin() + static_cast<std::ptrdiff_t>(
+                                       std::min(k + MAX_FAN_IN, runs.size())
+                                   )
+                );
+                merged_runs.push_back(numbered("merged-", next_run++));
+                std::ofstream file(
+                    merged_runs.back(), std::ios::binary | std::ios::trunc
+                );
+                std::string buffer;
+                if (!merge_runs(group, [&](const RunRecord &record) {
+                        buffer.clear();
+                        write_run_record(buffer, record);
+                        write_all(file, buffer);
+                        return static_cast<bool>(file);
+                    })) {
+                    return false;
+                }
+                for (const std::filesystem::path &path : group) {
+                    std::filesystem::remove(path);
+                }
+            }
+            runs = std::move(merged_runs);
+        }
+        std::ofstream output(output_path, std::ios::binary | std::ios::trunc);
+        std::ofstream counts(counts_path, std::ios::binary | std::ios::trunc);
+        CanonicalSystem system;
+        const bool merged = merge_runs(runs, [&](const RunRecord &record) {
+            if (!system.decode(
+                    record.encoding.data(), record.encoding.size()
+                )) {
+                return false;
+            }
+            system.write_wolfram(output);
+            output << "\n\n";
+            counts << record.count << "\n";
+            return output && counts;
+        });
+        for (const std::filesystem::path &path : runs) {
+            std::filesystem::remove(path);
+        }
+        return merged && output && counts;
+    }
+
+public:
+
+    explicit StreamingCanonizer(
+        const std::filesystem::path &work_directory,
+        std::size_t memory_budget_bytes,
+        unsigned thread_count
+    )
+        : work_dir(work_directory)
+        , memory_budget(memory_budget_bytes)
+        , num_threads(std::max(thread_count, 1U))
+        , degree_seen(-1)
+        , num_leaves(0)
+        , num_new(0) {
+        std::filesystem::create_directories(work_dir);
+        for (const auto &entry :
+             std::filesystem::directory_iterator(work_dir)) {
+            const std::string name = entry.path().filename().string();
+            if ((name.size() == 13) && name.starts_with("seen-") &&
+                name.ends_with(".bin")) {
+                degree_seen =
+                    std::max(degree_seen, std::stoi(name.substr(5, 4)));
+            }
+        }
+    }
+
+    // Returns the last degree whose systems have been recorded, or -1.
+    int completed_degree() const noexcept { return degree_seen; }
+
+    // Forgets the systems of every degree, so that canonization restarts
+    // from degree 0.
+    void reset() {
+        if (degree_seen >= 0) {
+            std::filesystem::remove(seen_path(degree_seen));
+        }
+        degree_seen = -1;
+    }
+
+    std::uint64_t leaves_seen() const noexcept { return num_leaves; }
+    std::uint64_t new_systems() const noexcept { return num_new; }
+
+    // Canonizes the leaf systems in the given files, which must be of the
+    // degree after completed_degree(), in order. The canonical systems not
+    // seen in an earlier degree are written to output_path, and their
+    // multiplicities in this degree, one per line, to counts_path.
+    bool canonize_degree(
+        const std::vector<Input> &inputs,
+        const std::filesystem::path &output_path,
+        const std::filesystem::path &counts_path
+    ) {
+        const int bucket_bits = bucket_bits_for(inputs);
+        std::deque<Bucket> buckets(static_cast<std::size_t>(1) << bucket_bits);
+        for (std::size_t b = 0; b < buckets.size(); ++b) {
+            buckets[b].path = numbered("bucket-", b);
+            std::filesystem::remove(buckets[b].path);
+        }
+        if (!scatter(inputs, buckets, bucket_bits)) { return false; }
+
+        const std::filesystem::path seen_in = seen_path(degree_seen);
+        std::vector<std::filesystem::path> seen_parts(buckets.size());
+        std::vector<std::filesystem::path> runs(buckets.size());
+        std::atomic<std::size_t> next_bucket = 0;
+        std::atomic<bool> failed = false;
+        std::atomic<std::uint64_t> leaves = 0;
+        std::atomic<std::uint64_t> new_groups = 0;
+        const auto work = [&]() {
+            while (!failed) {
+                const std::size_t b = next_bucket.fetch_add(1);
+                if (b >= buckets.size()) { break; }
+                seen_parts[b] = numbered("seen-part-", b);
+                runs[b] = numbered("run-", b);
+                std::uint64_t bucket_leaves = 0;
+                std::uint64_t bucket_new = 0;
+                if (!deduplicate(
+                        b,
+                        buckets[b].path,
+                        bucket_bits,
+                        seen_in,
+                        seen_parts[b],
+                        runs[b],
+                        bucket_leaves,
+                        bucket_new
+                    )) {
+                    failed = true;
+                }
+                std::error_code error;
+                std::filesystem::remove(buckets[b].path, error);
+                leaves += bucket_leaves;
+                new_groups += bucket_new;
+            }
+        };
+        std::vector<std::thread> threads;
+        for (unsigned k = 0; k < num_threads; ++k) {
+            threads.emplace_back(work);
+        }
+        for (std::thread &thread : threads) { thread.join(); }
+        if (failed) { return false; }
+
+        std::filesystem::path output_temp = output_path;
+        output_temp += ".temp";
+        std::filesystem::path counts_temp = counts_path;
+        counts_temp += ".temp";
+        if (!write_output(runs, output_temp, counts_temp)) { return false; }
+        const std::filesystem::path seen_next = seen_path(degree_seen + 1);
+        std::filesystem::path seen_temp = seen_next;
+        seen_temp += ".temp";
+        {
+            std::ofstream seen(seen_temp, std::ios::binary | std::ios::trunc);
+            for (const std::filesystem::path &path : seen_parts) {
+                if (std::filesystem::file_size(path) > 0) {
+                    std::ifstream part(path, std::ios::binary);
+                    seen << part.rdbuf();
+                }
+                std::filesystem::remove(path);
+            }
+            if (!seen) { return false; }
+        }
+        std::filesystem::rename(output_temp, output_path);
+        std::filesystem::rename(counts_temp, counts_path);
+        std::filesystem::rename(seen_temp, seen_next);
+        if (degree_seen >= 0) { std::filesystem::remove(seen_in); }
+        ++degree_seen;
+        num_leaves += leaves;
+        num_new += new_groups;
+        return true;
+    }
+
+}; // class StreamingCanonizer
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_STREAMING_CANONIZER_HPP_INCLUDED
@@ -0,0 +1,305 @@
+#!/usr/bin/env python3
+"""
+Verify canonical leaf systems as they are produced, instead of waiting for
+the solver to finish a whole degree.
+
+    ZeroOneSolver --max-degree D --canonize --stream |
+        StreamingVerifier.py [--workers K] [--threads T] [--boxes N]
+                             [--cas COMMAND] [--solver PATH] [--store DIR]
+    StreamingVerifier.py --listen PORT [--connections C] [...]
+
+Leaf systems are read from standard input, or from C solver processes that
+connect over TCP and send the same stream (e.g., `ZeroOneSolver ... --stream |
+nc HOST PORT`), as blocks of Wolfram-style equations separated by blank lines.
+Each distinct system passes through three stages, all running concurrently:
+
+1. Repeated systems are dropped, so each system is verified only once,
+   even if it is produced by several (m, n) pairs or several solvers.
+2. A single persistent `ZeroOneSolver --prefilter -` process refutes as
+   many systems as it can with interval arithmetic (see IntervalPrefilter.hpp)
+   and passes the remaining ones back to this script.
+3. K persistent CAS processes decide the remaining systems exactly. The
+   default is StreamingCylindricalSolver.wls, but any command that reads
+   systems in this format from standard input and prints one line for each
+   one, 0 if it has no real solution and 1 otherwise, can be used instead.
+
+With --store, systems already verified according to the result store in DIR
+(see ResultStore.py) are skipped, and the verdict for every other system is
+recorded there.
+
+The latency of each system, from its arrival here to its verdict, is bounded
+by the time the prefilter and one CAS process spend on it, since the
+prefilter flushes its output whenever its input runs dry, and is reported at
+the end, together with the number of systems decided by each stage.
+"""
+
+import os
+import queue
+import shlex
+import socket
+import subprocess
+import threading
+from sys import argv, exit, stderr, stdin
+from time import monotonic
+from typing import Iterable, TextIO
+
+from Canonizer import canonize
+from ParallelSolver import RUNTIME_EXECUTABLE_PATH, compile_runtime
+from ResultStore import (
+    POSSIBLE_SOLUTION,
+    REFUTED_BY_CAS,
+    REFUTED_BY_PREFILTER,
+    ResultStore,
+    fingerprint,
+    parse_wolfram,
+)
+
+
+DEFAULT_CAS_COMMAND: str = "wolframscript -file StreamingCylindricalSolver.wls"
+DEFAULT_PREFILTER_BOXES: int = 100000
+
+
+def read_systems(file: TextIO) -> Iterable[str]:
+    lines: list[str] = []
+    for line in file:
+        line = line.strip()
+        if line:
+            lines.append(line)
+        elif lines:
+            yield "\n".join(lines)
+            lines = []
+    if lines:
+        yield "\n".join(lines)
+
+
+class StreamingVerifier(object):
+
+    def __init__(
+        self,
+        solver_path: str,
+        num_threads: int,
+        max_boxes: int,
+        store: ResultStore | None = None,
+    ):
+        self.lock = threading.Lock()
+        self.write_lock = threading.Lock()
+        self.seen: set[str] = set()
+        # Arrival time of each system that has not yet received a verdict.
+        self.arrival: dict[str, float] = {}
+        self.num_received: int = 0
+        self.num_duplicates: int = 0
+        self.num_known: int = 0
+        self.store = store
+        # Fingerprints of the systems passed to the prefilter, if store is set.
+        self.fingerprints: dict[str, int] = {}
+        self.residual_systems: set[str] = set()
+        self.num_residual: int = 0
+        self.num_verified: int = 0
+        self.counterexamples: list[str] = []
+        self.latencies: list[float] = []
+        self.residual: queue.Queue[str | None] = queue.Queue()
+        self.prefilter = subprocess.Popen(
+            [
+                solver_path,
+                *("--prefilter", "-"),
+                *("--prefilter-boxes", str(max_boxes)),
+                *("--threads", str(num_threads)),
+            ],
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            text=True,
+        )
+        self.reader = threading.Thread(target=self.read_residual)
+        self.reader.start()
+
+    def submit(self, system: str):
+        with self.lock:
+            self.num_received += 1
+            if system in self.seen:
+                self.num_duplicates += 1
+                return
+            self.seen.add(system)
+            if self.store is not None:
+                system_fingerprint = fingerprint(canonize(parse_wolfram(system)))
+                if self.store.status(system_fingerprint) in (
+                    REFUTED_BY_PREFILTER,
+                    REFUTED_BY_CAS,
+                ):
+                    self.num_known += 1
+                    return
+                self.fingerprints[system] = system_fingerprint
+            self.arrival[system] = monotonic()
+        # The prefilter may block on its output, which read_residual() can
+        # only drain while self.lock is free.
+        with self.write_lock:
+            assert self.prefilter.stdin is not None
+            self.prefilter.stdin.write(system + "\n\n")
+            self.prefilter.stdin.flush()
+
+    def read_residual(self):
+        assert self.prefilter.stdout is not None
+        for system in read_systems(self.prefilter.stdout):
+            with self.lock:
+                self.num_residual += 1
+                self.residual_systems.add(system)
+            self.residual.put(system)
+
+    def finish(self, system: str, result: str):
+        with self.lock:
+            self.num_verified += 1
+            start = self.arrival.pop(system, None)
+            if start is not None:
+                self.latencies.append(monotonic() - start)
+            if self.store is not None and result in ("0", "1"):
+                self.store.set_status(
+                    self.fingerprints[system],
+                    REFUTED_BY_CAS if result == "0" else POSSIBLE_SOLUTION,
+                )
+            if result != "0":
+                self.counterexamples.append(system)
+                print("FOUND POSSIBLE COUNTEREXAMPLE:", file=stderr)
+                print(system, file=stderr)
+            if self.num_verified % 1000 == 0:
+                print(
+                    f"Verified {self.num_verified} of {self.num_residual}"
+                    " systems not refuted by the prefilter.",
+                    file=stderr,
+                )
+
+    def run_cas_worker(self, command: list[str]):
+        with subprocess.Popen(
+            command, stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True
+        ) as process:
+            assert process.stdin is not None
+            assert process.stdout is not None
+            while (system := self.residual.get()) is not None:
+                process.stdin.write(system + "\n\n")
+                process.stdin.flush()
+                result = process.stdout.readline().strip()
+                if not result:
+                    print("ERROR: CAS process", command, "exited.", file=stderr)
+                    self.finish(system, "?")
+                    break
+                self.finish(system, result)
+            process.stdin.close()
+
+    def close(self, workers: list[threading.Thread]):
+        assert self.prefilter.stdin is not None
+        self.prefilter.stdin.close()
+        self.reader.join()
+        self.prefilter.wait()
+        for _ in workers:
+            self.residual.put(None)
+        for worker in workers:
+            worker.join()
+        if self.store is not None:
+            for system, system_fingerprint in self.fingerprints.items():
+                if system not in self.residual_systems:
+                    self.store.set_status(system_fingerprint, REFUTED_BY_PREFILTER)
+            self.store.flush()
+
+    def report(self):
+        num_unique = self.num_received - self.num_duplicates
+        print(f"Received {self.num_received} systems", end="", file=stderr)
+        print(f" ({self.num_duplicates} duplicates).", file=stderr)
+        if self.store is not None:
+            print(f"Skipped {self.num_known} systems verified before.", file=stderr)
+        print(
+            f"Refuted {num_unique - self.num_known - self.num_residual}"
+            " systems natively"
+            f" and verified {self.num_verified} with the CAS.",
+            file=stderr,
+        )
+        if self.latencies:
+            mean = sum(self.latencies) / len(self.latencies)
+            print(
+                f"CAS verdict latency: mean {mean:.3f} s,"
+                f" max {max(self.latencies):.3f} s.",
+                file=stderr,
+            )
+        if self.counterexamples:
+            print(
+                f"FOUND {len(self.counterexamples)} POSSIBLE COUNTEREXAMPLES.",
+                file=stderr,
+            )
+        elif self.num_verified == self.num_residual:
+            print("All systems have no real solution.", file=stderr)
+
+
+def serve(verifier: StreamingVerifier, port: int, num_connections: int):
+    def handle(connection: socket.socket):
+        with connection, connection.makefile("r") as file:
+            for system in read_systems(file):
+                verifier.submit(system)
+
+    with socket.create_server(("", port)) as server:
+        print(f"Listening for solver output on port {port}.", file=stderr)
+        handlers: list[threading.Thread] = []
+        for _ in range(num_connections):
+            connection, _ = server.accept()
+            handler = threading.Thread(target=handle, args=(connection,))
+            handler.start()
+            handlers.append(handler)
+        for handler in handlers:
+            handler.join()
+
+
+def main():
+    num_workers = max((os.cpu_count() or 2) // 2, 1)
+    num_threads = num_workers
+    max_boxes = DEFAULT_PREFILTER_BOXES
+    cas_command = DEFAULT_CAS_COMMAND
+    solver_path = RUNTIME_EXECUTABLE_PATH
+    port: int | None = None
+    num_connections = 1
+    store: ResultStore | None = None
+    args = argv[1:]
+    while args:
+        if len(args) < 2:
+            print(__doc__, file=stderr)
+            exit(1)
+        if args[0] == "--workers":
+            num_workers = int(args[1])
+        elif args[0] == "--threads":
+            num_threads = int(args[1])
+        elif args[0] == "--boxes":
+            max_boxes = int(args[1])
+        elif args[0] == "--cas":
+            cas_command = args[1]
+        elif args[0] == "--solver":
+            solver_path = args[1]
+        elif args[0] == "--listen":
+            port = int(args[1])
+        elif args[0] == "--connections":
+            num_connections = int(args[1])
+        elif args[0] == "--store":
+            store = ResultStore(args[1])
+        else:
+            print(__doc__, file=stderr)
+            exit(1)
+        args = args[2:]
+
+    if not os.path.isfile(solver_path):
+        os.makedirs(os.path.dirname(solver_path), exist_ok=True)
+        compile_runtime(solver_path)
+    verifier = StreamingVerifier(solver_path, num_threads, max_boxes, store)
+    workers = [
+        threading.Thread(
+            target=verifier.run_cas_worker, args=(shlex.split(cas_command),)
+        )
+        for _ in range(num_workers)
+    ]
+    for worker in workers:
+        worker.start()
+    if port is None:
+        for system in read_systems(stdin):
+            verifier.submit(system)
+    else:
+        serve(verifier, port, num_connections)
+    verifier.close(workers)
+    verifier.report()
+    exit(1 if verifier.counterexamples else 0)
+
+
+if __name__ == "__main__":
+    main()
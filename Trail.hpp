@@ -0,0 +1,133 @@
+#ifndef ZERO_ONE_SOLVER_TRAIL_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_TRAIL_HPP_INCLUDED
+
+#include <algorithm>   // for std::fill
+#include <cassert>     // for assert
+#include <cstddef>     // for std::byte, std::size_t
+#include <cstdint>     // for std::uint8_t, std::uint32_t, std::uint64_t
+#include <cstring>     // for std::memcpy
+#include <type_traits> // for std::is_trivially_copyable_v
+#include <vector>      // for std::vector
+
+namespace ZeroOneSolver {
+
+
+/**
+ * A NullTrail discards every write it is told about. It is the default trail
+ * argument of all mutating System methods, so that code which does not need
+ * to backtrack pays nothing for trail support.
+ */
+struct NullTrail {
+
+    static constexpr bool ENABLED = false;
+
+    template <typename T>
+    constexpr void save(const T &) const noexcept {}
+
+}; // struct NullTrail
+
+
+/**
+ * A Trail records the previous contents of every memory location written
+ * while a System is modified in place, so that the System can later be
+ * restored to any earlier state by undoing the writes in reverse order.
+ *
+ * Locations are stored as byte offsets relative to the System passed to the
+ * constructor, rather than as pointers. This allows the recorded writes to be
+ * undone on a copy of the System, which is how a snapshot of an earlier state
+ * is produced without disturbing the System being searched.
+ *
+ * Each location is recorded at most once between consecutive marks, since
+ * only its value at the most recent mark is needed to undo back to it. Hence,
+ * the length of the trail is bounded by sizeof(SYSTEM) times the number of
+ * choice points on the current search path, i.e., it is proportional to the
+ * search depth, independent of the branching factor.
+ */
+template <typename SYSTEM>
+class Trail {
+
+    struct Entry {
+        std::uint64_t old_value;
+        std::uint32_t offset;
+        std::uint8_t size;
+    }; // struct Entry
+
+    const std::byte *base;
+    std::vector<Entry> entries;
+    // stamps[offset] == epoch if the byte at the given offset has already
+    // been recorded since the most recent call to mark() or undo().
+    std::vector<std::uint32_t> stamps;
+    std::uint32_t epoch;
+
+    void next_epoch() noexcept {
+        if (++epoch == 0) {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            epoch = 1;
+        }
+    }
+
+public:
+
+    static constexpr bool ENABLED = true;
+
+    explicit Trail(const SYSTEM &system) noexcept
+        : base(reinterpret_cast<const std::byte *>(&system))
+        , entries()
+        , stamps(sizeof(SYSTEM), 0)
+        , epoch(1) {}
+
+    template <typename T>
+    void save(const T &location) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(sizeof(T) <= sizeof(std::uint64_t));
+        const std::byte *address =
+            reinterpret_cast<const std::byte *>(&location);
+        assert((base <= address) && (address < base + sizeof(SYSTEM)));
+        const std::size_t offset = static_cast<std::size_t>(address - base);
+        if (stamps[offset] == epoch) { return; }
+        stamps[offset] = epoch;
+        Entry entry;
+        entry.old_value = 0;
+        std::memcpy(&entry.old_value, address, sizeof(T));
+        entry.offset = static_cast<std::uint32_t>(offset);
+        entry.size = static_cast<std::uint8_t>(sizeof(T));
+        entries.push_back(entry);
+    }
+
+    // Returns a position on the trail to which undo() can later return.
+    std::size_t mark() noexcept {
+        next_epoch();
+        return entries.size();
+    }
+
+    void clear() noexcept {
+        entries.clear();
+        next_epoch();
+    }
+
+    // Restores system to its state at the given mark,
+    // discarding all trail entries recorded after it.
+    void undo(SYSTEM &system, std::size_t mark) noexcept {
+        assert(mark <= entries.size());
+        restore(system, mark);
+        entries.resize(mark);
+        next_epoch();
+    }
+
+    // Restores system, which must be a copy of the System being searched,
+    // to its state at the given mark, leaving the trail itself untouched.
+    void restore(SYSTEM &system, std::size_t mark) const noexcept {
+        assert(mark <= entries.size());
+        std::byte *target = reinterpret_cast<std::byte *>(&system);
+        for (std::size_t k = entries.size(); k > mark; --k) {
+            const Entry &entry = entries[k - 1];
+            std::memcpy(target + entry.offset, &entry.old_value, entry.size);
+        }
+    }
+
+}; // class Trail<SYSTEM>
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_TRAIL_HPP_INCLUDED
@@ -0,0 +1,211 @@
+#ifndef ZERO_ONE_SOLVER_TRANSPOSITION_CACHE_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_TRANSPOSITION_CACHE_HPP_INCLUDED
+
+#include <cstddef>       // for std::size_t
+#include <cstdint>       // for std::uint8_t, std::uint64_t
+#include <deque>         // for std::deque
+#include <mutex>         // for std::mutex, std::lock_guard
+#include <string>        // for std::string
+#include <unordered_map> // for std::unordered_map
+#include <utility>       // for std::move
+#include <vector>        // for std::vector
+
+#include "FingerprintSet.hpp"
+#include "ZeroOneSolver.hpp"
+
+namespace ZeroOneSolver {
+
+
+struct CacheCounters {
+
+    std::uint64_t hits;
+    std::uint64_t misses;
+    std::uint64_t stores;
+    std::uint64_t evictions;
+    std::uint64_t bytes;
+
+    constexpr void add(const CacheCounters &other) noexcept {
+        hits += other.hits;
+        misses += other.misses;
+        stores += other.stores;
+        evictions += other.evictions;
+        bytes += other.bytes;
+    }
+
+    constexpr double hit_rate() const noexcept {
+        const std::uint64_t lookups = hits + misses;
+        return lookups ? static_cast<double>(hits) /
+                             static_cast<double>(lookups)
+                       : 0.0;
+    }
+
+}; // struct CacheCounters
+
+
+/**
+ * A TranspositionCache remembers the leaf systems found in the subtrees of
+ * the search rooted at simplified systems, so that a subtree whose root has
+ * been seen before, in another branch or another case, is not searched
+ * again. The search below a simplified system depends only on its terms,
+ * right-hand sides, and which variables are still undetermined, as do the
+ * leaf systems it writes. Hence, systems that agree on these are identified
+ * by the fingerprint of their residual() encoding, regardless of the values
+ * of their fixed variables. (With
+ * preserve_values, those values are also compared, since mirrored splits
+ * depend on them.) A subtree without leaf systems is stored as an empty
+ * entry, which is the common case.
+ *
+ * Entries are divided into shards by fingerprint, each guarded by its own
+ * mutex, and each shard is kept within its share of the memory budget by
+ * CLOCK eviction: an entry is evicted when the clock hand reaches it for
+ * the second time without a hit in between.
+ */
+template <typename SYSTEM>
+class TranspositionCache {
+
+    // Approximate memory used by one entry, not counting its leaf systems,
+    // including its hash table node and bucket pointer.
+    static constexpr std::size_t ENTRY_COST = 128;
+
+    struct Entry {
+        Fingerprint key;
+        bool referenced;
+        std::vector<SYSTEM> leaves;
+    }; // struct Entry
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<Fingerprint, std::size_t, FingerprintHash> index;
+        std::vector<Entry> entries;
+        std::size_t hand = 0;
+        CacheCounters counters = {};
+    }; // struct Shard
+
+    const bool preserve_values;
+    const std::size_t shard_budget;
+    std::deque<Shard> shards;
+
+    static constexpr std::size_t cost(std::size_t num_leaves) noexcept {
+        return ENTRY_COST + num_leaves * sizeof(SYSTEM);
+    }
+
+    Shard &shard_of(const Fingerprint &key) noexcept {
+        return shards[key.high % shards.size()];
+    }
+
+    // Must be called with shard.mutex held.
+    static void evict_one(Shard &shard) {
+        while (true) {
+            if (shard.hand >= shard.entries.size()) { shard.hand = 0; }
+            Entry &victim = shard.entries[shard.hand];
+            if (victim.referenced) {
+                victim.referenced = false;
+                ++shard.hand;
+                continue;
+            }
+            shard.counters.bytes -= cost(victim.leaves.size());
+            ++shard.counters.evictions;
+            shard.index.erase(victim.key);
+            if (shard.hand + 1 != shard.entries.size()) {
+                victim = std::move(shard.entries.back());
+                shard.index[victim.key] = shard.hand;
+            }
+            shard.entries.pop_back();
+            return;
+        }
+    }
+
+public:
+
+    explicit TranspositionCache(
+        std::size_t memory_budget,
+        bool preserve_fixed_values,
+        std::size_t num_shards = 64
+    )
+        : preserve_values(preserve_fixed_values)
+        , shard_budget(memory_budget / num_shards)
+        , shards(num_shards) {}
+
+    TranspositionCache(const TranspositionCache &) = delete;
+    TranspositionCache &operator=(const TranspositionCache &) = delete;
+
+    // Encodes the right-hand sides and terms of every equation, followed by
+    // the state of every variable. Unless preserve_values is set, the values
+    // ZERO and ONE of fixed variables are not distinguished.
+    Fingerprint residual(const SYSTEM &system) const {
+        std::string buffer;
+        buffer.reserve(
+            system.num_equations() * (2 * system.num_slots() + 1) +
+            system.m() + system.n()
+        );
+        for (std::size_t e = 0; e < system.num_equations(); ++e) {
+            buffer.push_back(static_cast<char>(system.rhs.get(e)));
+            for (std::size_t t = 0; t < system.num_slots(); ++t) {
+                const Term term = system.term(e, t);
+                buffer.push_back(static_cast<char>(term.p_index));
+                buffer.push_back(static_cast<char>(term.q_index));
+            }
+        }
+        const auto encode = [&](VAR value) {
+            if (!preserve_values && (value == VAR::ONE)) { value = VAR::ZERO; }
+            buffer.push_back(static_cast<char>(value));
+        };
+        for (std::size_t i = 0; i + 1 < system.m(); ++i) {
+            encode(system.p.get(i));
+        }
+        for (std::size_t i = 0; i + 1 < system.n(); ++i) {
+            encode(system.q.get(i));
+        }
+        return fingerprint_of(buffer.data(), buffer.size());
+    }
+
+    // If the subtree rooted at a system with the given residual fingerprint
+    // is cached, appends its leaf systems to leaves and returns true.
+    bool lookup(const Fingerprint &key, std::vector<SYSTEM> &leaves) {
+        Shard &shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto found = shard.index.find(key);
+        if (found == shard.index.end()) {
+            ++shard.counters.misses;
+            return false;
+        }
+        Entry &entry = shard.entries[found->second];
+        entry.referenced = true;
+        leaves.insert(leaves.end(), entry.leaves.begin(), entry.leaves.end());
+        ++shard.counters.hits;
+        return true;
+    }
+
+    // Records that the subtree rooted at a system with the given residual
+    // fingerprint has the leaf systems [first, last), in search order.
+    void
+    insert(const Fingerprint &key, const SYSTEM *first, const SYSTEM *last) {
+        const std::size_t num_leaves = static_cast<std::size_t>(last - first);
+        if (cost(num_leaves) > shard_budget) { return; }
+        Shard &shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.index.contains(key)) { return; }
+        while (shard.counters.bytes + cost(num_leaves) > shard_budget) {
+            evict_one(shard);
+        }
+        shard.index.emplace(key, shard.entries.size());
+        shard.entries.push_back({key, false, std::vector<SYSTEM>(first, last)});
+        shard.counters.bytes += cost(num_leaves);
+        ++shard.counters.stores;
+    }
+
+    CacheCounters counters() {
+        CacheCounters result = {};
+        for (Shard &shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            result.add(shard.counters);
+        }
+        return result;
+    }
+
+}; // class TranspositionCache<SYSTEM>
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_TRANSPOSITION_CACHE_HPP_INCLUDED
@@ -0,0 +1,71 @@
+#ifndef ZERO_ONE_SOLVER_WORK_STEALING_DEQUE_HPP_INCLUDED
+#define ZERO_ONE_SOLVER_WORK_STEALING_DEQUE_HPP_INCLUDED
+
+#include <cstddef> // for std::size_t
+#include <mutex>   // for std::mutex, std::lock_guard
+#include <utility> // for std::move
+
+#include "FixedDeque.hpp"
+
+namespace ZeroOneSolver {
+
+
+/**
+ * A WorkStealingDeque holds the pending search nodes of a single worker
+ * thread. The owning worker pushes and pops nodes at the back of the deque,
+ * so that it performs an ordinary depth-first search, while idle workers
+ * steal nodes from the front, where the shallowest (and therefore, typically
+ * largest) subtrees are found.
+ *
+ * Every operation is guarded by a per-deque mutex. The owner only contends
+ * with a thief when a steal is actually in progress, so the lock is almost
+ * always uncontended and costs far less than a single call to simplify().
+ * Nodes are stored in a FixedDeque, whose capacity must be set by reset()
+ * before the deque is used.
+ */
+template <typename T>
+class WorkStealingDeque {
+
+    std::mutex mutex;
+    FixedDeque<T> items;
+
+public:
+
+    void reset(std::size_t capacity, const T &prototype) {
+        std::lock_guard<std::mutex> lock(mutex);
+        items = FixedDeque<T>(capacity, prototype);
+    }
+
+    /**
+     * Calls f(items) while holding the lock, where items is the underlying
+     * FixedDeque<T>. This allows the owner to push several nodes and modify
+     * them in place without a thief observing a partially constructed node.
+     */
+    template <typename F>
+    auto locked(F &&f) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return f(items);
+    }
+
+    bool pop_back(T &result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty()) { return false; }
+        result = std::move(items.back());
+        items.pop_back();
+        return true;
+    }
+
+    bool steal(T &result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty()) { return false; }
+        result = std::move(items.front());
+        items.pop_front();
+        return true;
+    }
+
+}; // class WorkStealingDeque<T>
+
+
+} // namespace ZeroOneSolver
+
+#endif // ZERO_ONE_SOLVER_WORK_STEALING_DEQUE_HPP_INCLUDED
@@ -1,139 +1,384 @@
-#include <bitset>   // for std::bitset
-#include <cstddef>  // for std::size_t
-#include <iostream> // for std::cout, std::cerr
-#include <vector>   // for std::vector
+#include <algorithm>          // for std::min, std::max
+#include <atomic>             // for std::atomic
+#include <charconv>           // for std::from_chars
+#include <chrono>             // for std::chrono
+#include <condition_variable> // for std::condition_variable
+#include <cstddef>            // for std::size_t
+#include <cstdint>            // for std::uint8_t, std::uint16_t, std::uint64_t
+#include <cstdlib>            // for EXIT_SUCCESS, EXIT_FAILURE
+#include <deque>              // for std::deque
+#include <filesystem>         // for std::filesystem
+#include <fstream>            // for std::ofstream
+#include <functional>         // for std::ref
+#include <iomanip>            // for std::setw, std::setfill, std::setprecision
+#include <iostream>           // for std::cout, std::cerr
+#include <limits>             // for std::numeric_limits
+#include <map>                // for std::map
+#include <memory>             // for std::unique_ptr, std::make_unique
+#include <mutex>              // for std::mutex, std::lock_guard
+#include <optional>           // for std::optional
+#include <sstream>            // for std::ostringstream
+#include <streambuf>          // for std::streambuf
+#include <string>             // for std::string
+#include <system_error>       // for std::errc
+#include <thread>             // for std::thread, std::this_thread::yield
+#include <utility>            // for std::pair
+#include <vector>             // for std::vector
 
+#include "BatchSimplifier.hpp"
+#include "BitsetSystem.hpp"
+#include "CaseEnumerator.hpp"
+#include "Canonizer.hpp"
+#include "Checkpoint.hpp"
+#include "DynamicShape.hpp"
+#include "FixedDeque.hpp"
+#include "IntervalPrefilter.hpp"
+#include "LeafFormat.hpp"
+#include "NumaTopology.hpp"
+#include "ParseNumber.hpp"
+#include "Precheck.hpp"
+#include "ProofTrace.hpp"
+#include "ResultStore.hpp"
+#include "Scheduler.hpp"
+#include "Stats.hpp"
+#include "StreamingCanonizer.hpp"
+#include "Trail.hpp"
+#include "TranspositionCache.hpp"
+#include "WorkStealingDeque.hpp"
 #include "ZeroOneSolver.hpp"
 
+// The storage layout of the systems explored by the search is a compile-time
+// policy. Any layout X for which ZeroOneSolver::BasicX<SHAPE> provides the
+// interface of ZeroOneSolver::BasicSystem may be selected, e.g., by compiling
+// with -DZERO_ONE_SOLVER_LAYOUT=BitsetSystem.
+#ifndef ZERO_ONE_SOLVER_LAYOUT
+#define ZERO_ONE_SOLVER_LAYOUT System
+#endif
+
+#define ZERO_ONE_SOLVER_BASIC_LAYOUT_(X) Basic##X
+#define ZERO_ONE_SOLVER_BASIC_LAYOUT(X) ZERO_ONE_SOLVER_BASIC_LAYOUT_(X)
+#define ZERO_ONE_SOLVER_STRINGIFY_(X) #X
+#define ZERO_ONE_SOLVER_STRINGIFY(X) ZERO_ONE_SOLVER_STRINGIFY_(X)
+
+template <typename SHAPE>
+using Layout =
+    ZeroOneSolver::ZERO_ONE_SOLVER_BASIC_LAYOUT(ZERO_ONE_SOLVER_LAYOUT)<SHAPE>;
+
+// If ZERO_ONE_SOLVER_M and ZERO_ONE_SOLVER_N are defined, the solver is
+// specialized for those dimensions at compile time. Otherwise, it takes the
+// dimensions from the command line and dispatches to the smallest DynamicShape
+// capacity bucket that can hold them.
+#ifndef ZERO_ONE_SOLVER_VERBOSE
+#define ZERO_ONE_SOLVER_VERBOSE false
+#endif
+
+using ZeroOneSolver::CaseEnumerator;
+using ZeroOneSolver::CaseRecorder;
+using ZeroOneSolver::Checkpoint;
+using ZeroOneSolver::CheckpointHeader;
+using ZeroOneSolver::DynamicShape;
+using ZeroOneSolver::Fingerprint;
+using ZeroOneSolver::FixedDeque;
+using ZeroOneSolver::LeafDeduplicator;
+using ZeroOneSolver::LeafFormat;
+using ZeroOneSolver::LeafReader;
+using ZeroOneSolver::LeafRecord;
+using ZeroOneSolver::LeafWriter;
+using ZeroOneSolver::MAX_CHILDREN;
+using ZeroOneSolver::max_pending_nodes;
+using ZeroOneSolver::parse_number;
+using ZeroOneSolver::NullTrail;
+using ZeroOneSolver::passes_prechecks;
+using ZeroOneSolver::ProofRecorder;
+using ZeroOneSolver::ProofTrace;
 using ZeroOneSolver::RHS;
-using ZeroOneSolver::System;
+using ZeroOneSolver::record;
+using ZeroOneSolver::ResultStore;
+using ZeroOneSolver::Stat;
+using ZeroOneSolver::StaticShape;
+using ZeroOneSolver::STATS_ENABLED;
 using ZeroOneSolver::Term;
 using ZeroOneSolver::TERM_ZERO;
+using ZeroOneSolver::Trail;
+using ZeroOneSolver::trace_leaf;
+using ZeroOneSolver::trace_refuted;
+using ZeroOneSolver::trace_solved;
+using ZeroOneSolver::trace_split;
+using ZeroOneSolver::TranspositionCache;
 using ZeroOneSolver::VAR;
 using ZeroOneSolver::var_index_t;
+using ZeroOneSolver::WorkStealingDeque;
 
 
-template <std::size_t N>
-constexpr bool increment(std::bitset<N> &bitset) noexcept {
-    for (std::size_t i = 0; i < N; ++i) {
-        if (bitset[i]) {
-            bitset[i] = false;
-        } else {
-            bitset[i] = true;
-            return true;
+// Formats case_index as a string of M - 1 binary
+// digits, most significant first, like std::bitset.
+std::string case_string(var_index_t m, std::uint64_t case_index) {
+    std::string result;
+    for (int i = m - 2; i >= 0; --i) {
+        result.push_back(((case_index >> i) & 1) ? '1' : '0');
+    }
+    return result;
+}
+
+
+// The reflection p_i <-> p_{M - i}, q_j <-> q_{N - j}, which reverses the
+// coefficients of P, Q, and PQ, maps the equation for x^d to the equation
+// for x^{M + N - d}, and maps the case selected by bit i - 1 of case_index to
+// the case selected by bit M - i - 1. Hence, the initial systems of a case
+// and of its bitwise reversal are mirror images, and only the smaller of the
+// two needs to be solved, since the leaf systems of the other are mirror
+// images of leaf systems that cover the same solutions.
+constexpr std::uint64_t
+mirror_case(var_index_t m, std::uint64_t case_index) noexcept {
+    std::uint64_t result = 0;
+    for (int k = 0; k < m - 1; ++k) {
+        if ((case_index >> k) & 1) {
+            result |= static_cast<std::uint64_t>(1) << (m - 2 - k);
         }
     }
-    return false;
+    return result;
+}
+
+
+constexpr bool
+is_representative_case(var_index_t m, std::uint64_t case_index) noexcept {
+    return case_index <= mirror_case(m, case_index);
+}
+
+
+// Returns true if the given system is its own mirror image. After
+// simplify(), the left-hand sides of the equations are determined by the
+// values of the variables, so it suffices to compare those and the RHS.
+template <typename SYSTEM>
+constexpr bool is_self_mirror(const SYSTEM &system) noexcept {
+    const var_index_t M = system.m();
+    const var_index_t N = system.n();
+    for (var_index_t i = 1; 2 * i < M; ++i) {
+        if (system.p.get(i - 1) != system.p.get(M - i - 1)) { return false; }
+    }
+    for (var_index_t j = 1; 2 * j < N; ++j) {
+        if (system.q.get(j - 1) != system.q.get(N - j - 1)) { return false; }
+    }
+    const std::size_t num_equations = system.num_equations();
+    for (std::size_t e = 0; 2 * e + 1 < num_equations; ++e) {
+        if (system.rhs.get(e) != system.rhs.get(num_equations - 1 - e)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// A CaseSplit describes an exhaustive case distinction performed on a system
+// that cannot be simplified any further. Its children are numbered in the
+// order in which the search first pushes them onto the stack, and since the
+// search is depth-first, they are explored in the reverse of that order.
+enum class SplitKind : std::uint8_t {
+    P_VARIABLE,          // p_i == 1, p_i == 0
+    Q_VARIABLE,          // q_j == 1, q_j == 0
+    PRODUCT_ZERO,        // q_j == 0, p_i == 0
+    PRODUCT_ZERO_OR_ONE, // p_i == q_j == 1, q_j == 0, p_i == 0
+    EQUATION,            // equation == 1, equation == 0
+    // With --symmetry, a system that is its own mirror image (see
+    // is_self_mirror()) is split on p_i and p_{M - i} at once, in three
+    // cases rather than four. The case p_i == 0, p_{M - i} == 1 is dropped,
+    // since the reflection p_i <-> p_{M - i}, q_j <-> q_{N - j} maps it to
+    // the case p_i == 1, p_{M - i} == 0 of the same system, so its leaf
+    // systems are mirror images of those of the second child, as for
+    // mirrored cases (see mirror_case()). Similarly for q_j and q_{N - j}.
+    P_MIRRORED, // p_i == p_{M-i} == 1, p_i == 1 && p_{M-i} == 0,
+                // p_i == p_{M-i} == 0
+    Q_MIRRORED, // q_j == q_{N-j} == 1, q_j == 1 && q_{N-j} == 0,
+                // q_j == q_{N-j} == 0
+}; // enum class SplitKind
+
+
+// Proof traces (see ProofTrace.hpp) record each split by its SplitKind.
+static_assert(
+    static_cast<int>(SplitKind::P_VARIABLE) == ZeroOneSolver::PROOF_P_VARIABLE
+);
+static_assert(
+    static_cast<int>(SplitKind::Q_VARIABLE) == ZeroOneSolver::PROOF_Q_VARIABLE
+);
+static_assert(
+    static_cast<int>(SplitKind::PRODUCT_ZERO) ==
+    ZeroOneSolver::PROOF_PRODUCT_ZERO
+);
+static_assert(
+    static_cast<int>(SplitKind::PRODUCT_ZERO_OR_ONE) ==
+    ZeroOneSolver::PROOF_PRODUCT_ZERO_OR_ONE
+);
+static_assert(
+    static_cast<int>(SplitKind::EQUATION) == ZeroOneSolver::PROOF_EQUATION
+);
+static_assert(
+    static_cast<int>(SplitKind::P_MIRRORED) == ZeroOneSolver::PROOF_P_MIRRORED
+);
+static_assert(
+    static_cast<int>(SplitKind::Q_MIRRORED) == ZeroOneSolver::PROOF_Q_MIRRORED
+);
+
+
+struct CaseSplit {
+
+    SplitKind kind;
+    var_index_t p_index;
+    var_index_t q_index;
+    std::uint16_t equation;
+
+    constexpr int num_children() const noexcept {
+        return ((kind == SplitKind::PRODUCT_ZERO_OR_ONE) ||
+                (kind == SplitKind::P_MIRRORED) ||
+                (kind == SplitKind::Q_MIRRORED))
+                   ? 3
+                   : 2;
+    }
+
+}; // struct CaseSplit
+
+
+constexpr void record_case_split(const CaseSplit &split) noexcept {
+    record(static_cast<Stat>(
+        static_cast<int>(Stat::SPLIT_P_VARIABLE) + static_cast<int>(split.kind)
+    ));
+    record(
+        Stat::SPLIT_CHILDREN, static_cast<std::uint64_t>(split.num_children())
+    );
+    trace_split(
+        static_cast<std::uint8_t>(split.kind),
+        split.p_index,
+        split.q_index,
+        split.equation
+    );
 }
 
 
-template <var_index_t M, var_index_t N>
-void print_leaf_system(const System<M, N> &system) {
-    std::bitset<M - 1> p_used;
-    std::bitset<N - 1> q_used;
-    for (std::size_t e = 0; e < M + N - 1; ++e) {
-        if (system.rhs.get(e) == RHS::ZERO) {
-            for (std::size_t t = 0; t < M + 1; ++t) {
-                assert(system.lhs[e][t] == TERM_ZERO);
+template <typename SYSTEM, typename TRAIL = NullTrail>
+constexpr void apply_case_split(
+    SYSTEM &system, const CaseSplit &split, int child, TRAIL &&trail = TRAIL{}
+) noexcept {
+    assert((0 <= child) && (child < split.num_children()));
+    switch (split.kind) {
+        case SplitKind::P_VARIABLE:
+            if (child == 0) {
+                system.set_p_one(split.p_index, trail);
+            } else {
+                system.set_p_zero(split.p_index, trail);
             }
-        } else {
-            assert(system.rhs.get(e) == RHS::ONE);
-            bool first = true;
-            for (std::size_t t = 0; t < M + 1; ++t) {
-                const Term term = system.lhs[e][t];
-                if (term == TERM_ZERO) { continue; }
-                if (term.p_index) { p_used.set(term.p_index - 1); }
-                if (term.q_index) { q_used.set(term.q_index - 1); }
-                if (first) {
-                    first = false;
+            break;
+        case SplitKind::Q_VARIABLE:
+            if (child == 0) {
+                system.set_q_one(split.q_index, trail);
+            } else {
+                system.set_q_zero(split.q_index, trail);
+            }
+            break;
+        case SplitKind::PRODUCT_ZERO:
+            if (child == 0) {
+                system.set_q_zero(split.q_index, trail);
+            } else {
+                system.set_p_zero(split.p_index, trail);
+            }
+            break;
+        case SplitKind::PRODUCT_ZERO_OR_ONE:
+            if (child == 0) {
+                system.set_p_one(split.p_index, trail);
+                system.set_q_one(split.q_index, trail);
+            } else if (child == 1) {
+                system.set_q_zero(split.q_index, trail);
+            } else {
+                system.set_p_zero(split.p_index, trail);
+            }
+            break;
+        case SplitKind::EQUATION:
+            system.rhs.set(
+                split.equation, (child == 0) ? RHS::ONE : RHS::ZERO, trail
+            );
+            break;
+        case SplitKind::P_MIRRORED: {
+            const var_index_t mirror = system.m() - split.p_index;
+            if (child == 2) {
+                system.set_p_zero(split.p_index, trail);
+                system.set_p_zero(mirror, trail);
+            } else {
+                system.set_p_one(split.p_index, trail);
+                if (child == 0) {
+                    system.set_p_one(mirror, trail);
                 } else {
-                    std::cout << " + ";
+                    system.set_p_zero(mirror, trail);
                 }
-                std::cout << term;
             }
-            std::cout << "\n";
-        }
-    }
-    for (std::size_t i = 0; i < M - 1; ++i) {
-        const VAR value = system.p.get(i);
-        if ((value == VAR::ZERO) || (value == VAR::ONE)) {
-            assert(!p_used.test(i));
-        } else {
-            assert(value == VAR::UNKNOWN);
-            if (!p_used[i]) { std::cout << "0 <= p" << (i + 1) << " <= 1\n"; }
+            break;
         }
-    }
-    for (std::size_t i = 0; i < N - 1; ++i) {
-        const VAR value = system.q.get(i);
-        if ((value == VAR::ZERO) || (value == VAR::ONE)) {
-            assert(!q_used.test(i));
-        } else {
-            assert(value == VAR::UNKNOWN);
-            if (!q_used[i]) { std::cout << "0 <= q" << (i + 1) << " <= 1\n"; }
+        case SplitKind::Q_MIRRORED: {
+            const var_index_t mirror = system.n() - split.q_index;
+            if (child == 2) {
+                system.set_q_zero(split.q_index, trail);
+                system.set_q_zero(mirror, trail);
+            } else {
+                system.set_q_one(split.q_index, trail);
+                if (child == 0) {
+                    system.set_q_one(mirror, trail);
+                } else {
+                    system.set_q_zero(mirror, trail);
+                }
+            }
+            break;
         }
     }
-    std::cout << "\n";
 }
 
 
-template <var_index_t M, var_index_t N, bool verbose>
-bool find_case_split(
-    std::vector<System<M, N>> &stack, const System<M, N> &system
-) {
+// Calls visit(split) for every case split that can be performed on the given
+// system, in decreasing order of priority under SplitStrategy::FIRST, until
+// visit returns true. Returns true if and only if visit returned true.
+template <typename SYSTEM, typename VISIT>
+bool for_each_case_split(const SYSTEM &system, VISIT &&visit) {
 
     constexpr std::size_t INVALID_INDEX = ~static_cast<std::size_t>(0);
 
+    const var_index_t M = system.m();
+    const var_index_t N = system.n();
+    const std::size_t num_equations = system.num_equations();
+
     for (var_index_t p_index = 1; p_index <= M - 1; ++p_index) {
         if (system.p.get(p_index - 1) == VAR::ZERO_OR_ONE) {
-            if constexpr (verbose) {
-                std::cerr << "SPLIT ON P" << static_cast<int>(p_index) << "\n";
+            if (visit(CaseSplit{SplitKind::P_VARIABLE, p_index, 0, 0})) {
+                return true;
             }
-            stack.push_back(system);
-            stack.back().set_p_one(p_index);
-            stack.push_back(system);
-            stack.back().set_p_zero(p_index);
-            return true;
         }
     }
 
     for (var_index_t q_index = 1; q_index <= N - 1; ++q_index) {
         if (system.q.get(q_index - 1) == VAR::ZERO_OR_ONE) {
-            if constexpr (verbose) {
-                std::cerr << "SPLIT ON Q" << static_cast<int>(q_index) << "\n";
+            if (visit(CaseSplit{SplitKind::Q_VARIABLE, 0, q_index, 0})) {
+                return true;
             }
-            stack.push_back(system);
-            stack.back().set_q_one(q_index);
-            stack.push_back(system);
-            stack.back().set_q_zero(q_index);
-            return true;
         }
     }
 
-    for (std::size_t e = 0; e < M + N - 1; ++e) {
+    for (std::size_t e = 0; e < num_equations; ++e) {
         const RHS rhs_value = system.rhs.get(e);
         if (rhs_value == RHS::ZERO) {
-            for (std::size_t t = 0; t < M + 1; ++t) {
-                const Term term = system.lhs[e][t];
+            for (std::size_t t = 0; t < system.length(e); ++t) {
+                const Term term = system.term(e, t);
                 if (term != TERM_ZERO) {
-                    if constexpr (verbose) {
-                        std::cerr << "SPLIT ON P"
-                                  << static_cast<int>(term.p_index) << " * Q"
-                                  << static_cast<int>(term.q_index)
-                                  << " == 0\n";
-                    }
                     assert(term.p_index);
                     assert(term.q_index);
-                    stack.push_back(system);
-                    stack.back().set_q_zero(term.q_index);
-                    stack.push_back(system);
-                    stack.back().set_p_zero(term.p_index);
-                    return true;
+                    if (visit(CaseSplit{
+                            SplitKind::PRODUCT_ZERO,
+                            term.p_index,
+                            term.q_index,
+                            static_cast<std::uint16_t>(e),
+                        })) {
+                        return true;
+                    }
                 }
             }
         } else if (rhs_value == RHS::ZERO_OR_ONE) {
             std::size_t term_index = INVALID_INDEX;
-            for (std::size_t t = 0; t < M + 1; ++t) {
-                if (system.lhs[e][t] != TERM_ZERO) {
+            for (std::size_t t = 0; t < system.length(e); ++t) {
+                if (system.term(e, t) != TERM_ZERO) {
                     if (term_index != INVALID_INDEX) {
                         term_index = INVALID_INDEX;
                         break;
@@ -142,38 +387,31 @@ bool find_case_split(
                     }
                 }
             }
-            if (term_index != INVALID_INDEX) {
-                const Term term = system.lhs[e][term_index];
-                if constexpr (verbose) {
-                    std::cerr << "SPLIT ON P" << static_cast<int>(term.p_index)
-                              << " * Q" << static_cast<int>(term.q_index)
-                              << " == 0 or 1\n";
-                }
-                assert(term != TERM_ZERO);
-                assert(term.p_index);
-                assert(term.q_index);
-                stack.push_back(system);
-                stack.back().set_p_one(term.p_index);
-                stack.back().set_q_one(term.q_index);
-                stack.push_back(system);
-                stack.back().set_q_zero(term.q_index);
-                stack.push_back(system);
-                stack.back().set_p_zero(term.p_index);
-                return true;
+            // A lone linear term can only remain while its variable is
+            // undetermined, in which case a variable split is also available.
+            const Term term = (term_index == INVALID_INDEX)
+                                  ? TERM_ZERO
+                                  : system.term(e, term_index);
+            if (term.p_index && term.q_index && (term != TERM_ZERO)) {
+                if (visit(CaseSplit{
+                        SplitKind::PRODUCT_ZERO_OR_ONE,
+                        term.p_index,
+                        term.q_index,
+                        static_cast<std::uint16_t>(e),
+                    })) {
+                    return true;
+                }
             }
         }
     }
 
-    for (std::size_t e = 0; e < M + N - 1; ++e) {
+    for (std::size_t e = 0; e < num_equations; ++e) {
         if (system.rhs.get(e) == RHS::ZERO_OR_ONE) {
-            if constexpr (verbose) {
-                std::cerr << "SPLIT ON EQUATION " << e << "\n";
+            if (visit(CaseSplit{
+                    SplitKind::EQUATION, 0, 0, static_cast<std::uint16_t>(e)
+                })) {
+                return true;
             }
-            stack.push_back(system);
-            stack.back().rhs.set(e, RHS::ONE);
-            stack.push_back(system);
-            stack.back().rhs.set(e, RHS::ZERO);
-            return true;
         }
     }
 
@@ -181,42 +419,2875 @@ bool find_case_split(
 }
 
 
-template <var_index_t M, var_index_t N, bool verbose>
-void analyze_case(const std::bitset<M - 1> &case_index) {
-    std::vector<System<M, N>> stack;
-    stack.emplace_back();
-    stack.back().set_case(case_index);
+// A SplitStrategy decides which of the case splits enumerated by
+// for_each_case_split() is performed. Every strategy finds a split if and
+// only if one exists, so every strategy covers the same solutions, but it
+// may partition them into a different number of leaf systems.
+enum class SplitStrategy : std::uint8_t {
+    FIRST,        // the first split, i.e., the lowest-index variable
+    OCCURRENCES,  // the variable with the most remaining occurrences
+    FEWEST_TERMS, // a split on the equation with the fewest remaining terms
+    LOOKAHEAD,    // the split whose simplified children fix the most variables
+}; // enum class SplitStrategy
+
+
+constexpr const char *SPLIT_STRATEGY_NAMES[] = {
+    "first",
+    "occurrences",
+    "fewest-terms",
+    "lookahead",
+};
+
+
+bool parse_split_strategy(const std::string &name, SplitStrategy &strategy) {
+    for (std::size_t k = 0; k < std::size(SPLIT_STRATEGY_NAMES); ++k) {
+        if (name == SPLIT_STRATEGY_NAMES[k]) {
+            strategy = static_cast<SplitStrategy>(k);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+struct SplitOptions {
+    SplitStrategy strategy = SplitStrategy::FIRST;
+    // If true, splits on a variable of a system that is its own mirror
+    // image are replaced by the corresponding mirrored split.
+    bool break_symmetry = false;
+    // The prechecks (see Precheck.hpp) evaluated before simplifying a node.
+    // They are disabled by default, since on the pairs measured so far, only
+    // 1-2% of all nodes are inconsistent, and the prechecks cost more than
+    // the simplifications they save. Their counters show when this changes.
+    ZeroOneSolver::PrecheckMask precheck = ZeroOneSolver::PRECHECK_NONE;
+}; // struct SplitOptions
+
+
+template <typename SYSTEM>
+int count_live_terms(const SYSTEM &system, std::size_t e) noexcept {
+    int result = 0;
+    for (std::size_t t = 0; t < system.length(e); ++t) {
+        result += (system.term(e, t) != TERM_ZERO);
+    }
+    return result;
+}
+
+
+// Returns the number of remaining terms that contain the variable split on.
+template <typename SYSTEM>
+int count_occurrences(const SYSTEM &system, const CaseSplit &split) noexcept {
+    const auto &pattern = system.shape.pattern();
+    int result = 0;
+    if (split.kind == SplitKind::P_VARIABLE) {
+        for (std::size_t k = 0; k < pattern.p_count[split.p_index]; ++k) {
+            const auto [e, t] = pattern.p_occurrences[split.p_index][k];
+            result += (system.term(e, t).p_index == split.p_index);
+        }
+    } else {
+        for (std::size_t k = 0; k < pattern.q_count[split.q_index]; ++k) {
+            const auto [e, t] = pattern.q_occurrences[split.q_index][k];
+            result += (system.term(e, t).q_index == split.q_index);
+        }
+    }
+    return result;
+}
+
+
+// Returns the total number of variables fixed to 0 or 1 in the children of
+// the given split after simplification, where an inconsistent child counts
+// as fixing every variable, since it is pruned immediately.
+template <typename SYSTEM>
+int lookahead_score(const SYSTEM &system, const CaseSplit &split) noexcept {
+    const var_index_t M = system.m();
+    const var_index_t N = system.n();
+    int result = 0;
+    for (int child = 0; child < split.num_children(); ++child) {
+        SYSTEM copy = system;
+        apply_case_split(copy, split, child);
+        if (!copy.simplify()) {
+            result += (M - 1) + (N - 1);
+            continue;
+        }
+        for (var_index_t i = 1; i <= M - 1; ++i) {
+            const VAR value = copy.p.get(i - 1);
+            result += (value == VAR::ZERO) || (value == VAR::ONE);
+        }
+        for (var_index_t j = 1; j <= N - 1; ++j) {
+            const VAR value = copy.q.get(j - 1);
+            result += (value == VAR::ZERO) || (value == VAR::ONE);
+        }
+    }
+    return result;
+}
+
+
+void print_case_split(
+    std::ostream &os, var_index_t m, var_index_t n, const CaseSplit &split
+) {
+    const int p_index = split.p_index;
+    const int q_index = split.q_index;
+    switch (split.kind) {
+        case SplitKind::P_VARIABLE: os << "SPLIT ON P" << p_index; break;
+        case SplitKind::Q_VARIABLE: os << "SPLIT ON Q" << q_index; break;
+        case SplitKind::PRODUCT_ZERO:
+            os << "SPLIT ON P" << p_index << " * Q" << q_index << " == 0";
+            break;
+        case SplitKind::PRODUCT_ZERO_OR_ONE:
+            os << "SPLIT ON P" << p_index << " * Q" << q_index
+               << " == 0 or 1";
+            break;
+        case SplitKind::EQUATION:
+            os << "SPLIT ON EQUATION " << split.equation;
+            break;
+        case SplitKind::P_MIRRORED:
+            os << "SPLIT ON P" << p_index << " AND P" << (m - p_index);
+            break;
+        case SplitKind::Q_MIRRORED:
+            os << "SPLIT ON Q" << q_index << " AND Q" << (n - q_index);
+            break;
+    }
+    os << "\n";
+}
+
+
+template <typename SYSTEM, bool verbose>
+bool choose_case_split(
+    const SYSTEM &system, CaseSplit &split, const SplitOptions &options = {}
+) {
+    bool found = false;
+    switch (options.strategy) {
+        case SplitStrategy::FIRST:
+            found = for_each_case_split(system, [&](const CaseSplit &s) {
+                split = s;
+                return true;
+            });
+            break;
+        case SplitStrategy::OCCURRENCES: {
+            int best = -1;
+            for_each_case_split(system, [&](const CaseSplit &s) {
+                const bool is_variable = (s.kind == SplitKind::P_VARIABLE) ||
+                                         (s.kind == SplitKind::Q_VARIABLE);
+                if (!is_variable) {
+                    // Variable splits are enumerated first.
+                    if (!found) { split = s; }
+                    found = true;
+                    return true;
+                }
+                const int score = count_occurrences(system, s);
+                if (score > best) {
+                    best = score;
+                    split = s;
+                    found = true;
+                }
+                return false;
+            });
+            break;
+        }
+        case SplitStrategy::FEWEST_TERMS: {
+            int best = -1;
+            CaseSplit first_split = {};
+            bool found_first = false;
+            for_each_case_split(system, [&](const CaseSplit &s) {
+                if (!found_first) {
+                    first_split = s;
+                    found_first = true;
+                }
+                if ((s.kind == SplitKind::P_VARIABLE) ||
+                    (s.kind == SplitKind::Q_VARIABLE)) {
+                    return false;
+                }
+                const int score = count_live_terms(system, s.equation);
+                if ((best < 0) || (score < best)) {
+                    best = score;
+                    split = s;
+                    found = true;
+                }
+                return false;
+            });
+            if (!found && found_first) {
+                split = first_split;
+                found = true;
+            }
+            break;
+        }
+        case SplitStrategy::LOOKAHEAD: {
+            // Compares average scores per child, since splits
+            // may have different numbers of children.
+            int best_score = 0;
+            int best_children = 1;
+            for_each_case_split(system, [&](const CaseSplit &s) {
+                const int score = lookahead_score(system, s);
+                if (!found ||
+                    (score * best_children > best_score * s.num_children())) {
+                    best_score = score;
+                    best_children = s.num_children();
+                    split = s;
+                    found = true;
+                }
+                return false;
+            });
+            break;
+        }
+    }
+    if (!found) { return false; }
+    if (options.break_symmetry) {
+        if ((split.kind == SplitKind::P_VARIABLE) &&
+            (2 * split.p_index != system.m()) && is_self_mirror(system)) {
+            split.kind = SplitKind::P_MIRRORED;
+        } else if ((split.kind == SplitKind::Q_VARIABLE) &&
+                   (2 * split.q_index != system.n()) &&
+                   is_self_mirror(system)) {
+            split.kind = SplitKind::Q_MIRRORED;
+        }
+    }
+    if constexpr (verbose) {
+        print_case_split(std::cerr, system.m(), system.n(), split);
+    }
+    return true;
+}
+
+
+template <typename SYSTEM, bool verbose, typename STACK>
+bool find_case_split(
+    STACK &stack, const SYSTEM &system, const SplitOptions &options = {}
+) {
+    CaseSplit split;
+    if (!choose_case_split<SYSTEM, verbose>(system, split, options)) {
+        return false;
+    }
+    record_case_split(split);
+    for (int child = 0; child < split.num_children(); ++child) {
+        stack.push_back(system);
+        apply_case_split(stack.back(), split, child);
+    }
+    return true;
+}
+
+
+/**
+ * A TrailSearch performs the same depth-first search as analyze_case(), but
+ * instead of pushing a copy of the current system for every child of a case
+ * split, it modifies a single System in place and records every write on a
+ * Trail. Backtracking to a choice point undoes the writes made since then,
+ * and the next untried child of the split is applied to the restored system.
+ * Memory usage is therefore proportional to the depth of the search tree.
+ *
+ * Copies are only made when a worker has to hand off part of its subtree to
+ * an idle thread: donate_oldest() materializes the remaining children of the
+ * shallowest choice point by undoing the trail on a copy of the system.
+ *
+ * If a cache is supplied, the subtree of each choice point is stored in it
+ * when the choice point is exhausted, unless part of it has been donated.
+ */
+template <typename SYSTEM, bool verbose>
+class TrailSearch {
+
+    struct ChoicePoint {
+        CaseSplit split;
+        int next_child;
+        std::size_t mark;
+        bool cacheable;
+        Fingerprint key;
+        std::size_t first_leaf;
+    }; // struct ChoicePoint
+
+    SYSTEM current;
+    Trail<SYSTEM> trail;
+    std::vector<ChoicePoint> choices;
+    SplitOptions split_options;
+    TranspositionCache<SYSTEM> *cache;
+    // Leaf systems found since the oldest choice point was created,
+    // which are only recorded if a cache is supplied.
+    std::vector<SYSTEM> leaves;
+
+    bool backtrack() {
+        while (!choices.empty()) {
+            ChoicePoint &choice = choices.back();
+            trail.undo(current, choice.mark);
+            if (choice.next_child == 0) {
+                if (choice.cacheable) {
+                    cache->insert(
+                        choice.key,
+                        leaves.data() + choice.first_leaf,
+                        leaves.data() + leaves.size()
+                    );
+                }
+                choices.pop_back();
+                if (choices.empty()) { leaves.clear(); }
+            } else {
+                --choice.next_child;
+                apply_case_split(
+                    current, choice.split, choice.next_child, trail
+                );
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+
+    explicit TrailSearch(
+        const typename SYSTEM::shape_type &shape,
+        const SplitOptions &options = {},
+        TranspositionCache<SYSTEM> *transposition_cache = nullptr
+    )
+        : current(shape)
+        , trail(current)
+        , choices()
+        , split_options(options)
+        , cache(transposition_cache)
+        , leaves() {}
+
+    TrailSearch(const TrailSearch &) = delete;
+    TrailSearch &operator=(const TrailSearch &) = delete;
+
+    // Explores the subtree rooted at the given system, calling on_leaf for
+    // every leaf system found. Before visiting each node, poll(*this) is
+    // called to give the caller an opportunity to invoke donate_oldest().
+    template <typename LEAF_CALLBACK, typename POLL_CALLBACK>
+    void run(
+        const SYSTEM &root, LEAF_CALLBACK &&on_leaf, POLL_CALLBACK &&poll
+    ) {
+        current = root;
+        trail.clear();
+        choices.clear();
+        leaves.clear();
+        while (true) {
+            poll(*this);
+            record(Stat::NODES);
+            bool expanded = false;
+            if (passes_prechecks(current, split_options.precheck) &&
+                current.simplify(trail)) {
+                if (current.has_unknown_variable()) {
+                    Fingerprint key = {};
+                    if (cache) { key = cache->residual(current); }
+                    const std::size_t first_leaf = leaves.size();
+                    CaseSplit split;
+                    if (cache && cache->lookup(key, leaves)) {
+                        if constexpr (verbose) {
+                            std::cerr << "CACHED SUBTREE\n";
+                        }
+                        record(Stat::CACHED_NODES);
+                        for (std::size_t k = first_leaf; k < leaves.size();
+                             ++k) {
+                            on_leaf(leaves[k]);
+                        }
+                        if (choices.empty()) { leaves.clear(); }
+                    } else if (choose_case_split<SYSTEM, verbose>(
+                                   current, split, split_options
+                               )) {
+                        record_case_split(split);
+                        const int child = split.num_children() - 1;
+                        choices.push_back({
+                            split,
+                            child,
+                            trail.mark(),
+                            cache != nullptr,
+                            key,
+                            first_leaf,
+                        });
+                        apply_case_split(current, split, child, trail);
+                        expanded = true;
+                    } else {
+                        if constexpr (verbose) {
+                            std::cerr << "LEAF SYSTEM\n";
+                        }
+                        record(Stat::LEAF_NODES);
+                        trace_leaf();
+                        on_leaf(current);
+                        if (!choices.empty() && cache) {
+                            leaves.push_back(current);
+                        }
+                    }
+                } else {
+                    if constexpr (verbose) { std::cerr << "SOLVED SYSTEM\n"; }
+                    record(Stat::SOLVED_NODES);
+                    trace_solved();
+                }
+            } else {
+                if constexpr (verbose) {
+                    std::cerr << "INCONSISTENT SYSTEM\n";
+                }
+                record(Stat::INCONSISTENT_NODES);
+                trace_refuted();
+            }
+            if (!expanded && !backtrack()) { return; }
+        }
+    }
+
+    // Removes all untried children of the shallowest choice point that has
+    // any, passing a snapshot of each one to push. Returns the number
+    // of systems donated in this way.
+    template <typename PUSH_CALLBACK>
+    int donate_oldest(PUSH_CALLBACK &&push) {
+        for (std::size_t k = 0; k < choices.size(); ++k) {
+            ChoicePoint &choice = choices[k];
+            if (choice.next_child > 0) {
+                // The subtrees of this choice point and all of its ancestors
+                // are no longer explored entirely by this search.
+                for (std::size_t j = 0; j <= k; ++j) {
+                    choices[j].cacheable = false;
+                }
+                SYSTEM snapshot = current;
+                trail.restore(snapshot, choice.mark);
+                const int count = choice.next_child;
+                for (int child = count - 1; child >= 0; --child) {
+                    SYSTEM system = snapshot;
+                    apply_case_split(system, choice.split, child);
+                    push(system);
+                }
+                choice.next_child = 0;
+                return count;
+            }
+        }
+        return 0;
+    }
+
+    // Passes a snapshot of every system that remains to be explored to push,
+    // without modifying the search. When called from poll(), these are the
+    // untried children of every choice point and the current system, which
+    // has not been simplified yet. They are passed in the reverse of the
+    // order in which run() would visit them, so that popping them from the
+    // back of a stack continues the search in the same order.
+    template <typename PUSH_CALLBACK>
+    void snapshot_pending(PUSH_CALLBACK &&push) const {
+        for (const ChoicePoint &choice : choices) {
+            if (choice.next_child > 0) {
+                SYSTEM snapshot = current;
+                trail.restore(snapshot, choice.mark);
+                for (int child = 0; child < choice.next_child; ++child) {
+                    SYSTEM system = snapshot;
+                    apply_case_split(system, choice.split, child);
+                    push(system);
+                }
+            }
+        }
+        push(current);
+    }
+
+}; // class TrailSearch<SYSTEM, verbose>
+
+
+// The stack must be empty, and have a capacity of at least
+// max_pending_nodes(M, N). It is passed in so that it can be reused across
+// cases. If a cache is supplied, every split node is looked up in it before
+// it is expanded, and a subtree is stored once all of its descendants have
+// been popped from the stack, together with the leaf systems written
+// meanwhile.
+template <typename SYSTEM, bool verbose>
+void analyze_case(
+    const SYSTEM &root,
+    FixedDeque<SYSTEM> &stack,
+    LeafWriter &writer,
+    const SplitOptions &options = {},
+    TranspositionCache<SYSTEM> *cache = nullptr
+) {
+    struct Subtree {
+        Fingerprint key;
+        std::size_t stack_size;
+        std::size_t first_leaf;
+    }; // struct Subtree
+    std::vector<Subtree> subtrees;
+    std::vector<SYSTEM> leaves;
+    assert(stack.empty());
+    assert(stack.capacity() >= max_pending_nodes(root.m(), root.n()));
+    stack.push_back(root);
     while (!stack.empty()) {
-        System<M, N> system = stack.back();
+        SYSTEM system = stack.back();
+        stack.pop_back();
+        record(Stat::NODES);
+        if (passes_prechecks(system, options.precheck) && system.simplify()) {
+            if (system.has_unknown_variable()) {
+                Fingerprint key = {};
+                if (cache) { key = cache->residual(system); }
+                const std::size_t stack_size = stack.size();
+                const std::size_t first_leaf = leaves.size();
+                if (cache && cache->lookup(key, leaves)) {
+                    if constexpr (verbose) { std::cerr << "CACHED SUBTREE\n"; }
+                    record(Stat::CACHED_NODES);
+                    for (std::size_t k = first_leaf; k < leaves.size(); ++k) {
+                        writer.write(leaves[k]);
+                    }
+                    if (subtrees.empty()) { leaves.clear(); }
+                } else if (find_case_split<SYSTEM, verbose>(
+                               stack, system, options
+                           )) {
+                    if (cache) {
+                        subtrees.push_back({key, stack_size, first_leaf});
+                    }
+                } else {
+                    if constexpr (verbose) { std::cerr << "LEAF SYSTEM\n"; }
+                    record(Stat::LEAF_NODES);
+                    trace_leaf();
+                    writer.write(system);
+                    if (!subtrees.empty()) { leaves.push_back(system); }
+                }
+            } else {
+                if constexpr (verbose) { std::cerr << "SOLVED SYSTEM\n"; }
+                record(Stat::SOLVED_NODES);
+                trace_solved();
+            }
+        } else {
+            if constexpr (verbose) { std::cerr << "INCONSISTENT SYSTEM\n"; }
+            record(Stat::INCONSISTENT_NODES);
+            trace_refuted();
+        }
+        while (!subtrees.empty() &&
+               (stack.size() == subtrees.back().stack_size)) {
+            const Subtree &subtree = subtrees.back();
+            cache->insert(
+                subtree.key,
+                leaves.data() + subtree.first_leaf,
+                leaves.data() + leaves.size()
+            );
+            subtrees.pop_back();
+            if (subtrees.empty()) { leaves.clear(); }
+        }
+    }
+}
+
+
+template <typename SYSTEM, bool verbose>
+void analyze(
+    const typename SYSTEM::shape_type &shape,
+    std::uint64_t begin_case,
+    std::uint64_t end_case,
+    LeafWriter &writer,
+    const SplitOptions &options = {},
+    TranspositionCache<SYSTEM> *cache = nullptr
+) {
+    FixedDeque<SYSTEM> stack(
+        max_pending_nodes(shape.m(), shape.n()), SYSTEM(shape)
+    );
+    CaseEnumerator<SYSTEM> cases(shape);
+    for (std::uint64_t case_index = begin_case; case_index < end_case;
+         ++case_index) {
+        if (options.break_symmetry &&
+            !is_representative_case(shape.m(), case_index)) {
+            continue;
+        }
+        if constexpr (verbose) {
+            std::cerr << "ANALYZING CASE "
+                      << case_string(shape.m(), case_index) << "\n";
+        }
+        writer.begin_case(case_index);
+        analyze_case<SYSTEM, verbose>(
+            cases.root(case_index), stack, writer, options, cache
+        );
+        writer.end_case();
+    }
+}
+
+
+template <typename SYSTEM, bool verbose>
+void analyze_with_trail(
+    const typename SYSTEM::shape_type &shape,
+    std::uint64_t begin_case,
+    std::uint64_t end_case,
+    LeafWriter &writer,
+    const SplitOptions &options = {},
+    TranspositionCache<SYSTEM> *cache = nullptr
+) {
+    TrailSearch<SYSTEM, verbose> search(shape, options, cache);
+    CaseEnumerator<SYSTEM> cases(shape);
+    for (std::uint64_t case_index = begin_case; case_index < end_case;
+         ++case_index) {
+        if (options.break_symmetry &&
+            !is_representative_case(shape.m(), case_index)) {
+            continue;
+        }
+        if constexpr (verbose) {
+            std::cerr << "ANALYZING CASE "
+                      << case_string(shape.m(), case_index) << "\n";
+        }
+        writer.begin_case(case_index);
+        search.run(
+            cases.root(case_index),
+            [&](const SYSTEM &system) { writer.write(system); },
+            [](TrailSearch<SYSTEM, verbose> &) {}
+        );
+        writer.end_case();
+    }
+}
+
+
+// The batch size used by --gpu without --batch, which is large enough to
+// occupy every core of a GPU.
+constexpr std::size_t DEFAULT_GPU_BATCH_SIZE = 1 << 14;
+
+// The largest batch size accepted by --batch, at which a batch of the
+// largest BitsetSystems already takes about 5 GB.
+constexpr std::size_t MAX_BATCH_SIZE = 1 << 20;
+
+
+/**
+ * Explores the same cases as analyze(), writing the same leaf systems in
+ * the same order, but simplifies the nodes of many cases at a time through
+ * a BatchSimplifier of the given capacity. The cases are explored in
+ * lockstep by capacity / MAX_CHILDREN lanes, each of which performs the
+ * depth-first search of one case. In every round, each lane contributes
+ * the nodes on top of its stack that have not yet been simplified, i.e.,
+ * the children of its last split, or the root of its next case, so that
+ * they always fit in one batch. Then every lane pops nodes until it splits
+ * one or finishes its case. The leaf systems of each case are held until
+ * every earlier case is finished.
+ */
+template <typename SYSTEM, bool verbose>
+void analyze_batched(
+    const typename SYSTEM::shape_type &shape,
+    std::uint64_t begin_case,
+    std::uint64_t end_case,
+    LeafWriter &writer,
+    const SplitOptions &options,
+    std::size_t batch_size,
+    bool use_gpu
+) {
+    enum NodeState : std::uint8_t { PENDING, CONSISTENT, INCONSISTENT };
+    struct Lane {
+        std::uint64_t case_index;
+        std::vector<SYSTEM> stack;
+        std::vector<NodeState> states;
+        std::vector<SYSTEM> leaves;
+    }; // struct Lane
+    ZeroOneSolver::BatchSimplifier<SYSTEM> simplifier(
+        shape, std::max(batch_size, MAX_CHILDREN), use_gpu
+    );
+    std::vector<Lane> lanes(simplifier.capacity() / MAX_CHILDREN);
+    std::vector<NodeState *> batch_states;
+    CaseEnumerator<SYSTEM> cases(shape);
+    std::uint64_t next_case = begin_case;
+    // The cases started but not yet written, in order, and the leaf
+    // systems of those that are finished.
+    std::deque<std::uint64_t> started;
+    std::map<std::uint64_t, std::vector<SYSTEM>> finished;
+
+    const auto start_case = [&](Lane &lane) {
+        while (options.break_symmetry && (next_case < end_case) &&
+               !is_representative_case(shape.m(), next_case)) {
+            ++next_case;
+        }
+        if (next_case >= end_case) { return false; }
+        lane.case_index = next_case++;
+        if constexpr (verbose) {
+            std::cerr << "ANALYZING CASE "
+                      << case_string(shape.m(), lane.case_index) << "\n";
+        }
+        lane.stack.push_back(cases.root(lane.case_index));
+        lane.states.push_back(PENDING);
+        started.push_back(lane.case_index);
+        return true;
+    };
+
+    std::size_t num_active = 0;
+    for (Lane &lane : lanes) { num_active += start_case(lane); }
+    while (num_active > 0) {
+        for (Lane &lane : lanes) {
+            for (std::size_t k = lane.stack.size();
+                 (k > 0) && (lane.states[k - 1] == PENDING);
+                 --k) {
+                if (passes_prechecks(lane.stack[k - 1], options.precheck)) {
+                    simplifier.push(lane.stack[k - 1]);
+                    batch_states.push_back(&lane.states[k - 1]);
+                } else {
+                    lane.states[k - 1] = INCONSISTENT;
+                }
+            }
+        }
+        simplifier.run();
+        for (std::size_t k = 0; k < batch_states.size(); ++k) {
+            *batch_states[k] =
+                simplifier.consistent(k) ? CONSISTENT : INCONSISTENT;
+        }
+        simplifier.clear();
+        batch_states.clear();
+        for (Lane &lane : lanes) {
+            if (lane.stack.empty()) { continue; }
+            while (!lane.stack.empty() && (lane.states.back() != PENDING)) {
+                const SYSTEM system = lane.stack.back();
+                const NodeState state = lane.states.back();
+                lane.stack.pop_back();
+                lane.states.pop_back();
+                record(Stat::NODES);
+                if (state == INCONSISTENT) {
+                    if constexpr (verbose) {
+                        std::cerr << "INCONSISTENT SYSTEM\n";
+                    }
+                    record(Stat::INCONSISTENT_NODES);
+                } else if (!system.has_unknown_variable()) {
+                    if constexpr (verbose) { std::cerr << "SOLVED SYSTEM\n"; }
+                    record(Stat::SOLVED_NODES);
+                } else if (find_case_split<SYSTEM, verbose>(
+                               lane.stack, system, options
+                           )) {
+                    lane.states.resize(lane.stack.size(), PENDING);
+                    break;
+                } else {
+                    if constexpr (verbose) { std::cerr << "LEAF SYSTEM\n"; }
+                    record(Stat::LEAF_NODES);
+                    lane.leaves.push_back(system);
+                }
+            }
+            if (lane.stack.empty()) {
+                finished[lane.case_index] = std::move(lane.leaves);
+                lane.leaves.clear();
+                num_active -= !start_case(lane);
+            }
+        }
+        while (!started.empty() && finished.contains(started.front())) {
+            const auto leaves = finished.extract(started.front());
+            writer.begin_case(started.front());
+            for (const SYSTEM &system : leaves.mapped()) {
+                writer.write(system);
+            }
+            writer.end_case();
+            started.pop_front();
+        }
+    }
+}
+
+
+// The progress of a case explored by analyze_case_bounded(). Each child of
+// a case split is assigned an equal share of its parent, and the case is
+// closed once every share has been explored.
+struct CaseFrontier {
+    std::uint64_t case_index;
+    double closed_fraction;
+    std::uint64_t num_open;
+}; // struct CaseFrontier
+
+
+// Explores the case rooted at root in the same order as analyze_case(), but
+// stops after node_budget nodes, and appends the nodes left on the stack to
+// frontier in the order in which checkpoints store them, so that resuming
+// them in a checkpoint continues the search where it stopped. The stack
+// must be empty, and is left empty. The shares vector is only passed in so
+// that it can be reused across cases.
+template <typename SYSTEM, bool verbose>
+CaseFrontier analyze_case_bounded(
+    std::uint64_t case_index,
+    const SYSTEM &root,
+    FixedDeque<SYSTEM> &stack,
+    std::vector<double> &shares,
+    LeafWriter &writer,
+    const SplitOptions &options,
+    std::uint64_t node_budget,
+    std::vector<SYSTEM> &frontier
+) {
+    assert(stack.empty());
+    assert(stack.capacity() >= max_pending_nodes(root.m(), root.n()));
+    stack.push_back(root);
+    shares.assign(1, 1.0);
+    std::uint64_t num_nodes = 0;
+    while (!stack.empty() && (num_nodes < node_budget)) {
+        SYSTEM system = stack.back();
+        const double share = shares.back();
         stack.pop_back();
-        if (system.simplify()) {
+        shares.pop_back();
+        ++num_nodes;
+        record(Stat::NODES);
+        if (passes_prechecks(system, options.precheck) && system.simplify()) {
             if (system.has_unknown_variable()) {
-                if (!find_case_split<M, N, verbose>(stack, system)) {
+                const std::size_t stack_size = stack.size();
+                if (find_case_split<SYSTEM, verbose>(stack, system, options)) {
+                    const std::size_t num_children = stack.size() - stack_size;
+                    shares.resize(
+                        stack.size(), share / static_cast<double>(num_children)
+                    );
+                } else {
                     if constexpr (verbose) { std::cerr << "LEAF SYSTEM\n"; }
-                    print_leaf_system(system);
+                    record(Stat::LEAF_NODES);
+                    writer.write(system);
                 }
             } else {
                 if constexpr (verbose) { std::cerr << "SOLVED SYSTEM\n"; }
+                record(Stat::SOLVED_NODES);
             }
         } else {
             if constexpr (verbose) { std::cerr << "INCONSISTENT SYSTEM\n"; }
+            record(Stat::INCONSISTENT_NODES);
         }
     }
+    double open_fraction = 0.0;
+    for (const double share : shares) { open_fraction += share; }
+    const CaseFrontier result = {
+        case_index,
+        stack.empty() ? 1.0 : std::max(1.0 - open_fraction, 0.0),
+        stack.size(),
+    };
+    stack.append_to(frontier);
+    stack.clear();
+    return result;
 }
 
 
-template <var_index_t M, var_index_t N, bool verbose>
-void analyze() {
-    std::bitset<M - 1> case_index;
-    do {
+template <typename SYSTEM, bool verbose>
+void analyze_bounded(
+    const typename SYSTEM::shape_type &shape,
+    std::uint64_t begin_case,
+    std::uint64_t end_case,
+    LeafWriter &writer,
+    const SplitOptions &options,
+    std::uint64_t node_budget,
+    std::vector<SYSTEM> &frontier,
+    std::vector<CaseFrontier> &report
+) {
+    FixedDeque<SYSTEM> stack(
+        max_pending_nodes(shape.m(), shape.n()), SYSTEM(shape)
+    );
+    std::vector<double> shares;
+    CaseEnumerator<SYSTEM> cases(shape);
+    for (std::uint64_t case_index = begin_case; case_index < end_case;
+         ++case_index) {
+        if (options.break_symmetry &&
+            !is_representative_case(shape.m(), case_index)) {
+            continue;
+        }
         if constexpr (verbose) {
-            std::cerr << "ANALYZING CASE " << case_index.to_string() << "\n";
+            std::cerr << "ANALYZING CASE "
+                      << case_string(shape.m(), case_index) << "\n";
         }
-        analyze_case<M, N, verbose>(case_index);
-    } while (increment(case_index));
+        writer.begin_case(case_index);
+        report.push_back(analyze_case_bounded<SYSTEM, verbose>(
+            case_index,
+            cases.root(case_index),
+            stack,
+            shares,
+            writer,
+            options,
+            node_budget,
+            frontier
+        ));
+        writer.end_case();
+    }
+}
+
+
+struct SolverOptions {
+    unsigned num_threads = 1;
+    bool use_trail = false;
+    // If split.break_symmetry is true, only one case of each mirror-image
+    // pair is solved, and mirror-image branches within symmetric cases are
+    // pruned, so the leaf systems found are only complete up to the
+    // reflection p_i <-> p_{M-i}, q_j <-> q_{N-j}.
+    SplitOptions split;
+    LeafFormat format = LeafFormat::TEXT;
+    // Required in CANONICAL format, and shared by every call to solve()
+    // so that canonical systems are deduplicated across (M, N) pairs.
+    LeafDeduplicator *deduplicator = nullptr;
+    // If nonnull, the canonical fingerprints of the leaf systems of every
+    // completed case are recorded in this store (see ResultStore.hpp).
+    // This requires that cases are not shared by work stealing.
+    ResultStore *store = nullptr;
+    // If nonnull, every node of every case is recorded in this proof trace
+    // (see ProofTrace.hpp), which has the same requirement.
+    ProofTrace *proof = nullptr;
+    // If checkpoint_path is nonempty, a checkpoint is written there every
+    // checkpoint_interval seconds, and an existing checkpoint is resumed.
+    // The output stream must then be a file opened by open_output().
+    std::filesystem::path output_path;
+    std::filesystem::path checkpoint_path;
+    double checkpoint_interval = 300.0;
+    // Only cases in [begin_case, end_case) are solved. This range is divided
+    // into num_shards contiguous parts of nearly equal size, or of nearly
+    // equal predicted cost if shard_profile is nonempty, of which only the
+    // one with index shard_index is solved. The output of each part is
+    // exactly the corresponding segment of the output for the whole range.
+    std::uint64_t begin_case = 0;
+    std::uint64_t end_case = UINT64_MAX;
+    std::uint64_t shard_index = 0;
+    std::uint64_t num_shards = 1;
+    ZeroOneSolver::CaseProfile shard_profile;
+    // If nonempty, search statistics are written to stats_path (as JSON)
+    // and case_stats_path (as CSV) at every checkpoint and at the end.
+    // This requires compiling with -DZERO_ONE_SOLVER_STATS=true.
+    std::filesystem::path stats_path;
+    std::filesystem::path case_stats_path;
+    // If nonzero, subtrees are memoized in a TranspositionCache that uses
+    // at most approximately this many bytes. This is only supported by the
+    // trail search when a ParallelAnalyzer is used.
+    std::size_t cache_memory = 0;
+    // If async_output is true, leaf systems are written to the output by a
+    // dedicated thread (see OutputPipeline.hpp), and compressed with zstd if
+    // compression_level is nonzero. If ordered_output is also true, cases
+    // are not shared by work stealing, and the output of each case is
+    // written in order of case index, as it would be with one thread.
+    bool async_output = false;
+    bool ordered_output = false;
+    int compression_level = 0;
+    // If stream_output is true, every leaf system is written and flushed as
+    // soon as it is found, so that a consumer reading the output through a
+    // pipe, such as StreamingVerifier.py, sees it without delay.
+    bool stream_output = false;
+    // If true, the selected cases are benchmarked by benchmark() instead
+    // of being solved, and a JSON report is written to the output stream.
+    bool benchmark = false;
+    // If node_budget is nonzero, at most this many nodes of each case are
+    // explored, and the nodes that remain are written to frontier_path
+    // as frontier_parts work items (see write_frontier()).
+    std::uint64_t node_budget = 0;
+    std::filesystem::path frontier_path;
+    std::uint64_t frontier_parts = 1;
+    // If numa is true, the workers of a ParallelAnalyzer are divided among
+    // the NUMA nodes of the machine and pinned to their CPUs, and steal work
+    // from workers on the same node first (see NumaTopology.hpp).
+    bool numa = false;
+    // If batch_size is nonzero, a single-threaded search simplifies up to
+    // this many nodes at a time, on the GPU if use_gpu is true and one is
+    // available (see analyze_batched() and BatchSimplifier.hpp). The GPU
+    // path is experimental, since no automated build compiles its kernel.
+    std::size_t batch_size = 0;
+    bool use_gpu = false;
+
+    bool collect_stats() const noexcept {
+        return STATS_ENABLED &&
+               !(stats_path.empty() && case_stats_path.empty());
+    }
+}; // struct SolverOptions
+
+
+// Returns the cases of an M x N system selected by options, clamped to
+// the range [0, 2^(M-1)) of valid case indices, which main() has already
+// checked for an explicit --cases range.
+std::pair<std::uint64_t, std::uint64_t>
+case_range(int m, const SolverOptions &options) {
+    const std::uint64_t num_cases = static_cast<std::uint64_t>(1) << (m - 1);
+    const std::uint64_t begin = std::min(options.begin_case, num_cases);
+    const std::uint64_t end = std::clamp(options.end_case, begin, num_cases);
+    if (!options.shard_profile.empty() && (options.num_shards > 1)) {
+        const std::vector<std::uint64_t> bounds =
+            options.shard_profile.split(begin, end, options.num_shards);
+        return {bounds[options.shard_index], bounds[options.shard_index + 1]};
+    }
+    // Since width <= 2^63 and shard_index < num_shards < 2^64,
+    // the products below cannot overflow in 128-bit arithmetic.
+    const unsigned __int128 width = end - begin;
+    return {
+        begin + static_cast<std::uint64_t>(
+                    width * options.shard_index / options.num_shards
+                ),
+        begin + static_cast<std::uint64_t>(
+                    width * (options.shard_index + 1) / options.num_shards
+                ),
+    };
 }
 
 
-int main() {
-    analyze<ZERO_ONE_SOLVER_M, ZERO_ONE_SOLVER_N, ZERO_ONE_SOLVER_VERBOSE>();
+// With ordered output, a thread may only start a case if it is less than
+// this many cases per thread after the earliest unfinished case.
+constexpr std::uint64_t REORDER_WINDOW_PER_THREAD = 16;
+
+
+template <typename SYSTEM, bool verbose>
+class ParallelAnalyzer {
+
+    // Leaf systems are accumulated in a per-worker buffer and written
+    // to the output stream in blocks of approximately this many bytes.
+    static constexpr std::size_t OUTPUT_BUFFER_SIZE = 1 << 16;
+    // Worker 0 reads the clock to decide whether a checkpoint is due
+    // once every this many nodes.
+    static constexpr unsigned CHECKPOINT_POLL_INTERVAL = 64;
+
+    const typename SYSTEM::shape_type shape;
+    std::ostream &output;
+    const SolverOptions &options;
+    const std::uint64_t begin_case;
+    const std::uint64_t end_case;
+    const unsigned num_workers;
+    TranspositionCache<SYSTEM> *const cache;
+    // If nonnull, worker i writes its leaf systems to pipeline->channel(i).
+    ZeroOneSolver::OutputPipeline *const pipeline;
+    std::atomic<std::uint64_t> next_case;
+    // Number of workers that are currently looking for work. Workers in trail
+    // mode only donate parts of their subtrees when this is nonzero.
+    std::atomic<unsigned> idle_workers;
+    // Number of nodes that are either waiting in a deque
+    // or currently being processed by some worker.
+    std::atomic<std::uint64_t> pending;
+    // Every worker allocates its own deque, along with its output buffer and
+    // search state, so that with options.numa, when it is pinned to the CPUs
+    // of worker_nodes[i], their pages are local to that node. Worker 0 first
+    // fills its deque with checkpoint_pending. Until a worker has done so,
+    // its deque is empty and has no capacity, so nothing can be stolen.
+    std::deque<WorkStealingDeque<SYSTEM>> deques;
+    const std::vector<SYSTEM> &checkpoint_pending;
+    const ZeroOneSolver::NumaTopology topology;
+    const std::vector<std::size_t> worker_nodes;
+    // Worker i tries to steal from victims[i] in order: every other worker
+    // on the same node, starting from worker i + 1, and then the others.
+    std::vector<std::vector<unsigned>> victims;
+    std::mutex output_mutex;
+
+    // To take a checkpoint, every worker that has not finished stops at the
+    // next point where all of its unexplored nodes are either in its deque
+    // or in its trail search, which it then snapshots. The last worker to
+    // stop writes the checkpoint and wakes the others. All of the following
+    // are guarded by checkpoint_mutex, except that checkpoint_polls and
+    // next_checkpoint are only accessed by worker 0 or while it is stopped.
+    std::atomic<bool> checkpoint_requested;
+    unsigned checkpoint_polls;
+    std::chrono::steady_clock::time_point next_checkpoint;
+    std::mutex checkpoint_mutex;
+    std::condition_variable checkpoint_done;
+    unsigned running_workers;
+    unsigned paused_workers;
+    std::uint64_t checkpoint_generation;
+    std::vector<std::vector<SYSTEM>> snapshots;
+
+    // If options.collect_stats(), each worker attributes the nodes it
+    // explores to the case it started most recently, or to the stolen
+    // bucket after it has stolen a subtree, and times every segment of its
+    // work between such changes. Since each case is started by exactly one
+    // worker, its entry in stats.cases is only written by that worker. The
+    // counters of running workers are read only while they are stopped,
+    // and those of finished workers are accumulated in finished_counters.
+    struct CaseTimer {
+        std::uint64_t case_index;
+        std::chrono::steady_clock::time_point start;
+        std::uint64_t nodes;
+        std::uint64_t leaves;
+        ZeroOneSolver::CaseStats stolen;
+    }; // struct CaseTimer
+
+    static constexpr std::uint64_t STOLEN_CASE = UINT64_MAX;
+
+    const std::chrono::steady_clock::time_point start_time;
+    ZeroOneSolver::StatsSummary stats;
+    std::vector<CaseTimer> case_timers;
+    std::vector<const ZeroOneSolver::StatCounters *> worker_counters;
+    ZeroOneSolver::StatCounters finished_counters;
+    ZeroOneSolver::CaseStats finished_stolen;
+
+    // Attributes the work done by a worker since the start of its current
+    // segment to its current case, and starts a new segment for case_index.
+    void switch_case(unsigned worker_index, std::uint64_t case_index) {
+        if (!options.collect_stats()) { return; }
+        using ZeroOneSolver::THREAD_STATS;
+        CaseTimer &timer = case_timers[worker_index];
+        const auto now = std::chrono::steady_clock::now();
+        const ZeroOneSolver::CaseStats segment = {
+            THREAD_STATS[Stat::NODES] - timer.nodes,
+            THREAD_STATS[Stat::LEAF_NODES] - timer.leaves,
+            std::chrono::duration<double>(now - timer.start).count(),
+        };
+        if (timer.case_index == STOLEN_CASE) {
+            timer.stolen.add(segment);
+        } else {
+            stats.cases[timer.case_index - begin_case].add(segment);
+        }
+        timer.case_index = case_index;
+        timer.start = now;
+        timer.nodes = THREAD_STATS[Stat::NODES];
+        timer.leaves = THREAD_STATS[Stat::LEAF_NODES];
+    }
+
+    // Must be called with checkpoint_mutex held and every running worker
+    // stopped, or after every worker has finished.
+    void write_stats() {
+        if (!options.collect_stats()) { return; }
+        stats.counters = finished_counters;
+        stats.stolen = finished_stolen;
+        for (unsigned i = 0; i < num_workers; ++i) {
+            if (worker_counters[i]) {
+                stats.counters.add(*worker_counters[i]);
+                stats.stolen.add(case_timers[i].stolen);
+            }
+        }
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+        stats.seconds = elapsed.count();
+        if ((!options.stats_path.empty() &&
+             !stats.write_json(options.stats_path, shape.m(), shape.n())) ||
+            (!options.case_stats_path.empty() &&
+             !stats.write_csv(options.case_stats_path))) {
+            std::cerr << "WARNING: Failed to write search statistics.\n";
+        }
+    }
+
+    std::chrono::steady_clock::time_point checkpoint_deadline() const {
+        return std::chrono::steady_clock::now() +
+               std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                   std::chrono::duration<double>(options.checkpoint_interval)
+               );
+    }
+
+    bool checkpoint_due(unsigned worker_index) {
+        if (options.checkpoint_path.empty()) { return false; }
+        if ((worker_index == 0) &&
+            (++checkpoint_polls % CHECKPOINT_POLL_INTERVAL == 0) &&
+            (std::chrono::steady_clock::now() >= next_checkpoint)) {
+            checkpoint_requested.store(true, std::memory_order_relaxed);
+        }
+        return checkpoint_requested.load(std::memory_order_relaxed);
+    }
+
+    // Must be called with checkpoint_mutex held and every running worker
+    // stopped, so that no node is in flight.
+    void take_checkpoint() {
+        Checkpoint<SYSTEM> checkpoint;
+        if (pipeline) { pipeline->drain(); }
+        output.flush();
+        checkpoint.output_size = static_cast<std::uint64_t>(output.tellp());
+        checkpoint.begin_case = begin_case;
+        checkpoint.end_case = end_case;
+        checkpoint.next_case = std::min(next_case.load(), end_case);
+        checkpoint.break_symmetry = options.split.break_symmetry;
+        for (unsigned i = 0; i < num_workers; ++i) {
+            deques[i].locked([&](FixedDeque<SYSTEM> &items) {
+                items.append_to(checkpoint.pending);
+            });
+            checkpoint.pending.insert(
+                checkpoint.pending.end(),
+                snapshots[i].begin(),
+                snapshots[i].end()
+            );
+            snapshots[i].clear();
+        }
+        if (!output || !ZeroOneSolver::sync_file(options.output_path) ||
+            !ZeroOneSolver::write_checkpoint(
+                options.checkpoint_path, shape, options.format, checkpoint
+            )) {
+            std::cerr << "WARNING: Failed to write checkpoint "
+                      << options.checkpoint_path.string() << ".\n";
+        }
+        write_stats();
+        paused_workers = 0;
+        checkpoint_requested.store(false, std::memory_order_relaxed);
+        next_checkpoint = checkpoint_deadline();
+        ++checkpoint_generation;
+        checkpoint_done.notify_all();
+    }
+
+    void pause(
+        unsigned worker_index,
+        LeafWriter &writer,
+        const TrailSearch<SYSTEM, verbose> *search
+    ) {
+        writer.flush();
+        std::unique_lock<std::mutex> lock(checkpoint_mutex);
+        if (!checkpoint_requested.load(std::memory_order_relaxed)) { return; }
+        if (search) {
+            search->snapshot_pending([&](const SYSTEM &system) {
+                snapshots[worker_index].push_back(system);
+            });
+        }
+        const std::uint64_t generation = checkpoint_generation;
+        const std::uint64_t case_index = case_timers[worker_index].case_index;
+        switch_case(worker_index, case_index);
+        if (++paused_workers == running_workers) {
+            take_checkpoint();
+        } else {
+            checkpoint_done.wait(lock, [&] {
+                return checkpoint_generation != generation;
+            });
+        }
+        // Time spent waiting for the checkpoint is not attributed to any case.
+        case_timers[worker_index].start = std::chrono::steady_clock::now();
+    }
+
+    void finish(unsigned worker_index, LeafWriter &writer) {
+        writer.end_case();
+        writer.flush();
+        switch_case(worker_index, STOLEN_CASE);
+        std::lock_guard<std::mutex> lock(checkpoint_mutex);
+        if (options.collect_stats()) {
+            finished_counters.add(ZeroOneSolver::THREAD_STATS);
+            finished_stolen.add(case_timers[worker_index].stolen);
+            worker_counters[worker_index] = nullptr;
+        }
+        --running_workers;
+        if (checkpoint_requested.load(std::memory_order_relaxed) &&
+            (running_workers > 0) && (paused_workers == running_workers)) {
+            take_checkpoint();
+        }
+    }
+
+    void process_with_trail(
+        unsigned worker_index,
+        TrailSearch<SYSTEM, verbose> &search,
+        const SYSTEM &root,
+        LeafWriter &writer
+    ) {
+        search.run(
+            root,
+            [&](const SYSTEM &system) { writer.write(system); },
+            [&](TrailSearch<SYSTEM, verbose> &self) {
+                if (checkpoint_due(worker_index)) {
+                    pause(worker_index, writer, &self);
+                }
+                if (options.ordered_output ||
+                    (idle_workers.load(std::memory_order_relaxed) == 0)) {
+                    return;
+                }
+                deques[worker_index].locked(
+                    [&](FixedDeque<SYSTEM> &items) {
+                        if (!items.empty()) { return; }
+                        pending += static_cast<std::uint64_t>(
+                            self.donate_oldest([&](const SYSTEM &node) {
+                                items.push_back(node);
+                            })
+                        );
+                    }
+                );
+            }
+        );
+        --pending;
+    }
+
+    void process(
+        unsigned worker_index, SYSTEM &system, LeafWriter &writer
+    ) {
+        record(Stat::NODES);
+        if (passes_prechecks(system, options.split.precheck) &&
+            system.simplify()) {
+            if (system.has_unknown_variable()) {
+                const bool found_split = deques[worker_index].locked(
+                    [&](FixedDeque<SYSTEM> &items) {
+                        const std::size_t old_size = items.size();
+                        const bool result = find_case_split<SYSTEM, verbose>(
+                            items, system, options.split
+                        );
+                        pending += items.size() - old_size;
+                        return result;
+                    }
+                );
+                if (!found_split) {
+                    if constexpr (verbose) { std::cerr << "LEAF SYSTEM\n"; }
+                    record(Stat::LEAF_NODES);
+                    trace_leaf();
+                    writer.write(system);
+                }
+            } else {
+                if constexpr (verbose) { std::cerr << "SOLVED SYSTEM\n"; }
+                record(Stat::SOLVED_NODES);
+                trace_solved();
+            }
+        } else {
+            if constexpr (verbose) { std::cerr << "INCONSISTENT SYSTEM\n"; }
+            record(Stat::INCONSISTENT_NODES);
+            trace_refuted();
+        }
+        --pending;
+    }
+
+    bool acquire(
+        unsigned worker_index,
+        SYSTEM &system,
+        LeafWriter &writer,
+        CaseEnumerator<SYSTEM> &case_roots
+    ) {
+        // Continue the local depth-first search whenever possible.
+        if (deques[worker_index].pop_back(system)) { return true; }
+        // Otherwise, the current case is finished, unless some of its
+        // nodes were stolen, which does not happen with ordered output.
+        writer.end_case();
+        // Otherwise, start a new case. The pending counter is incremented
+        // before claiming a case so that no other worker can observe a
+        // state in which all cases are claimed but none are pending.
+        ++pending;
+        std::uint64_t case_number = next_case++;
+        while (options.split.break_symmetry && (case_number < end_case) &&
+               !is_representative_case(shape.m(), case_number)) {
+            case_number = next_case++;
+        }
+        if (case_number < end_case) {
+            if (pipeline) { pipeline->wait_for_case(case_number); }
+            writer.begin_case(case_number);
+            if constexpr (verbose) {
+                std::cerr << "ANALYZING CASE "
+                          << case_string(shape.m(), case_number) << "\n";
+            }
+            switch_case(worker_index, case_number);
+            system = case_roots.root(case_number);
+            return true;
+        }
+        --pending;
+        if (options.ordered_output) { return false; }
+        // Once all cases are claimed, steal subtrees from other workers.
+        for (const unsigned victim : victims[worker_index]) {
+            if (deques[victim].steal(system)) {
+                switch_case(worker_index, STOLEN_CASE);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(unsigned worker_index) {
+        if (options.numa && !topology.pin(worker_nodes[worker_index])) {
+            std::cerr << "WARNING: Failed to pin worker " << worker_index
+                      << " to NUMA node " << worker_nodes[worker_index]
+                      << ".\n";
+        }
+        // Worker 0 explores the pending nodes of the checkpoint first.
+        deques[worker_index].reset(
+            max_pending_nodes(shape.m(), shape.n()) +
+                ((worker_index == 0) ? checkpoint_pending.size() : 0),
+            SYSTEM(shape)
+        );
+        if (worker_index == 0) {
+            deques[0].locked([&](FixedDeque<SYSTEM> &items) {
+                items.assign(
+                    checkpoint_pending.begin(), checkpoint_pending.end()
+                );
+            });
+        }
+        // The root system of each case claimed by this worker is built from
+        // the root of the previous one.
+        CaseEnumerator<SYSTEM> case_roots(shape);
+        std::optional<LeafWriter> leaf_writer;
+        if (pipeline) {
+            leaf_writer.emplace(
+                pipeline->channel(worker_index),
+                options.format,
+                OUTPUT_BUFFER_SIZE,
+                options.deduplicator
+            );
+        } else {
+            leaf_writer.emplace(
+                output,
+                options.format,
+                options.stream_output ? 0 : OUTPUT_BUFFER_SIZE,
+                &output_mutex,
+                options.deduplicator
+            );
+        }
+        LeafWriter &writer = *leaf_writer;
+        std::optional<CaseRecorder> recorder;
+        if (options.store) {
+            recorder.emplace(*options.store, shape.m(), shape.n());
+            writer.record_cases(&*recorder);
+        }
+        std::optional<ProofRecorder> proof;
+        if (options.proof) {
+            proof.emplace(*options.proof);
+            writer.record_proof(&*proof);
+        }
+        if (options.collect_stats()) {
+            std::lock_guard<std::mutex> lock(checkpoint_mutex);
+            ZeroOneSolver::THREAD_STATS = {};
+            worker_counters[worker_index] = &ZeroOneSolver::THREAD_STATS;
+            case_timers[worker_index] = {
+                STOLEN_CASE, std::chrono::steady_clock::now(), 0, 0, {}
+            };
+        }
+        SYSTEM system(shape);
+        TrailSearch<SYSTEM, verbose> search(shape, options.split, cache);
+        bool idle = false;
+        while (true) {
+            if (checkpoint_due(worker_index)) {
+                pause(worker_index, writer, nullptr);
+            }
+            if (acquire(worker_index, system, writer, case_roots)) {
+                if (idle) {
+                    --idle_workers;
+                    idle = false;
+                }
+                if (options.use_trail) {
+                    process_with_trail(worker_index, search, system, writer);
+                } else {
+                    process(worker_index, system, writer);
+                }
+            } else if (pending == 0) {
+                break;
+            } else {
+                if (!idle) {
+                    ++idle_workers;
+                    idle = true;
+                }
+                std::this_thread::yield();
+            }
+        }
+        finish(worker_index, writer);
+    }
+
+public:
+
+    // Explores the cases of the given checkpoint that have not been started,
+    // after its pending nodes, which are explored first in the same order
+    // as the search that wrote it. A new search starts from a checkpoint
+    // with next_case == begin_case and no pending nodes.
+    explicit ParallelAnalyzer(
+        const typename SYSTEM::shape_type &system_shape,
+        const SolverOptions &solver_options,
+        std::ostream &output_stream,
+        const Checkpoint<SYSTEM> &checkpoint,
+        TranspositionCache<SYSTEM> *transposition_cache = nullptr,
+        ZeroOneSolver::OutputPipeline *output_pipeline = nullptr
+    )
+        : shape(system_shape)
+        , output(output_stream)
+        , options(solver_options)
+        , begin_case(checkpoint.begin_case)
+        , end_case(checkpoint.end_case)
+        , num_workers(std::max(options.num_threads, 1U))
+        , cache(transposition_cache)
+        , pipeline(output_pipeline)
+        , next_case(checkpoint.next_case)
+        , idle_workers(0)
+        , pending(checkpoint.pending.size())
+        , deques(num_workers)
+        , checkpoint_pending(checkpoint.pending)
+        , topology(
+              options.numa ? ZeroOneSolver::NumaTopology::detect()
+                           : ZeroOneSolver::NumaTopology::single_node()
+          )
+        , worker_nodes(topology.assign(num_workers))
+        , victims(num_workers)
+        , checkpoint_requested(false)
+        , checkpoint_polls(0)
+        , next_checkpoint(checkpoint_deadline())
+        , checkpoint_mutex()
+        , checkpoint_done()
+        , running_workers(num_workers)
+        , paused_workers(0)
+        , checkpoint_generation(0)
+        , snapshots(num_workers)
+        , start_time(std::chrono::steady_clock::now())
+        , stats()
+        , case_timers(num_workers)
+        , worker_counters(num_workers, nullptr)
+        , finished_counters()
+        , finished_stolen() {
+        for (unsigned i = 0; i < num_workers; ++i) {
+            for (const bool same_node : {true, false}) {
+                for (unsigned k = 1; k < num_workers; ++k) {
+                    const unsigned victim = (i + k) % num_workers;
+                    if ((worker_nodes[victim] == worker_nodes[i]) ==
+                        same_node) {
+                        victims[i].push_back(victim);
+                    }
+                }
+            }
+        }
+        if (options.collect_stats()) {
+            stats.begin_case = begin_case;
+            stats.cases.assign(end_case - begin_case, {});
+        }
+    }
+
+    void run() {
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < num_workers; ++i) {
+            threads.emplace_back(&ParallelAnalyzer::work, this, i);
+        }
+        for (std::thread &thread : threads) { thread.join(); }
+        write_stats();
+    }
+
+}; // class ParallelAnalyzer<SYSTEM, verbose>
+
+
+// A stream buffer that discards everything written to it.
+class NullBuffer : public std::streambuf {
+
+protected:
+
+    int overflow(int c) override { return traits_type::not_eof(c); }
+
+    std::streamsize xsputn(const char *, std::streamsize count) override {
+        return count;
+    }
+
+}; // class NullBuffer
+
+
+/**
+ * Times the stages of the depth-first search over the selected cases
+ * separately, and writes a JSON report of the results to output:
+ *
+ *   1. analyze_case(), i.e., the whole search, writing leaf systems in the
+ *      selected format to a stream that discards them;
+ *   2. simplify(), applied to a copy of every node of the search tree; and
+ *   3. find_case_split(), applied to every simplified node that is split,
+ *      including the copies of the system made for its children.
+ *
+ * The nodes of each case are collected by an untimed search before stages
+ * 2 and 3 are timed, so memory usage is proportional to the largest case.
+ * The size of one system of the layout under test is reported as well.
+ */
+template <typename SYSTEM>
+bool benchmark(
+    const typename SYSTEM::shape_type &shape,
+    const SolverOptions &options,
+    std::ostream &output
+) {
+    using clock = std::chrono::steady_clock;
+    const auto [begin_case, end_case] = case_range(shape.m(), options);
+    NullBuffer null_buffer;
+    std::ostream null_stream(&null_buffer);
+    LeafWriter writer(
+        null_stream, options.format, 1 << 20, nullptr, options.deduplicator
+    );
+    std::uint64_t nodes = 0;
+    std::uint64_t leaves = 0;
+    std::uint64_t solved = 0;
+    std::uint64_t inconsistent = 0;
+    std::uint64_t splits = 0;
+    std::uint64_t children = 0;
+    clock::duration analyze_time{};
+    clock::duration simplify_time{};
+    clock::duration split_time{};
+    std::vector<SYSTEM> inputs;
+    std::vector<SYSTEM> simplified;
+    std::vector<SYSTEM> stack;
+    const SplitOptions &split_options = options.split;
+    std::unique_ptr<TranspositionCache<SYSTEM>> cache;
+    if (options.cache_memory) {
+        cache = std::make_unique<TranspositionCache<SYSTEM>>(
+            options.cache_memory, split_options.break_symmetry
+        );
+    }
+    FixedDeque<SYSTEM> dfs_stack(
+        max_pending_nodes(shape.m(), shape.n()), SYSTEM(shape)
+    );
+    CaseEnumerator<SYSTEM> cases(shape);
+    for (std::uint64_t case_index = begin_case; case_index < end_case;
+         ++case_index) {
+        if (split_options.break_symmetry &&
+            !is_representative_case(shape.m(), case_index)) {
+            continue;
+        }
+
+        const clock::time_point analyze_start = clock::now();
+        const SYSTEM &root = cases.root(case_index);
+        analyze_case<SYSTEM, false>(
+            root, dfs_stack, writer, split_options, cache.get()
+        );
+        analyze_time += clock::now() - analyze_start;
+
+        inputs.clear();
+        simplified.clear();
+        stack.clear();
+        stack.push_back(root);
+        while (!stack.empty()) {
+            SYSTEM system = stack.back();
+            stack.pop_back();
+            inputs.push_back(system);
+            ++nodes;
+            if (passes_prechecks(system, split_options.precheck) &&
+                system.simplify()) {
+                if (system.has_unknown_variable()) {
+                    const std::size_t old_size = stack.size();
+                    if (find_case_split<SYSTEM, false>(
+                            stack, system, split_options
+                        )) {
+                        simplified.push_back(system);
+                        ++splits;
+                        children += stack.size() - old_size;
+                    } else {
+                        ++leaves;
+                    }
+                } else {
+                    ++solved;
+                }
+            } else {
+                ++inconsistent;
+            }
+        }
+
+        std::vector<SYSTEM> work = inputs;
+        const clock::time_point simplify_start = clock::now();
+        for (SYSTEM &system : work) {
+            if (passes_prechecks(system, split_options.precheck)) {
+                system.simplify();
+            }
+        }
+        simplify_time += clock::now() - simplify_start;
+
+        const clock::time_point split_start = clock::now();
+        for (const SYSTEM &system : simplified) {
+            stack.clear();
+            find_case_split<SYSTEM, false>(stack, system, split_options);
+        }
+        split_time += clock::now() - split_start;
+    }
+    writer.flush();
+
+    using seconds = std::chrono::duration<double>;
+    const double analyze_seconds = seconds(analyze_time).count();
+    const double simplify_seconds = seconds(simplify_time).count();
+    const double split_seconds = seconds(split_time).count();
+    const double num_nodes = static_cast<double>(std::max<std::uint64_t>(
+        nodes, 1
+    ));
+    const ZeroOneSolver::CacheCounters cache_counters =
+        cache ? cache->counters() : ZeroOneSolver::CacheCounters{};
+    output << "{\"m\": " << static_cast<int>(shape.m())
+           << ", \"n\": " << static_cast<int>(shape.n())
+           << ", \"layout\": \""
+           << ZERO_ONE_SOLVER_STRINGIFY(ZERO_ONE_SOLVER_LAYOUT) << "\""
+           << ", \"strategy\": \""
+           << SPLIT_STRATEGY_NAMES[static_cast<int>(split_options.strategy)]
+           << "\", \"precheck\": \""
+           << ZeroOneSolver::PRECHECK_NAMES[split_options.precheck]
+           << "\", \"symmetry\": "
+           << (split_options.break_symmetry ? "true" : "false")
+           << ", \"system_size\": " << sizeof(SYSTEM)
+           << ", \"begin_case\": " << begin_case
+           << ", \"end_case\": " << end_case << ", \"nodes\": " << nodes
+           << ", \"leaves\": " << leaves << ", \"solved\": " << solved
+           << ", \"inconsistent\": " << inconsistent
+           << ", \"splits\": " << splits << ", \"children\": " << children
+           << ", \"analyze_seconds\": " << analyze_seconds
+           << ", \"simplify_seconds\": " << simplify_seconds
+           << ", \"split_seconds\": " << split_seconds
+           << ", \"nodes_per_second\": " << (num_nodes / analyze_seconds)
+           << ", \"leaves_per_second\": "
+           << (static_cast<double>(leaves) / analyze_seconds)
+           << ", \"simplify_ns_per_node\": "
+           << (1.0e9 * simplify_seconds / num_nodes)
+           << ", \"split_ns_per_split\": "
+           << (1.0e9 * split_seconds /
+               static_cast<double>(std::max<std::uint64_t>(splits, 1)))
+           << ", \"cache_memory\": " << options.cache_memory
+           << ", \"cache_hits\": " << cache_counters.hits
+           << ", \"cache_misses\": " << cache_counters.misses
+           << ", \"cache_hit_rate\": " << cache_counters.hit_rate()
+           << ", \"cache_evictions\": " << cache_counters.evictions
+           << "}\n";
+    output.flush();
+    return static_cast<bool>(output);
+}
+
+
+void print_cache_counters(const ZeroOneSolver::CacheCounters &counters) {
+    std::ostringstream hit_rate;
+    hit_rate << std::fixed << std::setprecision(1)
+             << (100.0 * counters.hit_rate());
+    std::cerr << "Transposition cache: " << counters.hits << " hits, "
+              << counters.misses << " misses (" << hit_rate.view()
+              << "% hit rate), " << counters.stores << " stored, "
+              << counters.evictions << " evicted, " << counters.bytes
+              << " bytes in use.\n";
+}
+
+
+// Deals the frontier left by analyze_bounded() round-robin into
+// options.frontier_parts checkpoints, named frontier_path if there is only
+// one part, and frontier_path.K for K = 0, 1, ... otherwise. Every part has
+// no output and no cases left to start, so resuming it with --checkpoint,
+// the same case range, and a new output file writes exactly the leaf
+// systems below its nodes, without exploring any node explored before.
+// The closed fraction and number of open nodes of every case are written
+// to frontier_path.csv.
+template <typename SYSTEM>
+bool write_frontier(
+    const typename SYSTEM::shape_type &shape,
+    const SolverOptions &options,
+    std::uint64_t begin_case,
+    std::uint64_t end_case,
+    const std::vector<SYSTEM> &frontier,
+    const std::vector<CaseFrontier> &report
+) {
+    std::vector<Checkpoint<SYSTEM>> parts(
+        options.frontier_parts,
+        {0, begin_case, end_case, end_case, options.split.break_symmetry, {}}
+    );
+    for (std::size_t k = 0; k < frontier.size(); ++k) {
+        parts[k % parts.size()].pending.push_back(frontier[k]);
+    }
+    for (std::size_t k = 0; k < parts.size(); ++k) {
+        std::filesystem::path path = options.frontier_path;
+        if (parts.size() > 1) { path += "." + std::to_string(k); }
+        if (!ZeroOneSolver::write_checkpoint(
+                path, shape, options.format, parts[k]
+            )) {
+            return false;
+        }
+    }
+    std::filesystem::path report_path = options.frontier_path;
+    report_path += ".csv";
+    std::ofstream file(report_path);
+    file << "case_index,closed_fraction,frontier_systems\n";
+    double closed = 0.0;
+    std::size_t num_closed = 0;
+    for (const CaseFrontier &entry : report) {
+        file << entry.case_index << "," << entry.closed_fraction << ","
+             << entry.num_open << "\n";
+        closed += entry.closed_fraction;
+        if (entry.num_open == 0) { ++num_closed; }
+    }
+    std::cerr << "Closed " << num_closed << " of " << report.size()
+              << " cases and "
+              << (report.empty() ? 100.0 : 100.0 * closed / report.size())
+              << "% of the search space, leaving " << frontier.size()
+              << " frontier systems in " << parts.size() << " part"
+              << ((parts.size() == 1) ? "" : "s") << ".\n";
+    return static_cast<bool>(file);
+}
+
+
+// Returns false, after printing an error message, if the output
+// could not be written or a checkpoint could not be resumed.
+template <typename SYSTEM, bool verbose>
+bool solve(
+    const typename SYSTEM::shape_type &shape,
+    const SolverOptions &options,
+    std::ostream &output
+) {
+    if (options.benchmark) {
+        return benchmark<SYSTEM>(shape, options, output);
+    }
+    const auto [begin_case, end_case] = case_range(shape.m(), options);
+    Checkpoint<SYSTEM> checkpoint = {
+        0, begin_case, end_case, begin_case, options.split.break_symmetry, {}
+    };
+    const bool checkpointed = !options.checkpoint_path.empty();
+    const bool resumed =
+        checkpointed && std::filesystem::exists(options.checkpoint_path);
+    if (resumed) {
+        if (!ZeroOneSolver::read_checkpoint(
+                options.checkpoint_path, shape, options.format, checkpoint
+            ) ||
+            (checkpoint.begin_case != begin_case) ||
+            (checkpoint.end_case != end_case) ||
+            (checkpoint.break_symmetry != options.split.break_symmetry)) {
+            std::cerr << "ERROR: " << options.checkpoint_path.string()
+                      << " is not a checkpoint of this solver,"
+                         " case range, and symmetry mode.\n";
+            return false;
+        }
+        std::cerr << "Resuming from case " << checkpoint.next_case << " with "
+                  << checkpoint.pending.size() << " pending systems.\n";
+    }
+    // The header of a binary leaf file goes through the pipeline, if any,
+    // so that it is compressed together with the leaf systems. A checkpoint
+    // with no output, such as a part of a frontier, starts a new file.
+    std::ostringstream header;
+    if ((checkpoint.output_size == 0) &&
+        (options.format == LeafFormat::BINARY)) {
+        ZeroOneSolver::write_leaf_file_header(header, shape.m(), shape.n());
+    }
+    std::unique_ptr<TranspositionCache<SYSTEM>> cache;
+    if (options.cache_memory) {
+        cache = std::make_unique<TranspositionCache<SYSTEM>>(
+            options.cache_memory, options.split.break_symmetry
+        );
+    }
+    // Checkpoints and statistics are always taken by a ParallelAnalyzer,
+    // which performs the same search, in the same order, as analyze()
+    // with one thread.
+    const bool parallel =
+        (options.num_threads > 1) || checkpointed || options.collect_stats();
+    std::unique_ptr<ZeroOneSolver::OutputPipeline> pipeline;
+    if (options.async_output) {
+        const unsigned num_channels =
+            parallel ? std::max(options.num_threads, 1U) : 1;
+        pipeline = std::make_unique<ZeroOneSolver::OutputPipeline>(
+            output,
+            header.view(),
+            num_channels,
+            // Without a ParallelAnalyzer, cases are always solved in order.
+            parallel && options.ordered_output,
+            checkpoint.next_case,
+            REORDER_WINDOW_PER_THREAD * num_channels,
+            [&](std::uint64_t case_index) {
+                return options.split.break_symmetry &&
+                       (case_index < checkpoint.end_case) &&
+                       !is_representative_case(shape.m(), case_index);
+            },
+            options.compression_level
+        );
+    } else {
+        output << header.view();
+    }
+    if (parallel) {
+        ParallelAnalyzer<SYSTEM, verbose>(
+            shape, options, output, checkpoint, cache.get(), pipeline.get()
+        )
+            .run();
+    } else {
+        std::optional<LeafWriter> leaf_writer;
+        if (pipeline) {
+            leaf_writer.emplace(
+                pipeline->channel(0),
+                options.format,
+                1 << 20,
+                options.deduplicator
+            );
+        } else {
+            leaf_writer.emplace(
+                output,
+                options.format,
+                options.stream_output ? 0 : (1 << 20),
+                nullptr,
+                options.deduplicator
+            );
+        }
+        LeafWriter &writer = *leaf_writer;
+        std::optional<CaseRecorder> recorder;
+        if (options.store) {
+            recorder.emplace(*options.store, shape.m(), shape.n());
+            writer.record_cases(&*recorder);
+        }
+        std::optional<ProofRecorder> proof;
+        if (options.proof) {
+            proof.emplace(*options.proof);
+            writer.record_proof(&*proof);
+        }
+        std::vector<SYSTEM> frontier;
+        std::vector<CaseFrontier> report;
+        if (options.node_budget) {
+            analyze_bounded<SYSTEM, verbose>(
+                shape,
+                checkpoint.begin_case,
+                checkpoint.end_case,
+                writer,
+                options.split,
+                options.node_budget,
+                frontier,
+                report
+            );
+        } else if (options.batch_size) {
+            analyze_batched<SYSTEM, verbose>(
+                shape,
+                checkpoint.begin_case,
+                checkpoint.end_case,
+                writer,
+                options.split,
+                options.batch_size,
+                options.use_gpu
+            );
+        } else if (options.use_trail) {
+            analyze_with_trail<SYSTEM, verbose>(
+                shape,
+                checkpoint.begin_case,
+                checkpoint.end_case,
+                writer,
+                options.split,
+                cache.get()
+            );
+        } else {
+            analyze<SYSTEM, verbose>(
+                shape,
+                checkpoint.begin_case,
+                checkpoint.end_case,
+                writer,
+                options.split,
+                cache.get()
+            );
+        }
+        writer.flush();
+        if (options.node_budget &&
+            !write_frontier<SYSTEM>(
+                shape,
+                options,
+                checkpoint.begin_case,
+                checkpoint.end_case,
+                frontier,
+                report
+            )) {
+            std::cerr << "ERROR: Failed to write frontier "
+                      << options.frontier_path.string() << ".\n";
+            return false;
+        }
+    }
+    if (pipeline) { pipeline->close(); }
+    output.flush();
+    if (!output) {
+        std::cerr << "ERROR: Failed to write output.\n";
+        return false;
+    }
+    if (checkpointed) {
+        ZeroOneSolver::sync_file(options.output_path);
+        std::filesystem::remove(options.checkpoint_path);
+    }
+    if (cache) { print_cache_counters(cache->counters()); }
+    return true;
+}
+
+
+// Opens the output file of a run with the given options. If a checkpoint
+// exists, the file is truncated to the size recorded in the checkpoint,
+// discarding any leaf systems written after it was taken; otherwise, or if
+// that size is zero, it is truncated to zero size.
+bool open_output(std::ofstream &file, const SolverOptions &options) {
+    CheckpointHeader header = {};
+    if (!options.checkpoint_path.empty() &&
+        std::filesystem::exists(options.checkpoint_path) &&
+        !ZeroOneSolver::read_checkpoint_header(
+            options.checkpoint_path, header
+        )) {
+        return false;
+    }
+    if (header.output_size > 0) {
+        std::error_code error;
+        const std::uintmax_t size =
+            std::filesystem::file_size(options.output_path, error);
+        if (error || (size < header.output_size)) { return false; }
+        std::filesystem::resize_file(
+            options.output_path, header.output_size, error
+        );
+        if (error) { return false; }
+        file.open(
+            options.output_path, std::ios::binary | std::ios::in | std::ios::out
+        );
+        file.seekp(0, std::ios::end);
+    } else {
+        file.open(options.output_path, std::ios::binary | std::ios::trunc);
+    }
+    return static_cast<bool>(file);
+}
+
+
+// Converts a binary leaf file to the text format, one leaf system at a time.
+bool export_text(const std::string &path, std::ostream &output) {
+    LeafReader reader(path);
+    LeafRecord record;
+    while (reader.next(record)) {
+        ZeroOneSolver::print_leaf_record(output, record);
+    }
+    return reader.is_valid();
+}
+
+
+// Reads the leaf systems in a binary leaf file, a text leaf file, or a
+// WeaklyCanonizedEquations file, and writes those that IntervalPrefilter
+// cannot refute to output in the format read by CylindricalSolver.wls. If
+// path is "-", text is read from standard input as a stream: the systems
+// read so far are filtered, written, and flushed whenever no more input is
+// immediately available, so that each system passes through without delay.
+bool prefilter(
+    const std::string &path,
+    std::size_t max_boxes,
+    unsigned num_threads,
+    std::ostream &output
+) {
+    using ZeroOneSolver::CanonicalSystem;
+    using ZeroOneSolver::IntervalPrefilter;
+    constexpr std::size_t BATCH_SIZE = 4096;
+    num_threads = std::max(num_threads, 1U);
+    std::vector<IntervalPrefilter> filters(
+        num_threads, IntervalPrefilter(max_boxes)
+    );
+    std::vector<CanonicalSystem> batch;
+    std::vector<char> refuted;
+    std::uint64_t num_systems = 0;
+    std::uint64_t num_refuted = 0;
+    const auto flush = [&]() {
+        refuted.assign(batch.size(), 0);
+        std::atomic<std::size_t> next(0);
+        const auto work = [&](IntervalPrefilter &filter) {
+            for (std::size_t k = next++; k < batch.size(); k = next++) {
+                refuted[k] = filter.refute(batch[k]);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (unsigned k = 1; (k < num_threads) && (k < batch.size()); ++k) {
+            threads.emplace_back(work, std::ref(filters[k]));
+        }
+        work(filters[0]);
+        for (std::thread &thread : threads) { thread.join(); }
+        for (std::size_t k = 0; k < batch.size(); ++k) {
+            if (refuted[k]) {
+                ++num_refuted;
+            } else {
+                batch[k].write_wolfram(output);
+                output << "\n\n";
+            }
+        }
+        num_systems += batch.size();
+        batch.clear();
+    };
+    const bool streaming = (path == "-");
+    bool valid = true;
+    ZeroOneSolver::LeafReader reader(streaming ? std::string() : path);
+    if (reader.is_valid()) {
+        ZeroOneSolver::LeafRecord record;
+        while (reader.next(record)) {
+            batch.push_back(ZeroOneSolver::canonical_system_of(record));
+            if (batch.size() == BATCH_SIZE) { flush(); }
+        }
+        valid = reader.is_valid();
+    } else {
+        std::ifstream file;
+        if (!streaming) { file.open(path); }
+        std::istream &input = streaming ? std::cin : file;
+        valid = static_cast<bool>(input);
+        std::vector<std::string> block;
+        std::string line;
+        while (valid && std::getline(input, line)) {
+            if (!line.empty()) {
+                block.push_back(line);
+                continue;
+            }
+            if (block.empty()) { continue; }
+            CanonicalSystem system;
+            valid = (block[0].find('[') == std::string::npos)
+                        ? ZeroOneSolver::parse_leaf_block(block, system)
+                        : system.parse_wolfram(block);
+            batch.push_back(std::move(system));
+            if ((batch.size() == BATCH_SIZE) ||
+                (streaming && (input.rdbuf()->in_avail() <= 0))) {
+                flush();
+                output.flush();
+            }
+            block.clear();
+        }
+        valid = valid && block.empty();
+    }
+    if (valid) { flush(); }
+    std::uint64_t num_boxes = 0;
+    for (const IntervalPrefilter &filter : filters) {
+        num_boxes += filter.boxes_examined();
+    }
+    std::cerr << "Refuted " << num_refuted << " of " << num_systems
+              << " leaf systems by examining " << num_boxes << " boxes; "
+              << (num_systems - num_refuted) << " remain undecided.\n";
+    return valid && static_cast<bool>(output);
+}
+
+
+#ifndef ZERO_ONE_SOLVER_M
+
+
+// Solves the system for the given runtime dimensions using the first of the
+// capacity buckets MAX_DEGREE, MORE... that can hold them. Larger buckets
+// make every system larger, so they are only used when necessary.
+template <std::size_t MAX_DEGREE, std::size_t... MORE>
+bool solve_dynamic(
+    int m, int n, const SolverOptions &options, std::ostream &output
+) {
+    if (DynamicShape<MAX_DEGREE>::fits(m, n)) {
+        using SHAPE = DynamicShape<MAX_DEGREE>;
+        return solve<Layout<SHAPE>, ZERO_ONE_SOLVER_VERBOSE>(
+            SHAPE(m, n), options, output
+        );
+    }
+    if constexpr (sizeof...(MORE) > 0) {
+        return solve_dynamic<MORE...>(m, n, options, output);
+    } else {
+        return false;
+    }
+}
+
+
+bool solve_dynamic(
+    int m, int n, const SolverOptions &options, std::ostream &output
+) {
+    return solve_dynamic<32, 64, 128>(m, n, options, output);
+}
+
+
+std::filesystem::path data_file_path(
+    const std::filesystem::path &data_dir, int m, int n, LeafFormat format
+) {
+    std::ostringstream name;
+    name << std::setfill('0') << "ZeroOneEquations-" << std::setw(4) << (m + n)
+         << "-" << std::setw(4) << m << "-" << std::setw(4) << n
+         << ((format == LeafFormat::BINARY) ? ".bin" : ".txt");
+    return data_dir / name.str();
+}
+
+
+// Solves every pair 0 < m < n with m + n <= max_degree in increasing order
+// of m + n, writing each to its own file in data_dir in the same format as
+// ParallelSolver.py. Files that already exist are skipped, and each result
+// is written to a temporary file that is only renamed once it is complete.
+// An interrupted sweep resumes the temporary file from its checkpoint.
+bool sweep(
+    int max_degree,
+    const std::filesystem::path &data_dir,
+    const SolverOptions &options
+) {
+    std::filesystem::create_directories(data_dir);
+    for (int degree = 0; degree <= max_degree; ++degree) {
+        for (int m = 1; 2 * m < degree; ++m) {
+            const int n = degree - m;
+            const std::filesystem::path path =
+                data_file_path(data_dir, m, n, options.format);
+            if (std::filesystem::exists(path)) {
+                std::cerr << path.string() << " already computed.\n";
+                continue;
+            }
+            SolverOptions pair_options = options;
+            pair_options.output_path = path;
+            pair_options.output_path += ".temp";
+            pair_options.checkpoint_path = pair_options.output_path;
+            pair_options.checkpoint_path += ".checkpoint";
+            std::cerr << "Computing " << path.string() << ".\n";
+            {
+                std::ofstream file;
+                if (!open_output(file, pair_options)) { return false; }
+                if (!solve_dynamic(m, n, pair_options, file)) { return false; }
+            }
+            std::filesystem::rename(pair_options.output_path, path);
+        }
+    }
+    return true;
+}
+
+
+// Solves the same pairs as sweep(), writing the same files, but shares
+// options.num_threads threads between all of them using a PairScheduler,
+// which solves the most expensive pairs first. The solver time of every
+// pair is recorded in data_dir, to predict the cost of later sweeps.
+bool schedule(
+    int max_degree,
+    const std::filesystem::path &data_dir,
+    const SolverOptions &options,
+    double progress_interval
+) {
+    std::filesystem::create_directories(data_dir);
+    SolverOptions unit_options = options;
+    unit_options.num_threads = 1;
+    ZeroOneSolver::PairScheduler scheduler(
+        data_dir / "ZeroOneSolverCosts.txt",
+        (options.format == LeafFormat::BINARY)
+            ? sizeof(ZeroOneSolver::LeafFileHeader)
+            : 0,
+        [&](int m,
+            int n,
+            std::uint64_t begin,
+            std::uint64_t end,
+            std::ostream &output) {
+            SolverOptions pair_options = unit_options;
+            pair_options.begin_case = begin;
+            pair_options.end_case = end;
+            return solve_dynamic(m, n, pair_options, output);
+        }
+    );
+    for (int degree = 0; degree <= max_degree; ++degree) {
+        for (int m = 1; 2 * m < degree; ++m) {
+            const int n = degree - m;
+            const std::filesystem::path path =
+                data_file_path(data_dir, m, n, options.format);
+            if (std::filesystem::exists(path)) {
+                std::cerr << path.string() << " already computed.\n";
+            } else {
+                scheduler.add_pair(m, n, path);
+            }
+        }
+    }
+    return scheduler.run(options.num_threads, progress_interval);
+}
+
+
+std::filesystem::path
+canonical_file_path(const std::filesystem::path &data_dir, int degree) {
+    std::ostringstream name;
+    name << std::setfill('0') << "WeaklyCanonizedEquations-" << std::setw(4)
+         << degree << ".txt";
+    return data_dir / name.str();
+}
+
+
+// Solves every pair 0 < m < n with m + n <= max_degree in the same order as
+// sweep(), but writes only the canonical forms of the leaf systems to one
+// file per degree in data_dir, in the same format as Canonizer.py. Systems
+// in files that already exist are recorded without being recomputed, so
+// that an interrupted sweep continues without writing any duplicates.
+bool sweep_canonical(
+    int max_degree,
+    const std::filesystem::path &data_dir,
+    const SolverOptions &options
+) {
+    std::filesystem::create_directories(data_dir);
+    for (int degree = 0; degree <= max_degree; ++degree) {
+        const std::filesystem::path path =
+            canonical_file_path(data_dir, degree);
+        if (std::filesystem::exists(path)) {
+            std::cerr << path.string() << " already computed.\n";
+            if (!options.deduplicator->seed_from_file(path)) { return false; }
+            continue;
+        }
+        std::filesystem::path temp_path = path;
+        temp_path += ".temp";
+        std::cerr << "Computing " << path.string() << ".\n";
+        {
+            std::ofstream file(temp_path, std::ios::binary);
+            for (int m = 1; 2 * m < degree; ++m) {
+                if (!solve_dynamic(m, degree - m, options, file)) {
+                    return false;
+                }
+            }
+            if (!file) { return false; }
+        }
+        std::filesystem::rename(temp_path, path);
+    }
+    return true;
+}
+
+
+// Solves the same pairs as sweep_canonical(), in the same order, but writes
+// the canonical forms of the leaf systems to output as they are found, e.g.,
+// to a pipe read by StreamingVerifier.py, instead of to files.
+bool stream_canonical(
+    int max_degree, const SolverOptions &options, std::ostream &output
+) {
+    for (int degree = 0; degree <= max_degree; ++degree) {
+        for (int m = 1; 2 * m < degree; ++m) {
+            if (!solve_dynamic(m, degree - m, options, output)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+std::filesystem::path
+canonical_counts_file_path(const std::filesystem::path &data_dir, int degree) {
+    std::ostringstream name;
+    name << std::setfill('0') << "WeaklyCanonizedCounts-" << std::setw(4)
+         << degree << ".txt";
+    return data_dir / name.str();
+}
+
+
+// Writes the same files as Canonizer.py from the data files in data_dir,
+// reading the binary file of each pair if it exists and the text file
+// otherwise, for every degree up to the last one whose data files are all
+// available. It also writes the multiplicity of every canonical system.
+// Degrees already canonized by an earlier run are skipped, as long as
+// their output files and the state of the canonizer in work_dir remain.
+bool canonize_data(
+    const std::filesystem::path &data_dir,
+    const std::filesystem::path &work_dir,
+    std::size_t memory_budget,
+    unsigned num_threads
+) {
+    using Input = ZeroOneSolver::StreamingCanonizer::Input;
+    const auto inputs_of = [&](int degree, std::vector<Input> &inputs) {
+        inputs.clear();
+        for (int m = 1; 2 * m < degree; ++m) {
+            const int n = degree - m;
+            const std::filesystem::path binary_path =
+                data_file_path(data_dir, m, n, LeafFormat::BINARY);
+            const std::filesystem::path text_path =
+                data_file_path(data_dir, m, n, LeafFormat::TEXT);
+            if (std::filesystem::exists(binary_path)) {
+                inputs.push_back({binary_path, true});
+            } else if (std::filesystem::exists(text_path)) {
+                inputs.push_back({text_path, false});
+            } else {
+                return false;
+            }
+        }
+        return true;
+    };
+    std::vector<Input> inputs;
+    int max_degree = -1;
+    while (inputs_of(max_degree + 1, inputs)) { ++max_degree; }
+    std::cerr << "Data files of degree <= " << max_degree
+              << " are available.\n";
+    ZeroOneSolver::StreamingCanonizer canonizer(
+        work_dir, memory_budget, num_threads
+    );
+    for (int degree = 0; degree <= canonizer.completed_degree(); ++degree) {
+        if (!(std::filesystem::exists(canonical_file_path(data_dir, degree)) &&
+              std::filesystem::exists(
+                  canonical_counts_file_path(data_dir, degree)
+              ))) {
+            canonizer.reset();
+        }
+    }
+    for (int degree = canonizer.completed_degree() + 1; degree <= max_degree;
+         ++degree) {
+        std::cerr << "Processing data files of degree " << degree << ".\n";
+        inputs_of(degree, inputs);
+        if (!canonizer.canonize_degree(
+                inputs,
+                canonical_file_path(data_dir, degree),
+                canonical_counts_file_path(data_dir, degree)
+            )) {
+            std::cerr << "ERROR: Failed to canonize the data files of degree "
+                      << degree << ".\n";
+            return false;
+        }
+    }
+    std::cerr << "Found " << canonizer.new_systems()
+              << " canonical systems among " << canonizer.leaves_seen()
+              << " leaf systems.\n";
+    return true;
+}
+
+
+#endif // ZERO_ONE_SOLVER_M
+
+
+// Parses a string of the form "A<separator>B" into two integers A < B.
+bool parse_pair(
+    const std::string &arg,
+    char separator,
+    std::uint64_t &first,
+    std::uint64_t &second
+) {
+    const std::size_t pos = arg.find(separator);
+    if (pos == std::string::npos) { return false; }
+    const char *const begin = arg.data();
+    const char *const end = begin + arg.size();
+    std::uint64_t a = 0;
+    std::uint64_t b = 0;
+    const auto [a_end, a_error] = std::from_chars(begin, begin + pos, a);
+    const auto [b_end, b_error] = std::from_chars(begin + pos + 1, end, b);
+    if ((a_error != std::errc()) || (a_end != begin + pos) ||
+        (b_error != std::errc()) || (b_end != end) || (a >= b)) {
+        return false;
+    }
+    first = a;
+    second = b;
+    return true;
+}
+
+
+int usage(const char *program) {
+    std::cerr << "Usage: " << program
+#ifdef ZERO_ONE_SOLVER_M
+              << " [--threads N] [--trail] [--binary] [--symmetry]\n";
+#else
+              << " (--m M --n N | --max-degree D [--data-dir DIR])"
+                 " [--threads N] [--trail] [--binary] [--symmetry]\n";
+    std::cerr << "       " << program
+              << " --max-degree D --schedule [--progress-interval SECONDS"
+                 " >= 0.1] ...\n";
+    std::cerr << "       " << program
+              << " --canonize-data [--data-dir DIR] [--threads N]"
+                 " [--dedupe-memory MB] [--spill-dir DIR]\n";
+#endif
+    std::cerr << "       " << program
+              << " ... [--output FILE [--checkpoint FILE]"
+                 " [--checkpoint-interval SECONDS]]\n";
+    std::cerr << "       " << program
+              << " ... --node-budget N --frontier FILE"
+                 " [--frontier-parts K]\n";
+    std::cerr << "       " << program
+              << " ... [--cases BEGIN:END] [--shard K/NUM_SHARDS"
+                 " [--case-costs FILE.csv]]\n";
+    std::cerr << "       " << program
+              << " ... --canonize [--dedupe-memory MB] [--spill-dir DIR]\n";
+    std::cerr << "       " << program
+              << " ... [--stats FILE.json] [--case-stats FILE.csv]\n";
+    std::cerr << "       " << program
+              << " ... [--strategy first|occurrences|fewest-terms|lookahead]\n";
+    std::cerr << "       " << program
+              << " ... [--precheck none|local|evaluation|all]\n";
+    std::cerr << "       " << program << " ... [--cache MB]\n";
+    std::cerr << "       " << program << " ... --threads N --numa\n";
+    std::cerr << "       " << program
+              << " ... [--batch SIZE] [--gpu (experimental)]\n";
+    std::cerr << "       " << program
+              << " ... [--async-output] [--ordered] [--zstd LEVEL]\n";
+    std::cerr << "       " << program << " ... --stream\n";
+    std::cerr << "       " << program << " ... --store DIR\n";
+    std::cerr << "       " << program << " ... --proof FILE\n";
+    std::cerr << "       " << program << " ... --benchmark\n";
+    std::cerr << "       " << program << " --export-text FILE\n";
+    std::cerr << "       " << program
+              << " --prefilter FILE [--prefilter-boxes N] [--threads N]"
+                 " [--output FILE]\n";
+    return EXIT_FAILURE;
+}
+
+
+// The largest accepted memory limit in MB, whose size in bytes still fits in
+// a std::size_t.
+constexpr std::size_t MAX_MEMORY_MB =
+    std::numeric_limits<std::size_t>::max() >> 20;
+
+
+// The largest accepted interval in seconds, which is about 30 years, so that
+// adding it to a steady_clock time point never overflows.
+constexpr double MAX_INTERVAL_SECONDS = 1e9;
+
+#ifndef ZERO_ONE_SOLVER_M
+// The smallest accepted --progress-interval in seconds. Shorter intervals
+// would flood stderr, and those that round to zero would make the reporter
+// spin while holding the lock of the scheduler.
+constexpr double MIN_PROGRESS_INTERVAL_SECONDS = 0.1;
+#endif
+
+
+// The largest accepted number of frontier parts, each of which is a file.
+constexpr std::uint64_t MAX_FRONTIER_PARTS = 1 << 16;
+
+
+// The largest accepted --threads count per available CPU.
+constexpr unsigned MAX_THREADS_PER_CPU = 4;
+
+
+#ifndef ZERO_ONE_SOLVER_M
+// The largest M, N, or degree accepted on the command line. Dimensions up to
+// this bound that no DynamicShape can hold are rejected with an error below.
+constexpr int MAX_DIMENSION = 4096;
+#endif
+
+
+int main(int argc, char **argv) {
+    SolverOptions options;
+    std::string export_path;
+    std::string prefilter_path;
+    std::size_t prefilter_boxes = 100000;
+    std::size_t dedupe_memory_mb = 1024;
+    std::filesystem::path spill_dir;
+    std::filesystem::path store_dir;
+    std::filesystem::path proof_path;
+    std::filesystem::path case_costs_path;
+#ifndef ZERO_ONE_SOLVER_M
+    int m = 0;
+    int n = 0;
+    int max_degree = 0;
+    std::filesystem::path data_dir = "data";
+    bool scheduled = false;
+    double progress_interval = 10.0;
+    bool canonize_data_files = false;
+#endif
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--trail") {
+            options.use_trail = true;
+        } else if (arg == "--symmetry") {
+            options.split.break_symmetry = true;
+        } else if ((arg == "--strategy") && (i + 1 < argc)) {
+            if (!parse_split_strategy(argv[++i], options.split.strategy)) {
+                return usage(argv[0]);
+            }
+        } else if ((arg == "--precheck") && (i + 1 < argc)) {
+            if (!ZeroOneSolver::parse_precheck_mask(
+                    argv[++i], options.split.precheck
+                )) {
+                return usage(argv[0]);
+            }
+        } else if (arg == "--binary") {
+            options.format = LeafFormat::BINARY;
+        } else if (arg == "--canonize") {
+            options.format = LeafFormat::CANONICAL;
+        } else if ((arg == "--dedupe-memory") && (i + 1 < argc)) {
+            if (!parse_number(argv[++i], dedupe_memory_mb, std::size_t(1),
+                              MAX_MEMORY_MB)) {
+                return usage(argv[0]);
+            }
+        } else if ((arg == "--store") && (i + 1 < argc)) {
+            store_dir = argv[++i];
+        } else if ((arg == "--proof") && (i + 1 < argc)) {
+            proof_path = argv[++i];
+        } else if ((arg == "--spill-dir") && (i + 1 < argc)) {
+            spill_dir = argv[++i];
+        } else if ((arg == "--output") && (i + 1 < argc)) {
+            options.output_path = argv[++i];
+        } else if ((arg == "--checkpoint") && (i + 1 < argc)) {
+            options.checkpoint_path = argv[++i];
+        } else if ((arg == "--checkpoint-interval") && (i + 1 < argc)) {
+            if (!parse_number(argv[++i], options.checkpoint_interval, 0.0,
+                              MAX_INTERVAL_SECONDS)) {
+                return usage(argv[0]);
+            }
+        } else if ((arg == "--node-budget") && (i + 1 < argc)) {
+            if (!parse_number(argv[++i], options.node_budget,
+                              std::uint64_t(1), UINT64_MAX)) {
+                return usage(argv[0]);
+            }
+        } else if ((arg == "--frontier") && (i + 1 < argc)) {
+            options.frontier_path = argv[++i];
+        } else if ((arg == "--frontier-parts") && (i + 1 < argc)) {
+            if (!parse_number(argv[++i], options.frontier_parts,
+                              std::uint64_t(1), MAX_FRONTIER_PARTS)) {
+                return usage(argv[0]);
+            }
+        } else if ((arg == "--cases") && (i + 1 < argc)) {
+            if (!parse_pair(argv[++i], ':', options.begin_case,
+                            options.end_case)) {
+                return usage(argv[0]);
+            }
+        } else if ((arg == "--shard") && (i + 1 < argc)) {
+            if (!parse_pair(argv[++i], '/', options.shard_index,
+                            options.num_shards)) {
+                return usage(argv[0]);
+            }
+        } else if ((arg == "--case-costs") && (i + 1 < argc)) {
+            case_costs_path = argv[++i];
+        } else if ((arg == "--cache") && (i + 1 < argc)) {
+            std::size_t cache_memory_mb = 0;
+            if (!parse_number(argv[++i], cache_memory_mb, std::size_t(0),
+                              MAX_MEMORY_MB)) {
+                return usage(argv[0]);
+            }
+            options.cache_memory = cache_memory_mb << 20;
+        } else if (arg == "--stream") {
+            options.stream_output = true;
+        } else if (arg == "--async-output") {
+            options.async_output = true;
+        } else if (arg == "--ordered") {
+            options.async_output = true;
+            options.ordered_output = true;
+        } else if ((arg == "--zstd") && (i + 1 < argc)) {
+            options.async_output = true;
+            if (!parse_number(argv[++i], options.compression_level,
+                              ZeroOneSolver::ZSTD_MIN_LEVEL,
+                              ZeroOneSolver::ZSTD_MAX_LEVEL)) {
+                return usage(argv[0]);
+            }
+        } else if (arg == "--benchmark") {
+            options.benchmark = true;
+        } else if ((arg == "--stats") && (i + 1 < argc)) {
+            options.stats_path = argv[++i];
+        } else if ((arg == "--case-stats") && (i + 1 < argc)) {
+            options.case_stats_path = argv[++i];
+        } else if ((arg == "--export-text") && (i + 1 < argc)) {
+            export_path = argv[++i];
+        } else if ((arg == "--prefilter") && (i + 1 < argc)) {
+            prefilter_path = argv[++i];
+        } else if ((arg == "--prefilter-boxes") && (i + 1 < argc)) {
+            if (!parse_number(argv[++i], prefilter_boxes, std::size_t(1),
+                              std::numeric_limits<std::size_t>::max())) {
+                return usage(argv[0]);
+            }
+        } else if ((arg == "--threads") && (i + 1 < argc)) {
+            // Oversubscribing the CPUs by more than a small factor only
+            // adds contention, so larger counts are rejected as typos.
+            const unsigned num_cpus =
+                std::max(std::thread::hardware_concurrency(), 1U);
+            if (!parse_number(argv[++i], options.num_threads, 0U,
+                              MAX_THREADS_PER_CPU * num_cpus)) {
+                return usage(argv[0]);
+            }
+            if (options.num_threads == 0) {
+                options.num_threads = std::thread::hardware_concurrency();
+            }
+        } else if (arg == "--numa") {
+            options.numa = true;
+        } else if ((arg == "--batch") && (i + 1 < argc)) {
+            if (!parse_number(argv[++i], options.batch_size, std::size_t(1),
+                              MAX_BATCH_SIZE)) {
+                return usage(argv[0]);
+            }
+        } else if (arg == "--gpu") {
+            options.use_gpu = true;
+#ifndef ZERO_ONE_SOLVER_M
+        } else if ((arg == "--m") && (i + 1 < argc)) {
+            if (!parse_number(argv[++i], m, 1, MAX_DIMENSION)) {
+                return usage(argv[0]);
+            }
+        } else if ((arg == "--n") && (i + 1 < argc)) {
+            if (!parse_number(argv[++i], n, 1, MAX_DIMENSION)) {
+                return usage(argv[0]);
+            }
+        } else if ((arg == "--max-degree") && (i + 1 < argc)) {
+            if (!parse_number(argv[++i], max_degree, 1, MAX_DIMENSION)) {
+                return usage(argv[0]);
+            }
+        } else if ((arg == "--data-dir") && (i + 1 < argc)) {
+            data_dir = argv[++i];
+        } else if (arg == "--canonize-data") {
+            canonize_data_files = true;
+        } else if (arg == "--schedule") {
+            scheduled = true;
+        } else if ((arg == "--progress-interval") && (i + 1 < argc)) {
+            if (!parse_number(argv[++i], progress_interval,
+                              MIN_PROGRESS_INTERVAL_SECONDS,
+                              MAX_INTERVAL_SECONDS)) {
+                return usage(argv[0]);
+            }
+#endif
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (!export_path.empty()) {
+        if (!export_text(export_path, std::cout)) {
+            std::cerr << "ERROR: " << export_path
+                      << " is not a valid binary leaf file.\n";
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+    if (!prefilter_path.empty()) {
+        std::ofstream residual_file;
+        if (!options.output_path.empty()) {
+            residual_file.open(
+                options.output_path, std::ios::binary | std::ios::trunc
+            );
+        }
+        if (!prefilter(
+                prefilter_path,
+                prefilter_boxes,
+                options.num_threads,
+                options.output_path.empty() ? std::cout : residual_file
+            )) {
+            std::cerr << "ERROR: Failed to prefilter " << prefilter_path
+                      << ".\n";
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+#ifndef ZERO_ONE_SOLVER_M
+    if (canonize_data_files) {
+        if (spill_dir.empty()) { spill_dir = data_dir / "canonizer"; }
+        return canonize_data(
+                   data_dir,
+                   spill_dir,
+                   dedupe_memory_mb << 20,
+                   options.num_threads
+               )
+                   ? EXIT_SUCCESS
+                   : EXIT_FAILURE;
+    }
+#endif
+    std::unique_ptr<LeafDeduplicator> deduplicator;
+    if (options.format == LeafFormat::CANONICAL) {
+        if (spill_dir.empty()) {
+#ifdef ZERO_ONE_SOLVER_M
+            spill_dir = "fingerprints";
+#else
+            spill_dir = data_dir / "fingerprints";
+#endif
+        }
+        deduplicator = std::make_unique<LeafDeduplicator>(
+            spill_dir, dedupe_memory_mb << 20
+        );
+        options.deduplicator = deduplicator.get();
+    }
+    if (!options.checkpoint_path.empty() &&
+        (options.output_path.empty() ||
+         (options.format == LeafFormat::CANONICAL))) {
+        std::cerr << "ERROR: --checkpoint requires --output"
+                     " and is not supported with --canonize.\n";
+        return EXIT_FAILURE;
+    }
+    if (!(options.stats_path.empty() && options.case_stats_path.empty()) &&
+        !STATS_ENABLED) {
+        std::cerr << "ERROR: --stats and --case-stats require compiling"
+                     " with -DZERO_ONE_SOLVER_STATS=true.\n";
+        return EXIT_FAILURE;
+    }
+    if (options.benchmark &&
+        (options.use_trail || (options.num_threads > 1) ||
+         !options.checkpoint_path.empty() || options.collect_stats())) {
+        std::cerr << "ERROR: --benchmark is not supported with --trail,"
+                     " --threads, --checkpoint, or --stats.\n";
+        return EXIT_FAILURE;
+    }
+    if (options.cache_memory && !options.use_trail &&
+        ((options.num_threads > 1) || !options.checkpoint_path.empty() ||
+         options.collect_stats())) {
+        std::cerr << "ERROR: --cache requires --trail when used with"
+                     " --threads, --checkpoint, or --stats.\n";
+        return EXIT_FAILURE;
+    }
+    if (options.compression_level && !ZeroOneSolver::ZSTD_ENABLED) {
+        std::cerr << "ERROR: --zstd requires compiling with"
+                     " -DZERO_ONE_SOLVER_ZSTD=true and -lzstd.\n";
+        return EXIT_FAILURE;
+    }
+    if (options.stream_output && options.async_output) {
+        std::cerr << "ERROR: --stream is not supported with --async-output,"
+                     " --ordered, or --zstd.\n";
+        return EXIT_FAILURE;
+    }
+    // The frontier is left by a single-threaded search of a single pair, and
+    // is resumed from checkpoints, which the leaf systems below it complete.
+    if ((options.node_budget == 0) != options.frontier_path.empty()) {
+        std::cerr << "ERROR: --node-budget and --frontier"
+                     " must be used together.\n";
+        return EXIT_FAILURE;
+    }
+    if (options.node_budget &&
+        (options.use_trail || (options.num_threads > 1) ||
+         !options.checkpoint_path.empty() || options.collect_stats() ||
+         options.cache_memory || options.benchmark ||
+         (options.format == LeafFormat::CANONICAL) || !store_dir.empty())) {
+        std::cerr << "ERROR: --node-budget is not supported with --trail,"
+                     " --threads, --checkpoint, --stats, --cache,"
+                     " --benchmark, --canonize, or --store.\n";
+        return EXIT_FAILURE;
+    }
+    // A batched search is single-threaded, and its nodes are only recorded
+    // once every node of a round has been simplified.
+    if (options.use_gpu) {
+        std::cerr << "WARNING: --gpu is experimental; compare its leaf"
+                     " systems with a run without --gpu.\n";
+        if (options.batch_size == 0) {
+            options.batch_size = DEFAULT_GPU_BATCH_SIZE;
+        }
+    }
+    if (options.batch_size &&
+        (options.use_trail || (options.num_threads > 1) ||
+         !options.checkpoint_path.empty() || options.collect_stats() ||
+         options.cache_memory || options.benchmark || options.node_budget ||
+         !proof_path.empty())) {
+        std::cerr << "ERROR: --batch and --gpu are not supported with --trail,"
+                     " --threads, --checkpoint, --stats, --cache,"
+                     " --benchmark, --node-budget, or --proof.\n";
+        return EXIT_FAILURE;
+    }
+    if (options.ordered_output && !options.checkpoint_path.empty()) {
+        std::cerr << "ERROR: --ordered is not supported with --checkpoint.\n";
+        return EXIT_FAILURE;
+    }
+    // Every leaf system of a case must pass through the LeafWriter that
+    // started it, so cases may not be stolen or resumed from a checkpoint.
+    std::unique_ptr<ResultStore> store;
+    if (!store_dir.empty()) {
+        if (((options.num_threads > 1) && !options.ordered_output) ||
+            !options.checkpoint_path.empty() || options.benchmark) {
+            std::cerr << "ERROR: --store requires --ordered with --threads"
+                         " and is not supported with --checkpoint"
+                         " or --benchmark.\n";
+            return EXIT_FAILURE;
+        }
+        store = std::make_unique<ResultStore>(store_dir);
+        options.store = store.get();
+    }
+    // An explicit case range must lie within the 2^(M-1) cases of the pair,
+    // so that a mistyped range is not mistaken for a finished empty run.
+    if ((options.begin_case != 0) || (options.end_case != UINT64_MAX)) {
+#ifdef ZERO_ONE_SOLVER_M
+        const int case_m = ZERO_ONE_SOLVER_M;
+#else
+        const int case_m = m;
+#endif
+        if ((case_m >= 1) && (case_m <= 64)) {
+            const std::uint64_t num_cases = static_cast<std::uint64_t>(1)
+                                            << (case_m - 1);
+            if ((options.begin_case >= num_cases) ||
+                (options.end_case > num_cases)) {
+                std::cerr << "ERROR: --cases " << options.begin_case << ":"
+                          << options.end_case << " is not within the "
+                          << num_cases << " cases of M = " << case_m
+                          << ".\n";
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    // Shards are balanced by the per-case node counts of a previous run of a
+    // pair with the same M, which has the same cases.
+    if (!case_costs_path.empty()) {
+#ifdef ZERO_ONE_SOLVER_M
+        const int shard_m = ZERO_ONE_SOLVER_M;
+#else
+        const int shard_m = m;
+#endif
+        ZeroOneSolver::CaseProfile measured;
+        if ((shard_m < 1) || (shard_m > 64) ||
+            !measured.read_case_stats(
+                case_costs_path, static_cast<std::uint64_t>(1) << (shard_m - 1)
+            )) {
+            std::cerr << "ERROR: " << case_costs_path.string()
+                      << " is not a file written by --case-stats"
+                         " for a pair with the same M.\n";
+            return EXIT_FAILURE;
+        }
+        options.shard_profile = measured.prediction();
+    }
+    // A proof trace has the same requirements as a store, and moreover
+    // records every node, so that no subtree may be skipped by the cache
+    // or left unexplored by a node budget, and covers a single pair.
+    std::unique_ptr<ProofTrace> proof;
+    if (!proof_path.empty()) {
+#ifdef ZERO_ONE_SOLVER_M
+        const int proof_m = ZERO_ONE_SOLVER_M;
+        const int proof_n = ZERO_ONE_SOLVER_N;
+#else
+        const int proof_m = m;
+        const int proof_n = n;
+        if ((max_degree > 0) || !DynamicShape<128>::fits(m, n)) {
+            std::cerr << "ERROR: --proof requires --m and --n,"
+                         " and is not supported with --max-degree.\n";
+            return EXIT_FAILURE;
+        }
+#endif
+        if (((options.num_threads > 1) && !options.ordered_output) ||
+            !options.checkpoint_path.empty() || options.benchmark ||
+            options.cache_memory || options.node_budget) {
+            std::cerr << "ERROR: --proof requires --ordered with --threads"
+                         " and is not supported with --checkpoint,"
+                         " --benchmark, --cache, or --node-budget.\n";
+            return EXIT_FAILURE;
+        }
+        const auto [begin, end] = case_range(proof_m, options);
+        proof = std::make_unique<ProofTrace>(
+            proof_path,
+            proof_m,
+            proof_n,
+            options.split.break_symmetry,
+            begin,
+            end
+        );
+        options.proof = proof.get();
+    }
+    std::ofstream output_file;
+    std::ostream *output = &std::cout;
+    if (!options.output_path.empty()) {
+        if (!open_output(output_file, options)) {
+            std::cerr << "ERROR: Failed to open "
+                      << options.output_path.string() << ".\n";
+            return EXIT_FAILURE;
+        }
+        output = &output_file;
+    }
+#ifdef ZERO_ONE_SOLVER_M
+    using SHAPE = StaticShape<ZERO_ONE_SOLVER_M, ZERO_ONE_SOLVER_N>;
+    if (!solve<Layout<SHAPE>, ZERO_ONE_SOLVER_VERBOSE>(
+            SHAPE(), options, *output
+        )) {
+        return EXIT_FAILURE;
+    }
+#else
+    if (scheduled && (max_degree == 0)) {
+        std::cerr << "ERROR: --schedule requires --max-degree.\n";
+        return EXIT_FAILURE;
+    }
+    if (max_degree > 0) {
+        if ((options.begin_case != 0) || (options.end_case != UINT64_MAX) ||
+            (options.num_shards != 1) || options.collect_stats() ||
+            options.benchmark || options.node_budget) {
+            std::cerr << "ERROR: --cases, --shard, --stats, --benchmark,"
+                         " and --node-budget are not supported"
+                         " with --max-degree.\n";
+            return EXIT_FAILURE;
+        }
+        if (scheduled &&
+            ((options.format == LeafFormat::CANONICAL) ||
+             options.cache_memory || options.async_output || store)) {
+            std::cerr << "ERROR: --canonize, --cache, --async-output, and"
+                         " --store are not supported with --schedule.\n";
+            return EXIT_FAILURE;
+        }
+        bool swept;
+        if (scheduled) {
+            swept = schedule(max_degree, data_dir, options, progress_interval);
+        } else if ((options.format == LeafFormat::CANONICAL) &&
+                   options.stream_output) {
+            swept = stream_canonical(max_degree, options, *output);
+        } else if (options.format == LeafFormat::CANONICAL) {
+            swept = sweep_canonical(max_degree, data_dir, options);
+        } else {
+            swept = sweep(max_degree, data_dir, options);
+        }
+        if (!swept) {
+            std::cerr << "ERROR: Failed to sweep up to degree " << max_degree
+                      << ".\n";
+            return EXIT_FAILURE;
+        }
+    } else if (!DynamicShape<128>::fits(m, n)) {
+        std::cerr << "ERROR: Unsupported dimensions (M, N) = (" << m << ", "
+                  << n << ").\n";
+        return EXIT_FAILURE;
+    } else if (!solve_dynamic(m, n, options, *output)) {
+        return EXIT_FAILURE;
+    }
+#endif
+    if (store && !store->flush()) {
+        std::cerr << "ERROR: Failed to write to " << store_dir.string()
+                  << ".\n";
+        return EXIT_FAILURE;
+    }
+    if (proof && !proof->close()) {
+        std::cerr << "ERROR: Failed to write " << proof_path.string()
+                  << ".\n";
+        return EXIT_FAILURE;
+    }
+    if (deduplicator && deduplicator->failed()) {
+        std::cerr << "ERROR: Failed to spill fingerprints to "
+                  << spill_dir.string()
+                  << "; canonical systems may be missing from the output.\n";
+        return EXIT_FAILURE;
+    }
+    if (deduplicator) {
+        std::cerr << "Found " << deduplicator->unique_systems()
+                  << " canonical systems among " << deduplicator->leaves_seen()
+                  << " leaf systems.\n";
+    }
+    return EXIT_SUCCESS;
 }
@@ -1,12 +1,15 @@
 #ifndef ZERO_ONE_SOLVER_HPP_INCLUDED
 #define ZERO_ONE_SOLVER_HPP_INCLUDED
 
-#include <bitset>  // for std::bitset
 #include <cassert> // for assert
 #include <cstddef> // for std::byte, std::size_t
-#include <cstdint> // for std::uint8_t
+#include <cstdint> // for std::uint8_t, std::uint16_t, std::uint64_t
 #include <ostream> // for std::ostream
 
+#include "ProofTrace.hpp"
+#include "Stats.hpp"
+#include "Trail.hpp"
+
 namespace ZeroOneSolver {
 
 
@@ -75,10 +78,13 @@ public:
         return static_cast<T>((byte & (MASK << shift)) >> shift);
     }
 
-    constexpr void set(std::size_t index, T item) noexcept {
+    template <typename TRAIL = NullTrail>
+    constexpr void
+    set(std::size_t index, T item, TRAIL &&trail = TRAIL{}) noexcept {
         assert(index < N);
         const std::size_t byte_index = index >> 2;
         const std::byte byte = data[byte_index];
+        trail.save(data[byte_index]);
         const int shift = static_cast<int>(index & 0x03) << 1;
         const std::byte new_byte = static_cast<std::byte>(item) << shift;
         data[byte_index] = (byte & ~(MASK << shift)) | new_byte;
@@ -102,61 +108,284 @@ enum class VAR : std::uint8_t {
 }; // enum class VAR
 
 
-template <var_index_t M, var_index_t N>
-struct System {
+/**
+ * A shape supplies the dimensions (M, N) of a system of equations, together
+ * with the capacities MAX_M, MAX_N, and MAX_EQUATIONS used to size the arrays
+ * that store it. A StaticShape fixes (M, N) at compile time, so that every
+ * loop bound is a constant, while a DynamicShape (see DynamicShape.hpp)
+ * selects them at runtime within a fixed capacity bucket.
+ */
+template <typename SHAPE>
+struct SystemPattern;
 
 
+template <var_index_t M, var_index_t N>
+struct StaticShape {
+
     static_assert((0 < M) && (M < N));
 
+    static constexpr std::size_t MAX_M = M;
+    static constexpr std::size_t MAX_N = N;
+    static constexpr std::size_t MAX_EQUATIONS = M + N - 1;
+
+    static constexpr var_index_t m() noexcept { return M; }
+    static constexpr var_index_t n() noexcept { return N; }
+    static constexpr std::size_t num_equations() noexcept { return M + N - 1; }
+    static constexpr std::size_t num_slots() noexcept { return M + 1; }
+
+    static constexpr const SystemPattern<StaticShape> &pattern() noexcept;
+
+}; // struct StaticShape<M, N>
+
+
+/**
+ * A SystemPattern records the structure of the initial system of equations
+ * for a given (M, N), before any variables have been fixed. The equation
+ * for the coefficient of x^d occupies row d - 1 of lhs, padded with
+ * TERM_ZERO to a uniform length of M + 1 slots. The exact length of each
+ * equation is recorded separately, so that loops over the terms of an
+ * equation never visit its padding.
+ *
+ * Terms never move between slots during the search; they are only zeroed out
+ * or have one of their factors replaced by 1. Hence, the slots at which each
+ * variable initially occurs form a static occurrence index, which allows the
+ * substitution of a variable to visit only the terms that contain it.
+ */
+template <typename SHAPE>
+struct SystemPattern {
+
+    struct Occurrence {
+        std::uint16_t equation;
+        std::uint16_t slot;
+    }; // struct Occurrence
+
+    var_index_t m;
+    var_index_t n;
+    Term lhs[SHAPE::MAX_EQUATIONS][SHAPE::MAX_M + 1];
+    // Only slots 0 .. length[e] - 1 of equation e are ever nonzero. The
+    // equations for x^d with d < M or d > N are much shorter than M + 1.
+    std::uint8_t length[SHAPE::MAX_EQUATIONS];
+
+    // p_occurrences[i][0 .. p_count[i] - 1] are the positions of all terms
+    // containing p_i, and similarly for q_j. Index 0 is unused.
+    Occurrence p_occurrences[SHAPE::MAX_M][SHAPE::MAX_N + 1];
+    std::uint16_t p_count[SHAPE::MAX_M];
+    Occurrence q_occurrences[SHAPE::MAX_N][SHAPE::MAX_M + 1];
+    std::uint16_t q_count[SHAPE::MAX_N];
+
+}; // struct SystemPattern<SHAPE>
+
+
+template <typename SHAPE>
+constexpr SystemPattern<SHAPE> make_system_pattern(int M, int N) noexcept {
+    assert((0 < M) && (M < N));
+    assert(static_cast<std::size_t>(M) <= SHAPE::MAX_M);
+    assert(static_cast<std::size_t>(N) <= SHAPE::MAX_N);
+    assert(static_cast<std::size_t>(M + N - 1) <= SHAPE::MAX_EQUATIONS);
+    SystemPattern<SHAPE> result{};
+    result.m = static_cast<var_index_t>(M);
+    result.n = static_cast<var_index_t>(N);
+    for (std::size_t e = 0; e < SHAPE::MAX_EQUATIONS; ++e) {
+        for (std::size_t t = 0; t < SHAPE::MAX_M + 1; ++t) {
+            result.lhs[e][t] = TERM_ZERO;
+        }
+    }
+    for (int d = 1; d <= M + N - 1; ++d) {
+        int t = 0;
+        if (d < M) {
+            for (int j = 1; j <= d - 1; ++j) {
+                result.lhs[d - 1][t++] = {j, d - j};
+            }
+            result.lhs[d - 1][t++] = {d, 0};
+            result.lhs[d - 1][t++] = {0, d};
+        } else if (d == M) {
+            for (int j = 1; j <= M - 1; ++j) {
+                result.lhs[d - 1][t++] = {j, d - j};
+            }
+            result.lhs[d - 1][t++] = {0, M};
+            result.lhs[d - 1][t++] = TERM_ONE;
+        } else if (d < N) {
+            for (int j = 1; j <= M - 1; ++j) {
+                result.lhs[d - 1][t++] = {j, d - j};
+            }
+            result.lhs[d - 1][t++] = {0, d - M};
+            result.lhs[d - 1][t++] = {0, d};
+        } else if (d == N) {
+            for (int j = 1; j <= M - 1; ++j) {
+                result.lhs[d - 1][t++] = {j, d - j};
+            }
+            result.lhs[d - 1][t++] = {0, N - M};
+            result.lhs[d - 1][t++] = TERM_ONE;
+        } else {
+            const int offset = d - N;
+            for (int j = offset + 1; j <= M - 1; ++j) {
+                result.lhs[d - 1][t++] = {j, d - j};
+            }
+            result.lhs[d - 1][t++] = {d - N, 0};
+            result.lhs[d - 1][t++] = {0, d - M};
+        }
+        result.length[d - 1] = static_cast<std::uint8_t>(t);
+    }
+    for (std::size_t e = 0; e < static_cast<std::size_t>(M + N - 1); ++e) {
+        for (std::size_t t = 0; t < result.length[e]; ++t) {
+            const Term term = result.lhs[e][t];
+            if (term == TERM_ZERO) { continue; }
+            const typename SystemPattern<SHAPE>::Occurrence occurrence = {
+                static_cast<std::uint16_t>(e), static_cast<std::uint16_t>(t)
+            };
+            if (term.p_index) {
+                const std::size_t i = term.p_index;
+                result.p_occurrences[i][result.p_count[i]++] = occurrence;
+            }
+            if (term.q_index) {
+                const std::size_t j = term.q_index;
+                result.q_occurrences[j][result.q_count[j]++] = occurrence;
+            }
+        }
+    }
+    return result;
+}
+
 
-    Term lhs[M + N - 1][M + 1];
-    TwoBitPackedArray<RHS, M + N - 1> rhs;
-    TwoBitPackedArray<VAR, M - 1> p;
-    TwoBitPackedArray<VAR, N - 1> q;
+template <var_index_t M, var_index_t N>
+inline constexpr SystemPattern<StaticShape<M, N>> SYSTEM_PATTERN =
+    make_system_pattern<StaticShape<M, N>>(M, N);
 
 
-    constexpr System() noexcept {
-        for (int d = 1; d <= M + N - 1; ++d) {
-            int t = 0;
-            if (d < M) {
-                for (int j = 1; j <= d - 1; ++j) {
-                    lhs[d - 1][t++] = {j, d - j};
-                }
-                lhs[d - 1][t++] = {d, 0};
-                lhs[d - 1][t++] = {0, d};
-            } else if (d == M) {
-                for (int j = 1; j <= M - 1; ++j) {
-                    lhs[d - 1][t++] = {j, d - j};
-                }
-                lhs[d - 1][t++] = {0, M};
-                lhs[d - 1][t++] = TERM_ONE;
-            } else if (d < N) {
-                for (int j = 1; j <= M - 1; ++j) {
-                    lhs[d - 1][t++] = {j, d - j};
-                }
-                lhs[d - 1][t++] = {0, d - M};
-                lhs[d - 1][t++] = {0, d};
-            } else if (d == N) {
-                for (int j = 1; j <= M - 1; ++j) {
-                    lhs[d - 1][t++] = {j, d - j};
-                }
-                lhs[d - 1][t++] = {0, N - M};
-                lhs[d - 1][t++] = TERM_ONE;
-            } else {
-                const int offset = d - N;
-                for (int j = offset + 1; j <= M - 1; ++j) {
-                    lhs[d - 1][t++] = {j, d - j};
-                }
-                lhs[d - 1][t++] = {d - N, 0};
-                lhs[d - 1][t++] = {0, d - M};
+template <var_index_t M, var_index_t N>
+constexpr const SystemPattern<StaticShape<M, N>> &
+StaticShape<M, N>::pattern() noexcept {
+    return SYSTEM_PATTERN<M, N>;
+}
+
+
+/**
+ * A Worklist is a FIFO queue of equation indices in which each equation
+ * appears at most once, so a ring buffer of M + N - 1 slots suffices.
+ * It drives the propagation phases of simplify(), which re-examine
+ * only those equations that contain a recently fixed variable.
+ */
+template <typename SHAPE>
+class Worklist {
+
+    static constexpr std::size_t CAPACITY = SHAPE::MAX_EQUATIONS;
+
+    const SystemPattern<SHAPE> &pattern;
+    std::uint16_t items[CAPACITY];
+    bool queued[CAPACITY];
+    std::size_t head;
+    std::size_t size;
+
+public:
+
+    constexpr explicit Worklist(const SystemPattern<SHAPE> &system_pattern
+    ) noexcept
+        : pattern(system_pattern)
+        , items{}
+        , queued{}
+        , head(0)
+        , size(0) {}
+
+    constexpr bool empty() const noexcept { return size == 0; }
+
+    // Returns true if e was not already queued.
+    constexpr bool push(std::size_t e) noexcept {
+        assert(e < CAPACITY);
+        if (queued[e]) { return false; }
+        queued[e] = true;
+        items[(head + size) % CAPACITY] = static_cast<std::uint16_t>(e);
+        ++size;
+        return true;
+    }
+
+    constexpr std::size_t pop() noexcept {
+        assert(size > 0);
+        const std::size_t e = items[head];
+        head = (head + 1) % CAPACITY;
+        --size;
+        queued[e] = false;
+        return e;
+    }
+
+    // Returns the number of equations that were newly queued.
+    constexpr std::size_t push_p(var_index_t p_index) noexcept {
+        std::size_t count = 0;
+        for (std::size_t k = 0; k < pattern.p_count[p_index]; ++k) {
+            count += push(pattern.p_occurrences[p_index][k].equation);
+        }
+        return count;
+    }
+
+    constexpr std::size_t push_q(var_index_t q_index) noexcept {
+        std::size_t count = 0;
+        for (std::size_t k = 0; k < pattern.q_count[q_index]; ++k) {
+            count += push(pattern.q_occurrences[q_index][k].equation);
+        }
+        return count;
+    }
+
+}; // class Worklist<SHAPE>
+
+
+template <typename SHAPE>
+struct BasicSystem {
+
+
+    using shape_type = SHAPE;
+
+    static constexpr std::size_t MAX_M = SHAPE::MAX_M;
+    static constexpr std::size_t MAX_N = SHAPE::MAX_N;
+    static constexpr std::size_t MAX_EQUATIONS = SHAPE::MAX_EQUATIONS;
+
+
+    [[no_unique_address]] SHAPE shape;
+    Term lhs[MAX_EQUATIONS][MAX_M + 1];
+    TwoBitPackedArray<RHS, MAX_EQUATIONS> rhs;
+    TwoBitPackedArray<VAR, MAX_M - 1> p;
+    TwoBitPackedArray<VAR, MAX_N - 1> q;
+
+
+    constexpr explicit BasicSystem(const SHAPE &system_shape = SHAPE()) noexcept
+        : shape(system_shape) {
+        const SystemPattern<SHAPE> &pattern = shape.pattern();
+        for (std::size_t e = 0; e < MAX_EQUATIONS; ++e) {
+            for (std::size_t t = 0; t < MAX_M + 1; ++t) {
+                lhs[e][t] = pattern.lhs[e][t];
             }
-            while (t < M + 1) { lhs[d - 1][t++] = TERM_ZERO; }
         }
-        for (std::size_t i = 0; i < M + N - 1; ++i) {
+        for (std::size_t i = 0; i < MAX_EQUATIONS; ++i) {
             rhs.set(i, RHS::ZERO_OR_ONE);
         }
-        for (std::size_t i = 0; i < M - 1; ++i) { p.set(i, VAR::UNKNOWN); }
-        for (std::size_t i = 0; i < N - 1; ++i) { q.set(i, VAR::UNKNOWN); }
+        for (std::size_t i = 0; i < MAX_M - 1; ++i) { p.set(i, VAR::UNKNOWN); }
+        for (std::size_t i = 0; i < MAX_N - 1; ++i) { q.set(i, VAR::UNKNOWN); }
+    }
+
+
+    constexpr var_index_t m() const noexcept { return shape.m(); }
+    constexpr var_index_t n() const noexcept { return shape.n(); }
+    constexpr std::size_t num_equations() const noexcept {
+        return shape.num_equations();
+    }
+    constexpr std::size_t num_slots() const noexcept {
+        return shape.num_slots();
+    }
+
+
+    // Returns the number of slots of equation e that may hold a term. Slots
+    // t with length(e) <= t < num_slots() always hold TERM_ZERO.
+    constexpr std::size_t length(std::size_t e) const noexcept {
+        assert(e < num_equations());
+        return shape.pattern().length[e];
+    }
+
+
+    // Returns the term currently occupying slot t of equation e. Search code
+    // accesses terms through this function, rather than reading lhs directly,
+    // so that it also works with alternative layouts such as BitsetSystem.
+    constexpr Term term(std::size_t e, std::size_t t) const noexcept {
+        assert(e < num_equations());
+        assert(t < num_slots());
+        return lhs[e][t];
     }
 
 
@@ -209,84 +438,132 @@ struct System {
     // }
 
 
-    constexpr void set_p_zero(var_index_t p_index) noexcept {
-        assert((1 <= p_index) && (p_index <= M - 1));
+    template <typename TRAIL = NullTrail>
+    constexpr void
+    set_p_zero(var_index_t p_index, TRAIL &&trail = TRAIL{}) noexcept {
+        assert((1 <= p_index) && (p_index < m()));
         assert(p.get(p_index - 1) != VAR::ONE);
-        p.set(p_index - 1, VAR::ZERO);
-        for (std::size_t e = 0; e < M + N - 1; ++e) {
-            for (std::size_t t = 0; t < M + 1; ++t) {
-                if (lhs[e][t].p_index == p_index) { lhs[e][t] = TERM_ZERO; }
+        p.set(p_index - 1, VAR::ZERO, trail);
+        const SystemPattern<SHAPE> &pattern = shape.pattern();
+        for (std::size_t k = 0; k < pattern.p_count[p_index]; ++k) {
+            const auto [e, t] = pattern.p_occurrences[p_index][k];
+            Term &term = lhs[e][t];
+            if (term.p_index == p_index) {
+                trail.save(term);
+                term = TERM_ZERO;
             }
         }
     }
 
 
-    constexpr void set_q_zero(var_index_t q_index) noexcept {
-        assert((1 <= q_index) && (q_index <= N - 1));
+    template <typename TRAIL = NullTrail>
+    constexpr void
+    set_q_zero(var_index_t q_index, TRAIL &&trail = TRAIL{}) noexcept {
+        assert((1 <= q_index) && (q_index < n()));
         assert(q.get(q_index - 1) != VAR::ONE);
-        q.set(q_index - 1, VAR::ZERO);
-        for (std::size_t e = 0; e < M + N - 1; ++e) {
-            for (std::size_t t = 0; t < M + 1; ++t) {
-                if (lhs[e][t].q_index == q_index) { lhs[e][t] = TERM_ZERO; }
+        q.set(q_index - 1, VAR::ZERO, trail);
+        const SystemPattern<SHAPE> &pattern = shape.pattern();
+        for (std::size_t k = 0; k < pattern.q_count[q_index]; ++k) {
+            const auto [e, t] = pattern.q_occurrences[q_index][k];
+            Term &term = lhs[e][t];
+            if (term.q_index == q_index) {
+                trail.save(term);
+                term = TERM_ZERO;
             }
         }
     }
 
 
-    constexpr void set_p_one(var_index_t p_index) noexcept {
-        assert((1 <= p_index) && (p_index <= M - 1));
+    template <typename TRAIL = NullTrail>
+    constexpr void
+    set_p_one(var_index_t p_index, TRAIL &&trail = TRAIL{}) noexcept {
+        assert((1 <= p_index) && (p_index < m()));
         assert(p.get(p_index - 1) != VAR::ZERO);
-        p.set(p_index - 1, VAR::ONE);
-        for (std::size_t e = 0; e < M + N - 1; ++e) {
-            for (std::size_t t = 0; t < M + 1; ++t) {
-                if (lhs[e][t].p_index == p_index) { lhs[e][t].p_index = 0; }
+        p.set(p_index - 1, VAR::ONE, trail);
+        const SystemPattern<SHAPE> &pattern = shape.pattern();
+        for (std::size_t k = 0; k < pattern.p_count[p_index]; ++k) {
+            const auto [e, t] = pattern.p_occurrences[p_index][k];
+            Term &term = lhs[e][t];
+            if (term.p_index == p_index) {
+                trail.save(term);
+                term.p_index = 0;
             }
         }
     }
 
 
-    constexpr void set_q_one(var_index_t q_index) noexcept {
-        assert((1 <= q_index) && (q_index <= N - 1));
+    template <typename TRAIL = NullTrail>
+    constexpr void
+    set_q_one(var_index_t q_index, TRAIL &&trail = TRAIL{}) noexcept {
+        assert((1 <= q_index) && (q_index < n()));
         assert(q.get(q_index - 1) != VAR::ZERO);
-        q.set(q_index - 1, VAR::ONE);
-        for (std::size_t e = 0; e < M + N - 1; ++e) {
-            for (std::size_t t = 0; t < M + 1; ++t) {
-                if (lhs[e][t].q_index == q_index) { lhs[e][t].q_index = 0; }
+        q.set(q_index - 1, VAR::ONE, trail);
+        const SystemPattern<SHAPE> &pattern = shape.pattern();
+        for (std::size_t k = 0; k < pattern.q_count[q_index]; ++k) {
+            const auto [e, t] = pattern.q_occurrences[q_index][k];
+            Term &term = lhs[e][t];
+            if (term.q_index == q_index) {
+                trail.save(term);
+                term.q_index = 0;
             }
         }
     }
 
 
-    constexpr bool set_p_zero_or_one(var_index_t p_index) noexcept {
-        assert((1 <= p_index) && (p_index <= M - 1));
+    template <typename TRAIL = NullTrail>
+    constexpr bool
+    set_p_zero_or_one(var_index_t p_index, TRAIL &&trail = TRAIL{}) noexcept {
+        assert((1 <= p_index) && (p_index < m()));
         if (p.get(p_index - 1) == VAR::UNKNOWN) {
-            p.set(p_index - 1, VAR::ZERO_OR_ONE);
+            p.set(p_index - 1, VAR::ZERO_OR_ONE, trail);
             return true;
         }
         return false;
     }
 
 
-    constexpr bool set_q_zero_or_one(var_index_t q_index) noexcept {
-        assert((1 <= q_index) && (q_index <= N - 1));
+    template <typename TRAIL = NullTrail>
+    constexpr bool
+    set_q_zero_or_one(var_index_t q_index, TRAIL &&trail = TRAIL{}) noexcept {
+        assert((1 <= q_index) && (q_index < n()));
         if (q.get(q_index - 1) == VAR::UNKNOWN) {
-            q.set(q_index - 1, VAR::ZERO_OR_ONE);
+            q.set(q_index - 1, VAR::ZERO_OR_ONE, trail);
             return true;
         }
         return false;
     }
 
 
-    constexpr void set_case(const std::bitset<M - 1> &case_index) noexcept {
-        set_q_zero(M);
-        set_q_zero(N - M);
-        for (var_index_t i = 1; i <= M - 1; ++i) {
-            if (case_index[i - 1]) {
-                set_q_zero(M - i);
-                set_q_zero(N - i);
-            } else {
-                set_p_zero(i);
-            }
+    // Bit i - 1 of case_index selects whether p_i == 0 (if clear)
+    // or q_{M - i} == q_{N - i} == 0 (if set), for 1 <= i <= M - 1.
+    constexpr void set_case(std::uint64_t case_index) noexcept {
+        set_case_base();
+        for (var_index_t i = 1; i <= m() - 1; ++i) {
+            set_case_choice(i, (case_index >> (i - 1)) & 1);
+        }
+    }
+
+
+    // The parts of set_case() that are common to all cases.
+    template <typename TRAIL = NullTrail>
+    constexpr void set_case_base(TRAIL &&trail = TRAIL{}) noexcept {
+        set_q_zero(m(), trail);
+        set_q_zero(n() - m(), trail);
+    }
+
+
+    // The part of set_case() selected by bit i - 1 of the case index. Since
+    // these parts commute, they can be applied and undone in any order.
+    template <typename TRAIL = NullTrail>
+    constexpr void set_case_choice(
+        var_index_t i, bool bit, TRAIL &&trail = TRAIL{}
+    ) noexcept {
+        assert((1 <= i) && (i < m()));
+        if (bit) {
+            set_q_zero(m() - i, trail);
+            set_q_zero(n() - i, trail);
+        } else {
+            set_p_zero(i, trail);
         }
     }
 
@@ -304,70 +581,106 @@ struct System {
 
 
     constexpr bool has_unknown_variable() const noexcept {
-        for (std::size_t i = 0; i < M - 1; ++i) {
+        for (std::size_t i = 0; i + 1 < m(); ++i) {
             if (p.get(i) == VAR::UNKNOWN) { return true; }
         }
-        for (std::size_t i = 0; i < N - 1; ++i) {
+        for (std::size_t i = 0; i + 1 < n(); ++i) {
             if (q.get(i) == VAR::UNKNOWN) { return true; }
         }
         return false;
     }
 
 
-    constexpr bool simplify() noexcept {
+    template <typename TRAIL = NullTrail>
+    constexpr bool simplify(TRAIL &&trail = TRAIL{}) noexcept {
 
         constexpr std::size_t INVALID_INDEX = ~static_cast<std::size_t>(0);
 
-        // Phase 1: Simplify right-hand sides.
-        for (std::size_t e = 0; e < M + N - 1; ++e) {
-            // Scan each equation to look for nonzero terms and the term 1,
+        // Phases 1 and 2 are driven by a worklist of equations that may have
+        // changed since they were last examined. Initially, every equation
+        // is dirty. Afterwards, fixing a variable only enqueues the equations
+        // that contain it, so each substitution costs time proportional to
+        // the number of occurrences of that variable, not the system size.
+        // Because every rule is monotone, the order in which equations are
+        // processed does not affect the resulting fixed point.
+        record(Stat::SIMPLIFY_CALLS);
+        const std::size_t num_equations = this->num_equations();
+        const SystemPattern<SHAPE> &pattern = shape.pattern();
+        Worklist<SHAPE> worklist(pattern);
+        for (std::size_t e = 0; e < num_equations; ++e) { worklist.push(e); }
+        while (!worklist.empty()) {
+            const std::size_t e = worklist.pop();
+
+            // Phase 1: Simplify the right-hand side of equation e.
+            // Scan the equation to look for nonzero terms and the term 1,
             // keeping track of the index at which 1 occurs.
             bool found_nonzero = false;
             std::size_t one_index = INVALID_INDEX;
-            for (std::size_t t = 0; t < M + 1; ++t) {
+            for (std::size_t t = 0; t < pattern.length[e]; ++t) {
                 const Term term = lhs[e][t];
                 if (term != TERM_ZERO) { found_nonzero = true; }
                 if (term == TERM_ONE) {
                     // An equation with multiple copies of 1
                     // on its left-hand side is unsatisfiable.
-                    if (one_index != INVALID_INDEX) { return false; }
+                    if (one_index != INVALID_INDEX) {
+                        record(Stat::PHASE_1_CONFLICTS);
+                        refute(PROOF_TWO_ONES, e);
+                        return false;
+                    }
                     one_index = t;
                 }
             }
             if (!found_nonzero) {
                 // An equation of the form 0 == 1 is unsatisfiable.
-                if (rhs.get(e) == RHS::ONE) { return false; }
+                if (rhs.get(e) == RHS::ONE) {
+                    record(Stat::PHASE_1_CONFLICTS);
+                    refute(PROOF_ZERO_EQUALS_ONE, e);
+                    return false;
+                }
                 // If an equation has no nonzero terms on its left-hand
                 // side, then we set its right-hand side to zero.
-                rhs.set(e, RHS::ZERO);
+                record(Stat::PHASE_1_FIRED, rhs.get(e) != RHS::ZERO);
+                rhs.set(e, RHS::ZERO, trail);
             }
             if (one_index != INVALID_INDEX) {
                 // An equation of the form ... + 1 + ... == 0 is unsatisfiable.
-                if (rhs.get(e) == RHS::ZERO) { return false; }
+                if (rhs.get(e) == RHS::ZERO) {
+                    record(Stat::PHASE_1_CONFLICTS);
+                    refute(PROOF_ONE_EQUALS_ZERO, e);
+                    return false;
+                }
                 // If an equation has 1 on its left-hand side, then we subtract
                 // 1 from both sides, setting the right-hand side to zero.
+                record(Stat::PHASE_1_FIRED);
+                trail.save(lhs[e][one_index]);
                 lhs[e][one_index] = TERM_ZERO;
-                rhs.set(e, RHS::ZERO);
+                rhs.set(e, RHS::ZERO, trail);
             }
-        }
-        // After the end of Phase 1, we may assume that
-        // the term 1 does not appear in any equation.
+            // After Phase 1, we may assume that the
+            // term 1 does not appear in equation e.
 
-        // Phase 2: Use right-hand sides to directly solve for variables.
-        for (std::size_t e = 0; e < M + N - 1; ++e) {
+            // Phase 2: Use the right-hand side to directly solve for variables.
             const RHS rhs_value = rhs.get(e);
             if (rhs_value == RHS::ZERO) {
                 // If an equation has the form ... + p_i + ... == 0,
                 // then we may conclude that p_i == 0. The same holds
                 // for equations of the form ... + q_i + ... == 0.
-                for (std::size_t t = 0; t < M + 1; ++t) {
+                for (std::size_t t = 0; t < pattern.length[e]; ++t) {
                     const Term term = lhs[e][t];
                     if (term.q_index == 0) {
-                        set_p_zero(term.p_index);
-                        return simplify();
+                        set_p_zero(term.p_index, trail);
+                        record(Stat::PHASE_2_FIRED);
+                        record(
+                            Stat::PHASE_2_RESTARTS,
+                            worklist.push_p(term.p_index)
+                        );
                     } else if (term.p_index == 0) {
-                        set_q_zero(term.q_index);
-                        return simplify();
+                        set_q_zero(term.q_index, trail);
+                        record(Stat::PHASE_2_FIRED);
+                        record(
+                            Stat::PHASE_2_RESTARTS,
+                            worklist.push_q(term.q_index)
+                        );
                     }
                 }
             } else if (rhs_value == RHS::ONE) {
@@ -376,7 +689,7 @@ struct System {
                 // of the form q_j == 1, and in fact, for equations of the form
                 // p_i * q_j == 1.
                 std::size_t term_index = INVALID_INDEX;
-                for (std::size_t t = 0; t < M + 1; ++t) {
+                for (std::size_t t = 0; t < pattern.length[e]; ++t) {
                     if (lhs[e][t] != TERM_ZERO) {
                         if (term_index != INVALID_INDEX) {
                             term_index = INVALID_INDEX;
@@ -389,124 +702,156 @@ struct System {
                 if (term_index != INVALID_INDEX) {
                     const Term term = lhs[e][term_index];
                     assert(term != TERM_ZERO);
-                    if (term.p_index) { set_p_one(term.p_index); }
-                    if (term.q_index) { set_q_one(term.q_index); }
-                    return simplify();
+                    if (term.p_index) {
+                        set_p_one(term.p_index, trail);
+                        record(Stat::PHASE_2_FIRED);
+                        record(
+                            Stat::PHASE_2_RESTARTS,
+                            worklist.push_p(term.p_index)
+                        );
+                    }
+                    if (term.q_index) {
+                        set_q_one(term.q_index, trail);
+                        record(Stat::PHASE_2_FIRED);
+                        record(
+                            Stat::PHASE_2_RESTARTS,
+                            worklist.push_q(term.q_index)
+                        );
+                    }
                 }
             }
         }
 
-        // Phase 3: Eliminate unknown variables using all-but-one principle.
-        bool made_changes = false;
-        for (std::size_t e = 0; e < M + N - 1; ++e) {
-            // If an equation has the form t_1 + t_2 + ... + t_k == 0 or 1
-            // and all but one of the terms t_i are already known to be
-            // 0 or 1, then the remaining term must also be 0 or 1.
-            std::size_t unknown_index = INVALID_INDEX;
-            for (std::size_t t = 0; t < M + 1; ++t) {
-                if (is_unknown(lhs[e][t])) {
-                    if (unknown_index != INVALID_INDEX) {
-                        unknown_index = INVALID_INDEX;
-                        break;
-                    } else {
-                        unknown_index = t;
+        // Phases 3 and 4 only mark variables as ZERO_OR_ONE, which does not
+        // change any equation, so Phases 1 and 2 need not be repeated.
+        while (true) {
+
+            std::size_t num_changes = 0;
+
+            // Phase 3: Eliminate unknown variables using all-but-one principle.
+            for (std::size_t e = 0; e < num_equations; ++e) {
+                // If an equation has the form t_1 + t_2 + ... + t_k == 0 or 1
+                // and all but one of the terms t_i are already known to be
+                // 0 or 1, then the remaining term must also be 0 or 1.
+                std::size_t unknown_index = INVALID_INDEX;
+                for (std::size_t t = 0; t < pattern.length[e]; ++t) {
+                    if (is_unknown(lhs[e][t])) {
+                        if (unknown_index != INVALID_INDEX) {
+                            unknown_index = INVALID_INDEX;
+                            break;
+                        } else {
+                            unknown_index = t;
+                        }
                     }
                 }
-            }
-            if (unknown_index != INVALID_INDEX) {
-                const Term term = lhs[e][unknown_index];
-                if (term.q_index == 0) {
-                    made_changes |= set_p_zero_or_one(term.p_index);
-                } else if (term.p_index == 0) {
-                    made_changes |= set_q_zero_or_one(term.q_index);
-                }
-            }
-        }
-        if (!has_unknown_variable()) { return true; }
-        if (made_changes) { return simplify(); }
-
-        // Phase 4: Eliminate unknown variables in subsystems of the form:
-        //     a + b == 0 or 1
-        //     a * b == 0 or 1
-        Term lone_quadratic_terms[M + N - 1];
-        for (std::size_t e = 0; e < M + N - 1; ++e) {
-            std::size_t term_index = INVALID_INDEX;
-            for (std::size_t t = 0; t < M + 1; ++t) {
-                const Term term = lhs[e][t];
-                if (is_unknown(term)) {
-                    if (term_index != INVALID_INDEX) {
-                        term_index = INVALID_INDEX;
-                        break;
-                    } else {
-                        term_index = t;
+                if (unknown_index != INVALID_INDEX) {
+                    const Term term = lhs[e][unknown_index];
+                    if (term.q_index == 0) {
+                        num_changes += set_p_zero_or_one(term.p_index, trail);
+                    } else if (term.p_index == 0) {
+                        num_changes += set_q_zero_or_one(term.q_index, trail);
                     }
                 }
             }
-            if (term_index != INVALID_INDEX) {
-                const Term term = lhs[e][term_index];
-                assert(term != TERM_ZERO);
-                assert(term.p_index);
-                assert(term.q_index);
-                lone_quadratic_terms[e] = term;
-            } else {
-                lone_quadratic_terms[e] = TERM_ONE;
+            record(Stat::PHASE_3_FIRED, num_changes);
+            if (!has_unknown_variable()) { return true; }
+            if (num_changes) {
+                record(Stat::PHASE_3_RESTARTS);
+                continue;
             }
-        }
-        for (std::size_t e = 0; e < M + N - 1; ++e) {
-            std::size_t first_index = INVALID_INDEX;
-            std::size_t second_index = INVALID_INDEX;
-            for (std::size_t t = 0; t < M + 1; ++t) {
-                const Term term = lhs[e][t];
-                if (term != TERM_ZERO) {
-                    if (first_index != INVALID_INDEX) {
-                        if (second_index != INVALID_INDEX) {
-                            second_index = INVALID_INDEX;
+
+            // Phase 4: Eliminate unknown variables in subsystems of the form:
+            //     a + b == 0 or 1
+            //     a * b == 0 or 1
+            Term lone_quadratic_terms[MAX_EQUATIONS];
+            for (std::size_t e = 0; e < num_equations; ++e) {
+                std::size_t term_index = INVALID_INDEX;
+                for (std::size_t t = 0; t < pattern.length[e]; ++t) {
+                    const Term term = lhs[e][t];
+                    if (is_unknown(term)) {
+                        if (term_index != INVALID_INDEX) {
+                            term_index = INVALID_INDEX;
                             break;
                         } else {
-                            second_index = t;
+                            term_index = t;
                         }
-                    } else {
-                        first_index = t;
                     }
                 }
+                if (term_index != INVALID_INDEX) {
+                    const Term term = lhs[e][term_index];
+                    assert(term != TERM_ZERO);
+                    assert(term.p_index);
+                    assert(term.q_index);
+                    lone_quadratic_terms[e] = term;
+                } else {
+                    lone_quadratic_terms[e] = TERM_ONE;
+                }
             }
-            if (second_index != INVALID_INDEX) {
-                const Term x = lhs[e][first_index];
-                const Term y = lhs[e][second_index];
-                if ((x.q_index == 0) && (y.p_index == 0)) {
-                    assert(x.p_index);
-                    assert(y.q_index);
-                    const Term target = {x.p_index, y.q_index};
-                    for (std::size_t t = 0; t < M + N - 1; ++t) {
-                        if (lone_quadratic_terms[t] == target) {
-                            made_changes |= set_p_zero_or_one(x.p_index);
-                            made_changes |= set_q_zero_or_one(y.q_index);
-                            break;
+            for (std::size_t e = 0; e < num_equations; ++e) {
+                std::size_t first_index = INVALID_INDEX;
+                std::size_t second_index = INVALID_INDEX;
+                for (std::size_t t = 0; t < pattern.length[e]; ++t) {
+                    const Term term = lhs[e][t];
+                    if (term != TERM_ZERO) {
+                        if (first_index != INVALID_INDEX) {
+                            if (second_index != INVALID_INDEX) {
+                                second_index = INVALID_INDEX;
+                                break;
+                            } else {
+                                second_index = t;
+                            }
+                        } else {
+                            first_index = t;
                         }
                     }
-                } else if ((x.p_index == 0) && (y.q_index == 0)) {
-                    assert(x.q_index);
-                    assert(y.p_index);
-                    const Term target = {y.p_index, x.q_index};
-                    for (std::size_t t = 0; t < M + N - 1; ++t) {
-                        if (lone_quadratic_terms[t] == target) {
-                            made_changes |= set_p_zero_or_one(y.p_index);
-                            made_changes |= set_q_zero_or_one(x.q_index);
-                            break;
+                }
+                if (second_index != INVALID_INDEX) {
+                    const Term x = lhs[e][first_index];
+                    const Term y = lhs[e][second_index];
+                    if ((x.q_index == 0) && (y.p_index == 0)) {
+                        assert(x.p_index);
+                        assert(y.q_index);
+                        const Term target = {x.p_index, y.q_index};
+                        for (std::size_t t = 0; t < num_equations; ++t) {
+                            if (lone_quadratic_terms[t] == target) {
+                                num_changes +=
+                                    set_p_zero_or_one(x.p_index, trail);
+                                num_changes +=
+                                    set_q_zero_or_one(y.q_index, trail);
+                                break;
+                            }
+                        }
+                    } else if ((x.p_index == 0) && (y.q_index == 0)) {
+                        assert(x.q_index);
+                        assert(y.p_index);
+                        const Term target = {y.p_index, x.q_index};
+                        for (std::size_t t = 0; t < num_equations; ++t) {
+                            if (lone_quadratic_terms[t] == target) {
+                                num_changes +=
+                                    set_p_zero_or_one(y.p_index, trail);
+                                num_changes +=
+                                    set_q_zero_or_one(x.q_index, trail);
+                                break;
+                            }
                         }
                     }
                 }
             }
+            record(Stat::PHASE_4_FIRED, num_changes);
+            if (!has_unknown_variable()) { return true; }
+            // If Phase 4 made no changes, then no
+            // further simplification is possible.
+            if (!num_changes) { return true; }
+            record(Stat::PHASE_4_RESTARTS);
         }
-        if (!has_unknown_variable()) { return true; }
-        if (made_changes) { return simplify(); }
-
-        // At this point, no further simplification is possible.
-        return true;
     }
 
 
-}; // struct System<M, N>
+}; // struct BasicSystem<SHAPE>
+
+
+template <var_index_t M, var_index_t N>
+using System = BasicSystem<StaticShape<M, N>>;
 
 
 } // namespace ZeroOneSolver